@@ -8,6 +8,7 @@
 #include <til/unicode.h>
 
 #include "textBuffer.hpp"
+#include "TextAttributeTable.hpp"
 #include "../../types/inc/GlyphWidth.hpp"
 
 // It would be nice to add checked array access in the future, but it's a little annoying to do so without impacting
@@ -82,6 +83,151 @@ constexpr OutIt copy_n_small(InIt first, Diff count, OutIt dest)
     return dest;
 }
 
+// Disable vectorization-unfriendly warnings.
+#pragma warning(push)
+#pragma warning(disable : 26429) // Symbol '...' is never tested for nullness, it can be marked as not_null (f.23).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+// Returns true for UTF-16 code units that are guaranteed to be 1 column wide, without asking CodepointWidthDetector.
+// These are the largest gaps in its table of wide and ambiguous codepoints (which also contains all overrides):
+// * U+0000-U+00A0: ASCII, C1 control characters and NBSP
+// * U+0452-U+10FF: Cyrillic Extended, Armenian, Hebrew, Arabic, the Indic scripts, Thai, Georgian, etc.
+// * U+1160-U+200F: Hangul Jungseong/Jongseong, Ethiopic, Cherokee, Khmer, Mongolian, Latin Extended Additional, etc.
+// * U+2500-U+259F: Box Drawing and Block Elements
+// Ambiguous characters are not included, since their width depends on the font fallback.
+// None of the ranges overlaps with surrogates, so a run of such code units can be written into a ROW as is.
+// If you modify s_wideAndAmbiguousTable in CodepointWidthDetector.cpp, you must update this function.
+constexpr bool isKnownNarrow(const wchar_t wch) noexcept
+{
+    // Written with binary operators and unsigned range checks for the same reason as isActionableFromGround().
+    return (wch <= 0xa0) |
+           (static_cast<wchar_t>(wch - 0x0452) <= 0x10ff - 0x0452) |
+           (static_cast<wchar_t>(wch - 0x1160) <= 0x200f - 0x1160) |
+           (static_cast<wchar_t>(wch - 0x2500) <= 0x259f - 0x2500);
+}
+
+[[msvc::forceinline]] static size_t countKnownNarrowPlain(const wchar_t* beg, const wchar_t* end, const wchar_t* it) noexcept
+{
+#pragma loop(no_vector)
+    for (; it < end && isKnownNarrow(*it); ++it)
+    {
+    }
+    return it - beg;
+}
+
+// Returns the length of the prefix of `data` that only consists of isKnownNarrow() code units.
+static size_t countKnownNarrow(const wchar_t* data, size_t count) noexcept
+{
+#if defined(TIL_SSE_INTRINSICS)
+
+    auto it = data;
+
+    // Each range check is implemented as "max(0, (wch - lo) - (hi - lo)) == 0" with "SubS" (subtraction with
+    // unsigned saturation), because SSE2/AVX2 lack unsigned comparisons. See findActionableFromGround().
+    if (__isa_available >= __ISA_AVAILABLE_AVX2)
+    {
+        for (const auto end = data + (count & ~size_t{ 15 }); it < end; it += 16)
+        {
+            const auto wch = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            const auto z = _mm256_setzero_si256();
+
+            auto a = _mm256_subs_epu16(wch, _mm256_set1_epi16(0xa0));
+            auto b = _mm256_subs_epu16(_mm256_sub_epi16(wch, _mm256_set1_epi16(0x0452)), _mm256_set1_epi16(0x10ff - 0x0452));
+            auto c = _mm256_subs_epu16(_mm256_sub_epi16(wch, _mm256_set1_epi16(0x1160)), _mm256_set1_epi16(0x200f - 0x1160));
+            auto d = _mm256_subs_epu16(_mm256_sub_epi16(wch, _mm256_set1_epi16(0x2500)), _mm256_set1_epi16(0x259f - 0x2500));
+            a = _mm256_cmpeq_epi16(a, z);
+            b = _mm256_cmpeq_epi16(b, z);
+            c = _mm256_cmpeq_epi16(c, z);
+            d = _mm256_cmpeq_epi16(d, z);
+
+            const auto e = _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d));
+            const auto mask = ~static_cast<unsigned int>(_mm256_movemask_epi8(e));
+
+            if (mask)
+            {
+                unsigned long offset;
+                _BitScanForward(&offset, mask);
+                it += offset / 2;
+                return it - data;
+            }
+        }
+    }
+
+    for (const auto end = data + (count & ~size_t{ 7 }); it < end; it += 8)
+    {
+        const auto wch = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+        const auto z = _mm_setzero_si128();
+
+        auto a = _mm_subs_epu16(wch, _mm_set1_epi16(0xa0));
+        auto b = _mm_subs_epu16(_mm_sub_epi16(wch, _mm_set1_epi16(0x0452)), _mm_set1_epi16(0x10ff - 0x0452));
+        auto c = _mm_subs_epu16(_mm_sub_epi16(wch, _mm_set1_epi16(0x1160)), _mm_set1_epi16(0x200f - 0x1160));
+        auto d = _mm_subs_epu16(_mm_sub_epi16(wch, _mm_set1_epi16(0x2500)), _mm_set1_epi16(0x259f - 0x2500));
+        a = _mm_cmpeq_epi16(a, z);
+        b = _mm_cmpeq_epi16(b, z);
+        c = _mm_cmpeq_epi16(c, z);
+        d = _mm_cmpeq_epi16(d, z);
+
+        const auto e = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        const auto mask = ~static_cast<unsigned int>(_mm_movemask_epi8(e)) & 0xffff;
+
+        if (mask)
+        {
+            unsigned long offset;
+            _BitScanForward(&offset, mask);
+            it += offset / 2;
+            return it - data;
+        }
+    }
+
+    return countKnownNarrowPlain(data, data + count, it);
+
+#elif defined(TIL_ARM_NEON_INTRINSICS)
+
+    auto it = data;
+    uint64_t mask;
+
+    for (const auto end = data + (count & ~size_t{ 7 }); it < end;)
+    {
+        const auto wch = vld1q_u16(it);
+        const auto a = vcleq_u16(wch, vdupq_n_u16(0xa0));
+        const auto b = vcleq_u16(vsubq_u16(wch, vdupq_n_u16(0x0452)), vdupq_n_u16(0x10ff - 0x0452));
+        const auto c = vcleq_u16(vsubq_u16(wch, vdupq_n_u16(0x1160)), vdupq_n_u16(0x200f - 0x1160));
+        const auto d = vcleq_u16(vsubq_u16(wch, vdupq_n_u16(0x2500)), vdupq_n_u16(0x259f - 0x2500));
+        // Inverted, so that the mask has bits set for code units that are *not* known to be narrow.
+        const auto e = vmvnq_u16(vorrq_u16(vorrq_u16(a, b), vorrq_u16(c, d)));
+
+        mask = vgetq_lane_u64(e, 0);
+        if (mask)
+        {
+            goto exitWithMask;
+        }
+        it += 4;
+
+        mask = vgetq_lane_u64(e, 1);
+        if (mask)
+        {
+            goto exitWithMask;
+        }
+        it += 4;
+    }
+
+    return countKnownNarrowPlain(data, data + count, it);
+
+exitWithMask:
+    unsigned long offset;
+    _BitScanForward64(&offset, mask);
+    it += offset / 16;
+    return it - data;
+
+#else
+
+    return countKnownNarrowPlain(data, data + count, data);
+
+#endif
+}
+
+#pragma warning(pop)
+
 CharToColumnMapper::CharToColumnMapper(const wchar_t* chars, const uint16_t* charOffsets, ptrdiff_t lastCharOffset, til::CoordType currentColumn) noexcept :
     _chars{ chars },
     _charOffsets{ charOffsets },
@@ -166,23 +312,91 @@ til::CoordType CharToColumnMapper::GetTrailingColumnAt(const wchar_t* str) noexc
     return GetTrailingColumnAt(str - _chars);
 }
 
+RowRenderView::RowRenderView(const wchar_t* chars, const uint16_t* charOffsets, std::span<const til::rle_pair<uint16_t, uint16_t>> attrRuns, const TextAttributeTable* attributes, const TextAttribute* localAttributes, til::CoordType columnCount) noexcept :
+    _chars{ chars },
+    _charOffsets{ charOffsets },
+    _attrRuns{ attrRuns },
+    _attributes{ attributes },
+    _localAttributes{ localAttributes },
+    _columnCount{ columnCount },
+    _attrRunEnd{ attrRuns.empty() ? 0 : attrRuns.front().length }
+{
+}
+
+til::CoordType RowRenderView::ColumnCount() const noexcept
+{
+    return _columnCount;
+}
+
+// Returns true if the given column is the trailing half of a wide glyph.
+// The column must be in the range [0, ColumnCount()].
+bool RowRenderView::IsTrailer(til::CoordType column) const noexcept
+{
+    return WI_IsFlagSet(_charOffsets[column], CharOffsetsTrailer);
+}
+
+// Returns the text of the glyph that covers the given column and stores the column past its end in `columnEnd`.
+// If the column is the trailing half of a wide glyph, columnEnd will be 1 past it, just like
+// TextBufferCellIterator would only advance by 1 column. The column must be in the range [0, ColumnCount()).
+std::wstring_view RowRenderView::GlyphAt(til::CoordType column, til::CoordType& columnEnd) const noexcept
+{
+    // Trailers store the same offset as their leading half.
+    const auto beg = _charOffsets[column] & CharOffsetsMask;
+    // The past-the-end offset at index _columnCount never has the CharOffsetsTrailer flag.
+    auto end = column + 1;
+    for (; IsTrailer(end); ++end)
+    {
+    }
+    columnEnd = end;
+    return { _chars + beg, _chars + (_charOffsets[end] & CharOffsetsMask) };
+}
+
+// Returns the attributes of the given column. This is O(1) if the column is in the same or
+// the next attribute run compared to the previous call, which makes walking a row from left
+// to right O(n) overall. The column must be in the range [0, ColumnCount()).
+const TextAttribute& RowRenderView::AttrAt(til::CoordType column) noexcept
+{
+    if (column < _attrRunBeg)
+    {
+        _attrRun = 0;
+        _attrRunBeg = 0;
+        _attrRunEnd = _attrRuns[0].length;
+    }
+    while (column >= _attrRunEnd)
+    {
+        ++_attrRun;
+        _attrRunBeg = _attrRunEnd;
+        _attrRunEnd += _attrRuns[_attrRun].length;
+    }
+    const auto id = _attrRuns[_attrRun].value;
+    return _localAttributes ? _localAttributes[id] : _attributes->Get(id);
+}
+
 // Routine Description:
 // - constructor
 // Arguments:
 // - rowWidth - the width of the row, cell elements
-// - fillAttribute - the default text attribute
+// - attributes - the table that stores the attributes of this row
+// - fillAttributeId - the ID of the default text attribute in that table
 // Return Value:
 // - constructed object
-ROW::ROW(wchar_t* charsBuffer, uint16_t* charOffsetsBuffer, uint16_t rowWidth, const TextAttribute& fillAttribute) :
+ROW::ROW(wchar_t* charsBuffer, uint16_t* charOffsetsBuffer, uint16_t rowWidth, TextAttributeTable& attributes, uint16_t fillAttributeId) noexcept :
     _charsBuffer{ charsBuffer },
     _chars{ charsBuffer, rowWidth },
     _charOffsets{ charOffsetsBuffer, ::base::strict_cast<size_t>(rowWidth) + 1u },
-    _attr{ rowWidth, fillAttribute },
+    _attr{ rowWidth, fillAttributeId },
+    _attributes{ &attributes },
     _columnCount{ rowWidth }
 {
+    _attributes->Acquire(fillAttributeId);
     _init();
 }
 
+ROW::~ROW()
+{
+    _releaseAttributes();
+}
+
 void ROW::SetWrapForced(const bool wrap) noexcept
 {
     _wrapForced = wrap;
@@ -234,11 +448,44 @@ til::CoordType ROW::GetReadableColumnCount() const noexcept
 // - <none>
 void ROW::Reset(const TextAttribute& attr) noexcept
 {
+    if (const auto id = _attributes->Intern(attr); id != TextAttributeTable::InvalidId)
+    {
+        _reset(id);
+        return;
+    }
+
+    // The table is full. See _intern().
+    try
+    {
+        std::vector<TextAttribute> local{ attr };
+        // Index 0 into _localAttributes.
+        _reset(0);
+        _localAttributes = std::move(local);
+        return;
+    }
+    CATCH_LOG();
+
+    _reset(_attributes->InternFill(attr));
+}
+
+// Same as Reset(), but with the ID of the attribute in the TextAttributeTable of this ROW.
+// Unlike Reset() this is safe to call concurrently for different ROWs of the same table.
+void ROW::ResetWithAttributeId(uint16_t attributeId) noexcept
+{
+    _attributes->Acquire(attributeId);
+    _reset(attributeId);
+}
+
+// Implements Reset() and takes over the caller's reference to the attribute ID.
+void ROW::_reset(uint16_t attributeId) noexcept
+{
+    _releaseAttributes();
+    _localAttributes.clear();
     _charsHeap.reset();
     _chars = { _charsBuffer, _columnCount };
     // Constructing and then moving objects into place isn't free.
     // Modifying the existing object is _much_ faster.
-    *_attr.runs().unsafe_shrink_to_size(1) = til::rle_pair{ attr, _columnCount };
+    *_attr.runs().unsafe_shrink_to_size(1) = til::rle_pair{ attributeId, _columnCount };
     _lineRendition = LineRendition::SingleWidth;
     _wrapForced = false;
     _doubleBytePadded = false;
@@ -360,10 +607,87 @@ void ROW::_init() noexcept
 #pragma warning(push)
 }
 
-void ROW::TransferAttributes(const til::small_rle<TextAttribute, uint16_t, 1>& attr, til::CoordType newWidth)
+// Replaces the attributes of the columns [columnBegin, size()) with those of the source ROW starting at sourceColumnBegin.
+// If the source ROW has fewer columns left than this one, its last attribute is extended to the end of this ROW.
+void ROW::CopyAttributesFrom(const ROW& source, til::CoordType sourceColumnBegin, til::CoordType columnBegin)
 {
-    _attr = attr;
-    _attr.resize_trailing_extent(gsl::narrow<uint16_t>(newWidth));
+    auto runs = source._attr.slice(source._clampedColumnInclusive(sourceColumnBegin), source._attr.size());
+
+    // IDs are only meaningful within their own table and local indices only within their own ROW.
+    // Each translated run holds a reference until we're done.
+    const auto translate = source._attributes != _attributes || !source._localAttributes.empty() || !_localAttributes.empty();
+    if (translate)
+    {
+        _translateAttributes(source, runs);
+    }
+    const auto releaseTranslated = wil::scope_exit([&]() noexcept {
+        if (translate)
+        {
+            for (const auto& run : runs.runs())
+            {
+                _releaseAttribute(run.value);
+            }
+        }
+    });
+
+    auto attr = _attr;
+    attr.replace(_clampedColumnInclusive(columnBegin), attr.size(), runs);
+    attr.resize_trailing_extent(_columnCount);
+
+    for (const auto& run : attr.runs())
+    {
+        _acquireAttribute(run.value);
+    }
+    _releaseAttributes();
+    _attr = std::move(attr);
+}
+
+// Turns the IDs of the given runs, which belong to the source ROW, into IDs of this ROW that each hold a reference.
+// This may switch this ROW over to storing its attributes locally, if its table is full.
+// Reflow() copies ROWs that share a table in parallel, and as Intern() isn't thread-safe, the attributes
+// are only interned if the tables differ. Otherwise, this ROW stores them locally, just like the source.
+void ROW::_translateAttributes(const ROW& source, til::small_rle<uint16_t, uint16_t, 1>& attr)
+{
+    auto& runs = attr.runs();
+    til::small_vector<TextAttribute, 4> attrs;
+    attrs.reserve(runs.size());
+    for (const auto& run : runs)
+    {
+        attrs.emplace_back(source._getAttribute(run.value));
+    }
+
+    if (_localAttributes.empty() && source._attributes != _attributes)
+    {
+        size_t interned = 0;
+        for (; interned < runs.size(); ++interned)
+        {
+            const auto id = _attributes->Intern(attrs[interned]);
+            if (id == TextAttributeTable::InvalidId)
+            {
+                break;
+            }
+            runs[interned].value = id;
+        }
+        if (interned == runs.size())
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < interned; ++i)
+        {
+            _attributes->Release(runs[i].value);
+        }
+    }
+
+    // If this ROW already stored its attributes locally, this drops
+    // the unused ones, so that the indices below fit into 16 bits.
+    _storeAttributesLocally();
+
+    for (size_t i = 0; i < runs.size(); ++i)
+    {
+        _localAttributes.emplace_back(attrs[i]);
+        runs[i].value = gsl::narrow<uint16_t>(_localAttributes.size() - 1);
+    }
 }
 
 void ROW::CopyFrom(const ROW& source)
@@ -377,7 +701,243 @@ void ROW::CopyFrom(const ROW& source)
     };
     CopyTextFrom(state);
 
-    TransferAttributes(source.Attributes(), _columnCount);
+    CopyAttributesFrom(source, 0, 0);
+}
+
+// The layout of a blob created by ROW::Pack(). It's followed by:
+// * attrRuns-many til::rle_pair<uint16_t, uint16_t>, which are IDs into the ROW's TextAttributeTable
+// * if PackedRowLocalAttributes is set: attrRuns-many TextAttribute, which the runs index into instead
+// * chars-many wchar_t, which is the text of the columns [0, measured)
+// * if PackedRowHasOffsets is set: measured-many uint16_t, which are _charOffsets[0, measured)
+// The columns [measured, columns) are implied to be whitespace, which is why a mostly
+// empty row packs into just a few dozen bytes, no matter how wide the row is.
+struct PackedRowHeader
+{
+    uint16_t columns;
+    uint16_t measured;
+    uint16_t chars;
+    uint16_t attrRuns;
+    LineRendition lineRendition;
+    uint8_t flags;
+};
+
+static constexpr uint8_t PackedRowWrapForced = 0x01;
+static constexpr uint8_t PackedRowDoubleBytePadded = 0x02;
+static constexpr uint8_t PackedRowHasOffsets = 0x04;
+static constexpr uint8_t PackedRowLocalAttributes = 0x08;
+
+using PackedAttrRun = til::rle_pair<uint16_t, uint16_t>;
+static_assert(std::is_trivially_copyable_v<PackedRowHeader>);
+static_assert(std::is_trivially_copyable_v<PackedAttrRun>);
+static_assert(std::is_trivially_copyable_v<TextAttribute>);
+
+// Serializes the ROW into a compact blob that Unpack() can restore it from. Unlike the ROW itself, the blob
+// doesn't store trailing whitespace and omits _charOffsets if it's the trivial 1 wchar_t per column mapping.
+// The attribute runs are stored as IDs into the ROW's TextAttributeTable and the blob holds a reference
+// to each of them until it's passed to ReleasePacked(). If the ROW stores its attributes locally, so does the blob.
+void ROW::Pack(std::vector<std::byte>& out) const
+{
+    const auto text = GetText();
+    auto it = text.end();
+    for (; it != text.begin() && til::at(it, -1) == L' '; --it)
+    {
+    }
+
+    // Trailing whitespace is always 1 column per wchar_t, which allows us to compute the column
+    // at which the trailing whitespace starts just like MeasureRight() does (minus its _wrapForced check).
+    const auto trailing = gsl::narrow_cast<uint16_t>(text.end() - it);
+    const auto measured = gsl::narrow_cast<uint16_t>(_columnCount - trailing);
+    const auto chars = gsl::narrow_cast<uint16_t>(text.size() - trailing);
+
+    auto hasOffsets = chars != measured;
+    for (uint16_t col = 0; !hasOffsets && col < measured; ++col)
+    {
+        hasOffsets = _charOffsets[col] != col;
+    }
+
+    const auto& runs = _attr.runs();
+    const auto local = !_localAttributes.empty();
+    const PackedRowHeader header{
+        .columns = _columnCount,
+        .measured = measured,
+        .chars = chars,
+        .attrRuns = gsl::narrow_cast<uint16_t>(runs.size()),
+        .lineRendition = _lineRendition,
+        .flags = gsl::narrow_cast<uint8_t>((_wrapForced ? PackedRowWrapForced : 0) |
+                                           (_doubleBytePadded ? PackedRowDoubleBytePadded : 0) |
+                                           (hasOffsets ? PackedRowHasOffsets : 0) |
+                                           (local ? PackedRowLocalAttributes : 0)),
+    };
+
+    const auto runsBytes = runs.size() * sizeof(PackedAttrRun);
+    const auto localBytes = local ? runs.size() * sizeof(TextAttribute) : 0;
+    const auto charsBytes = chars * sizeof(wchar_t);
+    const auto offsetsBytes = hasOffsets ? measured * sizeof(uint16_t) : 0;
+    out.resize(sizeof(header) + runsBytes + localBytes + charsBytes + offsetsBytes);
+
+    auto dst = out.data();
+    memcpy(dst, &header, sizeof(header));
+    dst += sizeof(header);
+    if (local)
+    {
+        // The blob only stores the attributes that are in use, one per run, in the order of the runs.
+        auto dstAttrs = dst + runsBytes;
+        for (size_t i = 0; i < runs.size(); ++i)
+        {
+            const PackedAttrRun packed{ gsl::narrow_cast<uint16_t>(i), runs[i].length };
+            memcpy(dst, &packed, sizeof(packed));
+            dst += sizeof(packed);
+            memcpy(dstAttrs, &til::at(_localAttributes, runs[i].value), sizeof(TextAttribute));
+            dstAttrs += sizeof(TextAttribute);
+        }
+        dst = dstAttrs;
+    }
+    else
+    {
+        memcpy(dst, runs.data(), runsBytes);
+        dst += runsBytes;
+    }
+    memcpy(dst, _chars.data(), charsBytes);
+    dst += charsBytes;
+    memcpy(dst, _charOffsets.data(), offsetsBytes);
+
+    if (!local)
+    {
+        for (const auto& run : runs)
+        {
+            _attributes->Acquire(run.value);
+        }
+    }
+}
+
+// Restores the contents of a ROW from a blob created by Pack(). The ROW must have the same width and TextAttributeTable
+// as the one the blob was created from. Any previous contents of this ROW are discarded. The blob keeps its references.
+void ROW::Unpack(std::span<const std::byte> data)
+{
+    PackedRowHeader header{};
+    THROW_HR_IF(E_INVALIDARG, data.size() < sizeof(header));
+    memcpy(&header, data.data(), sizeof(header));
+
+    const auto hasOffsets = WI_IsFlagSet(header.flags, PackedRowHasOffsets);
+    const auto local = WI_IsFlagSet(header.flags, PackedRowLocalAttributes);
+    const auto runsBytes = header.attrRuns * sizeof(PackedAttrRun);
+    const auto localBytes = local ? header.attrRuns * sizeof(TextAttribute) : 0;
+    const auto charsBytes = header.chars * sizeof(wchar_t);
+    const auto offsetsBytes = hasOffsets ? header.measured * sizeof(uint16_t) : 0;
+    THROW_HR_IF(E_INVALIDARG, header.columns != _columnCount || header.measured > _columnCount || header.attrRuns == 0);
+    THROW_HR_IF(E_INVALIDARG, data.size() != sizeof(header) + runsBytes + localBytes + charsBytes + offsetsBytes);
+
+    auto src = data.data() + sizeof(header);
+
+    decltype(_attr)::container runs;
+    runs.resize(header.attrRuns);
+    memcpy(runs.data(), src, runsBytes);
+    src += runsBytes;
+
+    std::vector<TextAttribute> localAttributes;
+    if (local)
+    {
+        for (const auto& run : runs)
+        {
+            THROW_HR_IF(E_INVALIDARG, run.value >= header.attrRuns);
+        }
+        localAttributes.resize(header.attrRuns);
+        memcpy(localAttributes.data(), src, localBytes);
+        src += localBytes;
+    }
+
+    decltype(_attr) attr{ std::move(runs) };
+    THROW_HR_IF(E_INVALIDARG, attr.size() != _columnCount);
+
+    const size_t trailing = _columnCount - header.measured;
+    const size_t length = header.chars + trailing;
+    THROW_HR_IF(E_INVALIDARG, length > UINT16_MAX);
+
+    // The only allocation we might need is for the text. Do it before modifying any members,
+    // so that we don't end up with a half-restored ROW if it throws.
+    std::unique_ptr<wchar_t[]> charsHeap;
+    if (length > _columnCount)
+    {
+        charsHeap = std::make_unique_for_overwrite<wchar_t[]>(length);
+    }
+
+    if (!local)
+    {
+        for (const auto& run : attr.runs())
+        {
+            _attributes->Acquire(run.value);
+        }
+    }
+    _releaseAttributes();
+    _attr = std::move(attr);
+    _localAttributes = std::move(localAttributes);
+    _charsHeap = std::move(charsHeap);
+    _chars = _charsHeap ? std::span{ _charsHeap.get(), length } : std::span{ _charsBuffer, _columnCount };
+    _lineRendition = header.lineRendition;
+    _wrapForced = WI_IsFlagSet(header.flags, PackedRowWrapForced);
+    _doubleBytePadded = WI_IsFlagSet(header.flags, PackedRowDoubleBytePadded);
+
+    memcpy(_chars.data(), src, charsBytes);
+    src += charsBytes;
+    std::fill_n(_chars.data() + header.chars, trailing, L' ');
+
+    if (hasOffsets)
+    {
+        memcpy(_charOffsets.data(), src, offsetsBytes);
+    }
+    else
+    {
+        std::iota(_charOffsets.data(), _charOffsets.data() + header.measured, uint16_t{ 0 });
+    }
+    std::iota(_charOffsets.data() + header.measured, _charOffsets.data() + _columnCount + 1, header.chars);
+}
+
+// Releases the TextAttributeTable references held by a blob that Pack() created. The blob must not be unpacked afterwards.
+void ROW::ReleasePacked(std::span<const std::byte> data, TextAttributeTable& attributes) noexcept
+{
+    PackedRowHeader header{};
+    if (data.size() < sizeof(header))
+    {
+        return;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+
+    // Local attributes don't hold any references.
+    if (WI_IsFlagSet(header.flags, PackedRowLocalAttributes) ||
+        data.size() < sizeof(header) + header.attrRuns * sizeof(PackedAttrRun))
+    {
+        return;
+    }
+
+    auto src = data.data() + sizeof(header);
+    for (uint16_t i = 0; i < header.attrRuns; ++i)
+    {
+        PackedAttrRun packed{};
+        memcpy(&packed, src, sizeof(packed));
+        src += sizeof(packed);
+        attributes.Release(packed.value);
+    }
+}
+
+// Returns true if the blob that Pack() created unpacks into a row that's indistinguishable from
+// a freshly reset one with the given attribute ID. Only the header and the first run are read.
+bool ROW::IsPackedBlank(std::span<const std::byte> data, uint16_t fillId) noexcept
+{
+    PackedRowHeader header{};
+    PackedAttrRun run{};
+    if (data.size() < sizeof(header) + sizeof(run))
+    {
+        return false;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    memcpy(&run, data.data() + sizeof(header), sizeof(run));
+
+    return header.measured == 0 &&
+           header.chars == 0 &&
+           header.attrRuns == 1 &&
+           run.value == fillId &&
+           header.lineRendition == LineRendition::SingleWidth &&
+           header.flags == 0;
 }
 
 // Returns the previous possible cursor position, preceding the given column.
@@ -453,7 +1013,7 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const til::CoordType c
             {
                 // Otherwise, commit this color into the run and save off the new one.
                 // Now commit the new color runs into the attr row.
-                _attr.replace(colorStarts, currentIndex, currentColor);
+                _replaceAttributes(colorStarts, currentIndex, _intern(currentColor));
                 currentColor = it->TextAttr();
                 colorUses = 1;
                 colorStarts = currentIndex;
@@ -533,7 +1093,7 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const til::CoordType c
     // Now commit the final color into the attr row
     if (colorUses)
     {
-        _attr.replace(colorStarts, currentIndex, currentColor);
+        _replaceAttributes(colorStarts, currentIndex, _intern(currentColor));
     }
 
     return it;
@@ -541,12 +1101,150 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const til::CoordType c
 
 void ROW::SetAttrToEnd(const til::CoordType columnBegin, const TextAttribute attr)
 {
-    _attr.replace(_clampedColumnInclusive(columnBegin), _attr.size(), attr);
+    _replaceAttributes(_clampedColumnInclusive(columnBegin), _columnCount, _intern(attr));
 }
 
 void ROW::ReplaceAttributes(const til::CoordType beginIndex, const til::CoordType endIndex, const TextAttribute& newAttr)
 {
-    _attr.replace(_clampedColumnInclusive(beginIndex), _clampedColumnInclusive(endIndex), newAttr);
+    _replaceAttributes(_clampedColumnInclusive(beginIndex), _clampedColumnInclusive(endIndex), _intern(newAttr));
+}
+
+// Returns _localAttributes for RowAttrIterator and RowRenderView, or nullptr if the ROW doesn't store its attributes locally.
+const TextAttribute* ROW::_localAttributesData() const noexcept
+{
+    return _localAttributes.empty() ? nullptr : _localAttributes.data();
+}
+
+const TextAttribute& ROW::_getAttribute(uint16_t attributeId) const noexcept
+{
+    return _localAttributes.empty() ? _attributes->Get(attributeId) : til::at(_localAttributes, attributeId);
+}
+
+// Returns an ID for the given attribute, which holds a reference like the ones TextAttributeTable::Intern() returns.
+// If the table is full, the ROW stores its attributes locally from then on, instead of losing them.
+uint16_t ROW::_intern(const TextAttribute& attr)
+{
+    if (_localAttributes.empty())
+    {
+        if (const auto id = _attributes->Intern(attr); id != TextAttributeTable::InvalidId)
+        {
+            return id;
+        }
+        _storeAttributesLocally();
+    }
+
+    if (_localAttributes.back() == attr)
+    {
+        return gsl::narrow_cast<uint16_t>(_localAttributes.size() - 1);
+    }
+    // Overwritten attributes aren't removed from _localAttributes right away. Drop them
+    // once they make up at least half of it. There's at most 1 entry per run otherwise.
+    if (_localAttributes.size() >= 2u * _columnCount)
+    {
+        _storeAttributesLocally();
+    }
+    _localAttributes.emplace_back(attr);
+    return gsl::narrow<uint16_t>(_localAttributes.size() - 1);
+}
+
+// Moves the attributes of this ROW from the table into _localAttributes, one entry per run.
+// If they're already stored locally, this drops the entries that no run refers to anymore.
+void ROW::_storeAttributesLocally()
+{
+    std::vector<TextAttribute> local;
+    local.reserve(_attr.runs().size() + 1);
+    auto attr = _attr;
+    for (auto& run : attr.runs())
+    {
+        local.emplace_back(_getAttribute(run.value));
+        run.value = gsl::narrow_cast<uint16_t>(local.size() - 1);
+    }
+
+    _releaseAttributes();
+    _attr = std::move(attr);
+    _localAttributes = std::move(local);
+}
+
+void ROW::_acquireAttribute(uint16_t attributeId) const noexcept
+{
+    if (_localAttributes.empty())
+    {
+        _attributes->Acquire(attributeId);
+    }
+}
+
+void ROW::_releaseAttribute(uint16_t attributeId) const noexcept
+{
+    if (_localAttributes.empty())
+    {
+        _attributes->Release(attributeId);
+    }
+}
+
+// Calls func with the ID of each attribute run that overlaps the columns [columnBegin, columnEnd).
+template<typename Func>
+void ROW::_forEachAttributeId(uint16_t columnBegin, uint16_t columnEnd, Func func) const
+{
+    uint16_t runBegin = 0;
+    for (const auto& run : _attr.runs())
+    {
+        if (runBegin >= columnEnd)
+        {
+            break;
+        }
+        const auto runEnd = gsl::narrow_cast<uint16_t>(runBegin + run.length);
+        if (runEnd > columnBegin)
+        {
+            func(run.value);
+        }
+        runBegin = runEnd;
+    }
+}
+
+// Replaces the attributes of the columns [columnBegin, columnEnd) with the given ID and consumes the caller's reference to it.
+// The replacement can only affect runs that overlap [columnBegin - 1, columnEnd + 1), because it merges with
+// its neighbors at most. Only their references are released and acquired again, instead of the entire row's.
+void ROW::_replaceAttributes(uint16_t columnBegin, uint16_t columnEnd, uint16_t attributeId)
+{
+    const auto releaseId = wil::scope_exit([&]() noexcept {
+        _releaseAttribute(attributeId);
+    });
+
+    if (columnBegin == columnEnd)
+    {
+        return;
+    }
+
+    const auto windowBegin = gsl::narrow_cast<uint16_t>(columnBegin ? columnBegin - 1 : 0);
+    const auto windowEnd = columnEnd < _columnCount ? gsl::narrow_cast<uint16_t>(columnEnd + 1) : columnEnd;
+    til::small_vector<uint16_t, 8> previous;
+    _forEachAttributeId(windowBegin, windowEnd, [&](uint16_t id) {
+        previous.emplace_back(id);
+    });
+
+    _attr.replace(columnBegin, columnEnd, attributeId);
+
+    _forEachAttributeId(windowBegin, windowEnd, [&](uint16_t id) noexcept {
+        _acquireAttribute(id);
+    });
+    for (const auto id : previous)
+    {
+        _releaseAttribute(id);
+    }
+}
+
+// Releases the references of all attribute runs, without modifying them. Unless the ROW
+// is being destroyed, the caller has to replace the contents of _attr afterwards.
+void ROW::_releaseAttributes() noexcept
+{
+    if (!_attributes || !_localAttributes.empty())
+    {
+        return;
+    }
+    for (const auto& run : _attr.runs())
+    {
+        _attributes->Release(run.value);
+    }
 }
 
 [[msvc::forceinline]] ROW::WriteHelper::WriteHelper(ROW& row, til::CoordType columnBegin, til::CoordType columnLimit, const std::wstring_view& chars) noexcept :
@@ -674,6 +1372,28 @@ catch (...)
 
     while (it != end)
     {
+        // Non-ASCII text often consists of long runs of characters that are known to be narrow, for instance
+        // box drawing characters in TUIs or text written in non-CJK scripts. We can write them out in bulk
+        // without asking CodepointWidthDetector about every single one of them. The check on the first
+        // character avoids running the vectorized scan for text that's predominantly wide (like CJK).
+        if (isKnownNarrow(*it))
+        {
+            const auto available = std::min<size_t>(end - it, colLimit - colEnd);
+            const auto narrow = countKnownNarrow(&*it, available);
+
+            iota_n(row._charOffsets.data() + colEnd, narrow, gsl::narrow_cast<uint16_t>(ch));
+            colEnd = gsl::narrow_cast<uint16_t>(colEnd + narrow);
+            ch += narrow;
+            it += narrow;
+
+            // If the row is full, but there's text left, we fall through
+            // to the code below, which handles the early exit for us.
+            if (it == end)
+            {
+                break;
+            }
+        }
+
         unsigned int width = 1;
         auto ptr = &*it;
         const auto wch = *ptr;
@@ -779,6 +1499,49 @@ catch (...)
     throw;
 }
 
+// Computes the same state.columnEnd and state.sourceColumnEnd that CopyTextFrom() would, if it was called on a `columnCount`
+// wide ROW that doesn't contain a wide glyph at state.columnBegin (for instance a freshly reset one), without copying anything.
+// This allows TextBuffer::Reflow() to compute the layout of the new buffer up front, which is then filled in parallel.
+void ROW::MeasureCopyTextFrom(RowCopyTextFromState& state, til::CoordType columnCount) noexcept
+{
+    const auto& source = state.source;
+    const auto sourceColBeg = source._clampedColumnInclusive(state.sourceColumnBegin);
+    const auto sourceColLimit = source._clampedColumnInclusive(state.sourceColumnLimit);
+    const auto colBeg = clamp(state.columnBegin, 0, columnCount);
+    const auto colLimit = clamp(state.columnLimit, 0, columnCount);
+
+    state.columnEnd = colBeg;
+    state.columnBeginDirty = colBeg;
+    state.columnEndDirty = colBeg;
+    state.sourceColumnEnd = source._columnCount;
+
+    // These are the same early returns as in CopyTextFrom().
+    if (sourceColBeg >= sourceColLimit || colBeg >= colLimit)
+    {
+        return;
+    }
+
+    const auto charOffsets = source._charOffsets.subspan(sourceColBeg, static_cast<size_t>(sourceColLimit) - sourceColBeg + 1);
+    const auto chBeg = charOffsets.front() & CharOffsetsMask;
+    const auto chEnd = charOffsets.back() & CharOffsetsMask;
+    if (chBeg == chEnd || WI_IsFlagSet(charOffsets.front(), CharOffsetsTrailer))
+    {
+        return;
+    }
+
+    // This is the same as WriteHelper::CopyTextFrom().
+    const auto colEndDirtyInput = std::min(gsl::narrow_cast<size_t>(colLimit - colBeg), charOffsets.size() - 1);
+    auto colEndInput = colEndDirtyInput;
+    for (; WI_IsFlagSet(til::at(charOffsets, colEndInput), CharOffsetsTrailer); --colEndInput)
+    {
+    }
+
+    const auto consumedAll = til::at(charOffsets, colEndInput) == chEnd;
+    state.columnEnd = consumedAll ? colBeg + gsl::narrow_cast<til::CoordType>(colEndInput) : colLimit;
+    state.columnEndDirty = colBeg + gsl::narrow_cast<til::CoordType>(colEndDirtyInput);
+    state.sourceColumnEnd = sourceColBeg + gsl::narrow_cast<til::CoordType>(colEndInput);
+}
+
 [[msvc::forceinline]] void ROW::WriteHelper::CopyTextFrom(const std::span<const uint16_t>& charOffsets) noexcept
 {
     // Since our `charOffsets` input is already in columns (just like the `ROW::_charOffsets`),
@@ -906,19 +1669,22 @@ void ROW::_resizeChars(uint16_t colEndDirty, uint16_t chBegDirty, size_t chEndDi
     }
 }
 
-til::small_rle<TextAttribute, uint16_t, 1>& ROW::Attributes() noexcept
+// Returns the attribute runs of this ROW as IDs into its TextAttributeTable.
+// If HasLocalAttributes() is true, they're indices into the ROW's own attributes instead.
+const til::small_rle<uint16_t, uint16_t, 1>& ROW::AttributeIds() const noexcept
 {
     return _attr;
 }
 
-const til::small_rle<TextAttribute, uint16_t, 1>& ROW::Attributes() const noexcept
+// Returns true if the TextAttributeTable was full when this ROW needed a new ID and it stores its attributes itself.
+bool ROW::HasLocalAttributes() const noexcept
 {
-    return _attr;
+    return !_localAttributes.empty();
 }
 
 TextAttribute ROW::GetAttrByColumn(const til::CoordType column) const
 {
-    return _attr.at(_clampedUint16(column));
+    return _getAttribute(_attr.at(_clampedUint16(column)));
 }
 
 std::vector<uint16_t> ROW::GetHyperlinks() const
@@ -926,9 +1692,10 @@ std::vector<uint16_t> ROW::GetHyperlinks() const
     std::vector<uint16_t> ids;
     for (const auto& run : _attr.runs())
     {
-        if (run.value.IsHyperlink())
+        const auto& attr = _getAttribute(run.value);
+        if (attr.IsHyperlink())
         {
-            ids.emplace_back(run.value.GetHyperlinkId());
+            ids.emplace_back(attr.GetHyperlinkId());
         }
     }
     return ids;
@@ -1064,12 +1831,12 @@ std::wstring_view ROW::GetText(til::CoordType columnBegin, til::CoordType column
 
 til::CoordType ROW::GetLeadingColumnAtCharOffset(const ptrdiff_t offset) const noexcept
 {
-    return _createCharToColumnMapper(offset).GetLeadingColumnAt(offset);
+    return CreateCharToColumnMapper(offset).GetLeadingColumnAt(offset);
 }
 
 til::CoordType ROW::GetTrailingColumnAtCharOffset(const ptrdiff_t offset) const noexcept
 {
-    return _createCharToColumnMapper(offset).GetTrailingColumnAt(offset);
+    return CreateCharToColumnMapper(offset).GetTrailingColumnAt(offset);
 }
 
 DelimiterClass ROW::DelimiterClassAt(til::CoordType column, const std::wstring_view& wordDelimiters) const noexcept
@@ -1163,7 +1930,7 @@ T ROW::_adjustForward(T column) const noexcept
 
 // Creates a CharToColumnMapper given an offset into _chars.data().
 // In other words, for a 120 column ROW with just ASCII text, the offset should be [0,120).
-CharToColumnMapper ROW::_createCharToColumnMapper(ptrdiff_t offset) const noexcept
+CharToColumnMapper ROW::CreateCharToColumnMapper(ptrdiff_t offset) const noexcept
 {
     const auto charsSize = _charSize();
     const auto lastChar = gsl::narrow_cast<ptrdiff_t>(charsSize - 1);
@@ -1172,3 +1939,9 @@ CharToColumnMapper ROW::_createCharToColumnMapper(ptrdiff_t offset) const noexce
     const auto guessedColumn = gsl::narrow_cast<til::CoordType>(clamp(offset, 0, _columnCount));
     return CharToColumnMapper{ _chars.data(), _charOffsets.data(), lastChar, guessedColumn };
 }
+
+RowRenderView ROW::CreateRenderView() const noexcept
+{
+    const auto& runs = _attr.runs();
+    return RowRenderView{ _chars.data(), _charOffsets.data(), { runs.data(), runs.size() }, _attributes, _localAttributesData(), _columnCount };
+}
@@ -8,6 +8,7 @@
 #include "LineRendition.hpp"
 #include "OutputCell.hpp"
 #include "OutputCellIterator.hpp"
+#include "TextAttributeTable.hpp"
 
 class ROW;
 class TextBuffer;
@@ -87,6 +88,105 @@ private:
     til::CoordType _currentColumn;
 };
 
+// A read-only view of a ROW for the renderer. It exposes the ROW's text, its column map (_charOffsets)
+// and its attribute runs directly, so that a row can be walked glyph by glyph without
+// TextBufferCellIterator, which constructs an OutputCellView for every single cell.
+struct RowRenderView
+{
+    RowRenderView(const wchar_t* chars, const uint16_t* charOffsets, std::span<const til::rle_pair<uint16_t, uint16_t>> attrRuns, const TextAttributeTable* attributes, const TextAttribute* localAttributes, til::CoordType columnCount) noexcept;
+
+    til::CoordType ColumnCount() const noexcept;
+    bool IsTrailer(til::CoordType column) const noexcept;
+    std::wstring_view GlyphAt(til::CoordType column, til::CoordType& columnEnd) const noexcept;
+    const TextAttribute& AttrAt(til::CoordType column) noexcept;
+
+private:
+    // See ROW and its members with identical name.
+    static constexpr uint16_t CharOffsetsTrailer = 0x8000;
+    static constexpr uint16_t CharOffsetsMask = 0x7fff;
+
+    const wchar_t* _chars;
+    const uint16_t* _charOffsets;
+    std::span<const til::rle_pair<uint16_t, uint16_t>> _attrRuns;
+    const TextAttributeTable* _attributes;
+    const TextAttribute* _localAttributes;
+    til::CoordType _columnCount;
+    // The attribute run AttrAt() last returned and the columns it spans.
+    size_t _attrRun = 0;
+    til::CoordType _attrRunBeg = 0;
+    til::CoordType _attrRunEnd = 0;
+};
+
+// Iterates over the attributes of a ROW column by column. ROWs store their attributes as IDs
+// into a TextAttributeTable, or as indices into their own attributes once the table is full.
+// This resolves them just like ROW::GetAttrByColumn().
+class RowAttrIterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = TextAttribute;
+    using difference_type = ptrdiff_t;
+    using pointer = const TextAttribute*;
+    using reference = const TextAttribute&;
+
+    RowAttrIterator(til::small_rle<uint16_t, uint16_t, 1>::const_iterator it, const TextAttributeTable* attributes, const TextAttribute* localAttributes) noexcept :
+        _it{ it },
+        _attributes{ attributes },
+        _localAttributes{ localAttributes }
+    {
+    }
+
+    reference operator*() const noexcept
+    {
+        return _localAttributes ? _localAttributes[*_it] : _attributes->Get(*_it);
+    }
+
+    pointer operator->() const noexcept
+    {
+        return &operator*();
+    }
+
+    RowAttrIterator& operator++() noexcept
+    {
+        ++_it;
+        return *this;
+    }
+
+    RowAttrIterator operator++(int) noexcept
+    {
+        auto tmp = *this;
+        ++_it;
+        return tmp;
+    }
+
+    RowAttrIterator& operator+=(difference_type offset) noexcept
+    {
+        _it += offset;
+        return *this;
+    }
+
+    RowAttrIterator operator+(difference_type offset) const noexcept
+    {
+        auto tmp = *this;
+        return tmp += offset;
+    }
+
+    bool operator==(const RowAttrIterator& other) const noexcept
+    {
+        return _it == other._it;
+    }
+
+    bool operator!=(const RowAttrIterator& other) const noexcept
+    {
+        return _it != other._it;
+    }
+
+private:
+    til::small_rle<uint16_t, uint16_t, 1>::const_iterator _it;
+    const TextAttributeTable* _attributes;
+    const TextAttribute* _localAttributes;
+};
+
 class ROW final
 {
 public:
@@ -114,13 +214,15 @@ public:
     }
 
     ROW() = default;
-    ROW(wchar_t* charsBuffer, uint16_t* charOffsetsBuffer, uint16_t rowWidth, const TextAttribute& fillAttribute);
+    ROW(wchar_t* charsBuffer, uint16_t* charOffsetsBuffer, uint16_t rowWidth, TextAttributeTable& attributes, uint16_t fillAttributeId) noexcept;
+    ~ROW();
 
+    // Each attribute run holds a reference into the TextAttributeTable. ROWs are constructed
+    // in place in the TextBuffer's memory arena and never need to be copied or moved.
     ROW(const ROW& other) = delete;
     ROW& operator=(const ROW& other) = delete;
-
-    ROW(ROW&& other) = default;
-    ROW& operator=(ROW&& other) = default;
+    ROW(ROW&& other) = delete;
+    ROW& operator=(ROW&& other) = delete;
 
     void SetWrapForced(const bool wrap) noexcept;
     bool WasWrapForced() const noexcept;
@@ -131,8 +233,13 @@ public:
     til::CoordType GetReadableColumnCount() const noexcept;
 
     void Reset(const TextAttribute& attr) noexcept;
-    void TransferAttributes(const til::small_rle<TextAttribute, uint16_t, 1>& attr, til::CoordType newWidth);
+    void ResetWithAttributeId(uint16_t attributeId) noexcept;
+    void CopyAttributesFrom(const ROW& source, til::CoordType sourceColumnBegin, til::CoordType columnBegin);
     void CopyFrom(const ROW& source);
+    void Pack(std::vector<std::byte>& out) const;
+    void Unpack(std::span<const std::byte> data);
+    static void ReleasePacked(std::span<const std::byte> data, TextAttributeTable& attributes) noexcept;
+    static bool IsPackedBlank(std::span<const std::byte> data, uint16_t fillId) noexcept;
 
     til::CoordType NavigateToPrevious(til::CoordType column) const noexcept;
     til::CoordType NavigateToNext(til::CoordType column) const noexcept;
@@ -145,9 +252,10 @@ public:
     void ReplaceCharacters(til::CoordType columnBegin, til::CoordType width, const std::wstring_view& chars);
     void ReplaceText(RowWriteState& state);
     void CopyTextFrom(RowCopyTextFromState& state);
+    static void MeasureCopyTextFrom(RowCopyTextFromState& state, til::CoordType columnCount) noexcept;
 
-    til::small_rle<TextAttribute, uint16_t, 1>& Attributes() noexcept;
-    const til::small_rle<TextAttribute, uint16_t, 1>& Attributes() const noexcept;
+    const til::small_rle<uint16_t, uint16_t, 1>& AttributeIds() const noexcept;
+    bool HasLocalAttributes() const noexcept;
     TextAttribute GetAttrByColumn(til::CoordType column) const;
     std::vector<uint16_t> GetHyperlinks() const;
     uint16_t size() const noexcept;
@@ -160,10 +268,12 @@ public:
     std::wstring_view GetText(til::CoordType columnBegin, til::CoordType columnEnd) const noexcept;
     til::CoordType GetLeadingColumnAtCharOffset(ptrdiff_t offset) const noexcept;
     til::CoordType GetTrailingColumnAtCharOffset(ptrdiff_t offset) const noexcept;
+    CharToColumnMapper CreateCharToColumnMapper(ptrdiff_t offset) const noexcept;
+    RowRenderView CreateRenderView() const noexcept;
     DelimiterClass DelimiterClassAt(til::CoordType column, const std::wstring_view& wordDelimiters) const noexcept;
 
-    auto AttrBegin() const noexcept { return _attr.begin(); }
-    auto AttrEnd() const noexcept { return _attr.end(); }
+    RowAttrIterator AttrBegin() const noexcept { return { _attr.begin(), _attributes, _localAttributesData() }; }
+    RowAttrIterator AttrEnd() const noexcept { return { _attr.end(), _attributes, _localAttributesData() }; }
 
 #ifdef UNIT_TESTING
     friend constexpr bool operator==(const ROW& a, const ROW& b) noexcept;
@@ -243,8 +353,19 @@ private:
     T _adjustForward(T column) const noexcept;
 
     void _init() noexcept;
+    void _reset(uint16_t attributeId) noexcept;
+    const TextAttribute* _localAttributesData() const noexcept;
+    const TextAttribute& _getAttribute(uint16_t attributeId) const noexcept;
+    uint16_t _intern(const TextAttribute& attr);
+    void _translateAttributes(const ROW& source, til::small_rle<uint16_t, uint16_t, 1>& attr);
+    void _storeAttributesLocally();
+    void _acquireAttribute(uint16_t attributeId) const noexcept;
+    void _releaseAttribute(uint16_t attributeId) const noexcept;
+    void _replaceAttributes(uint16_t columnBegin, uint16_t columnEnd, uint16_t attributeId);
+    template<typename Func>
+    void _forEachAttributeId(uint16_t columnBegin, uint16_t columnEnd, Func func) const;
+    void _releaseAttributes() noexcept;
     void _resizeChars(uint16_t colEndDirty, uint16_t chBegDirty, size_t chEndDirty, uint16_t chEndDirtyOld);
-    CharToColumnMapper _createCharToColumnMapper(ptrdiff_t offset) const noexcept;
 
     // These fields are a bit "wasteful", but it makes all this a bit more robust against
     // programming errors during initial development (which is when this comment was written).
@@ -286,9 +407,16 @@ private:
     // In other words, _charOffsets tells us both the width in chars and width in columns.
     // See CharOffsetsTrailer for more information.
     std::span<uint16_t> _charOffsets;
-    // _attr is a run-length-encoded vector of TextAttribute with a decompressed
+    // _attr is a run-length-encoded vector of TextAttribute IDs with a decompressed
     // length equal to _columnCount (= 1 TextAttribute per column).
-    til::small_rle<TextAttribute, uint16_t, 1> _attr;
+    // Each run holds a reference to its ID in the _attributes table.
+    til::small_rle<uint16_t, uint16_t, 1> _attr;
+    // The table of the TextBuffer this ROW belongs to.
+    TextAttributeTable* _attributes = nullptr;
+    // Empty, unless the _attributes table was full when this ROW needed a new ID. The ROW then stores its
+    // attributes here instead, and _attr holds indices into this vector, which don't hold any references.
+    // This lasts until the next Reset() or Unpack() of a row that didn't store its attributes locally.
+    std::vector<TextAttribute> _localAttributes;
     // The width of the row in visual columns.
     uint16_t _columnCount = 0;
     // Stores double-width/height (DECSWL/DECDWL/DECDHL) attributes.
@@ -0,0 +1,175 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "TextAttributeTable.hpp"
+
+TextAttributeTable::TextAttributeTable()
+{
+    _chunks.emplace_back(std::make_unique<Entry[]>(ChunkSize));
+    _freeIds.reserve(ChunkSize);
+    _count = 2;
+
+    // The table holds the only reference to FallbackId itself, which ensures that it's never collected.
+    auto& fallback = _entry(FallbackId);
+    fallback.refs = 1;
+    _ids.emplace(fallback.attr, FallbackId);
+}
+
+// Returns the ID of the given attribute and acquires a reference to it, which the caller has to Release().
+// If all IDs are referenced even after collecting unreferenced ones, or if we run out of memory, it returns
+// InvalidId instead. This only happens with tens of thousands of distinct attributes in a single buffer.
+uint16_t TextAttributeTable::Intern(const TextAttribute& attr) noexcept
+{
+    return _intern(attr, FillReserve);
+}
+
+// Same as Intern(), but for the fill attributes of a TextBuffer, which its ROWs are constructed and reset with.
+// It may use the IDs that Intern() leaves unused and only returns FallbackId once those are used up as well.
+uint16_t TextAttributeTable::InternFill(const TextAttribute& attr) noexcept
+{
+    if (const auto id = _intern(attr, 0); id != InvalidId)
+    {
+        return id;
+    }
+    Acquire(FallbackId);
+    return FallbackId;
+}
+
+void TextAttributeTable::Acquire(uint16_t id) noexcept
+{
+    assert(id != InvalidId && id < _count);
+    std::atomic_ref<uint32_t>{ _entry(id).refs }.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Decrements the reference count of the given ID. Once it reaches 0, the next Collect() may reuse it for another attribute.
+void TextAttributeTable::Release(uint16_t id) noexcept
+{
+    assert(id != InvalidId && id < _count);
+    [[maybe_unused]] const auto refs = std::atomic_ref<uint32_t>{ _entry(id).refs }.fetch_sub(1, std::memory_order_relaxed);
+    assert(refs != 0 && refs != FreeRefs);
+}
+
+// Frees the IDs without references for reuse. The table gets swept only once enough IDs were added since the
+// last time. Each sweep is preceded by at least as many additions as the table had entries, which makes it O(1)
+// amortized, no matter how often this is called.
+void TextAttributeTable::Collect() noexcept
+{
+    if (_added >= std::max(CollectThreshold, _ids.size()))
+    {
+        _sweep();
+    }
+}
+
+// Returns the number of distinct attributes that are currently referenced, excluding FallbackId's own reference.
+// This walks the entire table and is meant for tests and diagnostics.
+size_t TextAttributeTable::Size() const noexcept
+{
+    size_t size = 0;
+    for (size_t id = FallbackId; id < _count; ++id)
+    {
+        const auto refs = _chunks[id / ChunkSize][id % ChunkSize].refs;
+        size += refs != FreeRefs && refs > (id == FallbackId ? 1u : 0u);
+    }
+    return size;
+}
+
+TextAttributeTable::Entry& TextAttributeTable::_entry(uint16_t id) noexcept
+{
+    return _chunks[id / ChunkSize][id % ChunkSize];
+}
+
+// Implements Intern(). It fails if adding the attribute would leave no more than `reserve` IDs unused.
+uint16_t TextAttributeTable::_intern(const TextAttribute& attr, size_t reserve) noexcept
+{
+    if (_lastId == InvalidId || attr != _lastAttr)
+    {
+        uint16_t id = InvalidId;
+        if (const auto it = _ids.find(attr); it != _ids.end())
+        {
+            id = it->second;
+        }
+        else
+        {
+            try
+            {
+                id = _add(attr, reserve);
+            }
+            CATCH_LOG();
+        }
+        if (id == InvalidId)
+        {
+            return InvalidId;
+        }
+        _lastAttr = attr;
+        _lastId = id;
+    }
+
+    Acquire(_lastId);
+    return _lastId;
+}
+
+// Adds a new entry for the given attribute, which must not be in the table yet, and returns its ID.
+// Returns InvalidId if that would leave no more than `reserve` IDs unused.
+uint16_t TextAttributeTable::_add(const TextAttribute& attr, size_t reserve)
+{
+    if (_freeIds.size() + (IdCount - _count) <= reserve)
+    {
+        _sweep();
+        if (_freeIds.size() + (IdCount - _count) <= reserve)
+        {
+            return InvalidId;
+        }
+    }
+
+    const auto reuse = !_freeIds.empty();
+    const auto id = reuse ? _freeIds.back() : gsl::narrow_cast<uint16_t>(_count);
+
+    // Allocate everything first, so that an exception doesn't leave the table in a half-modified state.
+    if (!reuse && _chunks.size() * ChunkSize <= _count)
+    {
+        _chunks.emplace_back(std::make_unique<Entry[]>(ChunkSize));
+    }
+    if (!reuse && _freeIds.capacity() <= _count)
+    {
+        _freeIds.reserve(_freeIds.capacity() + ChunkSize);
+    }
+    _ids.emplace(attr, id);
+
+    if (reuse)
+    {
+        _freeIds.pop_back();
+    }
+    else
+    {
+        _count++;
+    }
+
+    auto& entry = _entry(id);
+    entry.refs = 0;
+    entry.attr = attr;
+    _added++;
+    return id;
+}
+
+void TextAttributeTable::_sweep() noexcept
+{
+    for (size_t i = FallbackId + 1; i < _count; ++i)
+    {
+        const auto id = gsl::narrow_cast<uint16_t>(i);
+        auto& entry = _entry(id);
+        if (entry.refs == 0)
+        {
+            _ids.erase(entry.attr);
+            entry.refs = FreeRefs;
+            // This can't throw, because _add() ensures that _freeIds has a capacity of at least _count.
+            _freeIds.emplace_back(id);
+        }
+    }
+
+    if (_lastId != InvalidId && _entry(_lastId).refs == FreeRefs)
+    {
+        _lastId = InvalidId;
+    }
+    _added = 0;
+}
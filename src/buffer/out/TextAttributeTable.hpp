@@ -0,0 +1,83 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include "TextAttribute.hpp"
+
+// Maps TextAttributes to 16-bit IDs. Each TextBuffer owns one of these and its ROWs store their attribute runs
+// as IDs into it, which shrinks a run from 18 to 4 bytes and turns merging two runs into an integer compare.
+//
+// Each attribute run of a ROW or of a packed row holds a reference to its ID. Acquire() and Release() are
+// thread-safe, so that TextBuffer::Reflow() can copy rows in parallel. An ID whose last reference was released
+// stays valid, because the same attribute is often written again right away. Collect() frees them for reuse and
+// TextBuffer calls it whenever the scrollback rotates, which is when rows drop most of their references.
+//
+// If all IDs are referenced, Intern() fails and the ROW stores its attributes itself instead. See ROW::_intern().
+class TextAttributeTable
+{
+public:
+    // No valid ID is 0. A default constructed ROW has no attribute runs. Intern() returns it if the table is full.
+    static constexpr uint16_t InvalidId = 0;
+    // The ID of TextAttribute{}, which is never collected. InternFill() returns it if even the reserved IDs are used up.
+    static constexpr uint16_t FallbackId = 1;
+
+    TextAttributeTable();
+
+    uint16_t Intern(const TextAttribute& attr) noexcept;
+    uint16_t InternFill(const TextAttribute& attr) noexcept;
+    void Acquire(uint16_t id) noexcept;
+    void Release(uint16_t id) noexcept;
+    void Collect() noexcept;
+    size_t Size() const noexcept;
+
+    // The returned reference stays valid until the ID got released and collected.
+    const TextAttribute& Get(uint16_t id) const noexcept
+    {
+        assert(id != InvalidId && id < _count);
+        return _chunks[id / ChunkSize][id % ChunkSize].attr;
+    }
+
+private:
+    struct Entry
+    {
+        // Accessed via std::atomic_ref. FreeRefs marks IDs that are in _freeIds.
+        alignas(std::atomic_ref<uint32_t>::required_alignment) uint32_t refs = 0;
+        TextAttribute attr;
+    };
+    struct Hash
+    {
+        size_t operator()(const TextAttribute& attr) const noexcept
+        {
+            return til::hash(attr);
+        }
+    };
+
+    static constexpr uint32_t FreeRefs = UINT32_MAX;
+    // Entries are allocated in chunks, so that references returned by Get() aren't invalidated by Intern().
+    static constexpr size_t ChunkSize = 256;
+    // Collect() only sweeps the table once at least this many IDs were added since the last time.
+    static constexpr size_t CollectThreshold = 1024;
+    // The number of IDs including InvalidId.
+    static constexpr size_t IdCount = size_t{ UINT16_MAX } + 1;
+    // Intern() leaves this many IDs to InternFill(). ROWs can only be constructed with an ID,
+    // which is why the fill attributes of a TextBuffer need to be interned no matter what.
+    static constexpr size_t FillReserve = 64;
+
+    Entry& _entry(uint16_t id) noexcept;
+    uint16_t _intern(const TextAttribute& attr, size_t reserve) noexcept;
+    uint16_t _add(const TextAttribute& attr, size_t reserve);
+    void _sweep() noexcept;
+
+    std::vector<std::unique_ptr<Entry[]>> _chunks;
+    // The number of IDs handed out so far, including InvalidId.
+    size_t _count = 0;
+    // IDs that were swept by Collect(). Its capacity is always at least _count, so that _sweep() can't throw.
+    std::vector<uint16_t> _freeIds;
+    std::unordered_map<TextAttribute, uint16_t, Hash> _ids;
+    // Consecutive writes mostly use the same attributes. This skips the hash map lookup for them.
+    TextAttribute _lastAttr;
+    uint16_t _lastId = InvalidId;
+    // The number of IDs added since the last sweep.
+    size_t _added = 0;
+};
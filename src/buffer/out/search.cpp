@@ -8,29 +8,238 @@
 
 using namespace Microsoft::Console::Types;
 
+// Searches all rows that changed since the last call (or all of them if the search criteria changed) in one go.
+// Returns true if the search criteria changed, in which case the caller should pick a new current match.
 bool Search::ResetIfStale(Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view& needle, bool reverse, bool caseInsensitive)
+{
+    const auto reset = Prepare(renderData, needle, reverse, caseInsensitive);
+    ScanSome(til::CoordTypeMax);
+    return reset;
+}
+
+// Prepares searching for the given needle without actually searching anything yet. Call ScanSome() afterwards.
+// If only the buffer contents changed since the last call, the results are kept and only the rows that changed
+// get searched again. Returns true if the search criteria changed and all previous results were discarded.
+bool Search::Prepare(Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view& needle, bool reverse, bool caseInsensitive)
 {
     const auto& textBuffer = renderData.GetTextBuffer();
-    const auto lastMutationId = textBuffer.GetLastMutationId();
 
-    if (_needle == needle &&
-        _caseInsensitive == caseInsensitive &&
-        _lastMutationId == lastMutationId)
+    _renderData = &renderData;
+    _step = reverse ? -1 : 1;
+
+    if (_needle != needle || _caseInsensitive != caseInsensitive)
+    {
+        _needle = needle;
+        _caseInsensitive = caseInsensitive;
+        _reset(textBuffer);
+        return true;
+    }
+
+    return _refresh(textBuffer);
+}
+
+// Searches up to rowBudget-many rows of those that still need to be searched. The caller must hold the console lock.
+// Returns true if there are rows left to search, in which case this function should be called again later.
+bool Search::ScanSome(til::CoordType rowBudget)
+{
+    if (!_renderData)
     {
-        _step = reverse ? -1 : 1;
         return false;
     }
 
-    _renderData = &renderData;
-    _needle = needle;
-    _caseInsensitive = caseInsensitive;
-    _lastMutationId = lastMutationId;
+    // The buffer may have changed since the last call, for instance if we're called in between chunks of output.
+    const auto& textBuffer = _renderData->GetTextBuffer();
+    _refresh(textBuffer);
 
-    _results = textBuffer.SearchText(needle, caseInsensitive);
-    _index = reverse ? gsl::narrow_cast<ptrdiff_t>(_results.size()) - 1 : 0;
-    _step = reverse ? -1 : 1;
+    while (rowBudget > 0 && !_pendingRows.empty())
+    {
+        auto& range = _pendingRows.front();
+        const auto end = range.end - range.begin > rowBudget ? range.begin + rowBudget : range.end;
+
+        _scanRows(textBuffer, range.begin, end);
+        rowBudget -= end - range.begin;
+        range.begin = end;
+
+        if (range.begin >= range.end)
+        {
+            _pendingRows.erase(_pendingRows.begin());
+        }
+    }
+
+    return !_pendingRows.empty();
+}
+
+bool Search::IsScanning() const noexcept
+{
+    return !_pendingRows.empty();
+}
+
+// Discards all results and marks the entire buffer as needing to be searched.
+void Search::_reset(const TextBuffer& textBuffer)
+{
+    _textBuffer = &textBuffer;
+    _lastMutationId = textBuffer.GetLastMutationId();
+    _firstRowIndex = textBuffer.GetFirstRowIndex();
+    _bufferSize = textBuffer.GetSize().Dimensions();
+    // Case-insensitive matching may turn 1 char into up to 3 (for instance U+FB03 and "ffi") and a row that
+    // consists of wide glyphs stores only 1 char per 2 columns. The +1 accounts for matches starting mid-row.
+    _contextRows = gsl::narrow_cast<til::CoordType>(_needle.size() * 6 / std::max(1, _bufferSize.width)) + 1;
+    _pendingRows.clear();
+    _results.clear();
+    _index = 0;
+    _addPendingRows(0, _bufferSize.height);
+}
+
+// Brings the results up to date with the buffer, without searching any rows yet.
+// Returns true if the buffer got replaced and all previous results were discarded.
+bool Search::_refresh(const TextBuffer& textBuffer)
+{
+    const auto lastMutationId = textBuffer.GetLastMutationId();
+
+    // Every TextBuffer starts with a unique _lastMutationId that is larger than that of any previous TextBuffer.
+    // If the value went backwards, we must be looking at a different one, even if its address is the same.
+    if (_textBuffer != &textBuffer || _bufferSize != textBuffer.GetSize().Dimensions() || lastMutationId < _lastMutationId)
+    {
+        _reset(textBuffer);
+        return true;
+    }
+
+    if (lastMutationId != _lastMutationId)
+    {
+        _invalidateChangedRows(textBuffer);
+    }
+
+    return false;
+}
+
+// Marks all rows as needing to be searched again that changed since _lastMutationId.
+void Search::_invalidateChangedRows(const TextBuffer& textBuffer)
+{
+    const auto height = _bufferSize.height;
+
+    // IncrementCircularBuffer() moves all rows up and the recycled rows at the bottom count as changed.
+    // If `height`-many rows or more scrolled out of the buffer, all rows changed and the modulo doesn't matter.
+    const auto firstRowIndex = textBuffer.GetFirstRowIndex();
+    const auto scrolled = (firstRowIndex - _firstRowIndex + height) % height;
+
+    if (scrolled)
+    {
+        std::optional<til::point> anchor;
+        if (const auto current = GetCurrent())
+        {
+            anchor = current->start.y >= scrolled ? til::point{ current->start.x, current->start.y - scrolled } : til::point{};
+        }
+
+        std::erase_if(_results, [&](const til::point_span& s) { return s.start.y < scrolled; });
+        for (auto& s : _results)
+        {
+            s.start.y -= scrolled;
+            s.end.y -= scrolled;
+        }
+
+        std::erase_if(_pendingRows, [&](const RowRange& r) { return r.end <= scrolled; });
+        for (auto& r : _pendingRows)
+        {
+            r.begin = std::max(0, r.begin - scrolled);
+            r.end -= scrolled;
+        }
+
+        _restoreCurrent(anchor);
+    }
+
+    for (auto y = textBuffer.FindChangedRow(_lastMutationId, 0, height); y < height; y = textBuffer.FindChangedRow(_lastMutationId, y, height))
+    {
+        const auto begin = y;
+        y = textBuffer.FindUnchangedRow(_lastMutationId, y, height);
+
+        // Matches that start up to _contextRows before the changed rows may extend into them and
+        // matches following them may now overlap with a match in the changed rows (or stop to).
+        _addPendingRows(begin - _contextRows, y + _contextRows);
+    }
+
+    _lastMutationId = textBuffer.GetLastMutationId();
+    _firstRowIndex = firstRowIndex;
+}
+
+// Inserts [begin,end) into _pendingRows, while keeping it sorted and merging it with overlapping or adjacent ranges.
+void Search::_addPendingRows(til::CoordType begin, til::CoordType end)
+{
+    begin = std::max(begin, 0);
+    end = std::min(end, _bufferSize.height);
+    if (begin >= end)
+    {
+        return;
+    }
+
+    auto first = std::find_if(_pendingRows.begin(), _pendingRows.end(), [&](const RowRange& r) { return r.end >= begin; });
+    const auto last = std::find_if(first, _pendingRows.end(), [&](const RowRange& r) { return r.begin > end; });
+
+    if (first != last)
+    {
+        begin = std::min(begin, first->begin);
+        end = std::max(end, (last - 1)->end);
+        first = _pendingRows.erase(first, last);
+    }
+
+    _pendingRows.insert(first, RowRange{ begin, end });
+}
+
+// Replaces all results that start in the rows [begin,end) with fresh ones.
+void Search::_scanRows(const TextBuffer& textBuffer, til::CoordType begin, til::CoordType end)
+{
+    std::optional<til::point> anchor;
+    if (const auto current = GetCurrent())
+    {
+        anchor = current->start;
+    }
+
+    // Matches that start in [begin,end) may extend into the rows after it. Those that start
+    // in the rows after it will be (or have been) found when those rows get searched.
+    auto hits = textBuffer.SearchText(_needle, _caseInsensitive, begin, end + _contextRows);
+    std::erase_if(hits, [&](const til::point_span& s) { return s.start.y >= end; });
+
+    const auto startsBefore = [](const til::point_span& s, til::CoordType y) noexcept { return s.start.y < y; };
+    const auto first = std::lower_bound(_results.begin(), _results.end(), begin, startsBefore);
+    const auto last = std::lower_bound(first, _results.end(), end, startsBefore);
+    const auto inserted = _results.insert(_results.erase(first, last), hits.begin(), hits.end());
+
+    // Searching the buffer in one go never yields overlapping matches, because the search
+    // continues after the end of the previous match. We emulate this by letting earlier matches win.
+    const auto overlaps = [&](size_t i) { return til::at(_results, i - 1).end >= til::at(_results, i).start; };
+    auto idx = gsl::narrow_cast<size_t>(inserted - _results.begin());
+    auto cut = idx + hits.size();
+    while (idx > 0 && idx < cut && overlaps(idx))
+    {
+        _results.erase(_results.begin() + idx);
+        --cut;
+    }
+    while (cut > 0 && cut < _results.size() && overlaps(cut))
+    {
+        _results.erase(_results.begin() + cut);
+    }
+
+    _restoreCurrent(anchor);
+}
+
+// Makes the first match at or after the given position the current one.
+// Without an anchor the first (or last if searching backwards) match is made current.
+void Search::_restoreCurrent(const std::optional<til::point>& anchor) noexcept
+{
+    const auto count = gsl::narrow_cast<ptrdiff_t>(_results.size());
+
+    if (anchor)
+    {
+        const auto it = std::lower_bound(_results.begin(), _results.end(), *anchor, [](const til::point_span& s, const til::point& p) noexcept {
+            return s.start < p;
+        });
+        _index = std::min(gsl::narrow_cast<ptrdiff_t>(it - _results.begin()), count - 1);
+    }
+    else
+    {
+        _index = _step < 0 ? count - 1 : 0;
+    }
 
-    return true;
+    _index = std::max<ptrdiff_t>(0, _index);
 }
 
 void Search::MoveToCurrentSelection()
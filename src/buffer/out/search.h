@@ -7,6 +7,8 @@ Module Name:
 
 Abstract:
 - This module is used for searching through the screen for a substring
+- Results are cached and only rows that changed since the last search (see TextBuffer::GetRowGeneration)
+  are searched again. Large buffers can be searched in chunks via Prepare() and ScanSome().
 
 Author(s):
 - Michael Niksa (MiNiksa) 20-Apr-2018
@@ -26,6 +28,9 @@ public:
     Search() = default;
 
     bool ResetIfStale(Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view& needle, bool reverse, bool caseInsensitive);
+    bool Prepare(Microsoft::Console::Render::IRenderData& renderData, const std::wstring_view& needle, bool reverse, bool caseInsensitive);
+    bool ScanSome(til::CoordType rowBudget);
+    bool IsScanning() const noexcept;
 
     void MoveToCurrentSelection();
     void MoveToPoint(til::point anchor) noexcept;
@@ -39,11 +44,38 @@ public:
     ptrdiff_t CurrentMatch() const noexcept;
 
 private:
+    struct RowRange
+    {
+        til::CoordType begin;
+        til::CoordType end;
+    };
+
+    void _reset(const TextBuffer& textBuffer);
+    bool _refresh(const TextBuffer& textBuffer);
+    void _invalidateChangedRows(const TextBuffer& textBuffer);
+    void _addPendingRows(til::CoordType begin, til::CoordType end);
+    void _scanRows(const TextBuffer& textBuffer, til::CoordType begin, til::CoordType end);
+    void _restoreCurrent(const std::optional<til::point>& anchor) noexcept;
+
     // _renderData is a pointer so that Search() is constexpr default constructable.
     Microsoft::Console::Render::IRenderData* _renderData = nullptr;
+    // The buffer _results refer to. It's only used to detect when the buffer
+    // got replaced, for instance when switching to the alternate screen buffer.
+    const TextBuffer* _textBuffer = nullptr;
     std::wstring _needle;
     bool _caseInsensitive = false;
+    // All rows whose TextBuffer::GetRowGeneration() is at most this value are either
+    // correctly represented in _results or listed in _pendingRows.
     uint64_t _lastMutationId = 0;
+    // TextBuffer::GetFirstRowIndex() at the time of _lastMutationId. This allows us
+    // to move _results up when rows got scrolled out via IncrementCircularBuffer().
+    til::CoordType _firstRowIndex = 0;
+    til::size _bufferSize;
+    // Matches may span multiple rows. When a row is searched, this many rows
+    // before and after it need to be searched again, too. See _reset().
+    til::CoordType _contextRows = 0;
+    // Rows that still need to be searched. Sorted and non-overlapping.
+    std::vector<RowRange> _pendingRows;
 
     std::vector<til::point_span> _results;
     ptrdiff_t _index = 0;
@@ -5,6 +5,8 @@
 
 #include "textBuffer.hpp"
 
+#include <execution>
+
 #include <til/hash.h>
 #include <til/unicode.h>
 
@@ -50,6 +52,7 @@ TextBuffer::TextBuffer(til::size screenBufferSize,
                        const bool isActiveBuffer,
                        Microsoft::Console::Render::Renderer& renderer) :
     _renderer{ renderer },
+    _attributes{ std::make_shared<TextAttributeTable>() },
     _currentAttributes{ defaultAttributes },
     // This way every TextBuffer will start with a ""unique"" _lastMutationId
     // and so it'll compare unequal with the counter of other TextBuffers.
@@ -69,6 +72,16 @@ TextBuffer::~TextBuffer()
     {
         _destroy();
     }
+
+    // The table may outlive us, because it's shared with the buffers created by Reflow().
+    for (size_t index = 0; index < _cold.rows.size(); ++index)
+    {
+        _releaseColdRow(index);
+    }
+    if (_initialAttributesId != TextAttributeTable::InvalidId)
+    {
+        _attributes->Release(_initialAttributesId);
+    }
 }
 
 // I put these functions in a block at the start of the class, because they're the most
@@ -79,6 +92,16 @@ TextBuffer::~TextBuffer()
 #pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
 #pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
 
+static uintptr_t getPageSize() noexcept
+{
+    static const auto pageSize = [] {
+        SYSTEM_INFO info{};
+        GetSystemInfo(&info);
+        return static_cast<uintptr_t>(info.dwPageSize);
+    }();
+    return pageSize;
+}
+
 // MEM_RESERVEs memory sufficient to store height-many ROW structs,
 // as well as their ROW::_chars and ROW::_charOffsets buffers.
 //
@@ -110,12 +133,48 @@ void TextBuffer::_reserve(til::size screenBufferSize, const TextAttribute& defau
     };
     _bufferEnd = _buffer.get() + allocSize;
     _commitWatermark = _buffer.get();
-    _initialAttributes = defaultAttributes;
+    _prefaultWatermark = _buffer.get();
+    _setInitialAttributes(defaultAttributes);
     _bufferRowStride = rowStride;
     _bufferOffsetChars = rowSize;
     _bufferOffsetCharOffsets = rowSize + charsBufferSize;
     _width = w;
     _height = h;
+    _rowMap.resize(h);
+    _resetRowMap();
+    // Since _lastMutationId starts out unique for each TextBuffer, this ensures that
+    // users of GetRowGeneration() can't confuse our rows with those of another buffer.
+    _rowGenerations.assign(h, _lastMutationId);
+    _rowGenerationBlocks.assign((h + _rowGenerationBlockSize - 1) / _rowGenerationBlockSize, _lastMutationId);
+}
+
+void TextBuffer::_setInitialAttributes(const TextAttribute& attributes) noexcept
+{
+    const auto id = _attributes->InternFill(attributes);
+    if (_initialAttributesId != TextAttributeTable::InvalidId)
+    {
+        _attributes->Release(_initialAttributesId);
+    }
+    _initialAttributes = attributes;
+    _initialAttributesId = id;
+}
+
+// Switches this buffer over to the TextAttributeTable of the other one, which allows copying ROWs between
+// the two by copying their attribute IDs, even from multiple threads. See TextAttributeTable.
+// This buffer must still be blank, i.e. none of its ROWs have been constructed yet.
+void TextBuffer::_shareAttributeTable(const TextBuffer& other)
+{
+    if (_attributes == other._attributes)
+    {
+        return;
+    }
+
+    THROW_HR_IF(E_UNEXPECTED, _commitWatermark != _buffer.get() || !_cold.rows.empty() || _pendingReflow.rows);
+
+    const auto id = other._attributes->InternFill(_initialAttributes);
+    _attributes->Release(_initialAttributesId);
+    _attributes = other._attributes;
+    _initialAttributesId = id;
 }
 
 // MEM_COMMITs the memory and constructs all ROWs up to and including the given row pointer.
@@ -131,19 +190,120 @@ __declspec(noinline) void TextBuffer::_commit(const std::byte* row)
     const auto minimum = gsl::narrow_cast<uintptr_t>(rowEnd - _commitWatermark);
     const auto ideal = minimum + _bufferRowStride * _commitReadAheadRowCount;
     const auto size = std::min(remaining, ideal);
+    const auto end = _commitWatermark + size;
+
+    // Accessing the row right at the watermark means that we're scrolling through the buffer. Double the read-ahead.
+    if (row == _commitWatermark)
+    {
+        _commitReadAheadRowCount = std::min(_commitReadAheadRowCount * 2, _commitReadAheadMaxRowCount);
+    }
+
+    _waitForPrefault();
+
+    if (end > _prefaultWatermark)
+    {
+        THROW_LAST_ERROR_IF_NULL(VirtualAlloc(_commitWatermark, size, MEM_COMMIT, PAGE_READWRITE));
+        _commitStatistics.commits++;
+        _commitStatistics.committedBytes += size;
+    }
+
+    _construct(end);
+    _submitPrefault();
+}
+
+// The threadpool callback of SetPrefault(). Commits [beg, end) and touches every page in it,
+// so that the writer thread neither has to call VirtualAlloc nor take the page faults.
+void CALLBACK TextBuffer::_prefaultCallback(PTP_CALLBACK_INSTANCE, PVOID context, PTP_WORK) noexcept
+{
+    const auto pageSize = getPageSize();
+    auto& prefault = *static_cast<Prefault*>(context);
+    const auto size = gsl::narrow_cast<size_t>(prefault.end - prefault.beg);
+    prefault.committed = VirtualAlloc(prefault.beg, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+    if (!prefault.committed)
+    {
+        return;
+    }
+
+    // beg is usually in the middle of a page that contains the last constructed ROW. Only touch memory past it.
+    const auto beg = reinterpret_cast<uintptr_t>(prefault.beg);
+    const auto end = reinterpret_cast<uintptr_t>(prefault.end);
+    for (auto it = beg; it < end; it = (it & ~(pageSize - 1)) + pageSize)
+    {
+        *reinterpret_cast<volatile std::byte*>(it) = std::byte{};
+    }
+}
+
+// Commits the memory after the _commitWatermark in the background, if enabled via SetPrefault().
+void TextBuffer::_submitPrefault() noexcept
+{
+    if (!_prefault || _commitWatermark >= _bufferEnd)
+    {
+        return;
+    }
+
+    const auto remaining = gsl::narrow_cast<uintptr_t>(_bufferEnd - _commitWatermark);
+    const auto size = std::min(remaining, _bufferRowStride * _commitReadAheadRowCount);
+    _prefault->beg = _commitWatermark;
+    _prefault->end = _commitWatermark + size;
+    _prefault->committed = false;
+    _prefault->pending = true;
+    SubmitThreadpoolWork(_prefault->work.get());
+}
 
-    THROW_LAST_ERROR_IF_NULL(VirtualAlloc(_commitWatermark, size, MEM_COMMIT, PAGE_READWRITE));
+// Waits for the callback submitted by _submitPrefault(). This needs to happen before anything
+// accesses the memory past the _commitWatermark or the arena gets swapped or released.
+void TextBuffer::_waitForPrefault() noexcept
+{
+    if (!_prefault || !_prefault->pending)
+    {
+        return;
+    }
 
-    _construct(_commitWatermark + size);
+    WaitForThreadpoolWorkCallbacks(_prefault->work.get(), FALSE);
+    _prefault->pending = false;
+
+    if (_prefault->committed && _prefault->beg == _commitWatermark)
+    {
+        _prefaultWatermark = _prefault->end;
+        _commitStatistics.prefaults++;
+        _commitStatistics.prefaultedBytes += gsl::narrow_cast<size_t>(_prefault->end - _prefault->beg);
+    }
 }
 
 // Destructs and MEM_DECOMMITs all previously constructed ROWs.
 // You can use this (or rather the Reset() method) to fully clear the TextBuffer.
 void TextBuffer::_decommit() noexcept
 {
+    _waitForPrefault();
     _destroy();
     VirtualFree(_buffer.get(), 0, MEM_DECOMMIT);
     _commitWatermark = _buffer.get();
+    _prefaultWatermark = _buffer.get();
+    _commitReadAheadRowCount = _commitReadAheadMinRowCount;
+
+    _markAllRowsChanged();
+    _pendingReflow = {};
+
+    if (_cold.rows.empty())
+    {
+        _resetRowMap();
+    }
+    else
+    {
+        // All rows are blank now and none of them are stored in the arena.
+        std::fill(_rowMap.begin(), _rowMap.end(), uint16_t{ 0 });
+        for (size_t index = 0; index < _cold.rows.size(); ++index)
+        {
+            _releaseColdRow(index);
+        }
+        _cold.thawPool.assign(_coldThawPoolSize, ThawedRow{});
+        _cold.thawPoolNext = 0;
+        _cold.thawPoolEpoch++;
+        _cold.freeSlots.clear();
+        _cold.nextSlot = 1;
+        _cold.frozenRows = 0;
+        _cold.touchedRows = 0;
+    }
 }
 
 // Constructs ROWs up to (excluding) the ROW pointed to by `until`.
@@ -154,7 +314,7 @@ void TextBuffer::_construct(const std::byte* until) noexcept
         const auto row = reinterpret_cast<ROW*>(_commitWatermark);
         const auto chars = reinterpret_cast<wchar_t*>(_commitWatermark + _bufferOffsetChars);
         const auto indices = reinterpret_cast<uint16_t*>(_commitWatermark + _bufferOffsetCharOffsets);
-        std::construct_at(row, chars, indices, _width, _initialAttributes);
+        std::construct_at(row, chars, indices, _width, *_attributes, _initialAttributesId);
     }
 }
 
@@ -185,6 +345,42 @@ ROW& TextBuffer::_getRowByOffsetDirect(size_t offset)
 }
 
 ROW& TextBuffer::_getRow(til::CoordType y) const
+{
+    // We add 1 to the row offset, because row "0" is the one returned by GetScratchpadRow().
+    // _rowMap already contains offsets including this bias.
+#pragma warning(suppress : 26492) // Don't use const_cast to cast away const or volatile (type.3).
+    const auto self = const_cast<TextBuffer*>(this);
+    const auto index = _getRowMapIndex(y);
+    const auto slot = til::at(_rowMap, index);
+    if (slot == 0)
+    {
+        if (_isPendingRow(index))
+        {
+            return self->_reflowPendingRow(index);
+        }
+        return self->_thawRow(index, false);
+    }
+    return self->_getRowByOffsetDirect(slot);
+}
+
+// Same as _getRow(), but moves cold rows back into the memory arena, instead of returning a temporary copy.
+ROW& TextBuffer::_getMutableRow(til::CoordType y)
+{
+    const auto index = _getRowMapIndex(y);
+    const auto slot = til::at(_rowMap, index);
+    if (slot == 0)
+    {
+        if (_isPendingRow(index))
+        {
+            return _reflowPendingRow(index);
+        }
+        return _thawRow(index, true);
+    }
+    return _getRowByOffsetDirect(slot);
+}
+
+// Returns the _rowMap index for the given "user-visible" row index.
+size_t TextBuffer::_getRowMapIndex(til::CoordType y) const noexcept
 {
     // Rows are stored circularly, so the index you ask for is offset by the start position and mod the total of rows.
     auto offset = (_firstRow + y) % _height;
@@ -196,9 +392,243 @@ ROW& TextBuffer::_getRow(til::CoordType y) const
         offset += _height;
     }
 
-    // We add 1 to the row offset, because row "0" is the one returned by GetScratchpadRow().
+    return gsl::narrow_cast<size_t>(offset);
+}
+
+// Restores the identity mapping between circular row offsets and ROWs in the memory arena.
+void TextBuffer::_resetRowMap() noexcept
+{
+#pragma warning(suppress : 26447) // The function is declared 'noexcept' but calls function 'iota<...>()' which may throw exceptions (f.6).
+    std::iota(_rowMap.begin(), _rowMap.end(), uint16_t{ 1 });
+}
+
+// Returns the ROW for a _rowMap entry of 0 that isn't pending a reflow, which only exists while the cold scrollback
+// storage is enabled. If `mutate` is false, a copy of the row is unpacked into the thaw pool, which makes reads cheap and doesn't
+// grow the arena. Otherwise, the row is moved back into the arena, because it would lose the changes otherwise.
+ROW& TextBuffer::_thawRow(size_t index, bool mutate)
+{
+    auto& cold = til::at(_cold.rows, index);
+
+    if (mutate)
+    {
+        auto slot = cold.thawedSlot;
+        if (slot)
+        {
+            // The thaw pool already holds an up-to-date copy. We can just take it.
+            // The ROW stays where it is, which means that pinned references to it remain valid.
+            if (const auto thawed = _findThawedRow(index))
+            {
+                *thawed = {};
+            }
+            cold.thawedSlot = 0;
+        }
+        else
+        {
+            slot = _allocateRowSlot();
+            try
+            {
+                _unpackColdRow(_getRowByOffsetDirect(slot), index);
+            }
+            catch (...)
+            {
+                _cold.freeSlots.emplace_back(slot);
+                throw;
+            }
+        }
+
+        const auto y = gsl::narrow_cast<til::CoordType>((index + _height - gsl::narrow_cast<size_t>(_firstRow)) % _height);
+        _releaseColdRow(index);
+        til::at(_rowMap, index) = slot;
+        _cold.frozenRows = std::min(_cold.frozenRows, y);
+        _cold.touchedRows = std::max(_cold.touchedRows, y + 1);
+        return _getRowByOffsetDirect(slot);
+    }
+
+    if (cold.thawedSlot)
+    {
+        return _getRowByOffsetDirect(cold.thawedSlot);
+    }
+
+    // Evict the oldest entry in the thaw pool that isn't pinned. Its ROW will now hold a copy of this row instead.
+    // If all of them are pinned, the pool grows. This is bounded, because each cold row is only ever thawed once.
+    ThawedRow* victim = nullptr;
+    for (size_t i = 0; i < _cold.thawPool.size() && !victim; ++i)
+    {
+        auto& candidate = til::at(_cold.thawPool, _cold.thawPoolNext);
+        _cold.thawPoolNext = (_cold.thawPoolNext + 1) % _cold.thawPool.size();
+        if (!candidate.pins)
+        {
+            victim = &candidate;
+        }
+    }
+    auto& thawed = victim ? *victim : _cold.thawPool.emplace_back();
+
+    if (thawed.owner != SIZE_MAX)
+    {
+        til::at(_cold.rows, thawed.owner).thawedSlot = 0;
+        thawed.owner = SIZE_MAX;
+    }
+    if (!thawed.slot)
+    {
+        thawed.slot = _allocateRowSlot();
+    }
+
+    auto& row = _getRowByOffsetDirect(thawed.slot);
+    _unpackColdRow(row, index);
+    thawed.owner = index;
+    cold.thawedSlot = thawed.slot;
+    return row;
+}
+
+// Returns the thaw pool entry that holds a copy of the given cold row, or nullptr if there's none.
+TextBuffer::ThawedRow* TextBuffer::_findThawedRow(size_t index) noexcept
+{
+    if (_cold.rows.empty() || !til::at(_cold.rows, index).thawedSlot)
+    {
+        return nullptr;
+    }
+    for (auto& thawed : _cold.thawPool)
+    {
+        if (thawed.owner == index)
+        {
+            return &thawed;
+        }
+    }
+    return nullptr;
+}
+
+TextBuffer::RowPin::RowPin(const TextBuffer& buffer, til::CoordType y)
+{
+    // Only cold rows in the thaw pool can be recycled by reads. See _thawRow().
 #pragma warning(suppress : 26492) // Don't use const_cast to cast away const or volatile (type.3).
-    return const_cast<TextBuffer*>(this)->_getRowByOffsetDirect(gsl::narrow_cast<size_t>(offset) + 1);
+    const auto self = const_cast<TextBuffer*>(&buffer);
+    const auto index = self->_getRowMapIndex(y);
+    if (const auto thawed = self->_findThawedRow(index))
+    {
+        thawed->pins++;
+        _buffer = self;
+        _index = index;
+        _epoch = self->_cold.thawPoolEpoch;
+    }
+}
+
+TextBuffer::RowPin::~RowPin()
+{
+    // If the epoch changed, the thaw pool was flushed along with our pin.
+    if (_buffer && _buffer->_cold.thawPoolEpoch == _epoch)
+    {
+        if (const auto thawed = _buffer->_findThawedRow(_index); thawed && thawed->pins)
+        {
+            thawed->pins--;
+        }
+    }
+}
+
+void TextBuffer::_unpackColdRow(ROW& row, size_t index)
+{
+    const auto& cold = til::at(_cold.rows, index);
+    if (cold.data)
+    {
+        row.Unpack({ cold.data.get(), cold.size });
+    }
+    else
+    {
+        row.ResetWithAttributeId(_initialAttributesId);
+    }
+}
+
+// Discards the packed contents of a cold row and releases its references to interned attributes.
+void TextBuffer::_releaseColdRow(size_t index) noexcept
+{
+    auto& cold = til::at(_cold.rows, index);
+    if (cold.data)
+    {
+        ROW::ReleasePacked({ cold.data.get(), cold.size }, *_attributes);
+    }
+    cold = {};
+}
+
+// Returns the arena offset of an unused ROW. Every row is either stored in the arena, or cold, and only
+// cold rows can be in the thaw pool. As such there are always enough ROWs for this function to succeed.
+uint16_t TextBuffer::_allocateRowSlot()
+{
+    if (!_cold.freeSlots.empty())
+    {
+        const auto slot = _cold.freeSlots.back();
+        _cold.freeSlots.pop_back();
+        return slot;
+    }
+
+    THROW_HR_IF(E_UNEXPECTED, _cold.nextSlot > _height);
+    return _cold.nextSlot++;
+}
+
+// Returns all ROWs in the thaw pool to the free list. This needs to be called before the _rowMap indices
+// of cold rows change, because the thaw pool refers to them by index.
+void TextBuffer::_releaseThawedRows()
+{
+    for (auto& thawed : _cold.thawPool)
+    {
+        if (thawed.owner != SIZE_MAX)
+        {
+            til::at(_cold.rows, thawed.owner).thawedSlot = 0;
+        }
+        if (thawed.slot)
+        {
+            _cold.freeSlots.emplace_back(thawed.slot);
+        }
+        thawed = {};
+    }
+
+    // If RowPins made the pool grow, this is a good opportunity to shrink it back.
+    _cold.thawPool.resize(_coldThawPoolSize);
+    _cold.thawPoolNext = 0;
+    _cold.thawPoolEpoch++;
+}
+
+// Packs all rows that are more than ColdScrollback::distance rows above the given row into the cold storage.
+void TextBuffer::_freezeScrollback(til::CoordType cursorY)
+{
+    if (_cold.distance <= 0)
+    {
+        return;
+    }
+
+    const auto limit = std::min<til::CoordType>(cursorY - _cold.distance, _height);
+
+    for (; _cold.frozenRows < limit; ++_cold.frozenRows)
+    {
+        const auto index = _getRowMapIndex(_cold.frozenRows);
+        auto& slot = til::at(_rowMap, index);
+        if (!slot)
+        {
+            continue;
+        }
+
+        auto& row = _getRowByOffsetDirect(slot);
+        row.Pack(_cold.packBuffer);
+
+        const auto size = _cold.packBuffer.size();
+        auto& cold = til::at(_cold.rows, index);
+        try
+        {
+            cold.size = gsl::narrow<uint32_t>(size);
+            cold.data = std::make_unique_for_overwrite<std::byte[]>(size);
+        }
+        catch (...)
+        {
+            ROW::ReleasePacked(_cold.packBuffer, *_attributes);
+            cold = {};
+            throw;
+        }
+        memcpy(cold.data.get(), _cold.packBuffer.data(), size);
+
+        // Reset() releases the ROW's heap allocation, if it had any.
+        row.ResetWithAttributeId(_initialAttributesId);
+        // This can't throw, because freeSlots has a capacity of _height. See SetColdScrollbackDistance().
+        _cold.freeSlots.emplace_back(slot);
+        slot = 0;
+    }
 }
 
 // Returns the "user-visible" index of the last committed row, which can be used
@@ -206,6 +636,17 @@ ROW& TextBuffer::_getRow(til::CoordType y) const
 // Returns 0 if no rows are committed in.
 til::CoordType TextBuffer::_estimateOffsetOfLastCommittedRow() const noexcept
 {
+    // With the cold scrollback storage the arena isn't filled in order anymore.
+    if (!_cold.rows.empty())
+    {
+        return std::max(0, _cold.touchedRows - 1);
+    }
+    // Neither is it while rows are pending a reflow. Reflow() placed the text at the end of the buffer.
+    if (_pendingReflow.rows)
+    {
+        return _height - 1;
+    }
+
     const auto lastRowOffset = (_commitWatermark - _buffer.get()) / _bufferRowStride;
     // This subtracts 2 from the offset to account for the:
     // * scratchpad row at offset 0, whereas regular rows start at offset 1.
@@ -226,7 +667,8 @@ const ROW& TextBuffer::GetRowByOffset(const til::CoordType index) const
 ROW& TextBuffer::GetMutableRowByOffset(const til::CoordType index)
 {
     _lastMutationId++;
-    return _getRow(index);
+    _markRowChanged(_getRowMapIndex(index));
+    return _getMutableRow(index);
 }
 
 // Returns a row filled with whitespace and the current attributes, for you to freely use.
@@ -776,11 +1218,22 @@ void TextBuffer::IncrementCircularBuffer(const TextAttribute& fillAttributes)
         _renderer.TriggerFlush(true);
     }
 
-    // Prune hyperlinks to delete obsolete references
-    _PruneHyperlinks();
+    if (_pendingReflow.rows)
+    {
+        // The first row hasn't been reflowed yet. There's no point in doing so only to discard it.
+        // This skips pruning its hyperlinks, because it'd require reflowing the entire scrollback.
+        _discardFirstPendingRow();
+    }
+    else
+    {
+        // Prune hyperlinks to delete obsolete references
+        _PruneHyperlinks();
+    }
 
     // Second, clean out the old "first row" as it will become the "last row" of the buffer after the circle is performed.
     GetMutableRowByOffset(0).Reset(fillAttributes);
+    // The discarded row may have held the last references to some attributes. Collect() is amortized.
+    _attributes->Collect();
     {
         // Now proceed to increment.
         // Incrementing it will cause the next line down to become the new "top" of the window (the new "0" in logical coordinates)
@@ -791,6 +1244,10 @@ void TextBuffer::IncrementCircularBuffer(const TextAttribute& fillAttributes)
         {
             _firstRow = 0;
         }
+
+        // The row we just reset is now the last row in the buffer.
+        _cold.frozenRows = std::max(0, _cold.frozenRows - 1);
+        _cold.touchedRows = _height;
     }
 }
 
@@ -883,76 +1340,98 @@ const Viewport TextBuffer::GetSize() const noexcept
 void TextBuffer::_SetFirstRowIndex(const til::CoordType FirstRowIndex) noexcept
 {
     _firstRow = FirstRowIndex;
+    _cold.frozenRows = 0;
+    _cold.touchedRows = _height;
 }
 
+// Moves the `size` rows starting at `firstRow` by `delta` rows (negative values move them up).
+// This rotates the affected entries in _rowMap instead of copying any ROWs. As such the rows that are
+// scrolled over aren't lost, but are rotated into the space vacated by the scrolled rows instead.
+// Callers are expected to clear the vacated rows if they don't want them to retain that content.
 void TextBuffer::ScrollRows(const til::CoordType firstRow, til::CoordType size, const til::CoordType delta)
 {
-    if (delta == 0)
+    // A negative size doesn't make any sense.
+    size = std::max(0, size);
+
+    if (delta == 0 || size == 0)
     {
         return;
     }
 
-    // Since the for() loop uses !=, we must ensure that size is positive.
-    // A negative size doesn't make any sense anyways.
-    size = std::max(0, size);
+    // The layout is like this:
+    // delta is -2, size is 3, firstRow is 5
+    // We want 3 rows from 5 (5, 6, and 7) to move up 2 spots.
+    // --- (storage) ----
+    // | 0
+    // | 1
+    // | 2
+    // | 3 A. beg = firstRow + delta (because delta is negative)
+    // | 4
+    // | 5 B. firstRow
+    // | 6
+    // | 7
+    // | 8 C. end = firstRow + size
+    // | 9
+    // We want [B,C) to slide up to A and [A,B) to end up at C-2 and C-1.
+    // This is a left rotation of [A,C) by 2. A positive delta mirrors this and results in a right rotation.
+    const auto beg = std::min(firstRow, firstRow + delta);
+    const auto end = std::max(firstRow + size, firstRow + size + delta);
+    const auto count = end - beg;
+
+    // If the rows would overlap with themselves after wrapping around the circular buffer,
+    // there's no meaningful way to rotate them. This shouldn't happen with any valid input.
+    THROW_HR_IF(E_INVALIDARG, count > _height);
 
-    til::CoordType y = 0;
-    til::CoordType end = 0;
-    til::CoordType step = 0;
-
-    if (delta < 0)
-    {
-        // The layout is like this:
-        // delta is -2, size is 3, firstRow is 5
-        // We want 3 rows from 5 (5, 6, and 7) to move up 2 spots.
-        // --- (storage) ----
-        // | 0 begin
-        // | 1
-        // | 2
-        // | 3 A. firstRow + delta (because delta is negative)
-        // | 4
-        // | 5 B. firstRow
-        // | 6
-        // | 7
-        // | 8 C. firstRow + size
-        // | 9
-        // | 10
-        // | 11
-        // - end
-        // We want B to slide up to A (the negative delta) and everything from [B,C) to slide up with it.
-        y = firstRow;
-        end = firstRow + size;
-        step = 1;
-    }
-    else
+    _lastMutationId++;
+    for (auto y = beg; y < end; ++y)
     {
-        // The layout is like this:
-        // delta is 2, size is 3, firstRow is 5
-        // We want 3 rows from 5 (5, 6, and 7) to move down 2 spots.
-        // --- (storage) ----
-        // | 0 begin
-        // | 1
-        // | 2
-        // | 3
-        // | 4
-        // | 5 A. firstRow
-        // | 6
-        // | 7
-        // | 8 B. firstRow + size
-        // | 9
-        // | 10 C. firstRow + size + delta
-        // | 11
-        // - end
-        // We want B-1 to slide down to C-1 (the positive delta) and everything from [A, B) to slide down with it.
-        y = firstRow + size - 1;
-        end = firstRow - 1;
-        step = -1;
+        _markRowChanged(_getRowMapIndex(y));
     }
 
-    for (; y != end; y += step)
+    if (_cold.rows.empty())
+    {
+        // All affected rows are accessed once to commit their memory. This keeps _estimateOffsetOfLastCommittedRow()
+        // working like it did when this function was implemented by copying rows, because it assumes that rows get
+        // committed in order. It also ensures that we never rotate an uncommitted ROW into the committed range.
+        for (auto y = beg; y < end; ++y)
+        {
+            _getRow(y);
+        }
+    }
+    else
     {
-        GetMutableRowByOffset(y + delta).CopyFrom(GetRowByOffset(y));
+        // Pending rows need to stay at the top of the buffer. See _isPendingRow().
+        if (beg < _pendingReflow.rows)
+        {
+            _reflowPendingRows(beg);
+        }
+
+        // Cold rows are rotated along with the _rowMap entries and don't need to be thawed.
+        // Only the thaw pool needs to be flushed, because it refers to cold rows by their index.
+        _releaseThawedRows();
+        _cold.frozenRows = std::min(_cold.frozenRows, std::max(0, beg));
+        _cold.touchedRows = beg < 0 ? _height : std::clamp<til::CoordType>(end, _cold.touchedRows, _height);
     }
+
+    // A rotation implemented as 3 reversals: rotate_left([A,C), k) = reverse(reverse([A,A+k)) + reverse([A+k,C))).
+    // Unlike std::rotate() this works with our circular index mapping without having to special-case the wrap-around.
+    const auto reverse = [this](til::CoordType lo, til::CoordType hi) noexcept {
+        const auto cold = !_cold.rows.empty();
+        for (--hi; lo < hi; ++lo, --hi)
+        {
+            const auto a = _getRowMapIndex(lo);
+            const auto b = _getRowMapIndex(hi);
+            std::swap(til::at(_rowMap, a), til::at(_rowMap, b));
+            if (cold)
+            {
+                std::swap(til::at(_cold.rows, a), til::at(_cold.rows, b));
+            }
+        }
+    };
+    const auto mid = beg + (delta < 0 ? -delta : count - delta);
+    reverse(beg, mid);
+    reverse(mid, end);
+    reverse(beg, end);
 }
 
 Cursor& TextBuffer::GetCursor() noexcept
@@ -970,6 +1449,80 @@ uint64_t TextBuffer::GetLastMutationId() const noexcept
     return _lastMutationId;
 }
 
+// Returns the GetLastMutationId() value of the last time the given row was modified. In other words,
+// if the generation of a row is greater than a previously retrieved GetLastMutationId(), it changed since then.
+uint64_t TextBuffer::GetRowGeneration(til::CoordType y) const noexcept
+{
+    return til::at(_rowGenerations, _getRowMapIndex(y));
+}
+
+// Returns the first row in [beg, end) that changed since the given GetLastMutationId() value, or `end` if there's none.
+// Together with FindUnchangedRow() this allows you to iterate over all changed ranges of rows:
+//   for (auto y = FindChangedRow(g, beg, end); y < end; y = FindChangedRow(g, y, end))
+//   {
+//       const auto changedEnd = FindUnchangedRow(g, y, end); // [y, changedEnd) changed
+//       y = changedEnd;
+//   }
+til::CoordType TextBuffer::FindChangedRow(uint64_t generation, til::CoordType beg, til::CoordType end) const noexcept
+{
+    end = std::min(end, gsl::narrow_cast<til::CoordType>(_height));
+
+    for (auto y = std::max(beg, 0); y < end;)
+    {
+        const auto index = _getRowMapIndex(y);
+        const auto block = index / _rowGenerationBlockSize;
+
+        // If no row in this block changed, we can skip to the start of the next one.
+        // The rows are stored circularly, so that's not necessarily a multiple of the block size.
+        if (til::at(_rowGenerationBlocks, block) <= generation)
+        {
+            const auto blockEnd = std::min((block + 1) * _rowGenerationBlockSize, size_t{ _height });
+            y += gsl::narrow_cast<til::CoordType>(blockEnd - index);
+            continue;
+        }
+
+        if (til::at(_rowGenerations, index) > generation)
+        {
+            return y;
+        }
+
+        ++y;
+    }
+
+    return end;
+}
+
+// Returns the first row in [beg, end) that didn't change since the given GetLastMutationId() value, or `end` if there's none.
+til::CoordType TextBuffer::FindUnchangedRow(uint64_t generation, til::CoordType beg, til::CoordType end) const noexcept
+{
+    end = std::min(end, gsl::narrow_cast<til::CoordType>(_height));
+
+    for (auto y = std::max(beg, 0); y < end; ++y)
+    {
+        if (GetRowGeneration(y) <= generation)
+        {
+            return y;
+        }
+    }
+
+    return end;
+}
+
+// Stores the current _lastMutationId as the generation of the row at the given _rowMap index.
+void TextBuffer::_markRowChanged(size_t index) noexcept
+{
+    til::at(_rowGenerations, index) = _lastMutationId;
+    til::at(_rowGenerationBlocks, index / _rowGenerationBlockSize) = _lastMutationId;
+}
+
+// Increments the _lastMutationId and marks all rows as changed.
+void TextBuffer::_markAllRowsChanged() noexcept
+{
+    _lastMutationId++;
+    std::fill(_rowGenerations.begin(), _rowGenerations.end(), _lastMutationId);
+    std::fill(_rowGenerationBlocks.begin(), _rowGenerationBlocks.end(), _lastMutationId);
+}
+
 const TextAttribute& TextBuffer::GetCurrentAttributes() const noexcept
 {
     return _currentAttributes;
@@ -1061,7 +1614,7 @@ til::point TextBuffer::BufferToScreenPosition(const til::point position) const
 void TextBuffer::Reset() noexcept
 {
     _decommit();
-    _initialAttributes = _currentAttributes;
+    _setInitialAttributes(_currentAttributes);
 }
 
 // Routine Description:
@@ -1077,6 +1630,8 @@ void TextBuffer::ResizeTraditional(til::size newSize)
     newSize.height = std::max(newSize.height, 1);
 
     TextBuffer newBuffer{ newSize, _currentAttributes, 0, false, _renderer };
+    newBuffer._shareAttributeTable(*this);
+    newBuffer.SetColdScrollbackDistance(_cold.distance);
     const auto cursorRow = GetCursor().GetPosition().y;
     const auto copyableRows = std::min<til::CoordType>(_height, newSize.height);
     til::CoordType srcRow = 0;
@@ -1090,20 +1645,324 @@ void TextBuffer::ResizeTraditional(til::size newSize)
     for (; dstRow < copyableRows; ++dstRow, ++srcRow)
     {
         newBuffer.GetMutableRowByOffset(dstRow).CopyFrom(GetRowByOffset(srcRow));
+        newBuffer._freezeScrollback(dstRow);
+    }
+
+    // The old arena is about to be released. Its ROWs and cold rows hold references into the shared
+    // TextAttributeTable and any heap allocations of their own, so they need to be destroyed first.
+    _waitForPrefault();
+    _destroy();
+    for (size_t index = 0; index < _cold.rows.size(); ++index)
+    {
+        _releaseColdRow(index);
     }
 
     // NOTE: Keep this in sync with _reserve().
     _buffer = std::move(newBuffer._buffer);
     _bufferEnd = newBuffer._bufferEnd;
     _commitWatermark = newBuffer._commitWatermark;
+    _prefaultWatermark = newBuffer._prefaultWatermark;
+    _commitReadAheadRowCount = newBuffer._commitReadAheadRowCount;
     _initialAttributes = newBuffer._initialAttributes;
+    // newBuffer's destructor releases our previous ID.
+    std::swap(_initialAttributesId, newBuffer._initialAttributesId);
     _bufferRowStride = newBuffer._bufferRowStride;
     _bufferOffsetChars = newBuffer._bufferOffsetChars;
     _bufferOffsetCharOffsets = newBuffer._bufferOffsetCharOffsets;
     _width = newBuffer._width;
     _height = newBuffer._height;
+    _rowMap = std::move(newBuffer._rowMap);
+    _rowGenerations = std::move(newBuffer._rowGenerations);
+    _rowGenerationBlocks = std::move(newBuffer._rowGenerationBlocks);
+    _cold = std::move(newBuffer._cold);
+    _pendingReflow = std::move(newBuffer._pendingReflow);
 
-    _SetFirstRowIndex(0);
+    // All rows potentially changed their position and contents.
+    _markAllRowsChanged();
+
+    _firstRow = 0;
+}
+
+// Enables the cold scrollback storage (see ColdScrollback), which packs rows that are more than `distance` rows
+// above the cursor whenever CompactScrollback() is called. Once enabled, the buffer stays in this mode, because
+// there's no benefit in moving all rows back into the arena. A distance of 0 only stops packing more rows.
+void TextBuffer::SetColdScrollbackDistance(til::CoordType distance)
+{
+    distance = std::max(0, distance);
+
+    if (distance && _cold.rows.empty())
+    {
+        // Pending rows get their ROWs from PendingReflow::nextSlot, which doesn't know about
+        // the slots that _allocateRowSlot() hands out. They need to be reflowed first.
+        _reflowPendingRows(0);
+
+        _cold.rows.resize(_height);
+        _cold.thawPool.resize(_coldThawPoolSize);
+        // _freezeScrollback() relies on this to not throw.
+        _cold.freeSlots.reserve(_height);
+
+        // Rows that haven't been committed yet are blank. They're turned into cold rows
+        // and their ROWs in the arena become available to _allocateRowSlot().
+        const auto committed = gsl::narrow_cast<uint16_t>((_commitWatermark - _buffer.get()) / _bufferRowStride);
+        _cold.nextSlot = std::max<uint16_t>(committed, 1);
+        _cold.frozenRows = 0;
+        _cold.touchedRows = 0;
+
+        for (til::CoordType y = 0; y < _height; ++y)
+        {
+            auto& slot = til::at(_rowMap, _getRowMapIndex(y));
+            if (slot >= _cold.nextSlot)
+            {
+                slot = 0;
+            }
+            else
+            {
+                _cold.touchedRows = y + 1;
+            }
+        }
+    }
+
+    _cold.distance = distance;
+}
+
+// Packs rows that are far enough above the cursor into the cold scrollback storage, if it's enabled.
+// This invalidates all ROW references previously returned by this class.
+void TextBuffer::CompactScrollback()
+{
+    _freezeScrollback(_cursor.GetPosition().y);
+}
+
+// Returns the number of distinct attributes that are referenced by the rows of this buffer, as well as any other
+// buffer that shares its TextAttributeTable. This walks the entire table and is meant for tests and diagnostics.
+size_t TextBuffer::GetAttributeCount() const noexcept
+{
+    return _attributes->Size();
+}
+
+// Enables committing the memory arena ahead of the writer on the threadpool. Applications that produce output
+// in long bursts then spend less time in VirtualAlloc and page faults while holding the console lock.
+void TextBuffer::SetPrefault(bool enabled)
+{
+    if (enabled == static_cast<bool>(_prefault))
+    {
+        return;
+    }
+
+    if (enabled)
+    {
+        auto prefault = std::make_unique<Prefault>();
+        prefault->work.reset(CreateThreadpoolWork(&_prefaultCallback, prefault.get(), nullptr));
+        THROW_LAST_ERROR_IF(!prefault->work);
+        _prefault = std::move(prefault);
+        _submitPrefault();
+    }
+    else
+    {
+        _waitForPrefault();
+        _prefault.reset();
+    }
+}
+
+// Returns the memory of the blank rows at the end of the buffer to the OS and returns the number of bytes that were
+// decommitted. For instance, after erasing the scrollback, all rows below the viewport are blank, but they'd otherwise
+// stay committed up to the previous high watermark. Rows are only considered blank if they're indistinguishable from
+// a freshly constructed one, because that's what they'll be when they get committed again.
+// This invalidates all ROW references previously returned by this class.
+size_t TextBuffer::DecommitBlankRows()
+{
+    _waitForPrefault();
+
+    if (!_cold.rows.empty())
+    {
+        return _decommitBlankColdRows();
+    }
+
+    // Pending rows are at the top of the buffer and contain text. They don't have a ROW yet, but the ones
+    // in [_pendingReflow.nextSlot, _height] are reserved for them, which the swaps below don't touch.
+    const auto pendingRows = _pendingReflow.rows;
+
+    // Slot 0 is the scratchpad row.
+    const auto committedSlots = gsl::narrow_cast<size_t>((_commitWatermark - _buffer.get()) / _bufferRowStride);
+    auto keep = _height;
+    while (keep > pendingRows && _isBlankRow(til::at(_rowMap, _getRowMapIndex(keep - 1)), committedSlots))
+    {
+        --keep;
+    }
+
+    const auto keepSlots = gsl::narrow_cast<size_t>(keep - pendingRows) + 1;
+    if (keepSlots >= committedSlots)
+    {
+        return 0;
+    }
+
+    _lastMutationId++;
+
+    // The rows [pendingRows, keep) need to end up in the slots [1, keepSlots). For every one of them that's currently
+    // stored past that, one of the blank rows [keep, _height) has to occupy one of those slots. Swap them.
+    auto blank = keep;
+    for (auto y = pendingRows; y < keep; ++y)
+    {
+        const auto index = _getRowMapIndex(y);
+        auto& slot = til::at(_rowMap, index);
+        if (slot < keepSlots)
+        {
+            continue;
+        }
+
+        auto blankIndex = _getRowMapIndex(blank);
+        while (til::at(_rowMap, blankIndex) >= keepSlots)
+        {
+            blankIndex = _getRowMapIndex(++blank);
+        }
+        ++blank;
+
+        auto& blankSlot = til::at(_rowMap, blankIndex);
+        auto& target = *reinterpret_cast<ROW*>(_buffer.get() + _bufferRowStride * blankSlot);
+        if (slot < committedSlots)
+        {
+            target.CopyFrom(*reinterpret_cast<const ROW*>(_buffer.get() + _bufferRowStride * slot));
+        }
+        else
+        {
+            target.ResetWithAttributeId(_initialAttributesId);
+        }
+
+        std::swap(slot, blankSlot);
+        _markRowChanged(index);
+        _markRowChanged(blankIndex);
+    }
+
+    return _decommitSlots(keepSlots);
+}
+
+// With the cold scrollback storage, the ROWs in the arena are handed out by _allocateRowSlot() in no particular order.
+// Blank rows are turned into cold rows without a blob instead, which don't need a ROW at all, just like the blank
+// blobs that CompactScrollback() may have created. The ROWs that are left are moved to the start of the arena.
+// Pending rows don't have a ROW yet and get theirs from _allocateRowSlot() later on, which is why they can be ignored.
+size_t TextBuffer::_decommitBlankColdRows()
+{
+    // The thaw pool only holds copies of cold rows. Its ROWs go back to the free list.
+    _releaseThawedRows();
+    _lastMutationId++;
+
+    const auto committedSlots = gsl::narrow_cast<size_t>((_commitWatermark - _buffer.get()) / _bufferRowStride);
+    size_t usedSlots = 0;
+    til::CoordType touchedRows = _pendingReflow.rows;
+
+    for (til::CoordType y = 0; y < _height; ++y)
+    {
+        const auto index = _getRowMapIndex(y);
+        auto& slot = til::at(_rowMap, index);
+        auto& cold = til::at(_cold.rows, index);
+
+        if (slot)
+        {
+            if (!_isBlankRow(slot, committedSlots))
+            {
+                usedSlots++;
+                touchedRows = y + 1;
+                continue;
+            }
+            // This can't throw, because freeSlots has a capacity of _height. See SetColdScrollbackDistance().
+            _cold.freeSlots.emplace_back(slot);
+            slot = 0;
+            _markRowChanged(index);
+        }
+        else if (cold.data)
+        {
+            if (!ROW::IsPackedBlank({ cold.data.get(), cold.size }, _initialAttributesId))
+            {
+                touchedRows = y + 1;
+                continue;
+            }
+            _releaseColdRow(index);
+        }
+    }
+
+    // Every ROW below nextSlot is either in use or on the free list. Since the used ones need to end up in the slots
+    // [1, keepSlots), there are exactly as many free slots in that range as there are used ones past it.
+    const auto keepSlots = usedSlots + 1;
+    std::erase_if(_cold.freeSlots, [&](const uint16_t slot) { return slot >= keepSlots; });
+
+    for (til::CoordType y = 0; y < _height; ++y)
+    {
+        const auto index = _getRowMapIndex(y);
+        auto& slot = til::at(_rowMap, index);
+        if (slot < keepSlots)
+        {
+            continue;
+        }
+
+        const auto target = _cold.freeSlots.back();
+        _cold.freeSlots.pop_back();
+        _getRowByOffsetDirect(target).CopyFrom(_getRowByOffsetDirect(slot));
+        slot = target;
+        _markRowChanged(index);
+    }
+
+    _cold.freeSlots.clear();
+    _cold.nextSlot = gsl::narrow_cast<uint16_t>(keepSlots);
+    _cold.touchedRows = touchedRows;
+
+    if (keepSlots >= committedSlots)
+    {
+        return 0;
+    }
+    return _decommitSlots(keepSlots);
+}
+
+// Destroys the ROWs in the slots [keepSlots, ...) and returns their memory to the OS.
+// The caller needs to ensure that none of them are in use anymore. Returns the number of bytes that were decommitted.
+size_t TextBuffer::_decommitSlots(size_t keepSlots) noexcept
+{
+    // Only whole pages can be decommitted. The ROWs in the page that straddles the new
+    // _commitWatermark are simply constructed again the next time it's committed.
+    const auto pageSize = getPageSize();
+    const auto newWatermark = _buffer.get() + _bufferRowStride * keepSlots;
+    for (auto it = newWatermark; it < _commitWatermark; it += _bufferRowStride)
+    {
+        std::destroy_at(reinterpret_cast<ROW*>(it));
+    }
+
+    const auto pageOffset = (pageSize - reinterpret_cast<uintptr_t>(newWatermark) % pageSize) % pageSize;
+    const auto decommitBeg = newWatermark + pageOffset;
+    const auto decommitEnd = std::max(_commitWatermark, _prefaultWatermark);
+    size_t decommitted = 0;
+    if (decommitBeg < decommitEnd)
+    {
+        decommitted = gsl::narrow_cast<size_t>(decommitEnd - decommitBeg);
+        VirtualFree(decommitBeg, decommitted, MEM_DECOMMIT);
+    }
+
+    _commitWatermark = newWatermark;
+    _prefaultWatermark = newWatermark;
+    _commitReadAheadRowCount = _commitReadAheadMinRowCount;
+    _commitStatistics.decommittedBytes += decommitted;
+    return decommitted;
+}
+
+// Returns true if the ROW in the given slot is indistinguishable from a freshly constructed one. See DecommitBlankRows().
+bool TextBuffer::_isBlankRow(uint16_t slot, size_t committedSlots) const noexcept
+{
+    if (slot >= committedSlots)
+    {
+        return true;
+    }
+
+    const auto& row = *reinterpret_cast<const ROW*>(_buffer.get() + _bufferRowStride * slot);
+    const auto& runs = row.AttributeIds().runs();
+    return !row.ContainsText() &&
+           !row.HasLocalAttributes() &&
+           runs.size() == 1 &&
+           runs.front().value == _initialAttributesId &&
+           row.GetLineRendition() == LineRendition::SingleWidth &&
+           !row.WasWrapForced() &&
+           !row.WasDoubleBytePadded();
+}
+
+const TextBuffer::CommitStatistics& TextBuffer::GetCommitStatistics() const noexcept
+{
+    return _commitStatistics;
 }
 
 void TextBuffer::SetAsActiveBuffer(const bool isActiveBuffer) noexcept
@@ -2377,11 +3236,231 @@ void TextBuffer::_AppendRTFText(std::ostringstream& contentBuilder, const std::w
     }
 }
 
+namespace
+{
+    // A piece of an old row that TextBuffer::Reflow() copies into a new row.
+    struct ReflowCopy
+    {
+        til::CoordType oldY = 0;
+        til::CoordType newY = 0;
+        til::CoordType oldX = 0;
+        // The old row is copied via ROW::CopyFrom() if this is -1, because it has a non-standard line rendition.
+        til::CoordType oldLimit = 0;
+        til::CoordType newX = 0;
+        // The new row continues in the next row and needs SetWrapForced(true).
+        bool wrapForced = false;
+    };
+
+    // A row of the old buffer in TextBuffer::Reflow(). Cold rows are referred to by their packed blob instead,
+    // because reading them via GetRowByOffset() goes through the thaw pool, which isn't thread-safe.
+    struct ReflowSourceRow
+    {
+        const ROW* row = nullptr;
+        std::span<const std::byte> packed;
+    };
+
+    // Unpacks cold ReflowSourceRows into a ROW of its own, which allows each thread to read them independently.
+    // The last unpacked row is kept, because consecutive ReflowCopy instructions usually read from the same one.
+    class ReflowScratch
+    {
+    public:
+        ReflowScratch(uint16_t width, TextAttributeTable& attributes, uint16_t blankAttributeId) :
+            _chars{ std::make_unique<wchar_t[]>(ROW::CalculateCharsBufferSize(width) / sizeof(wchar_t)) },
+            _charOffsets{ std::make_unique<uint16_t[]>(ROW::CalculateCharOffsetsBufferSize(width) / sizeof(uint16_t)) },
+            _row{ _chars.get(), _charOffsets.get(), width, attributes, blankAttributeId },
+            _blankAttributeId{ blankAttributeId }
+        {
+        }
+
+        const ROW& Resolve(const ReflowSourceRow& source)
+        {
+            if (source.row)
+            {
+                return *source.row;
+            }
+
+            if (!_valid || source.packed.data() != _packed)
+            {
+                _valid = false;
+                if (source.packed.empty())
+                {
+                    _row.ResetWithAttributeId(_blankAttributeId);
+                }
+                else
+                {
+                    _row.Unpack(source.packed);
+                }
+                _packed = source.packed.data();
+                _valid = true;
+            }
+            return _row;
+        }
+
+    private:
+        std::unique_ptr<wchar_t[]> _chars;
+        std::unique_ptr<uint16_t[]> _charOffsets;
+        ROW _row;
+        uint16_t _blankAttributeId;
+        const std::byte* _packed = nullptr;
+        bool _valid = false;
+    };
+
+    // Splits [0,count) into ranges with at least minChunkSize items, at most a few per hardware thread.
+    std::vector<std::pair<size_t, size_t>> splitIntoChunks(size_t count, size_t minChunkSize)
+    {
+        const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        const auto chunkCount = std::clamp<size_t>(count / minChunkSize, 1, threads * 4);
+
+        std::vector<std::pair<size_t, size_t>> chunks;
+        chunks.reserve(chunkCount);
+        for (size_t i = 0; i < chunkCount; ++i)
+        {
+            chunks.emplace_back(count * i / chunkCount, count * (i + 1) / chunkCount);
+        }
+        return chunks;
+    }
+
+    // Calls func(beg, end) for each chunk. Exceptions thrown by func are rethrown on the calling thread.
+    template<typename Func>
+    void forEachChunk(const std::vector<std::pair<size_t, size_t>>& chunks, const Func& func)
+    {
+        if (chunks.size() <= 1)
+        {
+            for (const auto& [beg, end] : chunks)
+            {
+                func(beg, end);
+            }
+            return;
+        }
+
+        // Exceptions escaping a parallel algorithm call std::terminate(), so we have to marshal them ourselves.
+        std::mutex mutex;
+        std::exception_ptr exception;
+
+        std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](const std::pair<size_t, size_t>& chunk) {
+            try
+            {
+                func(chunk.first, chunk.second);
+            }
+            catch (...)
+            {
+                const std::scoped_lock lock{ mutex };
+                if (!exception)
+                {
+                    exception = std::current_exception();
+                }
+            }
+        });
+
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    // Returns true if `row` is part of the same logical line as the `previous` row, the way TextBuffer::Reflow() treats them.
+    // Rows with a non-standard line rendition are always a logical line of their own, because they get truncated.
+    bool continuesLine(const ROW& previous, const ROW& row) noexcept
+    {
+        return previous.WasWrapForced() &&
+               previous.GetLineRendition() == LineRendition::SingleWidth &&
+               row.GetLineRendition() == LineRendition::SingleWidth;
+    }
+
+    // Appends the ReflowCopy instructions for the logical line in the rows [oldBeg, oldEnd) of `source` to `copies`.
+    // This is the layout loop of TextBuffer::Reflow() without any of the cursor handling. The line starts at a newY
+    // of 0 and the number of new rows it occupies is returned.
+    til::CoordType layoutLine(const TextBuffer& source, til::CoordType oldBeg, til::CoordType oldEnd, til::CoordType newWidth, std::vector<ReflowCopy>& copies)
+    {
+        til::CoordType newX = 0;
+        til::CoordType newY = 0;
+
+        for (auto oldY = oldBeg; oldY < oldEnd; ++oldY)
+        {
+            const auto& oldRow = source.GetRowByOffset(oldY);
+
+            if (oldRow.GetLineRendition() != LineRendition::SingleWidth)
+            {
+                copies.emplace_back(ReflowCopy{ .oldY = oldY, .newY = newY, .oldLimit = -1 });
+                break;
+            }
+
+            const auto oldRowLimit = oldRow.MeasureRight();
+            til::CoordType oldX = 0;
+
+            do
+            {
+                if (newX >= newWidth)
+                {
+                    copies.back().wrapForced = true;
+                    newX = 0;
+                    newY++;
+                }
+
+                RowCopyTextFromState state{
+                    .source = oldRow,
+                    .columnBegin = newX,
+                    .columnLimit = til::CoordTypeMax,
+                    .sourceColumnBegin = oldX,
+                    .sourceColumnLimit = oldRowLimit,
+                };
+                ROW::MeasureCopyTextFrom(state, newWidth);
+
+                copies.emplace_back(ReflowCopy{ .oldY = oldY, .newY = newY, .oldX = oldX, .oldLimit = oldRowLimit, .newX = newX });
+
+                oldX = state.sourceColumnEnd;
+                newX = state.columnEnd;
+            } while (oldX < oldRowLimit);
+        }
+
+        return newY + 1;
+    }
+
+    // Copies the text and attributes described by `c` from oldRow into newRow.
+    void executeCopy(const ReflowCopy& c, const ROW& oldRow, ROW& newRow)
+    {
+        if (c.oldLimit < 0)
+        {
+            newRow.CopyFrom(oldRow);
+            newRow.SetWrapForced(false);
+            return;
+        }
+
+        RowCopyTextFromState state{
+            .source = oldRow,
+            .columnBegin = c.newX,
+            .columnLimit = til::CoordTypeMax,
+            .sourceColumnBegin = c.oldX,
+            .sourceColumnLimit = c.oldLimit,
+        };
+        newRow.CopyTextFrom(state);
+
+        newRow.CopyAttributesFrom(oldRow, c.oldX, c.newX);
+
+        if (c.wrapForced)
+        {
+            newRow.SetWrapForced(true);
+        }
+    }
+}
+
 // Function Description:
 // - Reflow the contents from the old buffer into the new buffer. The new buffer
 //   can have different dimensions than the old buffer. If it does, then this
 //   function will attempt to maintain the logical contents of the old buffer,
 //   by continuing wrapped lines onto the next line in the new buffer.
+// - If the scrollback is guaranteed to fill up the new buffer, only the rows
+//   around the cursor and viewport are reflowed right away. The rest is reflowed
+//   once it's accessed (see PendingReflow). In that case the rows of the old buffer
+//   may get moved into the new buffer, leaving the old buffer blank.
+// - Pending rows are reflowed from the text they had before the first deferred
+//   Reflow() and not from the text of each size in between. This makes a difference
+//   for the lines at the top of the scrollback, which an eager reflow cuts off if
+//   they don't fit into a narrower buffer: If the buffer grows again before the rows
+//   are accessed, pending rows still contain those lines. The scrollback is longer
+//   then and the cursor further down than after eager reflows, and the topmost line
+//   may be complete where an eager reflow kept only its remainder. Every other line
+//   is identical, including rows that were accessed in between.
 // Arguments:
 // - oldBuffer - the text buffer to copy the contents FROM
 // - newBuffer - the text buffer to copy the contents TO
@@ -2393,6 +3472,17 @@ void TextBuffer::_AppendRTFText(std::ostringstream& contentBuilder, const std::w
 //   the new buffer. The rows's new value is placed back into this parameter.
 // Return Value:
 // - S_OK if we successfully copied the contents to the new buffer, otherwise an appropriate HRESULT.
+//
+// Reflow happens in 3 phases:
+// 1. Measure the text of all old rows via ROW::MeasureRight() in parallel. This is the bulk of the work of computing the layout.
+// 2. Compute the layout of the new buffer sequentially. This results in a list of ReflowCopy instructions, but without
+//    copying any text, which makes this phase cheap. It's sequential, because the position of each logical line depends
+//    on all preceding ones and because the cursor limits how much of the old buffer fits into the new one (see newYLimit).
+// 3. Execute the ReflowCopy instructions in parallel. The instructions are sorted by newY and each thread gets a
+//    contiguous range of new rows. Instructions whose row got overwritten later (the new buffer is circular) are skipped.
+// With the cold scrollback storage (see SetColdScrollbackDistance()) the threads unpack cold rows of the old buffer
+// into a ReflowScratch of their own. The new buffer is filled in batches of _reflowBatchRows rows then, which get
+// packed once they're done, so that the memory usage stays bounded like it does when writing to the buffer.
 void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const Viewport* lastCharacterViewport, PositionInformation* positionInfo)
 {
     const auto& oldCursor = oldBuffer.GetCursor();
@@ -2405,7 +3495,7 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
     // * To compute an oldHeight that includes at a minimum the cursor row
     // * For REFLOW_JANK_CURSOR_WRAP (see comment below)
     // Both of these would break the reflow algorithm, but the latter of the two in particular
-    // would cause the main copy loop below to deadlock. In other words, these two lines
+    // would cause the main layout loop below to deadlock. In other words, these two lines
     // protect this function against yet-unknown bugs in other parts of the code base.
     oldCursorPos.x = std::clamp(oldCursorPos.x, 0, oldBuffer._width - 1);
     oldCursorPos.y = std::clamp(oldCursorPos.y, 0, oldBuffer._height - 1);
@@ -2423,12 +3513,121 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
 
     const auto oldHeight = std::max(lastRowWithText, oldCursorPos.y) + 1;
     const auto newHeight = newBuffer.GetSize().Height();
-    const auto newWidthU16 = gsl::narrow_cast<uint16_t>(newWidth);
 
-    // Copy oldBuffer into newBuffer until oldBuffer has been fully consumed.
-    for (; oldY < oldHeight && newY < newYLimit; ++oldY)
+    // Both buffers use the same attribute IDs, which allows executeCopy() to copy them from multiple threads.
+    newBuffer._shareAttributeTable(oldBuffer);
+    newBuffer.SetColdScrollbackDistance(oldBuffer._cold.distance);
+    newBuffer.SetPrefault(static_cast<bool>(oldBuffer._prefault));
+
+    // Rows above oldBeginY don't affect the layout of the rows below them, if they're guaranteed to fill up the rest
+    // of the new buffer. In that case they get deferred into pendingSegments. Every logical line occupies at least 1 row.
+    til::CoordType oldBeginY = 0;
+    std::vector<PendingReflowSegment> pendingSegments;
+
+    auto& oldPending = oldBuffer._pendingReflow;
+
+    auto anchor = oldCursorPos.y;
+    if (positionInfo)
+    {
+        anchor = std::min({ anchor, positionInfo->mutableViewportTop, positionInfo->visibleViewportTop });
+    }
+    anchor -= _pendingReflowMargin;
+
+    // If the old buffer has pending rows itself, we can pass them on without reflowing them twice. If the rows
+    // between them and the anchor are few, we reflow those right away instead of holding onto the old buffer
+    // just for them. This ensures that resizing the window repeatedly doesn't accumulate old buffers.
+    if (anchor < oldPending.rows + _pendingReflowMargin)
+    {
+        oldBuffer._reflowPendingRows(anchor);
+        anchor = oldPending.rows;
+    }
+
+    // Logical lines are reflowed independently, so the anchor needs to be at the start of one.
+    while (anchor > oldPending.rows && continuesLine(oldBuffer.GetRowByOffset(anchor - 1), oldBuffer.GetRowByOffset(anchor)))
+    {
+        anchor--;
+    }
+
+    if (anchor > 0)
+    {
+        til::CoordType pendingLines = 0;
+        til::CoordType eagerLines = 0;
+        til::CoordType oldLines = 0;
+
+        for (const auto& segment : oldPending.segments)
+        {
+            pendingLines += segment.lines;
+        }
+
+        const ROW* previousRow = nullptr;
+        for (auto y = oldPending.rows; y < oldHeight; ++y)
+        {
+            const auto& row = oldBuffer.GetRowByOffset(y);
+            if (!previousRow || y == anchor || !continuesLine(*previousRow, row))
+            {
+                (y < anchor ? oldLines : eagerLines)++;
+            }
+            previousRow = &row;
+        }
+
+        if (pendingLines + oldLines >= newHeight - eagerLines)
+        {
+            oldBeginY = anchor;
+            pendingSegments = oldPending.segments;
+            if (oldLines)
+            {
+                // The source is filled in at the end, once we're done reading from oldBuffer.
+                pendingSegments.emplace_back(PendingReflowSegment{ .begin = oldPending.rows, .end = anchor, .lines = oldLines });
+            }
+        }
+    }
+
+    // We resolve all rows up front, because TextBuffer's accessors aren't thread-safe.
+    // Afterwards, all rows with a _rowMap entry of 0 are cold rows.
+    oldBuffer._reflowPendingRows(oldBeginY);
+    std::vector<ReflowSourceRow> oldRows(gsl::narrow_cast<size_t>(oldHeight - oldBeginY));
+    for (auto y = oldBeginY; y < oldHeight; ++y)
+    {
+        const auto index = oldBuffer._getRowMapIndex(y);
+        auto& source = til::at(oldRows, y - oldBeginY);
+        if (const auto slot = til::at(oldBuffer._rowMap, index))
+        {
+            source.row = &oldBuffer._getRowByOffsetDirect(slot);
+        }
+        else
+        {
+            const auto& cold = til::at(oldBuffer._cold.rows, index);
+            source.packed = { cold.data.get(), cold.size };
+        }
+    }
+
+    const auto makeScratch = [&]() {
+        return ReflowScratch{ oldBuffer._width, *oldBuffer._attributes, oldBuffer._initialAttributesId };
+    };
+    const auto getOldRow = [&](ReflowScratch& scratch, til::CoordType y) -> const ROW& {
+        return scratch.Resolve(til::at(oldRows, y - oldBeginY));
+    };
+
+    // PHASE 1: Rows don't store any information for what column the last written character is in.
+    // We simply truncate all trailing whitespace in this implementation.
+    std::vector<til::CoordType> oldRowLimits(gsl::narrow_cast<size_t>(oldHeight - oldBeginY));
+    forEachChunk(splitIntoChunks(oldRowLimits.size(), 1024), [&](size_t beg, size_t end) {
+        auto scratch = makeScratch();
+        for (auto i = beg; i < end; ++i)
+        {
+            til::at(oldRowLimits, i) = getOldRow(scratch, oldBeginY + gsl::narrow_cast<til::CoordType>(i)).MeasureRight();
+        }
+    });
+
+    // PHASE 2: Compute the layout of the new buffer.
+    std::vector<ReflowCopy> copies;
+    copies.reserve(oldRowLimits.size());
+    til::point cursorTarget;
+    auto layoutScratch = makeScratch();
+
+    for (oldY = oldBeginY; oldY < oldHeight && newY < newYLimit; ++oldY)
     {
-        const auto& oldRow = oldBuffer.GetRowByOffset(oldY);
+        const auto& oldRow = getOldRow(layoutScratch, oldY);
 
         // A pair of double height rows should optimally wrap as a union (i.e. after wrapping there should be 4 lines).
         // But for this initial implementation I chose the alternative approach: Just truncate them.
@@ -2443,20 +3642,11 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
                 newY++;
             }
 
-            auto& newRow = newBuffer.GetMutableRowByOffset(newY);
-
-            // See the comment marked with "REFLOW_RESET".
-            if (newY >= newHeight)
-            {
-                newRow.Reset(newBuffer._initialAttributes);
-            }
-
-            newRow.CopyFrom(oldRow);
-            newRow.SetWrapForced(false);
+            copies.emplace_back(ReflowCopy{ .oldY = oldY, .newY = newY, .oldLimit = -1 });
 
             if (oldY == oldCursorPos.y)
             {
-                newCursorPos = { newRow.AdjustToGlyphStart(oldCursorPos.x), newY };
+                cursorTarget = { oldCursorPos.x, newY };
             }
             if (oldY >= mutableViewportTop)
             {
@@ -2473,9 +3663,7 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
             continue;
         }
 
-        // Rows don't store any information for what column the last written character is in.
-        // We simply truncate all trailing whitespace in this implementation.
-        auto oldRowLimit = oldRow.MeasureRight();
+        auto oldRowLimit = til::at(oldRowLimits, oldY - oldBeginY);
         if (oldY == oldCursorPos.y)
         {
             // REFLOW_JANK_CURSOR_WRAP:
@@ -2499,27 +3687,17 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
             // A SetWrapForced of false implies an explicit newline, which is the default.
             if (newX >= newWidth)
             {
-                newBuffer.GetMutableRowByOffset(newY).SetWrapForced(true);
+                copies.back().wrapForced = true;
                 newX = 0;
                 newY++;
             }
 
-            // REFLOW_RESET:
-            // If we shrink the buffer vertically, for instance from 100 rows to 90 rows, we will write 10 rows in the
-            // new buffer twice. We need to reset them before copying text, or otherwise we'll see the previous contents.
-            // We don't need to be smart about this. Reset() is fast and shrinking doesn't occur often.
-            if (newY >= newHeight && newX == 0)
+            // We need to ensure not to overwrite the row the cursor is on.
+            if (newY >= newHeight && newX == 0 && newY >= newYLimit)
             {
-                // We need to ensure not to overwrite the row the cursor is on.
-                if (newY >= newYLimit)
-                {
-                    break;
-                }
-                newBuffer.GetMutableRowByOffset(newY).Reset(newBuffer._initialAttributes);
+                break;
             }
 
-            auto& newRow = newBuffer.GetMutableRowByOffset(newY);
-
             RowCopyTextFromState state{
                 .source = oldRow,
                 .columnBegin = newX,
@@ -2527,19 +3705,13 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
                 .sourceColumnBegin = oldX,
                 .sourceColumnLimit = oldRowLimit,
             };
-            newRow.CopyTextFrom(state);
+            ROW::MeasureCopyTextFrom(state, newWidth);
 
-            const auto& oldAttr = oldRow.Attributes();
-            auto& newAttr = newRow.Attributes();
-            const auto attributes = oldAttr.slice(gsl::narrow_cast<uint16_t>(oldX), oldAttr.size());
-            newAttr.replace(gsl::narrow_cast<uint16_t>(newX), newAttr.size(), attributes);
-            newAttr.resize_trailing_extent(newWidthU16);
+            copies.emplace_back(ReflowCopy{ .oldY = oldY, .newY = newY, .oldX = oldX, .oldLimit = oldRowLimit, .newX = newX });
 
             if (oldY == oldCursorPos.y && oldCursorPos.x >= oldX)
             {
-                // In theory AdjustToGlyphStart ensures we don't put the cursor on a trailing wide glyph.
-                // In practice I don't think that this can possibly happen. Better safe than sorry.
-                newCursorPos = { newRow.AdjustToGlyphStart(oldCursorPos.x - oldX + newX), newY };
+                cursorTarget = { oldCursorPos.x - oldX + newX, newY };
                 // If there's so much text past the old cursor position that it doesn't fit into new buffer,
                 // then the new cursor position will be "lost", because it's overwritten by unrelated text.
                 // We have two choices how can handle this:
@@ -2571,6 +3743,139 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
         }
     }
 
+    // If the scrollback was deferred, the rows we just laid out go to the end of the new buffer and the pending rows
+    // above them get filled in later, as if we had laid out all of oldBuffer. If they don't fit into the new buffer
+    // on their own, there's no need for that, since the deferred rows would get overwritten anyway.
+    if (oldBeginY)
+    {
+        // If the last row is wrapped, newY points at it and not past it.
+        const auto usedRows = newY + (!copies.empty() && copies.back().newY == newY ? 1 : 0);
+        if (usedRows < newHeight)
+        {
+            const auto pendingRows = newHeight - usedRows;
+            for (auto& c : copies)
+            {
+                c.newY += pendingRows;
+            }
+            cursorTarget.y += pendingRows;
+            if (positionInfo && mutableViewportTop == til::CoordTypeMax)
+            {
+                positionInfo->mutableViewportTop += pendingRows;
+            }
+            if (positionInfo && visibleViewportTop == til::CoordTypeMax)
+            {
+                positionInfo->visibleViewportTop += pendingRows;
+            }
+            newY = newHeight;
+
+            auto& pending = newBuffer._pendingReflow;
+            pending.segments = std::move(pendingSegments);
+            pending.rows = pendingRows;
+
+            // newBuffer is still empty, so its _firstRow is 0 and _rowMap indices are identical to row offsets.
+            // The rows we just laid out get the first ROWs in the arena, so that the pending ones aren't committed.
+            // With the cold scrollback storage, all of its rows are blank cold rows with an entry of 0 already.
+            if (newBuffer._cold.rows.empty())
+            {
+                std::fill_n(newBuffer._rowMap.begin(), pendingRows, uint16_t{ 0 });
+                std::iota(newBuffer._rowMap.begin() + pendingRows, newBuffer._rowMap.end(), uint16_t{ 1 });
+                pending.nextSlot = gsl::narrow_cast<uint16_t>(usedRows + 1);
+            }
+        }
+    }
+
+    // PHASE 3: Copy the text.
+    // The new buffer is circular, so if the old buffer doesn't fit into it, the earlier rows get overwritten.
+    // Only the last write to each row matters.
+    std::vector<til::CoordType> lastNewY(gsl::narrow_cast<size_t>(newHeight), -1);
+    for (const auto& c : copies)
+    {
+        til::at(lastNewY, c.newY % newHeight) = c.newY;
+    }
+
+    // With the cold scrollback storage, the rows of each batch get packed once we're done with them, so that reflowing
+    // a huge buffer doesn't need the memory for all of it. Once newY wraps around, the rows get reset and overwritten,
+    // so we only do this for the first pass. Without it, all rows are copied in a single batch.
+    const auto batchRows = newBuffer._cold.rows.empty() ? til::CoordTypeMax : _reflowBatchRows;
+    std::vector<ROW*> newRows(gsl::narrow_cast<size_t>(newHeight));
+
+    const auto copyChunk = [&](size_t beg, size_t end) {
+        auto scratch = makeScratch();
+        auto previousNewY = -1;
+
+        for (auto i = beg; i < end; ++i)
+        {
+            const auto& c = til::at(copies, i);
+            if (til::at(lastNewY, c.newY % newHeight) != c.newY)
+            {
+                continue;
+            }
+
+            auto& newRow = *til::at(newRows, c.newY % newHeight);
+
+            // REFLOW_RESET:
+            // If we shrink the buffer vertically, for instance from 100 rows to 90 rows, we will write 10 rows in the
+            // new buffer twice. We need to reset them before copying text, or otherwise we'll see the previous contents.
+            // We don't need to be smart about this. Reset() is fast and shrinking doesn't occur often.
+            if (c.newY != previousNewY)
+            {
+                previousNewY = c.newY;
+                if (c.newY >= newHeight)
+                {
+                    newRow.ResetWithAttributeId(newBuffer._initialAttributesId);
+                }
+            }
+
+            executeCopy(c, getOldRow(scratch, c.oldY), newRow);
+        }
+    };
+
+    for (size_t batchBeg = 0; batchBeg < copies.size();)
+    {
+        // In the batch we resolve all new ROWs up front as well.
+        const auto batchFirstY = til::at(copies, batchBeg).newY;
+        auto batchEnd = batchBeg;
+        for (auto previousNewY = -1; batchEnd < copies.size() && til::at(copies, batchEnd).newY - batchFirstY < batchRows; ++batchEnd)
+        {
+            const auto& c = til::at(copies, batchEnd);
+            if (c.newY != previousNewY && til::at(lastNewY, c.newY % newHeight) == c.newY)
+            {
+                til::at(newRows, c.newY % newHeight) = &newBuffer.GetMutableRowByOffset(c.newY);
+            }
+            previousNewY = c.newY;
+        }
+
+        // Each chunk needs to start at a new row, so that no two threads write to the same one.
+        auto chunks = splitIntoChunks(batchEnd - batchBeg, 512);
+        for (auto& chunk : chunks)
+        {
+            chunk.first += batchBeg;
+            chunk.second += batchBeg;
+        }
+        for (size_t i = 1; i < chunks.size(); ++i)
+        {
+            auto split = std::max(chunks[i].first, chunks[i - 1].first);
+            while (split < batchEnd && split > batchBeg && til::at(copies, split).newY == til::at(copies, split - 1).newY)
+            {
+                ++split;
+            }
+            chunks[i - 1].second = split;
+            chunks[i].first = split;
+            chunks[i].second = std::max(chunks[i].second, split);
+        }
+        forEachChunk(chunks, copyChunk);
+
+        batchBeg = batchEnd;
+        if (batchBeg < copies.size() && til::at(copies, batchBeg).newY < newHeight)
+        {
+            newBuffer._freezeScrollback(til::at(copies, batchBeg).newY);
+        }
+    }
+
+    // In theory AdjustToGlyphStart ensures we don't put the cursor on a trailing wide glyph.
+    // In practice I don't think that this can possibly happen. Better safe than sorry.
+    newCursorPos = { newBuffer.GetRowByOffset(cursorTarget.y).AdjustToGlyphStart(cursorTarget.x), cursorTarget.y };
+
     // Finish copying buffer attributes to remaining rows below the last
     // printable character. This is to fix the `color 2f` scenario, where you
     // change the buffer colors then resize and everything below the last
@@ -2580,9 +3885,7 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
     {
         auto& oldRow = oldBuffer.GetRowByOffset(oldY);
         auto& newRow = newBuffer.GetMutableRowByOffset(newY);
-        auto& newAttr = newRow.Attributes();
-        newAttr = oldRow.Attributes();
-        newAttr.resize_trailing_extent(newWidthU16);
+        newRow.CopyAttributesFrom(oldRow, 0, 0);
     }
 
     // Since we didn't use IncrementCircularBuffer() we need to compute the proper
@@ -2590,7 +3893,7 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
     // We need to do the same for newCursorPos.y for basically the same reason.
     if (newY > newHeight)
     {
-        newBuffer._firstRow = newY % newHeight;
+        newBuffer._SetFirstRowIndex(newY % newHeight);
         // _firstRow maps from API coordinates that always start at 0,0 in the top left corner of the
         // terminal's scrollback, to the underlying buffer Y coordinate via `(y + _firstRow) % height`.
         // Here, we need to un-map the `newCursorPos.y` from the underlying Y coordinate to the API coordinate
@@ -2605,9 +3908,156 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
     assert(newCursorPos.y >= 0 && newCursorPos.y < newHeight);
     newCursor.SetSize(oldCursor.GetSize());
     newCursor.SetPosition(newCursorPos);
+    newBuffer.CompactScrollback();
 
     newBuffer._marks = oldBuffer._marks;
     newBuffer._trimMarksOutsideBuffer();
+
+    // We're done reading from oldBuffer. If some of its rows are pending in newBuffer, we take them.
+    auto& segments = newBuffer._pendingReflow.segments;
+    if (!segments.empty() && !segments.back().source)
+    {
+        segments.back().source = oldBuffer._detachRows();
+    }
+}
+
+// Returns true if the _rowMap entry of 0 at the given index belongs to a row that's pending a reflow. See PendingReflow.
+bool TextBuffer::_isPendingRow(size_t index) const noexcept
+{
+    const auto y = gsl::narrow_cast<til::CoordType>((index + _height - gsl::narrow_cast<size_t>(_firstRow)) % _height);
+    return y < _pendingReflow.rows;
+}
+
+// Returns the ROW for a pending row, after reflowing it. See PendingReflow.
+ROW& TextBuffer::_reflowPendingRow(size_t index)
+{
+    const auto y = gsl::narrow_cast<til::CoordType>((index + _height - gsl::narrow_cast<size_t>(_firstRow)) % _height);
+    _reflowPendingRows(y);
+
+    const auto slot = til::at(_rowMap, index);
+    THROW_HR_IF(E_UNEXPECTED, slot == 0);
+    return _getRowByOffsetDirect(slot);
+}
+
+// Reflows pending rows bottom-up, one logical line at a time, until the given row isn't pending anymore.
+void TextBuffer::_reflowPendingRows(til::CoordType y)
+{
+    auto& pending = _pendingReflow;
+    std::vector<ReflowCopy> copies;
+
+    y = std::max(0, y);
+
+    while (pending.rows > y)
+    {
+        if (pending.segments.empty())
+        {
+            // The scrollback didn't fill up the buffer after all. This can happen if it contains long runs of
+            // wrapped, blank rows, because those collapse into fewer rows than there are logical lines.
+            // With the cold scrollback storage, the rows simply remain as blank cold rows.
+            for (auto r = y; r < pending.rows && _cold.rows.empty(); ++r)
+            {
+                til::at(_rowMap, _getRowMapIndex(r)) = _allocatePendingRowSlot();
+            }
+            pending.rows = y;
+            break;
+        }
+
+        auto& segment = pending.segments.back();
+        const auto source = segment.source;
+
+        auto beg = segment.end - 1;
+        while (beg > segment.begin && continuesLine(source->GetRowByOffset(beg - 1), source->GetRowByOffset(beg)))
+        {
+            beg--;
+        }
+
+        copies.clear();
+        const auto top = pending.rows - layoutLine(*source, beg, segment.end, _width, copies);
+
+        // The bookkeeping is updated before copying any text, so that an exception can't result in ROWs being handed out twice.
+        for (auto r = std::max(0, top); r < pending.rows; ++r)
+        {
+            til::at(_rowMap, _getRowMapIndex(r)) = _allocatePendingRowSlot();
+        }
+        pending.rows = std::max(0, top);
+        // The rows are in the arena now and CompactScrollback() needs to pack them again.
+        _cold.frozenRows = std::min(_cold.frozenRows, pending.rows);
+        segment.end = beg;
+        segment.lines--;
+        if (segment.end <= segment.begin)
+        {
+            pending.segments.pop_back();
+        }
+
+        for (const auto& c : copies)
+        {
+            const auto r = top + c.newY;
+            if (r >= 0)
+            {
+                executeCopy(c, source->GetRowByOffset(c.oldY), _getRowByOffsetDirect(til::at(_rowMap, _getRowMapIndex(r))));
+            }
+        }
+    }
+
+    if (!pending.rows)
+    {
+        // This releases the old buffers.
+        pending = {};
+    }
+}
+
+// Returns the arena offset of the ROW for a pending row that's about to be reflowed. The ROW is blank.
+uint16_t TextBuffer::_allocatePendingRowSlot()
+{
+    if (_cold.rows.empty())
+    {
+        // These ROWs haven't been used yet, because the ones past nextSlot are only handed out by this function.
+        return _pendingReflow.nextSlot++;
+    }
+
+    // ROWs from the free list may still hold the contents of a row that was packed or thawed before.
+    const auto slot = _allocateRowSlot();
+    _getRowByOffsetDirect(slot).ResetWithAttributeId(_initialAttributesId);
+    return slot;
+}
+
+// IncrementCircularBuffer() calls this instead of accessing the first row, if it's pending. The row gets a ROW without being
+// reflowed, which discards the oldest part of the pending scrollback, just like it would happen if it had been reflowed.
+void TextBuffer::_discardFirstPendingRow()
+{
+    auto& pending = _pendingReflow;
+    til::at(_rowMap, _getRowMapIndex(0)) = _allocatePendingRowSlot();
+
+    // The remaining pending rows [1, rows) become [0, rows - 1) once IncrementCircularBuffer() increments _firstRow.
+    pending.rows--;
+    if (!pending.rows)
+    {
+        pending = {};
+    }
+}
+
+// Moves all rows into a new TextBuffer and leaves this one blank. This allows Reflow() to
+// keep the rows of the old buffer around for PendingReflow, without having to copy them.
+std::shared_ptr<TextBuffer> TextBuffer::_detachRows()
+{
+    auto rows = std::make_shared<TextBuffer>(til::size{ _width, _height }, _initialAttributes, 0, false, _renderer);
+    // The ROWs refer to our TextAttributeTable.
+    rows->_shareAttributeTable(*this);
+    _waitForPrefault();
+    std::swap(_buffer, rows->_buffer);
+    std::swap(_bufferEnd, rows->_bufferEnd);
+    std::swap(_commitWatermark, rows->_commitWatermark);
+    std::swap(_prefaultWatermark, rows->_prefaultWatermark);
+    std::swap(_commitReadAheadRowCount, rows->_commitReadAheadRowCount);
+    std::swap(_rowMap, rows->_rowMap);
+    std::swap(_firstRow, rows->_firstRow);
+    std::swap(_pendingReflow, rows->_pendingReflow);
+    // Cold rows are indexed like the _rowMap and the thaw pool refers to ROWs in the arena, so they move along.
+    std::swap(_cold, rows->_cold);
+    SetColdScrollbackDistance(rows->_cold.distance);
+
+    _markAllRowsChanged();
+    return rows;
 }
 
 // Method Description:
@@ -2737,6 +4187,327 @@ std::vector<til::point_span> TextBuffer::SearchText(const std::wstring_view& nee
         return results;
     }
 
+    if (!_searchTextLiteral(results, needle, caseInsensitive, rowBeg, rowEnd))
+    {
+        results.clear();
+        _searchTextICU(results, needle, caseInsensitive, rowBeg, rowEnd);
+    }
+
+    return results;
+}
+
+namespace
+{
+    // Under full Unicode case folding, which is what ICU uses for UREGEX_CASE_INSENSITIVE, these are the only non-ASCII
+    // characters that fold into a sequence containing ASCII letters. For instance "ß" matches "ss" and the Kelvin sign "K" matches "k".
+    constexpr bool foldsIntoAscii(const wchar_t ch) noexcept
+    {
+        return ch == 0x00df || ch == 0x0130 || ch == 0x0149 || ch == 0x017f || ch == 0x01f0 ||
+               (ch >= 0x1e96 && ch <= 0x1e9a) || ch == 0x1e9e || ch == 0x212a || (ch >= 0xfb00 && ch <= 0xfb06);
+    }
+
+    bool containsFoldsIntoAscii(const std::wstring_view& text) noexcept
+    {
+        auto it = text.data();
+        const auto end = it + text.size();
+
+#if defined(TIL_SSE_INTRINSICS)
+        // Most text is ASCII, which means we can skip 8 characters at a time if they're all below U+00DF.
+        for (const auto end8 = it + (text.size() & ~size_t{ 7 }); it < end8; it += 8)
+        {
+            const auto wch = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            const auto above = _mm_subs_epu16(wch, _mm_set1_epi16(0x00de));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(above, _mm_setzero_si128())) != 0xffff)
+            {
+                for (auto i = 0; i < 8; ++i)
+                {
+                    if (foldsIntoAscii(it[i]))
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+#endif
+
+        for (; it < end; ++it)
+        {
+            if (foldsIntoAscii(*it))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // A literal (non-regex) needle matcher over the rows of a TextBuffer, which produces the same results as ICU's
+    // UREGEX_LITERAL search via UTextFromTextBuffer(). Just like the UText, it treats the rows as one contiguous string
+    // and so matches may span multiple rows. Since it operates directly on ROW::GetText() and checks the first and last
+    // character of the needle in bulk with SIMD, it's an order of magnitude faster than ICU.
+    //
+    // Case-insensitive matching is implemented by OR-ing 0x20 into ASCII letters. This only works for ASCII needles and
+    // only if the text doesn't contain any of the few characters that fold into ASCII (see foldsIntoAscii()).
+    class LiteralMatcher
+    {
+    public:
+        LiteralMatcher(const TextBuffer& textBuffer, til::CoordType rowEnd) noexcept :
+            _textBuffer{ textBuffer },
+            _rowEnd{ rowEnd }
+        {
+        }
+
+        // Returns false if the needle requires ICU.
+        bool SetNeedle(const std::wstring_view& needle, bool caseInsensitive)
+        {
+            // ICU iterates by code point and so a match never starts or ends in the middle of a surrogate pair.
+            if (til::is_trailing_surrogate(needle.front()) || til::is_leading_surrogate(needle.back()))
+            {
+                return false;
+            }
+
+            _needle.resize(needle.size());
+            _masks.resize(needle.size());
+            _caseInsensitive = caseInsensitive;
+
+            for (size_t i = 0; i < needle.size(); ++i)
+            {
+                auto ch = til::at(needle, i);
+                uint16_t mask = 0;
+
+                if (caseInsensitive)
+                {
+                    if (ch >= 0x80)
+                    {
+                        return false;
+                    }
+                    if ((ch | 0x20) >= L'a' && (ch | 0x20) <= L'z')
+                    {
+                        ch |= 0x20;
+                        mask = 0x20;
+                    }
+                }
+
+                til::at(_needle, i) = ch;
+                til::at(_masks, i) = mask;
+            }
+
+            return true;
+        }
+
+        // Returns false if the text requires ICU, in which case `results` contains garbage.
+        bool Search(std::vector<til::point_span>& results, til::CoordType rowBeg)
+        {
+            auto y = rowBeg;
+            size_t offset = 0;
+
+            while (y < _rowEnd)
+            {
+                const auto& row = _textBuffer.GetRowByOffset(y);
+                const auto text = row.GetText();
+                if (!_checkRow(y, text))
+                {
+                    return false;
+                }
+
+                std::optional<CharToColumnMapper> mapper;
+                // `row` needs to stay valid while _matchAt() reads the following rows. See TextBuffer::GetRowByOffset().
+                std::optional<TextBuffer::RowPin> pin;
+                auto nextY = y + 1;
+                size_t nextOffset = 0;
+
+                while (offset < text.size())
+                {
+                    const auto pos = _findCandidate(text, offset);
+                    if (pos >= text.size())
+                    {
+                        break;
+                    }
+
+                    if (!pin && pos + _needle.size() > text.size())
+                    {
+                        pin.emplace(_textBuffer, y);
+                    }
+
+                    auto endY = y;
+                    size_t endOffset = 0;
+                    if (!_matchAt(text, pos, endY, endOffset))
+                    {
+                        if (_fallback)
+                        {
+                            return false;
+                        }
+                        offset = pos + 1;
+                        continue;
+                    }
+
+                    if (!mapper)
+                    {
+                        mapper.emplace(row.CreateCharToColumnMapper(gsl::narrow_cast<ptrdiff_t>(pos)));
+                    }
+
+                    auto& span = results.emplace_back();
+                    span.start = { mapper->GetLeadingColumnAt(gsl::narrow_cast<ptrdiff_t>(pos)), y };
+
+                    if (endY == y)
+                    {
+                        span.end = { mapper->GetTrailingColumnAt(gsl::narrow_cast<ptrdiff_t>(endOffset)), y };
+                        offset = endOffset + 1;
+                        continue;
+                    }
+
+                    // The match continues in a following row. Just like ICU, we continue searching after its end.
+                    const auto& endRow = _textBuffer.GetRowByOffset(endY);
+                    span.end = { endRow.GetTrailingColumnAtCharOffset(gsl::narrow_cast<ptrdiff_t>(endOffset)), endY };
+                    nextY = endY;
+                    nextOffset = endOffset + 1;
+                    break;
+                }
+
+                y = nextY;
+                offset = nextOffset;
+            }
+
+            return true;
+        }
+
+    private:
+        // Verifies that the row can be searched without ICU. Each row is only checked once.
+        bool _checkRow(til::CoordType y, const std::wstring_view& text) noexcept
+        {
+            if (y < _checkedRows)
+            {
+                return true;
+            }
+            _checkedRows = y + 1;
+            _fallback = _caseInsensitive && containsFoldsIntoAscii(text);
+            return !_fallback;
+        }
+
+        bool _charMatches(wchar_t ch, size_t i) const noexcept
+        {
+            return (ch | til::at(_masks, i)) == til::at(_needle, i);
+        }
+
+        // Returns the first offset >= `offset` at which the first character of the needle matches, as well as the last
+        // one, if the needle fits into the remaining text. Returns text.size() if there are no such candidates.
+        size_t _findCandidate(const std::wstring_view& text, size_t offset) const noexcept
+        {
+            const auto data = text.data();
+            const auto lastIndex = _needle.size() - 1;
+            // Candidates in [offset,fitEnd) fit into this row. Those in [fitEnd,text.size()) continue in the next row.
+            const auto fitEnd = std::max(offset, text.size() >= _needle.size() ? text.size() - lastIndex : 0);
+            auto it = offset;
+
+#if defined(TIL_SSE_INTRINSICS)
+            const auto firstChar = _mm_set1_epi16(_needle.front());
+            const auto firstMask = _mm_set1_epi16(_masks.front());
+            const auto lastChar = _mm_set1_epi16(_needle.back());
+            const auto lastMask = _mm_set1_epi16(_masks.back());
+
+            for (; it + 8 <= fitEnd; it += 8)
+            {
+                auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + it));
+                auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + it + lastIndex));
+                a = _mm_cmpeq_epi16(_mm_or_si128(a, firstMask), firstChar);
+                b = _mm_cmpeq_epi16(_mm_or_si128(b, lastMask), lastChar);
+
+                const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_and_si128(a, b)));
+                if (mask)
+                {
+                    unsigned long index;
+                    _BitScanForward(&index, mask);
+                    return it + index / 2;
+                }
+            }
+#elif defined(TIL_ARM_NEON_INTRINSICS)
+            const auto firstChar = vdupq_n_u16(_needle.front());
+            const auto firstMask = vdupq_n_u16(_masks.front());
+            const auto lastChar = vdupq_n_u16(_needle.back());
+            const auto lastMask = vdupq_n_u16(_masks.back());
+
+            for (; it + 8 <= fitEnd; it += 8)
+            {
+                const auto a = vceqq_u16(vorrq_u16(vld1q_u16(reinterpret_cast<const uint16_t*>(data + it)), firstMask), firstChar);
+                const auto b = vceqq_u16(vorrq_u16(vld1q_u16(reinterpret_cast<const uint16_t*>(data + it + lastIndex)), lastMask), lastChar);
+                // Narrowing the 16-bit lanes to 8 bits results in a 64-bit mask with 8 bits per candidate.
+                const auto mask = vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(vandq_u16(a, b))), 0);
+                if (mask)
+                {
+                    unsigned long index;
+                    _BitScanForward64(&index, mask);
+                    return it + index / 8;
+                }
+            }
+#endif
+
+            for (; it < fitEnd; ++it)
+            {
+                if (_charMatches(data[it], 0) && _charMatches(data[it + lastIndex], lastIndex))
+                {
+                    return it;
+                }
+            }
+
+            for (; it < text.size(); ++it)
+            {
+                if (_charMatches(data[it], 0))
+                {
+                    return it;
+                }
+            }
+
+            return text.size();
+        }
+
+        // Compares the entire needle against the text starting at `pos` in row `y`, continuing into the
+        // following rows if needed. On success, `y` and `offset` will point to the last matching character.
+        bool _matchAt(std::wstring_view text, size_t pos, til::CoordType& y, size_t& offset)
+        {
+            for (size_t i = 0; i < _needle.size(); ++i, ++pos)
+            {
+                while (pos >= text.size())
+                {
+                    if (++y >= _rowEnd)
+                    {
+                        return false;
+                    }
+                    text = _textBuffer.GetRowByOffset(y).GetText();
+                    if (!_checkRow(y, text))
+                    {
+                        return false;
+                    }
+                    pos = 0;
+                }
+
+                if (!_charMatches(text[pos], i))
+                {
+                    return false;
+                }
+            }
+
+            offset = pos - 1;
+            return true;
+        }
+
+        const TextBuffer& _textBuffer;
+        til::CoordType _rowEnd;
+        til::CoordType _checkedRows = 0;
+        std::wstring _needle;
+        std::vector<uint16_t> _masks;
+        bool _caseInsensitive = false;
+        bool _fallback = false;
+    };
+}
+
+// Searches for `needle` using LiteralMatcher. Returns false if the needle or the text require ICU instead.
+bool TextBuffer::_searchTextLiteral(std::vector<til::point_span>& results, const std::wstring_view& needle, bool caseInsensitive, til::CoordType rowBeg, til::CoordType rowEnd) const
+{
+    LiteralMatcher matcher{ *this, rowEnd };
+    return matcher.SetNeedle(needle, caseInsensitive) && matcher.Search(results, rowBeg);
+}
+
+void TextBuffer::_searchTextICU(std::vector<til::point_span>& results, const std::wstring_view& needle, bool caseInsensitive, til::CoordType rowBeg, til::CoordType rowEnd) const
+{
     auto text = ICU::UTextFromTextBuffer(*this, rowBeg, rowEnd);
 
     uint32_t flags = UREGEX_LITERAL;
@@ -2753,8 +4524,6 @@ std::vector<til::point_span> TextBuffer::SearchText(const std::wstring_view& nee
             results.emplace_back(ICU::BufferRangeFromMatch(&text, re.get()));
         } while (uregex_findNext(re.get(), &status));
     }
-
-    return results;
 }
 
 const std::vector<ScrollMark>& TextBuffer::GetMarks() const noexcept
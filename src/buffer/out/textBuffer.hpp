@@ -54,6 +54,7 @@ filling in the last row, and updating the screen.
 #include "cursor.h"
 #include "Row.hpp"
 #include "TextAttribute.hpp"
+#include "TextAttributeTable.hpp"
 #include "../types/inc/Viewport.hpp"
 
 #include "../buffer/out/textBufferCellIterator.hpp"
@@ -123,9 +124,30 @@ public:
     // row manipulation
     ROW& GetScratchpadRow();
     ROW& GetScratchpadRow(const TextAttribute& attributes);
+    // The returned ROW is only valid until the buffer gets modified. While the cold scrollback storage is enabled
+    // (see SetColdScrollbackDistance()), reading other rows can invalidate it as well: Cold rows are unpacked into
+    // a pool of _coldThawPoolSize (256) ROWs, which recycles the least recently unpacked one once that many other
+    // cold rows have been read. Callers that hold onto a ROW while reading an unbounded number of rows need a RowPin.
     const ROW& GetRowByOffset(til::CoordType index) const;
     ROW& GetMutableRowByOffset(til::CoordType index);
 
+    // Keeps the ROW that GetRowByOffset() returned for the given row from being recycled by
+    // the thaw pool for as long as the pin exists. It doesn't protect it from modifications.
+    class RowPin
+    {
+    public:
+        RowPin(const TextBuffer& buffer, til::CoordType y);
+        ~RowPin();
+
+        RowPin(const RowPin&) = delete;
+        RowPin& operator=(const RowPin&) = delete;
+
+    private:
+        TextBuffer* _buffer = nullptr;
+        size_t _index = 0;
+        uint32_t _epoch = 0;
+    };
+
     TextBufferCellIterator GetCellDataAt(const til::point at) const;
     TextBufferCellIterator GetCellLineDataAt(const til::point at) const;
     TextBufferCellIterator GetCellDataAt(const til::point at, const Microsoft::Console::Types::Viewport limit) const;
@@ -169,6 +191,9 @@ public:
     const Cursor& GetCursor() const noexcept;
 
     uint64_t GetLastMutationId() const noexcept;
+    uint64_t GetRowGeneration(til::CoordType y) const noexcept;
+    til::CoordType FindChangedRow(uint64_t generation, til::CoordType beg, til::CoordType end) const noexcept;
+    til::CoordType FindUnchangedRow(uint64_t generation, til::CoordType beg, til::CoordType end) const noexcept;
     const til::CoordType GetFirstRowIndex() const noexcept;
 
     const Microsoft::Console::Types::Viewport GetSize() const noexcept;
@@ -196,6 +221,27 @@ public:
 
     void ResizeTraditional(const til::size newSize);
 
+    void SetColdScrollbackDistance(til::CoordType distance);
+    void CompactScrollback();
+    size_t GetAttributeCount() const noexcept;
+
+    void SetPrefault(bool enabled);
+    size_t DecommitBlankRows();
+
+    // Counts how often and how much of the memory arena has been committed and decommitted.
+    struct CommitStatistics
+    {
+        // Calls to VirtualAlloc(MEM_COMMIT) on the writer thread.
+        size_t commits = 0;
+        size_t committedBytes = 0;
+        // Same, but done ahead of time in the background. See SetPrefault().
+        size_t prefaults = 0;
+        size_t prefaultedBytes = 0;
+        // Returned to the OS by DecommitBlankRows().
+        size_t decommittedBytes = 0;
+    };
+    const CommitStatistics& GetCommitStatistics() const noexcept;
+
     void SetAsActiveBuffer(const bool isActiveBuffer) noexcept;
     bool IsActiveBuffer() const noexcept;
 
@@ -279,13 +325,41 @@ public:
     std::wstring_view CurrentCommand() const;
 
 private:
+    struct ThawedRow;
+
     void _reserve(til::size screenBufferSize, const TextAttribute& defaultAttributes);
+    void _setInitialAttributes(const TextAttribute& attributes) noexcept;
+    void _shareAttributeTable(const TextBuffer& other);
     void _commit(const std::byte* row);
     void _decommit() noexcept;
+    static void CALLBACK _prefaultCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work) noexcept;
+    void _submitPrefault() noexcept;
+    void _waitForPrefault() noexcept;
+    bool _isBlankRow(uint16_t slot, size_t committedSlots) const noexcept;
+    size_t _decommitBlankColdRows();
+    size_t _decommitSlots(size_t keepSlots) noexcept;
     void _construct(const std::byte* until) noexcept;
     void _destroy() const noexcept;
     ROW& _getRowByOffsetDirect(size_t offset);
     ROW& _getRow(til::CoordType y) const;
+    ROW& _getMutableRow(til::CoordType y);
+    size_t _getRowMapIndex(til::CoordType y) const noexcept;
+    void _markRowChanged(size_t index) noexcept;
+    void _markAllRowsChanged() noexcept;
+    void _resetRowMap() noexcept;
+    ROW& _thawRow(size_t index, bool mutate);
+    ThawedRow* _findThawedRow(size_t index) noexcept;
+    void _unpackColdRow(ROW& row, size_t index);
+    void _releaseColdRow(size_t index) noexcept;
+    uint16_t _allocateRowSlot();
+    void _releaseThawedRows();
+    void _freezeScrollback(til::CoordType cursorY);
+    bool _isPendingRow(size_t index) const noexcept;
+    ROW& _reflowPendingRow(size_t index);
+    void _reflowPendingRows(til::CoordType y);
+    uint16_t _allocatePendingRowSlot();
+    void _discardFirstPendingRow();
+    std::shared_ptr<TextBuffer> _detachRows();
     til::CoordType _estimateOffsetOfLastCommittedRow() const noexcept;
 
     void _SetFirstRowIndex(const til::CoordType FirstRowIndex) noexcept;
@@ -302,6 +376,8 @@ private:
     til::point _GetWordEndForSelection(const til::point target, const std::wstring_view wordDelimiters) const;
     void _PruneHyperlinks();
     void _trimMarksOutsideBuffer();
+    bool _searchTextLiteral(std::vector<til::point_span>& results, const std::wstring_view& needle, bool caseInsensitive, til::CoordType rowBeg, til::CoordType rowEnd) const;
+    void _searchTextICU(std::vector<til::point_span>& results, const std::wstring_view& needle, bool caseInsensitive, til::CoordType rowBeg, til::CoordType rowEnd) const;
 
     static void _AppendRTFText(std::ostringstream& contentBuilder, const std::wstring_view& text);
 
@@ -343,17 +419,46 @@ private:
     // In other words, _commitWatermark itself will either point exactly onto the next ROW
     // that should be committed or be equal to _bufferEnd when all ROWs are committed.
     std::byte* _commitWatermark = nullptr;
-    // This will MEM_COMMIT 128 rows more than we need, to avoid us from having to call VirtualAlloc too often.
+    // This will MEM_COMMIT at least 128 rows more than we need, to avoid us from having to call VirtualAlloc too often.
     // This equates to roughly the following commit chunk sizes at these column counts:
     // *  80 columns (the usual minimum) =  60KB chunks,  4.1MB buffer at 9001 rows
     // * 120 columns (the most common)   =  80KB chunks,  5.6MB buffer at 9001 rows
     // * 400 columns (the usual maximum) = 220KB chunks, 15.5MB buffer at 9001 rows
     // There's probably a better metric than this. (This comment was written when ROW had both,
     // a _chars array containing text and a _charOffsets array contain column-to-text indices.)
-    static constexpr size_t _commitReadAheadRowCount = 128;
+    //
+    // Every time the rows right past the _commitWatermark get accessed, which is what continuous scrolling does,
+    // the read-ahead doubles up to the maximum. This turns a long burst of output into a few large commits.
+    // It's reset to the minimum whenever the arena gets decommitted.
+    static constexpr size_t _commitReadAheadMinRowCount = 128;
+    static constexpr size_t _commitReadAheadMaxRowCount = 4096;
+    size_t _commitReadAheadRowCount = _commitReadAheadMinRowCount;
+    // The range between _commitWatermark (inclusive) and _prefaultWatermark (exclusive) has been committed
+    // and touched in the background, but doesn't contain any ROWs yet. See SetPrefault().
+    std::byte* _prefaultWatermark = nullptr;
+    // The state shared with the threadpool callback that commits memory ahead of the _commitWatermark.
+    // It only ever accesses [beg, end), which is beyond the _commitWatermark, and _commit()
+    // waits for it to finish before constructing ROWs or otherwise touching that memory.
+    struct Prefault
+    {
+        std::byte* beg = nullptr;
+        std::byte* end = nullptr;
+        // Set by the callback if VirtualAlloc succeeded.
+        bool committed = false;
+        bool pending = false;
+        wil::unique_threadpool_work work;
+    };
+    // Declared after _buffer, so that it waits for the callback before the arena is released.
+    std::unique_ptr<Prefault> _prefault;
+    CommitStatistics _commitStatistics;
+    // The attributes of all ROWs are stored as IDs into this table. It's shared with the buffers that Reflow() and
+    // ResizeTraditional() create from this one, so that they can copy ROWs without translating their attributes.
+    std::shared_ptr<TextAttributeTable> _attributes;
     // Before TextBuffer was made to use virtual memory it initialized the entire memory arena with the initial
     // attributes right away. To ensure it continues to work the way it used to, this stores these initial attributes.
     TextAttribute _initialAttributes;
+    // The ID of _initialAttributes in _attributes. The TextBuffer holds a reference to it.
+    uint16_t _initialAttributesId = TextAttributeTable::InvalidId;
     // ROW ---------------+--+--+
     // (padding)          |  |  v _bufferOffsetChars
     // ROW::_charsBuffer  |  |
@@ -367,6 +472,99 @@ private:
     uint16_t _width = 0;
     // The height of the buffer in rows, excluding the scratchpad row.
     uint16_t _height = 0;
+    // Maps from the circular row offset (that's `(_firstRow + y) % _height`) to the offset of the ROW in the
+    // memory arena, which is what _getRowByOffsetDirect() expects (= starting at 1, because 0 is the scratchpad).
+    // It starts out as the identity mapping and allows ScrollRows() to move rows by rotating this array.
+    std::vector<uint16_t> _rowMap;
+    // Indexed just like _rowMap. Stores the _lastMutationId of the last modification of each row.
+    // Rows that were moved by ScrollRows() count as modified, because their contents changed position.
+    std::vector<uint64_t> _rowGenerations;
+    // The maximum of each _rowGenerationBlockSize-many consecutive _rowGenerations.
+    // It allows FindChangedRow() to skip over large unchanged parts of the buffer.
+    static constexpr size_t _rowGenerationBlockSize = 64;
+    std::vector<uint64_t> _rowGenerationBlocks;
+
+    // The cold scrollback storage is an opt-in mode (see SetColdScrollbackDistance()) for very large buffers. Rows that
+    // are far enough above the cursor get packed via ROW::Pack() into a compact heap allocation and their ROW in the
+    // memory arena gets recycled. In this mode, a _rowMap entry of 0 means that the row isn't stored in the arena.
+    // It's then either stored in ColdScrollback::rows under the same index or blank, because it was never written to.
+    // Reading such a row unpacks a copy into a small pool of ROWs and writing to it moves it back into the arena.
+    // This way the commit charge of the arena is limited to roughly the rows around the cursor.
+    // Packed rows store the same attribute IDs as the ROWs. Each blob holds a reference to its IDs
+    // until the row gets thawed for writing, which includes rows rotated out of the top.
+    struct ColdRow
+    {
+        // The blob created by ROW::Pack() or nullptr if the row is blank.
+        std::unique_ptr<std::byte[]> data;
+        uint32_t size = 0;
+        // If non-zero, this is the arena offset of the ROW in the thaw pool that holds a copy of this row.
+        uint16_t thawedSlot = 0;
+    };
+    struct ThawedRow
+    {
+        // The arena offset of the ROW. 0 if it hasn't been allocated yet.
+        uint16_t slot = 0;
+        // The ColdScrollback::rows index this ROW is a copy of.
+        size_t owner = SIZE_MAX;
+        // The number of RowPins that prevent this entry from being evicted.
+        uint32_t pins = 0;
+    };
+    struct ColdScrollback
+    {
+        // Indexed just like _rowMap. Empty if the cold scrollback storage is disabled.
+        std::vector<ColdRow> rows;
+        // ROWs returned by GetRowByOffset() for cold rows are only valid until this many other
+        // cold rows have been read. This is plenty for algorithms that iterate over the buffer.
+        // The pool grows beyond _coldThawPoolSize entries if all of them are pinned by a RowPin.
+        std::vector<ThawedRow> thawPool;
+        size_t thawPoolNext = 0;
+        // Incremented whenever pinned entries may get released. RowPins of a previous epoch are stale.
+        uint32_t thawPoolEpoch = 0;
+        // The arena offsets of recycled ROWs and the lowest offset that hasn't been handed out yet.
+        std::vector<uint16_t> freeSlots;
+        uint16_t nextSlot = 1;
+        // Rows that are more than this many rows above the cursor get packed by CompactScrollback().
+        til::CoordType distance = 0;
+        // All rows in [0, frozenRows) are known to be cold. This turns CompactScrollback() into an O(1) operation.
+        til::CoordType frozenRows = 0;
+        // All rows in [touchedRows, _height) are known to be blank. See _estimateOffsetOfLastCommittedRow().
+        til::CoordType touchedRows = 0;
+        // Scratch buffer for ROW::Pack().
+        std::vector<std::byte> packBuffer;
+    };
+    static constexpr size_t _coldThawPoolSize = 256;
+    ColdScrollback _cold;
+
+    // Reflow() only reflows the rows around the cursor and viewport right away. The scrollback above it is kept
+    // unreflowed and only reflowed once it's accessed. Such "pending" rows have a _rowMap entry of 0, just like cold
+    // rows, but they're always at the top of the buffer, which is how _isPendingRow() tells them apart. They get
+    // reflowed bottom-up, one logical line at a time, because that's the only direction in which the layout of a
+    // row is known up front.
+    struct PendingReflowSegment
+    {
+        // The unreflowed rows. This is usually the previous buffer (see _detachRows()).
+        std::shared_ptr<const TextBuffer> source;
+        // The rows [begin, end) of the source. Both are at the start of a logical line.
+        til::CoordType begin = 0;
+        til::CoordType end = 0;
+        // The number of logical lines in [begin, end).
+        til::CoordType lines = 0;
+    };
+    struct PendingReflow
+    {
+        // Ordered from top to bottom. The last logical line of the last segment gets reflowed next.
+        std::vector<PendingReflowSegment> segments;
+        // All rows in [0, rows) are pending.
+        til::CoordType rows = 0;
+        // The arena offset of the ROW that will be used for the next reflowed row.
+        // With the cold scrollback storage, the ROWs come from _allocateRowSlot() instead.
+        uint16_t nextSlot = 1;
+    };
+    // How many rows above the cursor and viewport Reflow() reflows right away.
+    static constexpr til::CoordType _pendingReflowMargin = 256;
+    // How many rows of the new buffer Reflow() copies at once, before packing them, if the cold scrollback storage is enabled.
+    static constexpr til::CoordType _reflowBatchRows = 1024;
+    PendingReflow _pendingReflow;
 
     TextAttribute _currentAttributes;
     til::CoordType _firstRow = 0; // indexes top row (not necessarily 0)
@@ -379,5 +577,7 @@ private:
 #ifdef UNIT_TESTING
     friend class TextBufferTests;
     friend class UiaTextRangeTests;
+    friend class TextSearchTests;
+    friend class ReflowTests;
 #endif
 };
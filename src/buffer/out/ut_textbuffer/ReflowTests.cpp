@@ -805,6 +805,212 @@ class ReflowTests
             _compareTextBufferAgainstTestBuffer(*textBuffer, testBuffer);
         }
     }
+
+    static void _compareTextBuffers(const TextBuffer& expected, const TextBuffer& actual)
+    {
+        VERIFY_ARE_EQUAL(expected.GetSize().Dimensions(), actual.GetSize().Dimensions());
+        VERIFY_ARE_EQUAL(expected.GetCursor().GetPosition(), actual.GetCursor().GetPosition());
+
+        for (til::CoordType y = 0; y < expected.GetSize().Height(); ++y)
+        {
+            const auto& expectedRow = expected.GetRowByOffset(y);
+            const auto& actualRow = actual.GetRowByOffset(y);
+            VERIFY_ARE_EQUAL(expectedRow.GetText(), actualRow.GetText());
+            VERIFY_ARE_EQUAL(expectedRow.WasWrapForced(), actualRow.WasWrapForced());
+        }
+    }
+
+    // Creates a buffer filled with lines of random length, some of them wrapped and containing wide glyphs.
+    static std::unique_ptr<TextBuffer> _createLargeTextBuffer(const til::size size, bool cold)
+    {
+        auto buffer = std::make_unique<TextBuffer>(size, TextAttribute{ 0x7 }, 0, false, renderer);
+        if (cold)
+        {
+            buffer->SetColdScrollbackDistance(100);
+        }
+
+        uint32_t seed = 1;
+        for (til::CoordType y = 0; y < size.height; ++y)
+        {
+            seed = seed * 1103515245 + 12345;
+            const auto width = gsl::narrow_cast<til::CoordType>((seed >> 16) % (size.width + 1));
+
+            auto& row = buffer->GetMutableRowByOffset(y);
+            for (til::CoordType x = 0; x < width;)
+            {
+                if (x + 1 < width && (x + y) % 13 == 0)
+                {
+                    row.ReplaceCharacters(x, 2, L"\u304b");
+                    x += 2;
+                }
+                else
+                {
+                    const auto ch = gsl::narrow_cast<wchar_t>(L'a' + (x + y) % 26);
+                    row.ReplaceCharacters(x, 1, { &ch, 1 });
+                    x += 1;
+                }
+            }
+            row.SetWrapForced(width == size.width && (seed & 0x10000) != 0);
+        }
+
+        buffer->GetCursor().SetPosition({ 7, size.height - 1 });
+        return buffer;
+    }
+
+    static std::unique_ptr<TextBuffer> _reflowAndLogTiming(TextBuffer& buffer, const til::size newSize, TextBuffer::PositionInformation* positionInfo)
+    {
+        auto newBuffer = std::make_unique<TextBuffer>(newSize, TextAttribute{ 0x7 }, 0, false, renderer);
+
+        const auto beg = std::chrono::steady_clock::now();
+        TextBuffer::Reflow(buffer, *newBuffer, nullptr, positionInfo);
+        const auto end = std::chrono::steady_clock::now();
+
+        Log::Comment(NoThrowString().Format(L"%dx%d to %dx%d: %.3fms", buffer.GetSize().Width(), buffer.GetSize().Height(), newSize.width, newSize.height, std::chrono::duration<double, std::milli>(end - beg).count()));
+        return newBuffer;
+    }
+
+    // Scrolling to the top of the buffer prevents Reflow() from deferring any of the scrollback.
+    static std::unique_ptr<TextBuffer> _reflowEagerly(TextBuffer& buffer, const til::size newSize)
+    {
+        TextBuffer::PositionInformation position{ .mutableViewportTop = 0, .visibleViewportTop = 0 };
+        auto newBuffer = _reflowAndLogTiming(buffer, newSize, &position);
+        VERIFY_ARE_EQUAL(0, newBuffer->_pendingReflow.rows);
+        return newBuffer;
+    }
+
+    // Reflow() splits its work across threads for large buffers. With the cold scrollback storage enabled, each thread
+    // unpacks the cold rows on its own and the new rows are packed in batches. This tests that both produce identical
+    // results and logs the timings.
+    TEST_METHOD(ReflowLargeBuffer)
+    {
+        static constexpr til::size size{ 120, 9001 };
+
+        WEX::TestExecution::DisableVerifyExceptions disableVerifyExceptions{};
+        WEX::TestExecution::SetVerifyOutput verifyOutputScope{ WEX::TestExecution::VerifyOutputSettings::LogOnlyFailures };
+
+        for (const auto width : { 80, 200, 45 })
+        {
+            // Scrolling to the top of the buffer prevents Reflow() from deferring any of the scrollback.
+            TextBuffer::PositionInformation arenaPosition{ .mutableViewportTop = size.height - 30, .visibleViewportTop = 0 };
+            TextBuffer::PositionInformation coldPosition = arenaPosition;
+
+            const auto arena = _createLargeTextBuffer(size, false);
+            const auto cold = _createLargeTextBuffer(size, true);
+            VERIFY_IS_FALSE(cold->_cold.rows.empty());
+
+            Log::Comment(L"Arena:");
+            const auto arenaResult = _reflowAndLogTiming(*arena, { width, size.height }, &arenaPosition);
+            VERIFY_ARE_EQUAL(0, arenaResult->_pendingReflow.rows);
+            Log::Comment(L"Cold:");
+            const auto coldResult = _reflowAndLogTiming(*cold, { width, size.height }, &coldPosition);
+            VERIFY_IS_GREATER_THAN(coldResult->_cold.frozenRows, size.height / 2);
+
+            _compareTextBuffers(*arenaResult, *coldResult);
+            VERIFY_ARE_EQUAL(arenaPosition.mutableViewportTop, coldPosition.mutableViewportTop);
+            VERIFY_ARE_EQUAL(arenaPosition.visibleViewportTop, coldPosition.visibleViewportTop);
+        }
+    }
+
+    // If the scrollback fills up the buffer, Reflow() only reflows the rows around the cursor and leaves the
+    // rest pending until it's accessed. This tests that a series of resizes, like dragging a window edge, results
+    // in the same buffer contents as reflowing everything right away, and logs the timings.
+    TEST_METHOD(ReflowDefersScrollback)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"Data:cold", L"{false, true}")
+        END_TEST_METHOD_PROPERTIES()
+
+        INIT_TEST_PROPERTY(bool, cold, L"If true, enable the cold scrollback storage, whose rows share the _rowMap entry of 0 with pending rows.");
+
+        static constexpr til::size size{ 120, 9001 };
+
+        WEX::TestExecution::DisableVerifyExceptions disableVerifyExceptions{};
+        WEX::TestExecution::SetVerifyOutput verifyOutputScope{ WEX::TestExecution::VerifyOutputSettings::LogOnlyFailures };
+
+        auto deferred = _createLargeTextBuffer(size, cold);
+        auto eager = _createLargeTextBuffer(size, cold);
+
+        // The widths only shrink, because pending rows are reflowed from their original text. A narrower size in
+        // between doesn't cut off the top of the scrollback for them, unlike it does when everything is reflowed.
+        for (const auto width : { 110, 100, 90, 80 })
+        {
+            Log::Comment(L"Deferred:");
+            deferred = _reflowAndLogTiming(*deferred, { width, size.height }, nullptr);
+            Log::Comment(L"Eager:");
+            eager = _reflowEagerly(*eager, { width, size.height });
+
+            VERIFY_IS_GREATER_THAN(deferred->_pendingReflow.rows, size.height / 2);
+            VERIFY_ARE_EQUAL(1u, deferred->_pendingReflow.segments.size());
+            VERIFY_ARE_EQUAL(cold, !deferred->_cold.rows.empty());
+        }
+
+        // Accessing the rows reflows them.
+        _compareTextBuffers(*eager, *deferred);
+        VERIFY_ARE_EQUAL(0, deferred->_pendingReflow.rows);
+        VERIFY_IS_TRUE(deferred->_pendingReflow.segments.empty());
+    }
+
+    // Shrinking the buffer cuts off the lines at the top of the scrollback that don't fit anymore. Reflowing eagerly loses
+    // them, but pending rows still have them once the buffer grows again, which results in more scrollback and a lower
+    // cursor position. This tests that the buffers are otherwise identical, including the rows that got reflowed in between.
+    TEST_METHOD(ReflowDefersScrollbackAcrossShrinkAndGrow)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"Data:cold", L"{false, true}")
+        END_TEST_METHOD_PROPERTIES()
+
+        INIT_TEST_PROPERTY(bool, cold, L"If true, enable the cold scrollback storage, whose rows share the _rowMap entry of 0 with pending rows.");
+
+        static constexpr til::size size{ 120, 9001 };
+
+        WEX::TestExecution::DisableVerifyExceptions disableVerifyExceptions{};
+        WEX::TestExecution::SetVerifyOutput verifyOutputScope{ WEX::TestExecution::VerifyOutputSettings::LogOnlyFailures };
+
+        auto deferred = _createLargeTextBuffer(size, cold);
+        auto eager = _createLargeTextBuffer(size, cold);
+
+        deferred = _reflowAndLogTiming(*deferred, { 80, size.height }, nullptr);
+        eager = _reflowEagerly(*eager, { 80, size.height });
+
+        Log::Comment(L"Pending rows that are accessed in between are reflowed at the smaller size");
+        const auto touchedEnd = deferred->_pendingReflow.rows;
+        VERIFY_IS_GREATER_THAN(touchedEnd, 1000);
+        for (auto y = touchedEnd - 1000; y < touchedEnd; ++y)
+        {
+            const auto& expectedRow = eager->GetRowByOffset(y);
+            const auto& actualRow = deferred->GetRowByOffset(y);
+            VERIFY_ARE_EQUAL(expectedRow.GetText(), actualRow.GetText());
+            VERIFY_ARE_EQUAL(expectedRow.WasWrapForced(), actualRow.WasWrapForced());
+        }
+        VERIFY_IS_GREATER_THAN(deferred->_pendingReflow.rows, 0);
+        VERIFY_IS_LESS_THAN_OR_EQUAL(deferred->_pendingReflow.rows, touchedEnd - 1000);
+
+        deferred = _reflowAndLogTiming(*deferred, size, nullptr);
+        eager = _reflowEagerly(*eager, size);
+        VERIFY_IS_GREATER_THAN(deferred->_pendingReflow.rows, 0);
+
+        const auto expectedCursor = eager->GetCursor().GetPosition();
+        const auto actualCursor = deferred->GetCursor().GetPosition();
+        VERIFY_ARE_EQUAL(expectedCursor.x, actualCursor.x);
+        VERIFY_IS_GREATER_THAN(actualCursor.y, expectedCursor.y);
+
+        // The first logical line of the eager buffer may be the remainder of one that got cut off partially.
+        // The deferred buffer has all of it, which is why it's skipped. Everything below is identical.
+        til::CoordType firstLineEnd = 0;
+        while (firstLineEnd < expectedCursor.y && eager->GetRowByOffset(firstLineEnd).WasWrapForced())
+        {
+            firstLineEnd++;
+        }
+
+        const auto offset = actualCursor.y - expectedCursor.y;
+        for (auto y = firstLineEnd + 1; y <= expectedCursor.y; ++y)
+        {
+            const auto& expectedRow = eager->GetRowByOffset(y);
+            const auto& actualRow = deferred->GetRowByOffset(y + offset);
+            VERIFY_ARE_EQUAL(expectedRow.GetText(), actualRow.GetText());
+            VERIFY_ARE_EQUAL(expectedRow.WasWrapForced(), actualRow.WasWrapForced());
+        }
+    }
 };
 
 DummyRenderer ReflowTests::renderer{};
@@ -0,0 +1,200 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../textBuffer.hpp"
+#include "../../renderer/inc/DummyRenderer.hpp"
+#include "../../types/inc/GlyphWidth.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class TextSearchTests
+{
+    TEST_CLASS(TextSearchTests);
+
+    static DummyRenderer renderer;
+
+    static std::unique_ptr<TextBuffer> _createTextBuffer(const til::size size, const std::initializer_list<std::wstring_view> rows)
+    {
+        auto buffer = std::make_unique<TextBuffer>(size, TextAttribute{ 0x7 }, 0, false, renderer);
+
+        til::CoordType y = 0;
+        for (const auto& text : rows)
+        {
+            auto& row = buffer->GetMutableRowByOffset(y);
+
+            til::CoordType x = 0;
+            for (size_t i = 0; i < text.size(); ++i)
+            {
+                // Keep surrogate pairs together.
+                const auto count = til::is_leading_surrogate(text[i]) ? 2 : 1;
+                const auto glyph = text.substr(i, count);
+                const til::CoordType width = IsGlyphFullWidth(glyph) ? 2 : 1;
+                row.ReplaceCharacters(x, width, glyph);
+                x += width;
+                i += count - 1;
+            }
+
+            y++;
+        }
+
+        return buffer;
+    }
+
+    static void _verifySpansEqual(const std::vector<til::point_span>& expected, const std::vector<til::point_span>& actual)
+    {
+        VERIFY_ARE_EQUAL(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(expected[i].start, actual[i].start);
+            VERIFY_ARE_EQUAL(expected[i].end, actual[i].end);
+        }
+    }
+
+    static std::vector<til::point_span> _searchICU(const TextBuffer& buffer, const std::wstring_view& needle, bool caseInsensitive)
+    {
+        std::vector<til::point_span> results;
+        buffer._searchTextICU(results, needle, caseInsensitive, 0, buffer.GetSize().Height());
+        return results;
+    }
+
+    TEST_METHOD(LiteralMatchesICU)
+    {
+        // The rows are 20 columns wide, which allows some of the matches to span across rows.
+        const auto buffer = _createTextBuffer({ 20, 8 }, {
+                                                             L"Hello World",
+                                                             L"hello world HELLO",
+                                                             L"           Hello Wor",
+                                                             L"ld \u304b\u304dhello\u304b",
+                                                             L"\U0001F600hello\U0001F600 aaaa",
+                                                             L"aaaaaaaaaaaaaaaaaaaa",
+                                                             L"aa",
+                                                         });
+
+        static constexpr std::wstring_view needles[]{
+            L"hello",
+            L"Hello",
+            L"world",
+            L"lo w",
+            L"o",
+            L"ld",
+            L"aaa",
+            L"a a",
+            L"\u304bh",
+            L"\u304b\u304d",
+            L"\U0001F600",
+            L"\U0001F600h",
+        };
+
+        for (const auto& needle : needles)
+        {
+            for (const auto caseInsensitive : { false, true })
+            {
+                Log::Comment(NoThrowString().Format(L"needle \"%.*s\", caseInsensitive=%d", gsl::narrow_cast<int>(needle.size()), needle.data(), caseInsensitive));
+
+                std::vector<til::point_span> actual;
+                const auto isAscii = std::all_of(needle.begin(), needle.end(), [](wchar_t ch) { return ch < 0x80; });
+                VERIFY_ARE_EQUAL(isAscii || !caseInsensitive, buffer->_searchTextLiteral(actual, needle, caseInsensitive, 0, 8));
+
+                const auto expected = _searchICU(*buffer, needle, caseInsensitive);
+                _verifySpansEqual(expected, buffer->SearchText(needle, caseInsensitive));
+                if (isAscii || !caseInsensitive)
+                {
+                    _verifySpansEqual(expected, actual);
+                }
+            }
+        }
+    }
+
+    TEST_METHOD(FallsBackToICUForCaseFolding)
+    {
+        // U+212A KELVIN SIGN case-folds to "k" and U+00DF LATIN SMALL LETTER SHARP S to "ss".
+        const auto buffer = _createTextBuffer({ 20, 2 }, {
+                                                             L"1 \u212a, 2 k",
+                                                             L"stra\u00dfe strasse",
+                                                         });
+
+        std::vector<til::point_span> results;
+        VERIFY_IS_FALSE(buffer->_searchTextLiteral(results, L"k", true, 0, 2));
+        VERIFY_IS_FALSE(buffer->_searchTextLiteral(results, L"\u00e9", true, 0, 2));
+
+        results.clear();
+        VERIFY_IS_TRUE(buffer->_searchTextLiteral(results, L"k", false, 0, 2));
+        VERIFY_ARE_EQUAL(1u, results.size());
+
+        _verifySpansEqual(_searchICU(*buffer, L"k", true), buffer->SearchText(L"k", true));
+        VERIFY_ARE_EQUAL(2u, buffer->SearchText(L"k", true).size());
+        _verifySpansEqual(_searchICU(*buffer, L"ss", true), buffer->SearchText(L"ss", true));
+    }
+
+    // Not a correctness test, but rather a comparison between the literal search and ICU on a large buffer.
+    TEST_METHOD(BenchmarkLiteralVsICU)
+    {
+        static constexpr til::size size{ 120, 9001 };
+        static constexpr std::wstring_view words[]{ L"lorem", L"ipsum", L"dolor", L"sit", L"amet", L"Consectetur", L"ADIPISCING", L"elit", L"sed", L"do" };
+
+        const auto buffer = _createTextBuffer(size, {});
+        uint32_t seed = 1;
+        for (til::CoordType y = 0; y < size.height; ++y)
+        {
+            auto& row = buffer->GetMutableRowByOffset(y);
+            std::wstring text;
+            while (text.size() < gsl::narrow_cast<size_t>(size.width))
+            {
+                seed = seed * 1103515245 + 12345;
+                text.append(words[(seed >> 16) % std::size(words)]);
+                text.push_back(L' ');
+            }
+            text.resize(size.width);
+            for (til::CoordType x = 0; x < size.width; ++x)
+            {
+                row.ReplaceCharacters(x, 1, { &text[x], 1 });
+            }
+        }
+
+        const auto bytes = static_cast<double>(size.width) * size.height * sizeof(wchar_t);
+
+        for (const auto& needle : { std::wstring_view{ L"consectetur" }, std::wstring_view{ L"e" }, std::wstring_view{ L"not found" } })
+        {
+            for (const auto caseInsensitive : { false, true })
+            {
+                static constexpr auto iterations = 5;
+                std::vector<til::point_span> literal;
+                std::vector<til::point_span> icu;
+
+                const auto beg = std::chrono::steady_clock::now();
+                for (auto i = 0; i < iterations; ++i)
+                {
+                    literal.clear();
+                    VERIFY_IS_TRUE(buffer->_searchTextLiteral(literal, needle, caseInsensitive, 0, size.height));
+                }
+                const auto mid = std::chrono::steady_clock::now();
+                for (auto i = 0; i < iterations; ++i)
+                {
+                    icu = _searchICU(*buffer, needle, caseInsensitive);
+                }
+                const auto end = std::chrono::steady_clock::now();
+
+                _verifySpansEqual(icu, literal);
+
+                const auto literalSeconds = std::chrono::duration<double>(mid - beg).count() / iterations;
+                const auto icuSeconds = std::chrono::duration<double>(end - mid).count() / iterations;
+                Log::Comment(NoThrowString().Format(
+                    L"needle \"%.*s\", caseInsensitive=%d, %zu hits: literal %.1f MB/s, ICU %.1f MB/s",
+                    gsl::narrow_cast<int>(needle.size()),
+                    needle.data(),
+                    caseInsensitive,
+                    literal.size(),
+                    bytes / literalSeconds / 1e6,
+                    bytes / icuSeconds / 1e6));
+            }
+        }
+    }
+};
+
+DummyRenderer TextSearchTests::renderer{};
@@ -5,6 +5,7 @@
 #include "ConptyConnection.h"
 
 #include <conpty-static.h>
+#include <til/atomic.h>
 #include <til/string.h>
 #include <winternl.h>
 
@@ -414,6 +415,8 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 
         _startTime = std::chrono::high_resolution_clock::now();
 
+        _inputWriter = std::make_unique<::Microsoft::Console::Utils::PipeWriter>(_inPipe.get());
+
         // Create our own output handling thread
         // This must be done after the pipes are populated.
         // Each connection needs to make sure to drain the output from its backing host.
@@ -506,10 +509,63 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
             return;
         }
 
-        // convert from UTF-16LE to UTF-8 as ConPty expects UTF-8
-        // TODO GH#3378 reconcile and unify UTF-8 converters
-        auto str = winrt::to_string(data);
-        LOG_IF_WIN32_BOOL_FALSE(WriteFile(_inPipe.get(), str.c_str(), (DWORD)str.length(), nullptr, nullptr));
+        // The input writer thread converts the input to UTF-8 (as ConPTY expects it) and writes it in chunks.
+        // This way a large paste doesn't block our caller (usually the UI thread) while the client is busy.
+        const std::wstring_view str{ data };
+
+        // Ctrl+C aborts the remainder of a paste that's still being written.
+        if (_isInterrupt(str))
+        {
+            _inputWriter->Cancel();
+        }
+
+        // If a bracketed paste gets cancelled, we still need to write the end marker.
+        // Otherwise the shell would treat all further input as part of the paste.
+        static constexpr std::wstring_view pasteBegin{ L"\x1b[200~" };
+        static constexpr std::wstring_view pasteEnd{ L"\x1b[201~" };
+        const auto bracketed = str.starts_with(pasteBegin) && str.ends_with(pasteEnd);
+        _inputWriter->Write(str, bracketed ? pasteEnd.size() : 0);
+    }
+
+    // Returns true if the input is a Ctrl+C key press. Depending on the input mode
+    // it's either a plain ETX or a win32-input-mode sequence with a UnicodeChar of 3:
+    //   ESC [ Vk ; Sc ; Uc ; Kd ; Cs ; Rc _
+    bool ConptyConnection::_isInterrupt(const std::wstring_view input) noexcept
+    {
+        if (input == L"\x03")
+        {
+            return true;
+        }
+
+        if (input.size() > 32 || !input.starts_with(L"\x1b[") || !input.ends_with(L'_'))
+        {
+            return false;
+        }
+
+        unsigned int params[6]{};
+        size_t count = 0;
+        for (auto it = input.begin() + 2, end = input.end() - 1; it != end; ++it)
+        {
+            const auto ch = *it;
+            if (ch == L';')
+            {
+                if (++count == std::size(params))
+                {
+                    return false;
+                }
+            }
+            else if (ch >= L'0' && ch <= L'9')
+            {
+                til::at(params, count) = til::at(params, count) * 10 + gsl::narrow_cast<unsigned int>(ch - L'0');
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        // Uc (the character) must be ETX and Kd (key down) must be 1.
+        return til::at(params, 2) == 3 && til::at(params, 3) == 1;
     }
 
     void ConptyConnection::Resize(uint32_t rows, uint32_t columns)
@@ -572,6 +628,11 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         // FYI: The other members of this class are concurrently read by the _hOutputThread
         // thread running in the background and so they're not safe to be .reset().
         _hPC.reset();
+        // The input writer needs to stop using _inPipe before we close it.
+        if (_inputWriter)
+        {
+            _inputWriter->Stop();
+        }
         _inPipe.reset();
 
         if (_hOutputThread)
@@ -647,12 +708,35 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         // won't wait for us, and the known exit points _do_.
         auto strongThis{ get_strong() };
 
+        const auto traceOnExit = wil::scope_exit([&]() noexcept { _traceOutputStatistics(); });
+
+        // This thread only reads the output pipe and hands the raw bytes over to the parser thread,
+        // which converts and dispatches them. That way reading and parsing can happen concurrently.
+        auto channel = til::spsc::channel<char>(_ringCapacity);
+        auto& producer = channel.first;
+        std::thread parser{ [this, consumer = std::move(channel.second)]() mutable {
+            _ParserThread(std::move(consumer));
+        } };
+
+        // Dropping the producer makes the parser thread process the remaining output and exit.
+        // We need to wait for it before printing any exit messages, so that they appear after the output.
+        // It also ensures that Close() waiting for this thread means no more _TerminalOutputHandlers calls will happen.
+        const auto finishParser = [&]() noexcept {
+            if (parser.joinable())
+            {
+                producer = til::spsc::producer<char>{ nullptr };
+                parser.join();
+            }
+        };
+        const auto finishParserOnExit = wil::scope_exit(finishParser);
+
         // process the data of the output pipe in a loop
         while (true)
         {
             DWORD read{};
 
             const auto readFail{ !ReadFile(_outPipe.get(), _buffer.data(), gsl::narrow_cast<DWORD>(_buffer.size()), &read, nullptr) };
+            _outputReads++;
 
             // When we call CancelSynchronousIo() in Close() this is the branch that's taken and gets us out of here.
             if (_isStateAtOrBeyond(ConnectionState::Closing))
@@ -664,6 +748,7 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
             {
                 // EXIT POINT
                 const auto lastError = GetLastError();
+                finishParser();
                 if (lastError == ERROR_BROKEN_PIPE)
                 {
                     _LastConPtyClientDisconnected();
@@ -677,16 +762,7 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                 }
             }
 
-            const auto result{ til::u8u16(std::string_view{ _buffer.data(), read }, _u16Str, _u8State) };
-            if (FAILED(result))
-            {
-                // EXIT POINT
-                _indicateExitWithStatus(result); // print a message
-                _transitionToState(ConnectionState::Failed);
-                return gsl::narrow_cast<DWORD>(result);
-            }
-
-            if (_u16Str.empty())
+            if (read == 0)
             {
                 return 0;
             }
@@ -707,11 +783,267 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                 _receivedFirstByte = true;
             }
 
+            // Drain whatever else is already waiting in the pipe, so that it's all handed over at once.
+            const auto size = _coalesceOutput(read);
+            _outputBytes += size;
+
+            // This blocks while the ring is full, which back-pressures the child process just like
+            // a slow parser did before. It fails if the parser thread exited due to an error or Close().
+            if (!_pushOutput(producer, _buffer.data(), size))
+            {
+                return 0;
+            }
+        }
+    }
+
+    // Method Description:
+    // - The other half of _OutputThread(). It waits for output in the ring and then takes everything
+    //   that's available (up to _batchSize), converts it to UTF-16 and raises a TerminalOutput event.
+    //   If anyone subscribed to TerminalOutputUtf8, that one is raised with the UTF-8 instead.
+    //   Under load this means that the terminal lock is acquired once per batch instead of once per read.
+    // Arguments:
+    // - consumer: The receiving end of the ring. The thread exits once it's empty and the producer is gone.
+    void ConptyConnection::_ParserThread(til::spsc::consumer<char> consumer)
+    {
+        LOG_IF_FAILED(SetThreadDescription(GetCurrentThread(), L"ConptyConnection Parser Thread"));
+
+        // Unblocks _pushOutput() and makes it fail from now on.
+        const auto onExit = wil::scope_exit([&]() noexcept {
+            {
+                const std::scoped_lock lock{ _ringHandoff.mutex };
+                _ringHandoff.parserExited = true;
+                _ringHandoff.consumer.reset();
+            }
+            _ringUsed.store(0, std::memory_order_relaxed);
+            til::atomic_notify_one(_ringUsed);
+        });
+
+        auto batchSize = std::min<size_t>(_batchSize, _minRingCapacity);
+        auto batch = std::make_unique_for_overwrite<char[]>(batchSize);
+
+        while (true)
+        {
+            const auto count = consumer.pop_n(til::spsc::block_initially, batch.get(), batchSize).first;
+            if (count == 0)
+            {
+                // The output thread dropped the producer. Either it replaced the ring, or there's no more output.
+                uint32_t capacity = 0;
+                {
+                    const std::scoped_lock lock{ _ringHandoff.mutex };
+                    if (!_ringHandoff.consumer)
+                    {
+                        return;
+                    }
+                    consumer = std::move(*_ringHandoff.consumer);
+                    _ringHandoff.consumer.reset();
+                    capacity = _ringHandoff.capacity;
+                }
+
+                // The batch buffer follows the size of the ring, so that it shrinks after a burst as well.
+                if (const auto size = std::min<size_t>(_batchSize, capacity); size != batchSize)
+                {
+                    batch = std::make_unique_for_overwrite<char[]>(size);
+                    batchSize = size;
+                }
+                continue;
+            }
+            if (_isStateAtOrBeyond(ConnectionState::Closing))
+            {
+                return;
+            }
+
+            // Wake up _pushOutput() once we crossed the low watermark.
+            const auto used = _ringUsed.fetch_sub(count, std::memory_order_relaxed) - count;
+            if (used <= _ringLowWatermark && used + count > _ringLowWatermark)
+            {
+                til::atomic_notify_one(_ringUsed);
+            }
+
+            // The consumer converts the output itself, in small chunks that stay in the CPU caches.
+            if (_TerminalOutputUtf8Handlers)
+            {
+                const auto data = reinterpret_cast<const uint8_t*>(batch.get());
+                _TerminalOutputUtf8Handlers(winrt::array_view<const uint8_t>{ data, data + count });
+                _outputDispatches++;
+                continue;
+            }
+
+            const auto result{ til::u8u16(std::string_view{ batch.get(), count }, _u16Str, _u8State) };
+            if (FAILED(result))
+            {
+                // EXIT POINT
+                _indicateExitWithStatus(result); // print a message
+                _transitionToState(ConnectionState::Failed);
+                return;
+            }
+
+            // The batch may have ended in the middle of a UTF-8 sequence, which _u8State holds on to.
+            if (_u16Str.empty())
+            {
+                continue;
+            }
+
             // Pass the output to our registered event handlers
             _TerminalOutputHandlers(_u16Str);
+            _outputDispatches++;
+        }
+    }
+
+    // Method Description:
+    // - Pushes the output into the ring for the parser thread. If the ring is full, it gets replaced with one twice
+    //   the size, up to _maxRingCapacity. If that one is full, this waits until the parser thread drained the output
+    //   down to the low watermark. If the ring was empty for the last 256 calls, it gets replaced with a small one.
+    // Arguments:
+    // - producer: The sending end of the ring, which this may replace.
+    // - data, size: The output to push.
+    // Return Value:
+    // - false if the parser thread exited due to an error or Close().
+    bool ConptyConnection::_pushOutput(til::spsc::producer<char>& producer, const char* data, size_t size)
+    {
+        if (_ringCapacity == _minRingCapacity || _ringUsed.load(std::memory_order_relaxed) != 0)
+        {
+            _idlePushes = 0;
+        }
+        else if (++_idlePushes >= 256)
+        {
+            _idlePushes = 0;
+            // If this fails, we'll try again after another 256 calls.
+            _replaceRing(producer, _minRingCapacity);
+        }
+
+        while (size != 0)
+        {
+            // _ringUsed includes the bytes in the previous ring until the parser thread switched over.
+            // This may make us grow the ring early or wait longer than necessary, but not less.
+            if (_ringUsed.load(std::memory_order_relaxed) >= _ringCapacity &&
+                (_ringCapacity >= _maxRingCapacity || !_replaceRing(producer, _ringCapacity * 2)))
+            {
+                // The high watermark. Wait until the parser thread drained the ring down to the low watermark.
+                // This also unblocks if the parser thread exited, after which push_n() fails right away.
+                for (auto used = _ringUsed.load(std::memory_order_relaxed); used > _ringLowWatermark; used = _ringUsed.load(std::memory_order_relaxed))
+                {
+                    til::atomic_wait(_ringUsed, used);
+                }
+            }
+
+            const auto [pushed, ok] = producer.push_n(til::spsc::block_initially, data, size);
+            _ringUsed.fetch_add(pushed, std::memory_order_relaxed);
+            if (!ok)
+            {
+                return false;
+            }
+            data += pushed;
+            size -= pushed;
+        }
+
+        return true;
+    }
+
+    // Method Description:
+    // - Replaces the ring the output thread writes to with a new one of the given capacity.
+    //   The parser thread switches over to it once it took everything out of the current one.
+    // Return Value:
+    // - false if the parser thread didn't pick up the previous replacement yet, if it exited, or if we're out of memory.
+    bool ConptyConnection::_replaceRing(til::spsc::producer<char>& producer, uint32_t capacity) noexcept
+    try
+    {
+        auto [newProducer, newConsumer] = til::spsc::channel<char>(capacity);
+        {
+            const std::scoped_lock lock{ _ringHandoff.mutex };
+            if (_ringHandoff.consumer || _ringHandoff.parserExited)
+            {
+                return false;
+            }
+            _ringHandoff.consumer = std::move(newConsumer);
+            _ringHandoff.capacity = capacity;
         }
 
-        return 0;
+        // Dropping the producer of the old ring is what tells the parser thread to switch over.
+        producer = std::move(newProducer);
+        _ringCapacity = capacity;
+        return true;
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        return false;
+    }
+
+    // Method Description:
+    // - Appends the output that's immediately available in the pipe to _buffer without blocking.
+    //   The buffer grows up to _maxBufferSize if it fills up and shrinks again once the output calms down.
+    // Arguments:
+    // - size: The number of bytes in _buffer that were already read.
+    // Return Value:
+    // - The number of bytes in _buffer that are now ready to be dispatched.
+    size_t ConptyConnection::_coalesceOutput(size_t size)
+    {
+        while (true)
+        {
+            if (size == _buffer.size())
+            {
+                if (_buffer.size() >= _maxBufferSize)
+                {
+                    break;
+                }
+                _buffer.resize(_buffer.size() * 2);
+            }
+
+            DWORD available = 0;
+            if (!PeekNamedPipe(_outPipe.get(), nullptr, 0, nullptr, &available, nullptr) || available == 0)
+            {
+                break;
+            }
+
+            // Any failure here will be encountered again by the ReadFile() in _OutputThread() which will handle it.
+            DWORD read = 0;
+            const auto toRead = gsl::narrow_cast<DWORD>(std::min<size_t>(available, _buffer.size() - size));
+            if (!ReadFile(_outPipe.get(), _buffer.data() + size, toRead, &read, nullptr) || read == 0)
+            {
+                break;
+            }
+
+            size += read;
+            _outputReads++;
+        }
+
+        if (size > _buffer.size() / 4)
+        {
+            _smallReads = 0;
+        }
+        else if (_buffer.size() > _minBufferSize && ++_smallReads >= 256)
+        {
+            // The buffer has been mostly unused for a while. Give the memory back.
+            // This happens outside the ReadFile() calls, so we can't lose any data here.
+            _smallReads = 0;
+            _buffer.resize(std::max(_minBufferSize, size));
+            _buffer.shrink_to_fit();
+        }
+
+        return size;
+    }
+
+    void ConptyConnection::_traceOutputStatistics() const noexcept
+    {
+        if (!_receivedFirstByte)
+        {
+            return;
+        }
+
+        const std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - _startTime;
+
+#pragma warning(suppress : 26477 26485 26494 26482 26446) // We don't control TraceLoggingWrite
+        TraceLoggingWrite(g_hTerminalConnectionProvider,
+                          "OutputThroughput",
+                          TraceLoggingDescription("An event emitted when the connection stops reading output, with throughput statistics"),
+                          TraceLoggingGuid(_guid, "SessionGuid", "The WT_SESSION's GUID"),
+                          TraceLoggingUInt64(_outputBytes, "Bytes", "The number of bytes read from the output pipe"),
+                          TraceLoggingUInt64(_outputReads, "Reads", "The number of ReadFile() calls on the output pipe"),
+                          TraceLoggingUInt64(_outputDispatches, "Dispatches", "The number of TerminalOutput events that were raised"),
+                          TraceLoggingUInt64(_buffer.size(), "BufferSize", "The size of the read buffer at the end"),
+                          TraceLoggingFloat64(duration.count(), "Duration"),
+                          TraceLoggingKeyword(MICROSOFT_KEYWORD_MEASURES),
+                          TelemetryPrivacyDataTag(PDT_ProductAndServicePerformance));
     }
 
     static winrt::event<NewConnectionHandler> _newConnectionHandlers;
@@ -7,7 +7,9 @@
 #include "ConnectionStateHolder.h"
 
 #include "ITerminalHandoff.h"
+#include "../../types/inc/PipeWriter.hpp"
 #include <til/env.h>
+#include <til/spsc.h>
 
 namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 {
@@ -59,11 +61,13 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                                                                          const winrt::guid& profileGuid);
 
         WINRT_CALLBACK(TerminalOutput, TerminalOutputHandler);
+        WINRT_CALLBACK(TerminalOutputUtf8, TerminalOutputUtf8Handler);
 
     private:
         static void closePseudoConsoleAsync(HPCON hPC) noexcept;
         static HRESULT NewHandoff(HANDLE in, HANDLE out, HANDLE signal, HANDLE ref, HANDLE server, HANDLE client, TERMINAL_STARTUP_INFO startupInfo) noexcept;
         static winrt::hstring _commandlineFromProcess(HANDLE process);
+        static bool _isInterrupt(const std::wstring_view input) noexcept;
 
         HRESULT _LaunchAttachedClient() noexcept;
         void _indicateExitWithStatus(unsigned int status) noexcept;
@@ -84,14 +88,54 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         std::chrono::high_resolution_clock::time_point _startTime{};
 
         wil::unique_hfile _inPipe; // The pipe for writing input to
+        std::unique_ptr<::Microsoft::Console::Utils::PipeWriter> _inputWriter; // Writes to _inPipe on its own thread
         wil::unique_hfile _outPipe; // The pipe for reading output from
         wil::unique_handle _hOutputThread;
         wil::unique_process_information _piClient;
         wil::unique_any<HPCON, decltype(closePseudoConsoleAsync), closePseudoConsoleAsync> _hPC;
 
+        // The output thread passes the raw output to the parser thread through a til::spsc ring.
+        // It starts out at _minRingCapacity and the output thread replaces it with one twice the size whenever
+        // it finds it full, up to _maxRingCapacity. If that one is full as well, the output thread waits until
+        // the parser thread drained it to _ringLowWatermark, instead of waking up for every few bytes
+        // that got freed. Once the output calms down, it switches back to a small ring.
+        // The parser thread takes up to _batchSize bytes at once, but no more than the ring holds.
+        // See _pushOutput() and _ParserThread().
+        static constexpr uint32_t _minRingCapacity = 64 * 1024;
+        static constexpr uint32_t _maxRingCapacity = 4 * 1024 * 1024;
+        static constexpr size_t _ringLowWatermark = _maxRingCapacity / 4;
+        static constexpr size_t _batchSize = 1024 * 1024;
+        // The capacity of the ring the output thread currently writes to and the number
+        // of consecutive pushes into an empty ring. Only used by the output thread.
+        uint32_t _ringCapacity = _minRingCapacity;
+        uint32_t _idlePushes = 0;
+        // The number of bytes that were pushed, but not yet taken by the parser thread.
+        std::atomic<size_t> _ringUsed{ 0 };
+        // A ring that replaces the current one. The output thread drops the producer of the current ring after
+        // putting the consumer of the new one here. Once the parser thread drained the old one, it switches over.
+        struct RingHandoff
+        {
+            std::mutex mutex;
+            std::optional<til::spsc::consumer<char>> consumer;
+            uint32_t capacity = 0;
+            bool parserExited = false;
+        } _ringHandoff;
+        // These two are only used by the parser thread.
         til::u8state _u8State{};
         std::wstring _u16Str{};
-        std::array<char, 4096> _buffer{};
+        // The output is read into this buffer. It starts out small and grows while the reads keep
+        // filling it up, so that a busy child process gets its output dispatched in larger chunks.
+        // This amortizes the cost of acquiring the terminal lock per TerminalOutput event.
+        // See _OutputThread() and _coalesceOutput().
+        static constexpr size_t _minBufferSize = 4 * 1024;
+        static constexpr size_t _maxBufferSize = 1024 * 1024;
+        std::string _buffer = std::string(_minBufferSize, '\0');
+        // The number of consecutive reads that used at most a quarter of _buffer. Used to shrink it again.
+        uint32_t _smallReads = 0;
+        // Throughput statistics for diagnostics. They get logged when the output thread exits.
+        uint64_t _outputBytes = 0;
+        uint64_t _outputReads = 0;
+        uint64_t _outputDispatches = 0;
         bool _passthroughMode{};
         bool _inheritCursor{ false };
 
@@ -108,6 +152,11 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         } _startupInfo{};
 
         DWORD _OutputThread();
+        bool _pushOutput(til::spsc::producer<char>& producer, const char* data, size_t size);
+        bool _replaceRing(til::spsc::producer<char>& producer, uint32_t capacity) noexcept;
+        void _ParserThread(til::spsc::consumer<char> consumer);
+        size_t _coalesceOutput(size_t size);
+        void _traceOutputStatistics() const noexcept;
     };
 }
 
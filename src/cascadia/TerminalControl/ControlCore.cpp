@@ -42,6 +42,11 @@ constexpr const auto UpdatePatternLocationsInterval = std::chrono::milliseconds(
 // The delay before performing the search after change of search criteria
 constexpr const auto SearchAfterChangeDelay = std::chrono::milliseconds(200);
 
+// The number of rows Search() searches synchronously on the UI thread. The remaining
+// rows are searched on a background thread, in chunks of SearchBackgroundChunkRows rows.
+constexpr til::CoordType SearchForegroundRows = 4096;
+constexpr til::CoordType SearchBackgroundChunkRows = 2048;
+
 namespace winrt::Microsoft::Terminal::Control::implementation
 {
     static winrt::Microsoft::Terminal::Core::OptionalColor OptionalFromColor(const til::color& c)
@@ -270,8 +275,16 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // revoke ALL old handlers immediately
 
         _connectionOutputEventRevoker.revoke();
+        _connectionOutputUtf8EventRevoker.revoke();
         _connectionStateChangedRevoker.revoke();
 
+        // The old connection may have stopped in the middle of a UTF-8 sequence,
+        // which must not be completed by the first bytes of the new one.
+        {
+            const auto lock = _terminal->LockForWriting();
+            _terminal->ResetUtf8State();
+        }
+
         _connection = newConnection;
         if (_connection)
         {
@@ -294,6 +307,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             if (auto conpty{ newConnection.try_as<TerminalConnection::ConptyConnection>() })
             {
                 conpty.ReparentWindow(_owningHwnd);
+
+                // ConPTY's output is UTF-8. The Terminal converts it in small chunks
+                // as it parses it, instead of the connection converting all of it upfront.
+                // Messages of the connection itself, like the exit code, still arrive through TerminalOutput.
+                // This event is explicitly revoked in the destructor: does not need weak_ref
+                _connectionOutputUtf8EventRevoker = conpty.TerminalOutputUtf8(winrt::auto_revoke, { this, &ControlCore::_connectionOutputUtf8Handler });
             }
 
             // This event is explicitly revoked in the destructor: does not need weak_ref
@@ -1582,18 +1601,42 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     {
         const auto lock = _terminal->LockForWriting();
 
-        if (_searcher.ResetIfStale(*GetRenderData(), text, !goForward, !caseSensitive))
+        // Cancels any pending _searchInBackground(), even if this search finishes in the foreground.
+        // Otherwise it would report its results a second time and may even override the selection.
+        const auto generation = ++_searchGeneration;
+
+        // Only rows that changed since the last search get searched again.
+        // If the buffer is large, we only search the first couple rows here and the rest in the background.
+        const auto reset = _searcher.Prepare(*GetRenderData(), text, !goForward, !caseSensitive);
+        const auto scanning = _searcher.ScanSome(SearchForegroundRows);
+
+        if (reset)
         {
             _searcher.MoveToCurrentSelection();
-            _cachedSearchResultRows = {};
         }
         else
         {
             _searcher.FindNext();
         }
 
+        _cachedSearchResultRows = {};
+        _selectCurrentSearchResult(scanning);
+
+        if (scanning)
+        {
+            _searchInBackground(generation);
+        }
+    }
+
+    // Selects the current search result (if any) and raises a FoundMatch event, which the control will use
+    // to update the search box and to notify narrator if there were any results in the buffer.
+    // The caller must hold the terminal lock.
+    void ControlCore::_selectCurrentSearchResult(const bool searchInProgress)
+    {
         const auto foundMatch = _searcher.SelectCurrent();
         auto foundResults = winrt::make_self<implementation::FoundResultsArgs>(foundMatch);
+        foundResults->SearchInProgress(searchInProgress);
+
         if (foundMatch)
         {
             // this is used for search,
@@ -1609,11 +1652,61 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             _terminal->AlwaysNotifyOnBufferRotation(true);
         }
 
-        // Raise a FoundMatch event, which the control will use to notify
-        // narrator if there was any results in the buffer
         _FoundMatchHandlers(*this, *foundResults);
     }
 
+    // Searches the rows that Search() didn't get to in chunks, releasing the terminal lock in between,
+    // so that neither the UI nor the connection output get blocked for long. Every chunk's results are
+    // streamed to the search box. Any call to Search() or ClearSearch() cancels this via _searchGeneration.
+    winrt::fire_and_forget ControlCore::_searchInBackground(const uint64_t generation)
+    {
+        const auto weakThis{ get_weak() };
+
+        co_await winrt::resume_background();
+
+        for (auto scanning = true; scanning;)
+        {
+            const auto core = weakThis.get();
+            if (!core)
+            {
+                co_return;
+            }
+
+            const auto lock = core->_terminal->LockForWriting();
+            if (core->_searchGeneration != generation)
+            {
+                co_return;
+            }
+
+            const auto hadMatch = core->_searcher.GetCurrent() != nullptr;
+            const auto previousCount = core->_searcher.Results().size();
+            scanning = core->_searcher.ScanSome(SearchBackgroundChunkRows);
+
+            if (core->_searcher.Results().size() == previousCount && scanning)
+            {
+                continue;
+            }
+
+            core->_cachedSearchResultRows = {};
+
+            if (!hadMatch)
+            {
+                // Search() didn't find anything in the rows it searched, so we get to pick the first match.
+                core->_searcher.MoveToCurrentSelection();
+                core->_selectCurrentSearchResult(scanning);
+            }
+            else
+            {
+                // Don't steal the selection from the user, who may have navigated to another match in the meantime.
+                auto foundResults = winrt::make_self<implementation::FoundResultsArgs>(true);
+                foundResults->SearchInProgress(scanning);
+                foundResults->TotalMatches(gsl::narrow<int32_t>(core->_searcher.Results().size()));
+                foundResults->CurrentMatch(gsl::narrow<int32_t>(core->_searcher.CurrentMatch()));
+                core->_FoundMatchHandlers(*core, *foundResults);
+            }
+        }
+    }
+
     Windows::Foundation::Collections::IVector<int32_t> ControlCore::SearchResultRows()
     {
         const auto lock = _terminal->LockForReading();
@@ -1641,8 +1734,11 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
     void ControlCore::ClearSearch()
     {
+        const auto lock = _terminal->LockForWriting();
         _terminal->AlwaysNotifyOnBufferRotation(false);
         _searcher = {};
+        // Cancels any pending _searchInBackground().
+        _searchGeneration++;
     }
 
     void ControlCore::Close()
@@ -1651,11 +1747,18 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         {
             _closing = true;
 
+            {
+                // Cancels any pending _searchInBackground().
+                const auto lock = _terminal->LockForWriting();
+                _searchGeneration++;
+            }
+
             // Ensure Close() doesn't hang, waiting for MidiAudio to finish playing an hour long song.
             _midiAudio.BeginSkip();
 
             // Stop accepting new output and state changes before we disconnect everything.
             _connectionOutputEventRevoker.revoke();
+            _connectionOutputUtf8EventRevoker.revoke();
             _connectionStateChangedRevoker.revoke();
             _connection.Close();
         }
@@ -1942,13 +2045,24 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                 const auto lock = _terminal->LockForWriting();
                 _terminal->Write(hstr);
             }
+            _connectionOutputWritten();
+        }
+        catch (...)
+        {
+            // We're expecting to receive an exception here if the terminal
+            // is closed while we're blocked playing a MIDI note.
+        }
+    }
 
-            // Start the throttled update of where our hyperlinks are.
-            const auto shared = _shared.lock_shared();
-            if (shared->updatePatternLocations)
+    void ControlCore::_connectionOutputUtf8Handler(const winrt::array_view<const uint8_t>& output)
+    {
+        try
+        {
             {
-                (*shared->updatePatternLocations)();
+                const auto lock = _terminal->LockForWriting();
+                _terminal->WriteUtf8({ reinterpret_cast<const char*>(output.data()), output.size() });
             }
+            _connectionOutputWritten();
         }
         catch (...)
         {
@@ -1957,6 +2071,16 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
     }
 
+    void ControlCore::_connectionOutputWritten()
+    {
+        // Start the throttled update of where our hyperlinks are.
+        const auto shared = _shared.lock_shared();
+        if (shared->updatePatternLocations)
+        {
+            (*shared->updatePatternLocations)();
+        }
+    }
+
     uint64_t ControlCore::SwapChainHandle() const
     {
         // This is only ever called by TermControl::AttachContent, which occurs
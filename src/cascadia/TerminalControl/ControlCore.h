@@ -293,6 +293,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         TerminalConnection::ITerminalConnection _connection{ nullptr };
         TerminalConnection::ITerminalConnection::TerminalOutput_revoker _connectionOutputEventRevoker;
+        TerminalConnection::ConptyConnection::TerminalOutputUtf8_revoker _connectionOutputUtf8EventRevoker;
         TerminalConnection::ITerminalConnection::StateChanged_revoker _connectionStateChangedRevoker;
 
         winrt::com_ptr<ControlSettings> _settings{ nullptr };
@@ -308,6 +309,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         std::unique_ptr<::Microsoft::Console::Render::Renderer> _renderer{ nullptr };
 
         ::Search _searcher;
+        // Incremented by every Search(), ClearSearch() and Close(). Protected by the terminal lock.
+        uint64_t _searchGeneration{ 0 };
 
         winrt::handle _lastSwapChainHandle{ nullptr };
 
@@ -378,6 +381,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 #pragma region RendererCallbacks
         void _rendererWarning(const HRESULT hr);
         winrt::fire_and_forget _renderEngineSwapChainChanged(const HANDLE handle);
+        void _selectCurrentSearchResult(const bool searchInProgress);
+        winrt::fire_and_forget _searchInBackground(const uint64_t generation);
         void _rendererBackgroundColorChanged();
         void _rendererTabColorChanged();
 #pragma endregion
@@ -385,6 +390,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         void _raiseReadOnlyWarning();
         void _updateAntiAliasingMode();
         void _connectionOutputHandler(const hstring& hstr);
+        void _connectionOutputUtf8Handler(const winrt::array_view<const uint8_t>& output);
+        void _connectionOutputWritten();
         void _updateHoveredCell(const std::optional<til::point> terminalPosition);
         void _setOpacity(const double opacity);
 
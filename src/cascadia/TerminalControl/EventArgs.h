@@ -178,6 +178,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         WINRT_PROPERTY(bool, FoundMatch);
         WINRT_PROPERTY(int32_t, TotalMatches);
         WINRT_PROPERTY(int32_t, CurrentMatch);
+        WINRT_PROPERTY(bool, SearchInProgress);
     };
 
     struct ShowWindowArgs : public ShowWindowArgsT<ShowWindowArgs>
@@ -3510,7 +3510,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     winrt::fire_and_forget TermControl::_coreFoundMatch(const IInspectable& /*sender*/, Control::FoundResultsArgs args)
     {
         co_await wil::resume_foreground(Dispatcher());
-        if (auto automationPeer{ Automation::Peers::FrameworkElementAutomationPeer::FromElement(*this) })
+
+        // Large buffers are searched in the background and we receive the partial results as they come in.
+        // Only the final result is announced, but the search box status is kept up to date regardless.
+        if (const auto automationPeer{ args.SearchInProgress() ? nullptr : Automation::Peers::FrameworkElementAutomationPeer::FromElement(*this) })
         {
             automationPeer.RaiseNotificationEvent(
                 Automation::Peers::AutomationNotificationKind::ActionCompleted,
@@ -40,6 +40,18 @@ void Terminal::Create(til::size viewportSize, til::CoordType scrollbackLines, Re
     const UINT cursorSize = 12;
     _mainBuffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, true, renderer);
 
+    // Most of a very large scrollback is rarely ever looked at again. Packing rows that are far
+    // above the cursor keeps the memory usage of such buffers close to that of the default size.
+    // The distance is generous, so that the visible viewport is practically never affected.
+    // Output that fills such a buffer also commits a lot of memory, which is done in the background then.
+    static constexpr til::CoordType coldScrollbackMinimumHeight = 10000;
+    static constexpr til::CoordType coldScrollbackDistance = 1000;
+    if (bufferSize.height >= coldScrollbackMinimumHeight)
+    {
+        _mainBuffer->SetColdScrollbackDistance(coldScrollbackDistance);
+        _mainBuffer->SetPrefault(true);
+    }
+
     auto dispatch = std::make_unique<AdaptDispatch>(*this, renderer, _renderSettings, _terminalInput);
     auto engine = std::make_unique<OutputStateMachineEngine>(std::move(dispatch));
     _stateMachine = std::make_unique<StateMachine>(std::move(engine));
@@ -414,6 +426,29 @@ void Terminal::Write(std::wstring_view stringView)
     const til::point cursorPosBefore{ cursor.GetPosition() };
 
     _stateMachine->ProcessString(stringView);
+    _finishWrite(cursor, cursorPosBefore);
+}
+
+// Same as Write(), but for UTF-8, which the state machine converts in small chunks as it goes.
+// A partial UTF-8 sequence at the end of the string is completed by the next call.
+void Terminal::WriteUtf8(std::string_view stringView)
+{
+    const auto& cursor = _activeBuffer().GetCursor();
+    const til::point cursorPosBefore{ cursor.GetPosition() };
+
+    THROW_IF_FAILED(_stateMachine->ProcessUtf8(stringView, _u8State));
+    _finishWrite(cursor, cursorPosBefore);
+}
+
+// Discards a partial UTF-8 sequence that WriteUtf8() is holding onto, for instance because the connection changed.
+void Terminal::ResetUtf8State() noexcept
+{
+    _u8State.reset();
+}
+
+void Terminal::_finishWrite(const Cursor& cursor, const til::point cursorPosBefore)
+{
+    _mainBuffer->CompactScrollback();
 
     const til::point cursorPosAfter{ cursor.GetPosition() };
 
@@ -1207,9 +1242,31 @@ void Terminal::UpdatePatternsUnderLock()
 {
     _InvalidatePatternTree();
     _patternIntervalTree = _getPatterns(_VisibleStartIndex(), _VisibleEndIndex());
+    _updatePatternSpans();
     _InvalidatePatternTree();
 }
 
+// Method Description:
+// - Sets the regex patterns that should be detected in addition to URLs.
+//   Each pattern is compiled only once and shared between all Terminal instances.
+// Arguments:
+// - patterns: The ICU regex patterns. Their pattern IDs are their index + 1.
+void Terminal::SetCustomPatterns(std::vector<std::wstring> patterns)
+{
+    // The renderer stores the pattern IDs of a cell as a 64-bit mask (see PatternSpan)
+    // and the first one is reserved for URLs.
+    THROW_HR_IF(E_INVALIDARG, patterns.size() >= 64);
+
+    _customPatterns = std::move(patterns);
+    _patternCache.clear();
+    _patternCacheBuffer = nullptr;
+
+    if (_mainBuffer)
+    {
+        _updateUrlDetection();
+    }
+}
+
 // Method Description:
 // - Clears and invalidates the interval pattern tree
 // - This is called to prevent the renderer from rendering patterns while the
@@ -1222,6 +1279,117 @@ void Terminal::_clearPatternTree()
         _InvalidatePatternTree();
         _patternIntervalTree = {};
     }
+    _clearPatternSpans();
+}
+
+void Terminal::_clearPatternSpans() noexcept
+{
+    _patternSpans.clear();
+    _patternSpanRows.clear();
+}
+
+// Method Description:
+// - Flattens the _patternIntervalTree into _patternSpans, so that the renderer can look up
+//   the patterns of each cell of a row without querying the tree or allocating memory.
+// - The intervals may span multiple rows and overlap each other. They're split up into
+//   one piece per row and then cut at every begin/end, merging the ids of overlapping pieces.
+void Terminal::_updatePatternSpans()
+{
+    using Microsoft::Console::Render::PatternSpan;
+
+    _clearPatternSpans();
+
+    const auto viewport = _GetVisibleViewport();
+    const auto width = viewport.Width();
+    const auto height = viewport.Height();
+
+    struct Piece
+    {
+        til::CoordType row;
+        PatternSpan span;
+    };
+    std::vector<Piece> pieces;
+
+    _patternIntervalTree.visit_all([&](const auto& interval) {
+        // The ids are stored as a bitmask. SetCustomPatterns() ensures that the URL pattern (0)
+        // and all custom ones fit into it, so this only guards against invalid intervals.
+        if (interval.value >= 64)
+        {
+            return;
+        }
+
+        const auto ids = uint64_t{ 1 } << interval.value;
+        const auto first = std::max(interval.start.y, 0);
+        const auto last = std::min(interval.stop.y, height - 1);
+
+        for (auto y = first; y <= last; ++y)
+        {
+            const auto begin = y == interval.start.y ? interval.start.x : 0;
+            const auto end = y == interval.stop.y ? std::min(interval.stop.x, width) : width;
+            if (begin < end)
+            {
+                pieces.emplace_back(Piece{ y, PatternSpan{ begin, end, ids } });
+            }
+        }
+    });
+
+    std::sort(pieces.begin(), pieces.end(), [](const Piece& lhs, const Piece& rhs) {
+        return lhs.row < rhs.row || (lhs.row == rhs.row && lhs.span.begin < rhs.span.begin);
+    });
+
+    _patternSpanRows.resize(gsl::narrow_cast<size_t>(height) + 1);
+
+    std::vector<til::CoordType> bounds;
+    auto rowBeg = pieces.begin();
+
+    for (til::CoordType y = 0; y < height; ++y)
+    {
+        const auto rowFirstSpan = _patternSpans.size();
+        const auto rowEnd = std::find_if(rowBeg, pieces.end(), [=](const Piece& p) { return p.row != y; });
+        til::at(_patternSpanRows, y) = rowFirstSpan;
+
+        bounds.clear();
+        for (auto it = rowBeg; it != rowEnd; ++it)
+        {
+            bounds.emplace_back(it->span.begin);
+            bounds.emplace_back(it->span.end);
+        }
+        std::sort(bounds.begin(), bounds.end());
+        bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+        for (size_t i = 1; i < bounds.size(); ++i)
+        {
+            const auto begin = til::at(bounds, i - 1);
+            const auto end = til::at(bounds, i);
+            uint64_t ids = 0;
+
+            for (auto it = rowBeg; it != rowEnd; ++it)
+            {
+                if (it->span.begin <= begin && end <= it->span.end)
+                {
+                    ids |= it->span.ids;
+                }
+            }
+
+            if (!ids)
+            {
+                continue;
+            }
+
+            if (_patternSpans.size() > rowFirstSpan && _patternSpans.back().end == begin && _patternSpans.back().ids == ids)
+            {
+                _patternSpans.back().end = end;
+            }
+            else
+            {
+                _patternSpans.emplace_back(PatternSpan{ begin, end, ids });
+            }
+        }
+
+        rowBeg = rowEnd;
+    }
+
+    til::at(_patternSpanRows, height) = _patternSpans.size();
 }
 
 // Method Description:
@@ -1415,33 +1583,129 @@ private:
 
 static URegularExpressionInterner uregexInterner;
 
-PointTree Terminal::_getPatterns(til::CoordType beg, til::CoordType end) const
+// Brings the _patternCache up to date with the layout of the given buffer without scanning anything.
+void Terminal::_refreshPatternCache(const TextBuffer& textBuffer)
+{
+    const auto size = textBuffer.GetSize().Dimensions();
+    const auto lastMutationId = textBuffer.GetLastMutationId();
+    const auto firstRowIndex = textBuffer.GetFirstRowIndex();
+
+    // Every TextBuffer starts with a unique _lastMutationId that is larger than that of any previous TextBuffer.
+    // If the value went backwards, we must be looking at a different one, even if its address is the same.
+    if (_patternCacheBuffer != &textBuffer || _patternCacheBufferSize != size || lastMutationId < _patternCacheMutationId)
+    {
+        _patternCache.clear();
+        _patternCache.resize(gsl::narrow_cast<size_t>(size.height));
+    }
+    else
+    {
+        // IncrementCircularBuffer() moves all rows up. The rows that got recycled at the bottom
+        // have a new generation and won't match their (now rotated) cache entries anymore.
+        const auto scrolled = (firstRowIndex - _patternCacheFirstRowIndex + size.height) % size.height;
+        if (scrolled)
+        {
+            std::rotate(_patternCache.begin(), _patternCache.begin() + scrolled, _patternCache.end());
+            std::fill(_patternCache.end() - scrolled, _patternCache.end(), PatternCacheLine{});
+        }
+    }
+
+    _patternCacheBuffer = &textBuffer;
+    _patternCacheBufferSize = size;
+    _patternCacheMutationId = lastMutationId;
+    _patternCacheFirstRowIndex = firstRowIndex;
+}
+
+// Returns the pattern matches in the buffer rows [beg, end] in viewport-relative coordinates.
+// Only the logical lines (rows joined by wrapping) which changed since the last call are scanned.
+// The results of all others are taken from the _patternCache.
+PointTree Terminal::_getPatterns(til::CoordType beg, til::CoordType end)
 {
-    static constexpr std::array<std::wstring_view, 1> patterns{
+    static constexpr std::wstring_view urlPattern{
         LR"(\b(?:https?|ftp|file)://[-A-Za-z0-9+&@#/%?=~_|$!:,.;]*[A-Za-z0-9+&@#/%=~_|$])",
     };
 
-    auto text = ICU::UTextFromTextBuffer(_activeBuffer(), beg, end + 1);
-    UErrorCode status = U_ZERO_ERROR;
+    const auto& textBuffer = _activeBuffer();
+    const auto lastMutationId = textBuffer.GetLastMutationId();
+
+    _refreshPatternCache(textBuffer);
+
+    end = std::min(end, textBuffer.GetSize().Height() - 1);
+
+    // The first visible row may be the continuation of a line that wrapped from above the viewport.
+    // We look at most one viewport height upwards to bound the cost of extremely long lines.
+    auto lineBeg = beg;
+    for (const auto limit = std::max(0, beg - (end - beg + 1)); lineBeg > limit && textBuffer.GetRowByOffset(lineBeg - 1).WasWrapForced();)
+    {
+        --lineBeg;
+    }
+
+    // The compiled patterns are cloned lazily, because usually there's nothing to scan.
+    std::vector<ICU::unique_uregex> regexes;
     PointTree::interval_vector intervals;
 
-    for (size_t i = 0; i < patterns.size(); ++i)
+    while (lineBeg <= end)
     {
-        const auto re = uregexInterner.Intern(patterns.at(i));
-        uregex_setUText(re.get(), &text, &status);
+        auto lineEnd = lineBeg + 1;
+        while (lineEnd <= end && textBuffer.GetRowByOffset(lineEnd - 1).WasWrapForced())
+        {
+            ++lineEnd;
+        }
 
-        if (uregex_find(re.get(), -1, &status))
+        auto& line = til::at(_patternCache, lineBeg);
+        if (line.rows != lineEnd - lineBeg || textBuffer.FindChangedRow(line.generation, lineBeg, lineEnd) != lineEnd)
         {
-            do
+            if (regexes.empty())
             {
-                auto range = ICU::BufferRangeFromMatch(&text, re.get());
-                // PointTree uses half-open ranges and viewport-relative coordinates.
-                range.start.y -= beg;
-                range.end.y -= beg;
-                range.end.x++;
-                intervals.push_back(PointTree::interval(range.start, range.end, 0));
-            } while (uregex_findNext(re.get(), &status));
+                regexes.emplace_back(uregexInterner.Intern(urlPattern));
+                for (const auto& pattern : _customPatterns)
+                {
+                    regexes.emplace_back(uregexInterner.Intern(pattern));
+                }
+            }
+
+            line.rows = lineEnd - lineBeg;
+            line.generation = lastMutationId;
+            line.matches.clear();
+
+            auto text = ICU::UTextFromTextBuffer(textBuffer, lineBeg, lineEnd);
+
+            for (size_t i = 0; i < regexes.size(); ++i)
+            {
+                const auto re = til::at(regexes, i).get();
+                UErrorCode status = U_ZERO_ERROR;
+
+                // Patterns that failed to compile are skipped, but keep their ID.
+                if (!re)
+                {
+                    continue;
+                }
+
+                uregex_setUText(re, &text, &status);
+
+                if (uregex_find(re, -1, &status))
+                {
+                    do
+                    {
+                        auto range = ICU::BufferRangeFromMatch(&text, re);
+                        // PointTree uses half-open ranges. The cache stores rows relative to the line.
+                        range.start.y -= lineBeg;
+                        range.end.y -= lineBeg;
+                        range.end.x++;
+                        line.matches.push_back(PointTree::interval(range.start, range.end, i));
+                    } while (uregex_findNext(re, &status));
+                }
+            }
         }
+
+        // PointTree uses viewport-relative coordinates.
+        for (auto interval : line.matches)
+        {
+            interval.start.y += lineBeg - beg;
+            interval.stop.y += lineBeg - beg;
+            intervals.push_back(interval);
+        }
+
+        lineBeg = lineEnd;
     }
 
     return PointTree{ std::move(intervals) };
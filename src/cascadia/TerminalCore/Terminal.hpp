@@ -97,6 +97,8 @@ public:
 
     // Write comes from the PTY and goes to our parser to be stored in the output buffer
     void Write(std::wstring_view stringView);
+    void WriteUtf8(std::string_view stringView);
+    void ResetUtf8State() noexcept;
 
     // WritePastedText comes from our input and goes back to the PTY's input channel
     void WritePastedText(std::wstring_view stringView);
@@ -208,7 +210,7 @@ public:
     const bool IsGridLineDrawingAllowed() noexcept override;
     const std::wstring GetHyperlinkUri(uint16_t id) const override;
     const std::wstring GetHyperlinkCustomId(uint16_t id) const override;
-    const std::vector<size_t> GetPatternId(const til::point location) const override;
+    std::span<const Microsoft::Console::Render::PatternSpan> GetPatternSpans(const til::CoordType viewportRow) const noexcept override;
 
     std::pair<COLORREF, COLORREF> GetAttributeColors(const TextAttribute& attr) const noexcept override;
     std::vector<Microsoft::Console::Types::Viewport> GetSelectionRects() noexcept override;
@@ -237,6 +239,7 @@ public:
     void SetCursorOn(const bool isOn) noexcept;
 
     void UpdatePatternsUnderLock();
+    void SetCustomPatterns(std::vector<std::wstring> patterns);
 
     const std::optional<til::color> GetTabColor() const;
 
@@ -332,6 +335,7 @@ private:
 
     RenderSettings _renderSettings;
     std::unique_ptr<::Microsoft::Console::VirtualTerminal::StateMachine> _stateMachine;
+    til::u8state _u8State{};
     ::Microsoft::Console::VirtualTerminal::TerminalInput _terminalInput;
 
     std::optional<std::wstring> _title;
@@ -405,7 +409,34 @@ private:
     //      Either way, we should make this behavior controlled by a setting.
 
     interval_tree::IntervalTree<til::point, size_t> _patternIntervalTree;
+    // _patternIntervalTree flattened into sorted, non-overlapping spans per viewport row for the renderer.
+    // The spans of viewport row y are [_patternSpanRows[y], _patternSpanRows[y + 1]) in _patternSpans.
+    std::vector<Microsoft::Console::Render::PatternSpan> _patternSpans;
+    std::vector<size_t> _patternSpanRows;
     void _clearPatternTree();
+    void _clearPatternSpans() noexcept;
+    void _updatePatternSpans();
+
+    // Regex patterns that are highlighted in addition to URLs. Their pattern ID is their index + 1.
+    std::vector<std::wstring> _customPatterns;
+    // Caches the pattern matches of the logical line starting at each buffer row, so that
+    // UpdatePatternsUnderLock() only needs to scan the lines that changed since then.
+    struct PatternCacheLine
+    {
+        // The number of rows that were scanned or 0 if this isn't a cached line.
+        til::CoordType rows = 0;
+        // The TextBuffer::GetLastMutationId() at the time of the scan. If any of the
+        // rows have a newer TextBuffer::GetRowGeneration() the line must be scanned again.
+        uint64_t generation = 0;
+        // Matches with their y coordinates relative to the first row of the line.
+        interval_tree::IntervalTree<til::point, size_t>::interval_vector matches;
+    };
+    std::vector<PatternCacheLine> _patternCache;
+    // These are used to detect when the _patternCache refers to a different buffer or needs to be moved up.
+    const TextBuffer* _patternCacheBuffer = nullptr;
+    til::size _patternCacheBufferSize;
+    uint64_t _patternCacheMutationId = 0;
+    til::CoordType _patternCacheFirstRowIndex = 0;
     void _InvalidatePatternTree();
     void _InvalidateFromCoords(const til::point start, const til::point end);
 
@@ -450,11 +481,13 @@ private:
     void _NotifyScrollEvent();
 
     void _NotifyTerminalCursorPositionChanged() noexcept;
+    void _finishWrite(const Cursor& cursor, const til::point cursorPosBefore);
 
     bool _inAltBuffer() const noexcept;
     TextBuffer& _activeBuffer() const noexcept;
     void _updateUrlDetection();
-    interval_tree::IntervalTree<til::point, size_t> _getPatterns(til::CoordType beg, til::CoordType end) const;
+    interval_tree::IntervalTree<til::point, size_t> _getPatterns(til::CoordType beg, til::CoordType end);
+    void _refreshPatternCache(const TextBuffer& textBuffer);
 
 #pragma region TextSelection
     // These methods are defined in TerminalSelection.cpp
@@ -482,6 +482,7 @@ void Terminal::NotifyBufferRotation(const int delta)
 
     // manually erase our pattern intervals since the locations have changed now
     _patternIntervalTree = {};
+    _clearPatternSpans();
 
     auto& marks{ _activeBuffer().GetMarks() };
     const auto hasScrollMarks = marks.size() > 0;
@@ -100,31 +100,24 @@ const std::wstring Microsoft::Terminal::Core::Terminal::GetHyperlinkCustomId(uin
 }
 
 // Method Description:
-// - Gets the regex pattern ids of a location
+// - Gets the regex pattern spans of a viewport row
 // Arguments:
-// - The location
+// - The viewport-relative row
 // Return value:
-// - The pattern IDs of the location
-const std::vector<size_t> Terminal::GetPatternId(const til::point location) const
+// - The sorted, non-overlapping pattern spans of that row. See UpdatePatternsUnderLock().
+std::span<const Microsoft::Console::Render::PatternSpan> Terminal::GetPatternSpans(const til::CoordType viewportRow) const noexcept
 {
     _assertLocked();
 
-    // Look through our interval tree for this location
-    const auto intervals = _patternIntervalTree.findOverlapping({ location.x + 1, location.y }, location);
-    if (intervals.size() == 0)
+    const auto row = gsl::narrow_cast<size_t>(viewportRow);
+    if (viewportRow < 0 || row + 1 >= _patternSpanRows.size())
     {
         return {};
     }
-    else
-    {
-        std::vector<size_t> result{};
-        for (const auto& interval : intervals)
-        {
-            result.emplace_back(interval.value);
-        }
-        return result;
-    }
-    return {};
+
+    const auto beg = til::at(_patternSpanRows, row);
+    const auto end = til::at(_patternSpanRows, row + 1);
+    return { _patternSpans.data() + beg, end - beg };
 }
 
 std::pair<COLORREF, COLORREF> Terminal::GetAttributeColors(const TextAttribute& attr) const noexcept
@@ -53,6 +53,9 @@ class TerminalCoreUnitTests::TerminalBufferTests final
 
     TEST_METHOD(TestCursorNotifications);
 
+    TEST_METHOD(TestPatternSpans);
+    TEST_METHOD(TestIncrementalPatterns);
+
     TEST_METHOD_SETUP(MethodSetup)
     {
         // STEP 1: Set up the Terminal
@@ -636,3 +639,96 @@ void TerminalBufferTests::TestCursorNotifications()
     VERIFY_ARE_EQUAL(0, expectedCallbacks);
     VERIFY_IS_TRUE(callbackWasCalled);
 }
+
+void TerminalBufferTests::TestPatternSpans()
+{
+    using Microsoft::Console::Render::PatternSpanCursor;
+
+    auto lock = term->LockForWriting();
+
+    // Two URLs in the first row and one that wraps from the 3rd into the 4th row.
+    term->Write(L"see https://example.com and http://a.b/c");
+    term->Write(L"\x1b[3;75Hhttps://wrap.example/x");
+    term->UpdatePatternsUnderLock();
+
+    const auto verifySpan = [](const auto& span, til::CoordType begin, til::CoordType end) {
+        VERIFY_ARE_EQUAL(begin, span.begin);
+        VERIFY_ARE_EQUAL(end, span.end);
+        VERIFY_ARE_EQUAL(1u, span.ids);
+    };
+
+    const auto row0 = term->GetPatternSpans(0);
+    VERIFY_ARE_EQUAL(2u, row0.size());
+    verifySpan(row0[0], 4, 23);
+    verifySpan(row0[1], 28, 40);
+
+    VERIFY_ARE_EQUAL(0u, term->GetPatternSpans(1).size());
+
+    const auto row2 = term->GetPatternSpans(2);
+    VERIFY_ARE_EQUAL(1u, row2.size());
+    verifySpan(row2[0], 74, TerminalViewWidth);
+
+    const auto row3 = term->GetPatternSpans(3);
+    VERIFY_ARE_EQUAL(1u, row3.size());
+    verifySpan(row3[0], 0, 16);
+
+    VERIFY_ARE_EQUAL(0u, term->GetPatternSpans(-1).size());
+    VERIFY_ARE_EQUAL(0u, term->GetPatternSpans(TerminalViewHeight).size());
+
+    // The cursor is meant to be walked left to right, but must handle stepping back.
+    PatternSpanCursor cursor{ row0 };
+    VERIFY_ARE_EQUAL(0u, cursor.At(3));
+    VERIFY_ARE_EQUAL(1u, cursor.At(4));
+    VERIFY_ARE_EQUAL(1u, cursor.At(22));
+    VERIFY_ARE_EQUAL(0u, cursor.At(23));
+    VERIFY_ARE_EQUAL(1u, cursor.At(39));
+    VERIFY_ARE_EQUAL(1u, cursor.At(5));
+    VERIFY_ARE_EQUAL(0u, cursor.At(79));
+}
+
+void TerminalBufferTests::TestIncrementalPatterns()
+{
+    auto lock = term->LockForWriting();
+
+    const auto verifyRow = [&](til::CoordType y, std::initializer_list<Microsoft::Console::Render::PatternSpan> expected) {
+        const auto actual = term->GetPatternSpans(y);
+        VERIFY_ARE_EQUAL(expected.size(), actual.size());
+        auto it = actual.begin();
+        for (const auto& e : expected)
+        {
+            VERIFY_ARE_EQUAL(e.begin, it->begin);
+            VERIFY_ARE_EQUAL(e.end, it->end);
+            VERIFY_ARE_EQUAL(e.ids, it->ids);
+            ++it;
+        }
+    };
+
+    term->SetCustomPatterns({ LR"(\bERROR\b)" });
+    term->Write(L"ERROR: see http://a.b/c\r\nhttp://d.e/f\r\n");
+    term->UpdatePatternsUnderLock();
+
+    // The URL pattern has ID 0 and the custom ones follow after it.
+    verifyRow(0, { { 0, 5, 0b10 }, { 11, 23, 0b01 } });
+    verifyRow(1, { { 0, 12, 0b01 } });
+
+    Log::Comment(L"Changing a row must only affect the matches in that row.");
+    term->Write(L"\x1b[2;1Hnothing here");
+    term->UpdatePatternsUnderLock();
+    verifyRow(0, { { 0, 5, 0b10 }, { 11, 23, 0b01 } });
+    verifyRow(1, {});
+
+    Log::Comment(L"A URL that gets completed by wrapping into the next row must be found as a whole.");
+    term->Write(L"\x1b[3;71Hhttps://x");
+    term->UpdatePatternsUnderLock();
+    verifyRow(2, { { 70, 79, 0b01 } });
+    term->Write(L"yz.com/");
+    term->UpdatePatternsUnderLock();
+    verifyRow(2, { { 70, TerminalViewWidth, 0b01 } });
+    verifyRow(3, { { 0, 6, 0b01 } });
+
+    Log::Comment(L"Scrolling the viewport must move the cached matches along with their rows.");
+    term->Write(L"\x1b[32;1H\r\n");
+    term->UpdatePatternsUnderLock();
+    verifyRow(1, { { 70, TerminalViewWidth, 0b01 } });
+    verifyRow(2, { { 0, 6, 0b01 } });
+}
@@ -52,8 +52,8 @@ VtInputThread::VtInputThread(_In_ wil::unique_hfile hPipe,
 
 // Method Description:
 // - Processes a string of input characters. The characters should be UTF-8
-//      encoded, and will get converted to wstring to be processed by the
-//      input state machine.
+//      encoded and are processed by the input state machine, which
+//      takes care of the conversion to UTF-16.
 // Arguments:
 // - u8Str - the UTF-8 string received.
 // Return Value:
@@ -70,14 +70,11 @@ VtInputThread::VtInputThread(_In_ wil::unique_hfile hPipe,
 
     try
     {
-        std::wstring wstr{};
-        auto hr = til::u8u16(u8Str, wstr, _u8State);
         // If we hit a parsing error, eat it. It's bad utf-8, we can't do anything with it.
-        if (FAILED(hr))
+        if (FAILED(_pInputStateMachine->ProcessUtf8(u8Str, _u8State)))
         {
             return S_FALSE;
         }
-        _pInputStateMachine->ProcessString(wstr);
     }
     CATCH_RETURN();
 
@@ -182,6 +182,7 @@ VtIo::VtIo() :
                     }
                 }
 
+                xterm256Engine->SetCombineGraphicsRenditions(true);
                 _pVtRenderEngine = std::move(xterm256Engine);
                 break;
             }
@@ -217,6 +218,9 @@ VtIo::VtIo() :
             {
                 _pVtRenderEngine->SetTerminalOwner(this);
                 _pVtRenderEngine->SetResizeQuirk(_resizeQuirk);
+                // In passthrough mode the client application writes to the
+                // terminal directly, so we can't know what it displays.
+                _pVtRenderEngine->SetShadowFrame(!_passthroughMode);
             }
         }
     }
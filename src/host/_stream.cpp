@@ -301,6 +301,31 @@ void WriteCharsLegacy(SCREEN_INFORMATION& screenInfo, const std::wstring_view& t
     }
 }
 
+// Applies the VT quirk and corks the renderer until the returned object goes out of scope.
+static auto _beginWrite(SCREEN_INFORMATION& screenInfo, bool requiresVtQuirk)
+{
+    const auto vtIo = ServiceLocator::LocateGlobals().getConsoleInformation().GetVtIo();
+    auto restore = wil::scope_exit([&screenInfo, vtIo, requiresVtQuirk]() {
+        if (requiresVtQuirk)
+        {
+            screenInfo.ResetIgnoreLegacyEquivalentVTAttributes();
+        }
+        if (vtIo->IsUsingVt())
+        {
+            vtIo->CorkRenderer(false);
+        }
+    });
+    if (requiresVtQuirk)
+    {
+        screenInfo.SetIgnoreLegacyEquivalentVTAttributes();
+    }
+    if (vtIo->IsUsingVt())
+    {
+        vtIo->CorkRenderer(true);
+    }
+    return restore;
+}
+
 // Routine Description:
 // - Takes the given text and inserts it into the given screen buffer.
 // Note:
@@ -334,25 +359,7 @@ try
         return CONSOLE_STATUS_WAIT;
     }
 
-    const auto vtIo = ServiceLocator::LocateGlobals().getConsoleInformation().GetVtIo();
-    const auto restoreVtQuirk = wil::scope_exit([&]() {
-        if (requiresVtQuirk)
-        {
-            screenInfo.ResetIgnoreLegacyEquivalentVTAttributes();
-        }
-        if (vtIo->IsUsingVt())
-        {
-            vtIo->CorkRenderer(false);
-        }
-    });
-    if (requiresVtQuirk)
-    {
-        screenInfo.SetIgnoreLegacyEquivalentVTAttributes();
-    }
-    if (vtIo->IsUsingVt())
-    {
-        vtIo->CorkRenderer(true);
-    }
+    const auto restoreVtQuirk = _beginWrite(screenInfo, requiresVtQuirk);
 
     const std::wstring_view str{ pwchBuffer, *pcbBuffer / sizeof(WCHAR) };
 
@@ -369,6 +376,38 @@ try
 }
 NT_CATCH_RETURN()
 
+// Routine Description:
+// - The UTF-8 equivalent of DoWriteConsole() for the common case of VT processing being enabled. Instead of
+//   converting all of the text to UTF-16 upfront, the state machine converts it in small chunks as it goes.
+// Note:
+// - Console lock must be held when calling this routine
+// Arguments:
+// - text - UTF-8 text to be inserted into buffer
+// - screenInfo - Screen Information class to write the text into at the current cursor position
+// - state - holds partial UTF-8 sequences across calls
+// Return Value:
+// - S_OK if the text was written.
+// - S_FALSE if the text needs to be converted and passed to DoWriteConsole() instead, because the
+//   write would need to wait or because the text is written by WriteCharsLegacy().
+// - Or a suitable HRESULT code for conversion failures.
+[[nodiscard]] static HRESULT _doWriteConsoleUtf8(const std::string_view text,
+                                                 SCREEN_INFORMATION& screenInfo,
+                                                 bool requiresVtQuirk,
+                                                 til::u8state& state)
+try
+{
+    const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    if (WI_IsAnyFlagSet(gci.Flags, (CONSOLE_SUSPENDED | CONSOLE_SELECTING | CONSOLE_SCROLLBAR_TRACKING)) ||
+        WI_IsAnyFlagClear(screenInfo.OutputMode, ENABLE_VIRTUAL_TERMINAL_PROCESSING | ENABLE_PROCESSED_OUTPUT))
+    {
+        return S_FALSE;
+    }
+
+    const auto restoreVtQuirk = _beginWrite(screenInfo, requiresVtQuirk);
+    return screenInfo.GetStateMachine().ProcessUtf8(text, state);
+}
+CATCH_RETURN()
+
 // Routine Description:
 // - This method performs the actual work of attempting to write to the console, converting data types as necessary
 //   to adapt from the server types to the legacy internal host types.
@@ -460,6 +499,14 @@ NT_CATCH_RETURN()
         // Convert our input parameters to Unicode
         if (codepage == CP_UTF8)
         {
+            const auto hr = _doWriteConsoleUtf8(buffer, screenInfo, requiresVtQuirk, u8State);
+            RETURN_IF_FAILED(hr);
+            if (hr == S_OK)
+            {
+                read = buffer.size();
+                return S_OK;
+            }
+
             RETURN_IF_FAILED(til::u8u16(buffer, wstr, u8State));
             read = buffer.size();
         }
@@ -10,6 +10,7 @@
 #include <til/bytes.h>
 
 #include "misc.h"
+#include "../interactivity/inc/EventSynthesis.hpp"
 #include "../interactivity/inc/ServiceLocator.hpp"
 
 #define INPUT_BUFFER_DEFAULT_INPUT_MODE (ENABLE_LINE_INPUT | ENABLE_PROCESSED_INPUT | ENABLE_ECHO_INPUT | ENABLE_MOUSE_INPUT)
@@ -151,42 +152,71 @@ void InputBuffer::Cache(std::wstring_view source)
     _cachedTextReaderW = std::wstring_view{ _cachedTextW }.substr(off);
 }
 
-// Moves up to `count`, previously cached events into `target`.
-size_t InputBuffer::ConsumeCached(bool isUnicode, size_t count, InputEventQueue& target)
+// Returns the text at the front of the buffer that a character reader would read verbatim, i.e. the leading
+// printable characters of a text run written with `WriteString`. Readers can copy it directly instead of
+// going through the key events it would otherwise be expanded into. Call `ConsumeText` afterwards with
+// the number of characters that have been used. The returned view is invalidated by any other call.
+std::wstring_view InputBuffer::PeekText() const noexcept
 {
-    _switchReadingMode(isUnicode ? ReadingMode::InputEventsW : ReadingMode::InputEventsA);
-
-    size_t i = 0;
-
-    while (i < count && !_cachedInputEvents.empty())
+    if (_storage.empty() || _storage.front().EventType != TextRunEvent || !_cachedInputEvents.empty())
     {
-        target.push_back(std::move(_cachedInputEvents.front()));
-        _cachedInputEvents.pop_front();
-        i++;
+        return {};
     }
 
-    return i;
+    const auto& run = _textRuns.front();
+    const auto text = std::wstring_view{ run.text }.substr(run.offset);
+    // Control characters are excluded, because readers give them special treatment (or ignore them) based on
+    // their key events. Any other character is returned as-is by GetChar(), regardless of its virtual key.
+    const auto it = std::find_if(text.begin(), text.end(), [](const wchar_t wch) {
+        return wch < L' ' || wch == L'\x7f';
+    });
+    return text.substr(0, gsl::narrow_cast<size_t>(it - text.begin()));
 }
 
-// Copies up to `count`, previously cached events into `target`.
-size_t InputBuffer::PeekCached(bool isUnicode, size_t count, InputEventQueue& target)
+// Removes the first `count` characters returned by `PeekText` from the buffer.
+void InputBuffer::ConsumeText(const size_t count) noexcept
 {
-    _switchReadingMode(isUnicode ? ReadingMode::InputEventsW : ReadingMode::InputEventsA);
+    if (count == 0)
+    {
+        return;
+    }
+
+    assert(!_storage.empty() && _storage.front().EventType == TextRunEvent);
 
-    size_t i = 0;
+    auto& run = _textRuns.front();
+    run.offset += count;
+    _textRunLength -= count;
 
-    for (const auto& e : _cachedInputEvents)
+    if (run.offset >= run.text.size())
     {
-        if (i >= count)
+        _textRuns.pop_front();
+        _storage.pop_front();
+
+        if (_storage.empty())
         {
-            break;
+            ServiceLocator::LocateGlobals().hInputEvent.ResetEvent();
         }
-
-        target.push_back(e);
-        i++;
     }
+}
 
-    return i;
+// Moves up to `count`, previously cached events into `target`.
+size_t InputBuffer::ConsumeCached(bool isUnicode, size_t count, InputEventQueue& target)
+{
+    _switchReadingMode(isUnicode ? ReadingMode::InputEventsW : ReadingMode::InputEventsA);
+
+    const auto offset = target.size();
+    target.resize(offset + std::min(count, _cachedInputEvents.size()));
+    return _cachedInputEvents.pop_front({ target.data() + offset, target.size() - offset });
+}
+
+// Copies up to `count`, previously cached events into `target`.
+size_t InputBuffer::PeekCached(bool isUnicode, size_t count, InputEventQueue& target)
+{
+    _switchReadingMode(isUnicode ? ReadingMode::InputEventsW : ReadingMode::InputEventsA);
+
+    const auto offset = target.size();
+    target.resize(offset + std::min(count, _cachedInputEvents.size()));
+    return _cachedInputEvents.copy_front({ target.data() + offset, target.size() - offset });
 }
 
 // Trims `source` to have a size below or equal to `expectedSourceSize` by
@@ -197,10 +227,7 @@ void InputBuffer::Cache(bool isUnicode, InputEventQueue& source, size_t expected
 
     if (source.size() > expectedSourceSize)
     {
-        _cachedInputEvents.insert(
-            _cachedInputEvents.end(),
-            std::make_move_iterator(source.begin() + expectedSourceSize),
-            std::make_move_iterator(source.end()));
+        _cachedInputEvents.append(std::span{ source.data(), source.size() }.subspan(expectedSourceSize));
         source.resize(expectedSourceSize);
     }
 }
@@ -221,7 +248,7 @@ void InputBuffer::_switchReadingModeSlowPath(ReadingMode mode)
     _cachedTextW = std::wstring{};
     _cachedTextReaderW = {};
 
-    _cachedInputEvents = std::deque<INPUT_RECORD>{};
+    _cachedInputEvents = til::ring_buffer<INPUT_RECORD>{};
 
     _readingMode = mode;
 }
@@ -274,6 +301,8 @@ void InputBuffer::ReinitializeInputBuffer()
     ServiceLocator::LocateGlobals().hInputEvent.ResetEvent();
     InputMode = INPUT_BUFFER_DEFAULT_INPUT_MODE;
     _storage.clear();
+    _textRuns.clear();
+    _textRunLength = 0;
 }
 
 // Routine Description:
@@ -306,9 +335,11 @@ void InputBuffer::TerminateRead(_In_ WaitTerminationReason Flag)
 // - The number of events currently in the input buffer.
 // Note:
 // - The console lock must be held when calling this routine.
+// - Characters in text runs that haven't been expanded yet are counted as a key down/up
+//   pair each. This is an underestimate for characters that require modifier keys.
 size_t InputBuffer::GetNumberOfReadyEvents() const noexcept
 {
-    return _storage.size();
+    return _storage.size() - _textRuns.size() + 2 * _textRunLength;
 }
 
 // Routine Description:
@@ -322,6 +353,9 @@ size_t InputBuffer::GetNumberOfReadyEvents() const noexcept
 void InputBuffer::Flush()
 {
     _storage.clear();
+    _textRuns.clear();
+    _textRunLength = 0;
+    _ShrinkStorage();
     ServiceLocator::LocateGlobals().hInputEvent.ResetEvent();
 }
 
@@ -335,10 +369,10 @@ void InputBuffer::Flush()
 // - The console lock must be held when calling this routine.
 void InputBuffer::FlushAllButKeys()
 {
-    auto newEnd = std::remove_if(_storage.begin(), _storage.end(), [](const INPUT_RECORD& event) {
-        return event.EventType != KEY_EVENT;
+    // Text runs are made up of key events and are kept as well.
+    _storage.erase_if([](const INPUT_RECORD& event) {
+        return event.EventType != KEY_EVENT && event.EventType != TextRunEvent;
     });
-    _storage.erase(newEnd, _storage.end());
 }
 
 // Routine Description:
@@ -348,7 +382,7 @@ void InputBuffer::FlushAllButKeys()
 // Note:
 // - The console lock must be held when calling this routine.
 // Arguments:
-// - OutEvents - deque to store the read events
+// - OutEvents - queue to store the read events
 // - AmountToRead - the amount of events to try to read
 // - Peek - If true, copy events to pInputRecord but don't remove them from the input buffer.
 // - WaitForData - if true, wait until an event is input (if there aren't enough to fill client buffer). if false, return immediately
@@ -379,14 +413,27 @@ try
         ConsumeCached(Unicode, AmountToRead, OutEvents);
     }
 
-    auto it = _storage.begin();
-    const auto end = _storage.end();
+    // Each record produces at least one event below, so this expands no more than we're going to read.
+    _ExpandTextRuns(AmountToRead - std::min(AmountToRead, OutEvents.size()));
 
-    while (it != end && OutEvents.size() < AmountToRead)
+    size_t read = 0;
+
+    // Fast path: Without stream splitting or codepage conversion each record maps to exactly one event,
+    // which allows us to copy them over in bulk. This is what ReadConsoleInputW() ends up using.
+    if (Unicode && !Stream)
     {
-        if (it->EventType == KEY_EVENT)
+        const auto offset = OutEvents.size();
+        OutEvents.resize(offset + std::min(AmountToRead - std::min(AmountToRead, offset), _storage.size()));
+        read = _storage.copy_front({ OutEvents.data() + offset, OutEvents.size() - offset });
+    }
+
+    while (read < _storage.size() && OutEvents.size() < AmountToRead)
+    {
+        auto& record = _storage[read];
+
+        if (record.EventType == KEY_EVENT)
         {
-            auto event = *it;
+            auto event = record;
             WORD repeat = 1;
 
             // for stream reads we need to split any key events that have been coalesced
@@ -429,21 +476,22 @@ try
 
             if (repeat && !Peek)
             {
-                it->Event.KeyEvent.wRepeatCount = repeat;
+                record.Event.KeyEvent.wRepeatCount = repeat;
                 break;
             }
         }
         else
         {
-            OutEvents.push_back(*it);
+            OutEvents.push_back(record);
         }
 
-        ++it;
+        ++read;
     }
 
     if (!Peek)
     {
-        _storage.erase(_storage.begin(), it);
+        _storage.pop_front(read);
+        _ShrinkStorage();
     }
 
     Cache(Unicode, OutEvents, AmountToRead);
@@ -489,12 +537,12 @@ size_t InputBuffer::Prepend(const std::span<const INPUT_RECORD>& inEvents)
         // this way to handle any coalescing that might occur.
 
         // get all of the existing records, "emptying" the buffer
-        std::deque<INPUT_RECORD> existingStorage;
+        til::ring_buffer<INPUT_RECORD> existingStorage;
         existingStorage.swap(_storage);
 
         // We will need this variable to pass to _WriteBuffer so it can attempt to determine wait status.
-        // However, because we swapped the storage out from under it with an empty deque, it will always
-        // return true after the first one (as it is filling the newly emptied backing deque.)
+        // However, because we swapped the storage out from under it with an empty buffer, it will always
+        // return true after the first one (as it is filling the newly emptied backing buffer.)
         // Then after the second one, because we've inserted some input, it will always say false.
         auto unusedWaitStatus = false;
 
@@ -503,9 +551,10 @@ size_t InputBuffer::Prepend(const std::span<const INPUT_RECORD>& inEvents)
         _WriteBuffer(inEvents, prependEventsWritten, unusedWaitStatus);
         FAIL_FAST_IF(!(unusedWaitStatus));
 
-        for (const auto& event : existingStorage)
+        _storage.reserve(_storage.size() + existingStorage.size());
+        for (const auto& segment : existingStorage.segments())
         {
-            _storage.push_back(event);
+            _storage.append(segment);
         }
 
         // We need to set the wait event if there were 0 events in the
@@ -588,6 +637,65 @@ size_t InputBuffer::Write(const std::span<const INPUT_RECORD>& inEvents)
     }
 }
 
+// Routine Description:
+// - Writes a string to the input buffer, as if each character had been typed on the keyboard.
+//   Unlike building the key events with CharToKeyEvents() and calling Write(), the text is stored as
+//   a single text run which is only expanded into key events if a client reads INPUT_RECORDs.
+//   This keeps large pastes compact and lets character readers copy them over directly.
+// Arguments:
+// - text - The text to write.
+// - codepage - The codepage used to synthesize key events for characters not on the keyboard layout.
+// Note:
+// - The console lock must be held when calling this routine.
+void InputBuffer::WriteString(const std::wstring_view text, const unsigned int codepage)
+try
+{
+    if (text.empty())
+    {
+        return;
+    }
+
+    const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+
+    // _WriteBuffer() intercepts some key events: VT input mode translates them, any key
+    // releases a suspended output and Ctrl+S suspends it. Those need to go the slow way.
+    if (IsInVirtualTerminalInputMode() ||
+        WI_IsFlagSet(gci.Flags, CONSOLE_SUSPENDED) ||
+        (WI_IsFlagSet(InputMode, ENABLE_LINE_INPUT) && text.find(L'\x13') != std::wstring_view::npos))
+    {
+        InputEventQueue events;
+        for (const auto& wch : text)
+        {
+            Interactivity::CharToKeyEvents(wch, codepage, events);
+        }
+        Write(events);
+        return;
+    }
+
+    const auto wasEmpty = _storage.empty();
+
+    if (!wasEmpty && _storage.back().EventType == TextRunEvent && _textRuns.back().codepage == codepage)
+    {
+        _textRuns.back().text.append(text);
+    }
+    else
+    {
+        _textRuns.emplace_back(TextRun{ std::wstring{ text }, 0, codepage });
+        INPUT_RECORD record{};
+        record.EventType = TextRunEvent;
+        _storage.push_back(record);
+    }
+
+    _textRunLength += text.size();
+
+    if (wasEmpty)
+    {
+        ServiceLocator::LocateGlobals().hInputEvent.SetEvent();
+    }
+    WakeUpReadersWaitingForData();
+}
+CATCH_LOG()
+
 // This can be considered a "privileged" variant of Write() which allows FOCUS_EVENTs to generate focus VT sequences.
 // If we didn't do this, someone could write a FOCUS_EVENT_RECORD with WriteConsoleInput, exit without flushing the
 // input buffer and the next application will suddenly get a "\x1b[I" sequence in their input. See GH#13238.
@@ -682,6 +790,12 @@ void InputBuffer::_WriteBuffer(const std::span<const INPUT_RECORD>& inEvents, _O
 
     for (const auto& inEvent : inEvents)
     {
+        // TextRunEvent is reserved for our own bookkeeping and isn't a valid event type for clients.
+        if (inEvent.EventType == TextRunEvent)
+        {
+            continue;
+        }
+
         if (inEvent.EventType == KEY_EVENT && inEvent.Event.KeyEvent.bKeyDown)
         {
             // if output is suspended, any keyboard input releases it.
@@ -733,6 +847,75 @@ void InputBuffer::_WriteBuffer(const std::span<const INPUT_RECORD>& inEvents, _O
     }
 }
 
+// Routine Description:
+// - A large paste can grow the buffer to hold millions of records. Once most of them have been
+//   read or flushed, the memory is released, instead of being held onto until the console exits.
+// Note:
+// - The console lock must be held when calling this routine.
+void InputBuffer::_ShrinkStorage() noexcept
+{
+    static constexpr size_t minimumCapacity = 4096;
+    if (_storage.capacity() > minimumCapacity && _storage.size() < _storage.capacity() / 8)
+    {
+        try
+        {
+            _storage.shrink_to_fit();
+        }
+        CATCH_LOG();
+    }
+}
+
+// Routine Description:
+// - Expands the text runs among the first `count` records in the buffer into the key events they
+//   stand in for, so that they can be read like any other record. Text runs are only partially
+//   expanded if that suffices to make `count` records available.
+// Arguments:
+// - count - The number of records at the front of the buffer that must not be text runs.
+// Note:
+// - The console lock must be held when calling this routine.
+// - will throw on failure
+void InputBuffer::_ExpandTextRuns(const size_t count)
+{
+    if (_textRuns.empty())
+    {
+        return;
+    }
+
+    InputEventQueue events;
+    size_t pos = 0;
+
+    while (pos < count && pos < _storage.size())
+    {
+        if (_storage[pos].EventType != TextRunEvent)
+        {
+            ++pos;
+            continue;
+        }
+
+        // All text runs in front of this one have already been fully expanded and removed.
+        auto& run = _textRuns.front();
+        const auto needed = count - pos;
+        const auto beg = run.offset;
+
+        events.clear();
+        while (events.size() < needed && run.offset < run.text.size())
+        {
+            Interactivity::CharToKeyEvents(run.text[run.offset], run.codepage, events);
+            ++run.offset;
+        }
+
+        _storage.insert(pos, { events.data(), events.size() });
+        _textRunLength -= run.offset - beg;
+        pos += events.size();
+
+        if (run.offset >= run.text.size())
+        {
+            _storage.erase(pos);
+            _textRuns.pop_front();
+        }
+    }
+}
+
 // Routine Description::
 // - If the last input event saved and the first input event in inRecords
 // are both a keypress down event for the same key, update the repeat
@@ -814,6 +997,7 @@ void InputBuffer::_HandleTerminalInputCallback(const TerminalInput::StringType&
             return;
         }
 
+        _storage.reserve(_storage.size() + text.size());
         for (const auto& wch : text)
         {
             _storage.push_back(SynthesizeKeyEvent(true, 1, 0, 0, wch, 0));
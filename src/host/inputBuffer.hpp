@@ -11,6 +11,7 @@
 #include "../terminal/input/terminalInput.hpp"
 
 #include <deque>
+#include <til/ring_buffer.h>
 
 namespace Microsoft::Console::Render
 {
@@ -31,6 +32,8 @@ public:
     void Consume(bool isUnicode, std::wstring_view& source, std::span<char>& target);
     void ConsumeCached(bool isUnicode, std::span<char>& target);
     void Cache(std::wstring_view source);
+    std::wstring_view PeekText() const noexcept;
+    void ConsumeText(size_t count) noexcept;
     // INPUT_RECORD oriented APIs
     size_t ConsumeCached(bool isUnicode, size_t count, InputEventQueue& target);
     size_t PeekCached(bool isUnicode, size_t count, InputEventQueue& target);
@@ -58,6 +61,7 @@ public:
     size_t Prepend(const std::span<const INPUT_RECORD>& inEvents);
     size_t Write(const INPUT_RECORD& inEvent);
     size_t Write(const std::span<const INPUT_RECORD>& inEvents);
+    void WriteString(std::wstring_view text, unsigned int codepage);
     void WriteFocusEvent(bool focused) noexcept;
     bool WriteMouseEvent(til::point position, unsigned int button, short keyState, short wheelDelta);
 
@@ -77,10 +81,23 @@ private:
     std::string_view _cachedTextReaderA;
     std::wstring _cachedTextW;
     std::wstring_view _cachedTextReaderW;
-    std::deque<INPUT_RECORD> _cachedInputEvents;
+    til::ring_buffer<INPUT_RECORD> _cachedInputEvents;
     ReadingMode _readingMode = ReadingMode::StringA;
 
-    std::deque<INPUT_RECORD> _storage;
+    // A text run stands in for the key events of a string written with WriteString(). It occupies a single
+    // record of type TextRunEvent in _storage and only gets expanded into key events once someone asks for
+    // INPUT_RECORDs. Character readers can copy its text directly via PeekText() and ConsumeText() instead.
+    struct TextRun
+    {
+        std::wstring text;
+        size_t offset = 0;
+        unsigned int codepage = 0;
+    };
+    static constexpr WORD TextRunEvent = 0x8000;
+
+    til::ring_buffer<INPUT_RECORD> _storage;
+    std::deque<TextRun> _textRuns;
+    size_t _textRunLength = 0;
     INPUT_RECORD _writePartialByteSequence{};
     bool _writePartialByteSequenceAvailable = false;
     Microsoft::Console::VirtualTerminal::TerminalInput _termInput;
@@ -95,6 +112,8 @@ private:
     void _switchReadingModeSlowPath(ReadingMode mode);
     void _WriteBuffer(const std::span<const INPUT_RECORD>& inRecords, _Out_ size_t& eventsWritten, _Out_ bool& setWaitEvent);
     bool _CoalesceEvent(const INPUT_RECORD& inEvent) noexcept;
+    void _ExpandTextRuns(size_t count);
+    void _ShrinkStorage() noexcept;
     void _HandleTerminalInputCallback(const Microsoft::Console::VirtualTerminal::TerminalInput::StringType& text);
 
 #ifdef UNIT_TESTING
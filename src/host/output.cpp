@@ -85,8 +85,31 @@ static void _CopyRectangle(SCREEN_INFORMATION& screenInfo,
         if (sourceFullRows && verticalCopyOnly)
         {
             const auto delta = targetOrigin.y - source.Top();
+            auto& textBuffer = screenInfo.GetTextBuffer();
 
-            screenInfo.GetTextBuffer().ScrollRows(source.Top(), source.Height(), delta);
+            // ScrollRows() rotates all rows between the source and the target. If the two don't overlap
+            // or touch, that would shift the rows in between, which a copy must leave alone. They're
+            // copied row by row instead. Since they don't overlap, the order doesn't matter.
+            if (std::abs(delta) > source.Height())
+            {
+                for (auto y = source.Top(); y < source.BottomExclusive(); ++y)
+                {
+                    textBuffer.GetMutableRowByOffset(y + delta).CopyFrom(textBuffer.GetRowByOffset(y));
+                }
+                return;
+            }
+
+            textBuffer.ScrollRows(source.Top(), source.Height(), delta);
+
+            // ScrollRows() rotates the rows that were scrolled over into the part of the source
+            // that isn't covered by the target. A copy however is expected to leave the source intact.
+            // The caller will usually fill this area right after, but it may be outside of its clip rectangle.
+            const auto vacated = std::min(std::abs(delta), source.Height());
+            const auto vacatedTop = delta < 0 ? source.BottomExclusive() - vacated : source.Top();
+            for (auto y = vacatedTop; y < vacatedTop + vacated; ++y)
+            {
+                textBuffer.GetMutableRowByOffset(y).CopyFrom(textBuffer.GetRowByOffset(y + delta));
+            }
 
             return;
         }
@@ -322,6 +322,18 @@ void COOKED_READ_DATA::_readCharInputLoop()
         const auto pPopupKeys = hasPopup ? &popupKeys : nullptr;
         DWORD modifiers = 0;
 
+        // Fast path: Text written with WriteString() (e.g. a paste) can be inserted
+        // in bulk, without expanding it into key events for GetChar().
+        if (!hasPopup)
+        {
+            if (const auto text = _pInputBuffer->PeekText(); !text.empty())
+            {
+                _handleText(text);
+                _pInputBuffer->ConsumeText(text.size());
+                continue;
+            }
+        }
+
         const auto status = GetChar(_pInputBuffer, &charOrVkey, true, pCommandLineEditingKeys, pPopupKeys, &modifiers);
         if (status == CONSOLE_STATUS_WAIT)
         {
@@ -432,6 +444,24 @@ void COOKED_READ_DATA::_handleChar(wchar_t wch, const DWORD modifiers)
     _markAsDirty();
 }
 
+// Handles printable text (see InputBuffer::PeekText) for _readCharInputLoop() when no popups exist.
+// It's equivalent to calling _handleChar() for each character.
+void COOKED_READ_DATA::_handleText(const std::wstring_view& text)
+{
+    if (!_insertMode)
+    {
+        for (const auto& wch : text)
+        {
+            _handleChar(wch, 0);
+        }
+        return;
+    }
+
+    _buffer.insert(_bufferCursor, text);
+    _bufferCursor += text.size();
+    _markAsDirty();
+}
+
 // Handles non-character input for _readCharInputLoop() when no popups exist.
 void COOKED_READ_DATA::_handleVkey(uint16_t vkey, DWORD modifiers)
 {
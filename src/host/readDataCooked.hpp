@@ -115,6 +115,7 @@ private:
 
     void _readCharInputLoop();
     void _handleChar(wchar_t wch, DWORD modifiers);
+    void _handleText(const std::wstring_view& text);
     void _handleVkey(uint16_t vkey, DWORD modifiers);
     void _handlePostCharInputLoop(bool isUnicode, size_t& numBytes, ULONG& controlKeyState);
     void _transitionState(State state) noexcept;
@@ -313,7 +313,7 @@ const std::wstring RenderData::GetHyperlinkCustomId(uint16_t id) const
 }
 
 // For now, we ignore regex patterns in conhost
-const std::vector<size_t> RenderData::GetPatternId(const til::point /*location*/) const
+std::span<const Microsoft::Console::Render::PatternSpan> RenderData::GetPatternSpans(const til::CoordType /*viewportRow*/) const noexcept
 {
     return {};
 }
@@ -47,7 +47,7 @@ public:
     const std::wstring GetHyperlinkUri(uint16_t id) const override;
     const std::wstring GetHyperlinkCustomId(uint16_t id) const override;
 
-    const std::vector<size_t> GetPatternId(const til::point location) const override;
+    std::span<const Microsoft::Console::Render::PatternSpan> GetPatternSpans(const til::CoordType viewportRow) const noexcept override;
 
     std::pair<COLORREF, COLORREF> GetAttributeColors(const TextAttribute& attr) const noexcept override;
     const bool IsSelectionActive() const override;
@@ -120,6 +120,14 @@ SCREEN_INFORMATION::~SCREEN_INFORMATION()
                                                             pScreen->IsActiveScreenBuffer(),
                                                             *ServiceLocator::LocateGlobals().pRender);
 
+        // Filling a large buffer commits a lot of memory. It's committed in the background then, instead of
+        // while the console lock is held. Reflow() carries this over to the buffers created by a resize.
+        static constexpr til::CoordType prefaultMinimumHeight = 10000;
+        if (coordScreenBufferSize.height >= prefaultMinimumHeight)
+        {
+            pScreen->_textBuffer->SetPrefault(true);
+        }
+
         const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
         pScreen->_textBuffer->GetCursor().SetType(gci.GetCursorType());
 
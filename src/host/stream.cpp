@@ -422,6 +422,17 @@ try
 
     while (writer.size() >= charSize)
     {
+        // Fast path: Text written with WriteString() (e.g. a paste) can be copied
+        // over directly, without expanding it into key events for GetChar().
+        if (auto text = inputBuffer.PeekText(); !text.empty())
+        {
+            const auto size = text.size();
+            inputBuffer.Consume(unicode, text, writer);
+            inputBuffer.ConsumeText(size - text.size());
+            noDataReadYet = false;
+            continue;
+        }
+
         wchar_t wch;
         // We don't need to wait for input if `ConsumeCached` read something already, which is
         // indicated by the writer having been advanced (= it's shorter than the original buffer).
@@ -866,4 +866,68 @@ class ApiRoutinesTests
 
         ValidateComplexScreen(si, background, fill, scrollRect, Viewport::FromInclusive(scroll), destination, clipViewport);
     }
+
+    TEST_METHOD(ApiScrollConsoleScreenBufferWDistantRows)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& si = gci.GetActiveOutputBuffer();
+        auto& textBuffer = si.GetTextBuffer();
+
+        textBuffer.ResizeTraditional({ 5, 10 });
+
+        gci.LockConsole();
+        auto Unlock = wil::scope_exit([&] { gci.UnlockConsole(); });
+
+        // Screen now looks like:
+        // 00000
+        // 11111
+        // ...
+        // 99999
+        for (til::CoordType y = 0; y < 10; ++y)
+        {
+            si.GetActiveBuffer().Write(OutputCellIterator(static_cast<wchar_t>(L'0' + y), 5), { 0, y });
+        }
+
+        Log::Comment(L"Copy full rows far down, so that the source and target don't overlap. The rows in between must remain untouched.");
+        const til::inclusive_rect scroll{ 0, 2, 4, 3 };
+        VERIFY_SUCCEEDED(_pApiRoutines->ScrollConsoleScreenBufferWImpl(si, scroll, { 0, 7 }, std::nullopt, L'A', FOREGROUND_RED));
+
+        static constexpr std::array<std::wstring_view, 10> expected{
+            L"00000",
+            L"11111",
+            L"AAAAA",
+            L"AAAAA",
+            L"44444",
+            L"55555",
+            L"66666",
+            L"22222",
+            L"33333",
+            L"99999",
+        };
+        for (til::CoordType y = 0; y < 10; ++y)
+        {
+            VERIFY_ARE_EQUAL(til::at(expected, y), textBuffer.GetRowByOffset(y).GetText());
+        }
+
+        Log::Comment(L"Same, but upwards.");
+        const til::inclusive_rect scrollUp{ 0, 7, 4, 8 };
+        VERIFY_SUCCEEDED(_pApiRoutines->ScrollConsoleScreenBufferWImpl(si, scrollUp, { 0, 0 }, std::nullopt, L'B', FOREGROUND_RED));
+
+        static constexpr std::array<std::wstring_view, 10> expectedUp{
+            L"22222",
+            L"33333",
+            L"AAAAA",
+            L"AAAAA",
+            L"44444",
+            L"55555",
+            L"66666",
+            L"BBBBB",
+            L"BBBBB",
+            L"99999",
+        };
+        for (til::CoordType y = 0; y < 10; ++y)
+        {
+            VERIFY_ARE_EQUAL(til::at(expectedUp, y), textBuffer.GetRowByOffset(y).GetText());
+        }
+    }
 };
@@ -8,6 +8,7 @@
 
 #include "../types/inc/CodepointWidthDetector.hpp"
 
+using namespace WEX::Common;
 using namespace WEX::Logging;
 
 static constexpr std::wstring_view emoji = L"\xD83E\xDD22"; // U+1F922 nauseated face
@@ -66,24 +67,97 @@ class CodepointWidthDetectorTests
     {
         // Set up a detector with fallback.
         CodepointWidthDetector widthDetector;
-        widthDetector.SetFallbackMethod(std::bind(&FallbackMethod, std::placeholders::_1));
+        size_t fallbackCalls = 0;
+        widthDetector.SetFallbackMethod([&](const std::wstring_view glyph) {
+            ++fallbackCalls;
+            return FallbackMethod(glyph);
+        });
+
+        const auto& entry = widthDetector._fallbackCache.at(ambiguous[0] % widthDetector._fallbackCache.size());
 
         // Ensure fallback cache is empty.
-        VERIFY_ARE_EQUAL(0u, widthDetector._fallbackCache.size());
+        VERIFY_ARE_EQUAL(0u, entry.codepoint);
 
         // Lookup ambiguous width character.
         widthDetector.IsWide(ambiguous);
 
         // Cache should hold it.
-        VERIFY_ARE_EQUAL(1u, widthDetector._fallbackCache.size());
+        VERIFY_ARE_EQUAL(1u, fallbackCalls);
+        VERIFY_ARE_EQUAL(static_cast<char32_t>(ambiguous[0]), entry.codepoint);
 
         // Cached item should match what we expect
-        const auto it = widthDetector._fallbackCache.begin();
-        VERIFY_ARE_EQUAL(ambiguous[0], it->first);
-        VERIFY_ARE_EQUAL(FallbackMethod(ambiguous) ? 2u : 1u, it->second);
+        VERIFY_ARE_EQUAL(FallbackMethod(ambiguous) ? 2u : 1u, entry.width);
+
+        // A second lookup should be served from the cache.
+        widthDetector.IsWide(ambiguous);
+        VERIFY_ARE_EQUAL(1u, fallbackCalls);
 
         // Cache should empty when font changes.
         widthDetector.NotifyFontChanged();
-        VERIFY_ARE_EQUAL(0u, widthDetector._fallbackCache.size());
+        VERIFY_ARE_EQUAL(0u, entry.codepoint);
+
+        widthDetector.IsWide(ambiguous);
+        VERIFY_ARE_EQUAL(2u, fallbackCalls);
+    }
+
+    TEST_METHOD(AmbiguousCacheCollision)
+    {
+        CodepointWidthDetector widthDetector;
+        widthDetector.SetFallbackMethod(std::bind(&FallbackMethod, std::placeholders::_1));
+
+        // U+0414 and U+E014 (private use, ambiguous) map to the same slot and evict each other.
+        const auto size = gsl::narrow_cast<wchar_t>(widthDetector._fallbackCache.size());
+        const wchar_t other = gsl::narrow_cast<wchar_t>(ambiguous[0] % size + 0xE000);
+        VERIFY_ARE_EQUAL(ambiguous[0] % size, other % size);
+
+        const auto& entry = widthDetector._fallbackCache.at(ambiguous[0] % size);
+
+        VERIFY_ARE_EQUAL(FallbackMethod(ambiguous), widthDetector.IsWide(ambiguous));
+        VERIFY_ARE_EQUAL(static_cast<char32_t>(ambiguous[0]), entry.codepoint);
+
+        VERIFY_ARE_EQUAL(FallbackMethod({ &other, 1 }), widthDetector.IsWide({ &other, 1 }));
+        VERIFY_ARE_EQUAL(static_cast<char32_t>(other), entry.codepoint);
+
+        VERIFY_ARE_EQUAL(FallbackMethod(ambiguous), widthDetector.IsWide(ambiguous));
+        VERIFY_ARE_EQUAL(static_cast<char32_t>(ambiguous[0]), entry.codepoint);
+    }
+
+    // The two-stage lookup table is generated from the same ranges that the binary search operates on.
+    // This ensures that both agree on every codepoint and logs how long either takes for the entire range.
+    TEST_METHOD(TwoStageTableMatchesBinarySearch)
+    {
+        static constexpr char32_t codepointCount = 0x110000;
+        static constexpr int passes = 8;
+
+        for (char32_t cp = 0; cp < codepointCount; ++cp)
+        {
+            const auto expected = CodepointWidthDetector::_searchWidthClass(cp);
+            const auto actual = CodepointWidthDetector::_lookupWidthClass(cp);
+            if (expected != actual)
+            {
+                VERIFY_ARE_EQUAL(expected, actual, NoThrowString().Format(L"U+%04X", cp));
+            }
+        }
+
+        const auto measure = [](auto&& lookup) {
+            size_t checksum = 0;
+            const auto beg = std::chrono::steady_clock::now();
+            for (auto pass = 0; pass < passes; ++pass)
+            {
+                for (char32_t cp = 0; cp < codepointCount; ++cp)
+                {
+                    checksum += lookup(cp);
+                }
+            }
+            const auto end = std::chrono::steady_clock::now();
+            return std::pair{ std::chrono::duration<double, std::nano>(end - beg).count() / (passes * codepointCount), checksum };
+        };
+
+        const auto [search, searchChecksum] = measure(&CodepointWidthDetector::_searchWidthClass);
+        const auto [lookup, lookupChecksum] = measure(&CodepointWidthDetector::_lookupWidthClass);
+        VERIFY_ARE_EQUAL(searchChecksum, lookupChecksum);
+
+        Log::Comment(NoThrowString().Format(L"binary search: %.2f ns/codepoint", search));
+        Log::Comment(NoThrowString().Format(L"two-stage table: %.2f ns/codepoint", lookup));
     }
 };
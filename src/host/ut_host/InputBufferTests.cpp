@@ -6,9 +6,11 @@
 #include "../../inc/consoletaeftemplates.hpp"
 #include "CommonState.hpp"
 
+#include "../interactivity/inc/EventSynthesis.hpp"
 #include "../interactivity/inc/ServiceLocator.hpp"
 #include "../types/inc/IInputEvent.hpp"
 
+using namespace WEX::Common;
 using namespace WEX::Logging;
 using Microsoft::Console::Interactivity::ServiceLocator;
 
@@ -642,4 +644,130 @@ class InputBufferTests
         VERIFY_ARE_EQUAL(inputBuffer._storage.front().Event.KeyEvent.wRepeatCount, repeatCount);
         VERIFY_ARE_EQUAL(outEvents.front().Event.KeyEvent.wRepeatCount, 1u);
     }
+
+    TEST_METHOD(WriteStringExpandsTextRunsLazily)
+    {
+        InputBuffer inputBuffer;
+        const auto codepage = ServiceLocator::LocateGlobals().getConsoleInformation().OutputCP;
+        const std::wstring_view text{ L"Hello, World!" };
+
+        InputEventQueue expected;
+        for (const auto& wch : text)
+        {
+            Microsoft::Console::Interactivity::CharToKeyEvents(wch, codepage, expected);
+        }
+
+        inputBuffer.WriteString(text.substr(0, 5), codepage);
+        inputBuffer.WriteString(text.substr(5), codepage);
+
+        Log::Comment(L"Consecutive strings should be merged into a single text run.");
+        VERIFY_ARE_EQUAL(inputBuffer._storage.size(), 1u);
+        VERIFY_ARE_EQUAL(inputBuffer._textRuns.size(), 1u);
+        VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), 2 * text.size());
+
+        Log::Comment(L"Reading a few records should only expand the beginning of the text run.");
+        InputEventQueue outEvents;
+        VERIFY_NT_SUCCESS(inputBuffer.Read(outEvents, 3, false, false, true, false));
+        VERIFY_ARE_EQUAL(outEvents.size(), 3u);
+        VERIFY_ARE_EQUAL(inputBuffer._textRuns.size(), 1u);
+
+        Log::Comment(L"The remaining records should match those synthesized for each character.");
+        InputEventQueue remaining;
+        VERIFY_NT_SUCCESS(inputBuffer.Read(remaining, expected.size(), false, false, true, false));
+        outEvents.insert(outEvents.end(), remaining.begin(), remaining.end());
+        VERIFY_ARE_EQUAL(outEvents.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(expected[i], outEvents[i]);
+        }
+        VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), 0u);
+        VERIFY_IS_TRUE(inputBuffer._textRuns.empty());
+    }
+
+    TEST_METHOD(PeekTextReturnsPrintableText)
+    {
+        InputBuffer inputBuffer;
+        const auto codepage = ServiceLocator::LocateGlobals().getConsoleInformation().OutputCP;
+
+        inputBuffer.Write(MakeKeyEvent(true, 1, L'X', 0, L'x', 0));
+        inputBuffer.WriteString(L"ab\rcd", codepage);
+
+        Log::Comment(L"Text runs should only be available once the records in front of them have been read.");
+        VERIFY_IS_TRUE(inputBuffer.PeekText().empty());
+        InputEventQueue outEvents;
+        VERIFY_NT_SUCCESS(inputBuffer.Read(outEvents, 1, false, false, true, false));
+        VERIFY_ARE_EQUAL(std::wstring{ L"ab" }, std::wstring{ inputBuffer.PeekText() });
+        inputBuffer.ConsumeText(2);
+
+        Log::Comment(L"Control characters should be read as key events.");
+        VERIFY_IS_TRUE(inputBuffer.PeekText().empty());
+        InputEventQueue expected;
+        Microsoft::Console::Interactivity::CharToKeyEvents(L'\r', codepage, expected);
+        outEvents.clear();
+        VERIFY_NT_SUCCESS(inputBuffer.Read(outEvents, expected.size(), false, false, true, false));
+        VERIFY_ARE_EQUAL(outEvents.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(expected[i], outEvents[i]);
+        }
+
+        VERIFY_ARE_EQUAL(std::wstring{ L"cd" }, std::wstring{ inputBuffer.PeekText() });
+        inputBuffer.ConsumeText(2);
+        VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), 0u);
+        VERIFY_IS_TRUE(inputBuffer._storage.empty());
+        VERIFY_IS_TRUE(inputBuffer._textRuns.empty());
+    }
+
+    // Pushes 1M events through the buffer, once written all at once (like a large paste)
+    // and once in small write/read cycles (like a steady stream of mouse or key events),
+    // verifies that they come out unchanged and logs how long either took.
+    TEST_METHOD(WriteReadThroughput)
+    {
+        static constexpr size_t eventCount = 1024 * 1024;
+        static constexpr size_t batchSize = 64;
+
+        std::vector<INPUT_RECORD> records(eventCount);
+        for (size_t i = 0; i < eventCount; ++i)
+        {
+            // Alternating key down and up events prevent any coalescing.
+            const auto wch = static_cast<wchar_t>(L'a' + i / 2 % 26);
+            records[i] = MakeKeyEvent(i % 2 == 0, 1, wch, 0, wch, 0);
+        }
+
+        const auto measure = [&](size_t writeSize) {
+            InputBuffer inputBuffer;
+            InputEventQueue outEvents;
+            size_t written = 0;
+            size_t read = 0;
+            bool matches = true;
+
+            const auto beg = std::chrono::steady_clock::now();
+            while (read < eventCount)
+            {
+                if (written < eventCount)
+                {
+                    const auto count = std::min(writeSize, eventCount - written);
+                    written += inputBuffer.Write(std::span{ records }.subspan(written, count));
+                }
+
+                outEvents.clear();
+                VERIFY_NT_SUCCESS(inputBuffer.Read(outEvents, batchSize, false, false, true, false));
+                for (const auto& event : outEvents)
+                {
+                    matches &= WEX::TestExecution::VerifyCompareTraits<INPUT_RECORD, INPUT_RECORD>::AreEqual(records[read++], event);
+                }
+            }
+            const auto end = std::chrono::steady_clock::now();
+
+            VERIFY_IS_TRUE(matches);
+            VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), 0u);
+            return std::chrono::duration<double, std::nano>(end - beg).count() / eventCount;
+        };
+
+        const auto bulk = measure(eventCount);
+        const auto cycles = measure(batchSize);
+
+        Log::Comment(NoThrowString().Format(L"bulk write, batched reads: %.2f ns/event", bulk));
+        Log::Comment(NoThrowString().Format(L"batched write/read cycles: %.2f ns/event", cycles));
+    }
 };
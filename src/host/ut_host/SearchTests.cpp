@@ -158,4 +158,71 @@ class SearchTests
         s.ResetIfStale(gci.renderData, L"\x304b", true, true);
         DoFoundChecks(s, { 2, 3 }, -1);
     }
+
+    static void VerifyResultsEqual(const Search& expected, const Search& actual)
+    {
+        const auto& e = expected.Results();
+        const auto& a = actual.Results();
+        VERIFY_ARE_EQUAL(e.size(), a.size());
+        for (size_t i = 0; i < e.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(e[i].start, a[i].start);
+            VERIFY_ARE_EQUAL(e[i].end, a[i].end);
+        }
+    }
+
+    TEST_METHOD(IncrementalSearchMatchesFullSearch)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+        const auto width = textBuffer.GetSize().Width();
+
+        Search incremental;
+        VERIFY_IS_TRUE(incremental.ResetIfStale(gci.renderData, L"AB", false, false));
+        VERIFY_ARE_EQUAL(4u, incremental.Results().size());
+
+        const auto verify = [&]() {
+            // Only the buffer contents changed, so the cached results must be kept.
+            VERIFY_IS_FALSE(incremental.ResetIfStale(gci.renderData, L"AB", false, false));
+
+            Search full;
+            full.ResetIfStale(gci.renderData, L"AB", false, false);
+            VERIFY_ARE_EQUAL(full.Results().size(), incremental.Results().size());
+            VerifyResultsEqual(full, incremental);
+
+            // Searching in tiny chunks must yield the same results as searching in one go.
+            Search chunked;
+            VERIFY_IS_TRUE(chunked.Prepare(gci.renderData, L"AB", false, false));
+            while (chunked.ScanSome(1))
+            {
+                VERIFY_IS_TRUE(chunked.IsScanning());
+            }
+            VERIFY_IS_FALSE(chunked.IsScanning());
+            VerifyResultsEqual(full, chunked);
+        };
+
+        Log::Comment(L"A new match in a row that was previously empty");
+        textBuffer.GetMutableRowByOffset(10).ReplaceCharacters(5, 1, L"A");
+        textBuffer.GetMutableRowByOffset(10).ReplaceCharacters(6, 1, L"B");
+        verify();
+        VERIFY_ARE_EQUAL(5u, incremental.Results().size());
+
+        Log::Comment(L"A match that got overwritten");
+        textBuffer.GetMutableRowByOffset(0).ReplaceCharacters(0, 1, L"X");
+        verify();
+        VERIFY_ARE_EQUAL(4u, incremental.Results().size());
+
+        Log::Comment(L"A match that spans two rows");
+        textBuffer.GetMutableRowByOffset(20).ReplaceCharacters(width - 1, 1, L"A");
+        textBuffer.GetMutableRowByOffset(21).ReplaceCharacters(0, 1, L"B");
+        verify();
+        VERIFY_ARE_EQUAL(5u, incremental.Results().size());
+
+        Log::Comment(L"Rows that scrolled out of the buffer");
+        textBuffer.IncrementCircularBuffer();
+        textBuffer.IncrementCircularBuffer();
+        verify();
+        VERIFY_ARE_EQUAL(4u, incremental.Results().size());
+        VERIFY_ARE_EQUAL(til::point(0, 0), incremental.Results()[0].start);
+    }
 };
@@ -314,6 +314,8 @@ class TextBufferIteratorTests
 
     TEST_METHOD(ConstructedNoLimit);
     TEST_METHOD(ConstructedLimits);
+
+    TEST_METHOD(RowRenderViewMatchesCellIterator);
 };
 
 void TextBufferIteratorTests::BoolOperatorText()
@@ -581,3 +583,33 @@ void TextBufferIteratorTests::ConstructedLimits()
                            wil::ResultException,
                            [](wil::ResultException& e) { return e.GetErrorCode() == E_INVALIDARG; });
 }
+
+void TextBufferIteratorTests::RowRenderViewMatchesCellIterator()
+{
+    m_state->FillTextBuffer();
+
+    const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    const auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+    const auto width = textBuffer.GetSize().Width();
+
+    for (til::CoordType y = 0; y < 5; ++y)
+    {
+        auto view = textBuffer.GetRowByOffset(y).CreateRenderView();
+        VERIFY_ARE_EQUAL(width, view.ColumnCount());
+
+        // Start at every column, including trailing halves, like the renderer does for dirty regions.
+        for (til::CoordType x = 0; x < width; ++x)
+        {
+            auto it = textBuffer.GetCellLineDataAt({ x, y });
+            for (auto col = x; col < width; ++col, ++it)
+            {
+                VERIFY_IS_TRUE(it);
+                til::CoordType glyphEnd = 0;
+                VERIFY_ARE_EQUAL(it->Chars(), view.GlyphAt(col, glyphEnd));
+                VERIFY_ARE_EQUAL(it->TextAttr(), view.AttrAt(col));
+                VERIFY_ARE_EQUAL(it->DbcsAttr() == DbcsAttribute::Trailing, view.IsTrailer(col));
+                VERIFY_ARE_EQUAL(col + (it->DbcsAttr() == DbcsAttribute::Leading ? 2 : 1), glyphEnd);
+            }
+        }
+    }
+}
@@ -12,6 +12,7 @@
 
 #include "globals.h"
 #include "../buffer/out/textBuffer.hpp"
+#include "../types/inc/GlyphWidth.hpp"
 
 #include "input.h"
 #include "_stream.h"
@@ -141,6 +142,10 @@ class TextBufferTests
 
     TEST_METHOD(ResizeTraditionalRotationPreservesHighUnicode);
     TEST_METHOD(ScrollBufferRotationPreservesHighUnicode);
+    TEST_METHOD(ScrollRowsRotatesRows);
+    TEST_METHOD(ColdScrollbackPreservesRows);
+    TEST_METHOD(InternsAttributes);
+    TEST_METHOD(ColdScrollbackPinsRows);
 
     TEST_METHOD(ResizeTraditionalHighUnicodeRowRemoval);
     TEST_METHOD(ResizeTraditionalHighUnicodeColumnRemoval);
@@ -148,6 +153,7 @@ class TextBufferTests
     TEST_METHOD(TestBurrito);
     TEST_METHOD(TestOverwriteChars);
     TEST_METHOD(TestRowReplaceText);
+    TEST_METHOD(TestRowReplaceTextKnownNarrow);
 
     TEST_METHOD(TestAppendRTFText);
 
@@ -161,6 +167,10 @@ class TextBufferTests
 
     TEST_METHOD(HyperlinkTrim);
     TEST_METHOD(NoHyperlinkTrim);
+
+    TEST_METHOD(FindChangedRows);
+    TEST_METHOD(CommitReadAheadAndDecommit);
+    TEST_METHOD(DecommitBlankColdRows);
 };
 
 void TextBufferTests::TestBufferCreate()
@@ -1866,6 +1876,330 @@ void TextBufferTests::ScrollBufferRotationPreservesHighUnicode()
     VERIFY_ARE_EQUAL(String(fire), String(shouldBeFireText.data(), gsl::narrow<int>(shouldBeFireText.size())));
 }
 
+// ScrollRows() moves rows by rotating the row storage. The rows that are scrolled
+// over end up in the space that was vacated by the scrolled rows.
+void TextBufferTests::ScrollRowsRotatesRows()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"Data:circularOffset", L"{0, 3, 8}")
+    END_TEST_METHOD_PROPERTIES();
+
+    int circularOffset;
+    VERIFY_SUCCEEDED(TestData::TryGetValue(L"circularOffset", circularOffset));
+
+    const til::size bufferSize{ 4, 10 };
+    const TextAttribute attr{ 0x7f };
+    TextBuffer buffer{ bufferSize, attr, 12, false, _renderer };
+
+    // Ensure that the rotations below wrap around the end of the circular buffer.
+    for (auto i = 0; i < circularOffset; ++i)
+    {
+        buffer.IncrementCircularBuffer();
+    }
+
+    const auto reset = [&]() {
+        for (til::CoordType y = 0; y < bufferSize.height; ++y)
+        {
+            const auto ch = gsl::narrow_cast<wchar_t>(L'0' + y);
+            buffer.GetMutableRowByOffset(y).ReplaceCharacters(0, 1, { &ch, 1 });
+        }
+    };
+    const auto verify = [&](std::wstring_view expected) {
+        std::wstring actual;
+        for (til::CoordType y = 0; y < bufferSize.height; ++y)
+        {
+            actual.push_back(buffer.GetRowByOffset(y).GlyphAt(0).front());
+        }
+        VERIFY_ARE_EQUAL(expected, actual);
+    };
+
+    Log::Comment(L"Scroll rows 5-7 up by 2");
+    reset();
+    buffer.ScrollRows(5, 3, -2);
+    verify(L"0125673489");
+
+    Log::Comment(L"Scroll rows 5-7 down by 2");
+    reset();
+    buffer.ScrollRows(5, 3, 2);
+    verify(L"0123489567");
+
+    Log::Comment(L"Scroll rows 2-3 down by 5, which doesn't overlap");
+    reset();
+    buffer.ScrollRows(2, 2, 5);
+    verify(L"0145678239");
+
+    Log::Comment(L"Scroll the entire buffer up by 1");
+    reset();
+    buffer.ScrollRows(1, 9, -1);
+    verify(L"1234567890");
+}
+
+void TextBufferTests::ColdScrollbackPreservesRows()
+{
+    const til::size bufferSize{ 16, 40 };
+    const TextAttribute attr{ 0x7f };
+    TextBuffer buffer{ bufferSize, attr, 12, false, _renderer };
+    buffer.SetColdScrollbackDistance(5);
+
+    // Rows with a mix of everything ROW::Pack() needs to preserve: Wide glyphs, surrogate pairs,
+    // combining marks, attributes, line renditions, as well as wrapped and trailing whitespace.
+    static constexpr std::wstring_view texts[]{
+        L"row",
+        L"\u732B\u732B \u732B",
+        L"\U0001F600e\u0301 x ",
+        L"",
+    };
+    for (til::CoordType y = 0; y < bufferSize.height; ++y)
+    {
+        auto& row = buffer.GetMutableRowByOffset(y);
+        RowWriteState state{ .text = til::at(texts, y % 4), .columnBegin = y % 3 };
+        row.ReplaceText(state);
+        row.ReplaceAttributes(y % 5, y % 5 + 3, TextAttribute{ gsl::narrow_cast<WORD>(y) });
+        row.SetWrapForced(y % 2 == 0);
+        if (y % 4 == 3)
+        {
+            row.SetLineRendition(LineRendition::DoubleWidth);
+        }
+    }
+
+    struct Snapshot
+    {
+        std::wstring text;
+        std::vector<TextAttribute> attributes;
+        std::vector<DbcsAttribute> dbcs;
+        bool wrapForced;
+        LineRendition lineRendition;
+    };
+    const auto snapshot = [&](til::CoordType y) {
+        const auto& row = buffer.GetRowByOffset(y);
+        Snapshot s{ std::wstring{ row.GetText() }, {}, {}, row.WasWrapForced(), row.GetLineRendition() };
+        for (til::CoordType x = 0; x < bufferSize.width; ++x)
+        {
+            s.attributes.emplace_back(row.GetAttrByColumn(x));
+            s.dbcs.emplace_back(row.DbcsAttrAt(x));
+        }
+        return s;
+    };
+    const auto verify = [&](til::CoordType y, const Snapshot& expected) {
+        const auto actual = snapshot(y);
+        VERIFY_ARE_EQUAL(expected.text, actual.text);
+        VERIFY_IS_TRUE(expected.attributes == actual.attributes);
+        VERIFY_IS_TRUE(expected.dbcs == actual.dbcs);
+        VERIFY_ARE_EQUAL(expected.wrapForced, actual.wrapForced);
+        VERIFY_IS_TRUE(expected.lineRendition == actual.lineRendition);
+    };
+
+    std::vector<Snapshot> expected;
+    for (til::CoordType y = 0; y < bufferSize.height; ++y)
+    {
+        expected.emplace_back(snapshot(y));
+    }
+
+    Log::Comment(L"Pack all rows that are more than 5 rows above the cursor");
+    buffer.GetCursor().SetPosition({ 0, 39 });
+    buffer.CompactScrollback();
+    for (til::CoordType y = 0; y < bufferSize.height; ++y)
+    {
+        verify(y, til::at(expected, y));
+    }
+
+    Log::Comment(L"Writing to a cold row moves it back into the arena");
+    buffer.GetMutableRowByOffset(3).ReplaceCharacters(0, 1, L"X");
+    til::at(expected, 3) = snapshot(3);
+    VERIFY_ARE_EQUAL(L'X', til::at(expected, 3).text.front());
+    buffer.CompactScrollback();
+    verify(3, til::at(expected, 3));
+
+    Log::Comment(L"Cold rows survive scrolling the circular buffer");
+    buffer.IncrementCircularBuffer();
+    buffer.IncrementCircularBuffer();
+    buffer.CompactScrollback();
+    for (til::CoordType y = 0; y < bufferSize.height - 2; ++y)
+    {
+        verify(y, til::at(expected, y + 2));
+    }
+
+    Log::Comment(L"Cold rows survive being rotated by ScrollRows()");
+    buffer.ScrollRows(1, 4, -1);
+    verify(0, til::at(expected, 3));
+    verify(3, til::at(expected, 6));
+    verify(4, til::at(expected, 2));
+    verify(5, til::at(expected, 7));
+}
+
+void TextBufferTests::InternsAttributes()
+{
+    const til::size bufferSize{ 16, 40 };
+    const TextAttribute attr{ 0x7f };
+    TextBuffer buffer{ bufferSize, attr, 12, false, _renderer };
+    buffer.SetColdScrollbackDistance(5);
+
+    const auto rowAttr = [](til::CoordType y) {
+        TextAttribute a{ 0x7f };
+        a.SetForeground(RGB(y, 0, 0));
+        return a;
+    };
+    for (til::CoordType y = 0; y < bufferSize.height; ++y)
+    {
+        buffer.GetMutableRowByOffset(y).ReplaceAttributes(0, 8, rowAttr(y));
+    }
+
+    Log::Comment(L"Rows share the ID of the default attributes and each hold one unique ID");
+    VERIFY_ARE_EQUAL(size_t{ 41 }, buffer.GetAttributeCount());
+    VERIFY_ARE_EQUAL(buffer.GetRowByOffset(0).AttributeIds().runs().back().value, buffer.GetRowByOffset(1).AttributeIds().runs().back().value);
+
+    Log::Comment(L"Adjacent runs with the same attributes get merged");
+    buffer.GetMutableRowByOffset(39).ReplaceAttributes(8, 16, rowAttr(39));
+    VERIFY_ARE_EQUAL(size_t{ 1 }, buffer.GetRowByOffset(39).AttributeIds().runs().size());
+
+    Log::Comment(L"Packed rows keep their IDs");
+    buffer.GetCursor().SetPosition({ 0, 39 });
+    buffer.CompactScrollback();
+    VERIFY_ARE_EQUAL(size_t{ 41 }, buffer.GetAttributeCount());
+    for (til::CoordType y = 0; y < bufferSize.height - 1; ++y)
+    {
+        const auto& row = buffer.GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(rowAttr(y), row.GetAttrByColumn(7));
+        VERIFY_ARE_EQUAL(attr, row.GetAttrByColumn(8));
+    }
+
+    Log::Comment(L"Overwriting the attributes of a cold row releases its IDs");
+    buffer.GetMutableRowByOffset(1).ReplaceAttributes(0, 8, rowAttr(2));
+    VERIFY_ARE_EQUAL(size_t{ 40 }, buffer.GetAttributeCount());
+    VERIFY_ARE_EQUAL(buffer.GetRowByOffset(1).AttributeIds().runs().front().value, buffer.GetRowByOffset(2).AttributeIds().runs().front().value);
+
+    Log::Comment(L"Rows rotated out of the buffer release their IDs");
+    buffer.IncrementCircularBuffer(attr);
+    VERIFY_ARE_EQUAL(size_t{ 39 }, buffer.GetAttributeCount());
+    VERIFY_ARE_EQUAL(rowAttr(2), buffer.GetRowByOffset(0).GetAttrByColumn(0));
+
+    Log::Comment(L"Buffers created by Reflow() share the table");
+    TextBuffer newBuffer{ { 20, 40 }, attr, 0, false, _renderer };
+    TextBuffer::Reflow(buffer, newBuffer);
+    VERIFY_ARE_EQUAL(rowAttr(2), newBuffer.GetRowByOffset(0).GetAttrByColumn(0));
+    VERIFY_ARE_EQUAL(attr, newBuffer.GetRowByOffset(0).GetAttrByColumn(19));
+    VERIFY_ARE_EQUAL(buffer.GetAttributeCount(), newBuffer.GetAttributeCount());
+
+    const auto fillTable = [](TextAttributeTable& table) {
+        std::vector<uint16_t> ids;
+        for (uint32_t i = 0;; ++i)
+        {
+            TextAttribute a;
+            a.SetForeground(RGB(i & 0xff, i >> 8, 1));
+            const auto id = table.Intern(a);
+            if (id == TextAttributeTable::InvalidId)
+            {
+                return ids;
+            }
+            ids.emplace_back(id);
+        }
+    };
+
+    Log::Comment(L"A full table collects unreferenced IDs and fails otherwise, except for fill attributes");
+    TextAttributeTable table;
+    auto ids = fillTable(table);
+    VERIFY_IS_GREATER_THAN(ids.size(), size_t{ UINT16_MAX - 1 - 256 });
+    VERIFY_ARE_EQUAL(TextAttributeTable::InvalidId, table.Intern(rowAttr(0)));
+    const auto fillId = table.InternFill(rowAttr(0));
+    VERIFY_ARE_NOT_EQUAL(TextAttributeTable::FallbackId, fillId);
+    VERIFY_ARE_EQUAL(rowAttr(0), table.Get(fillId));
+    table.Release(fillId);
+
+    table.Release(ids.back());
+    const auto id = table.Intern(rowAttr(1));
+    VERIFY_ARE_NOT_EQUAL(TextAttributeTable::InvalidId, id);
+    VERIFY_ARE_EQUAL(rowAttr(1), table.Get(id));
+    VERIFY_ARE_EQUAL(ids.size(), table.Size());
+
+    Log::Comment(L"Rows store their attributes themselves while the table is full");
+    TextBuffer full{ { 16, 10 }, attr, 12, false, _renderer };
+    full.SetColdScrollbackDistance(2);
+    ids = fillTable(*full._attributes);
+    auto& row = full.GetMutableRowByOffset(1);
+    row.ReplaceAttributes(0, 4, rowAttr(1));
+    row.ReplaceAttributes(4, 8, rowAttr(2));
+    VERIFY_IS_TRUE(row.HasLocalAttributes());
+    VERIFY_ARE_EQUAL(rowAttr(1), row.GetAttrByColumn(3));
+    VERIFY_ARE_EQUAL(rowAttr(2), row.GetAttrByColumn(4));
+    VERIFY_ARE_EQUAL(attr, row.GetAttrByColumn(8));
+
+    Log::Comment(L"...including when they get copied and packed");
+    full.GetMutableRowByOffset(2).CopyFrom(full.GetRowByOffset(1));
+    full.GetCursor().SetPosition({ 0, 9 });
+    full.CompactScrollback();
+    for (til::CoordType y = 1; y <= 2; ++y)
+    {
+        const auto& copy = full.GetRowByOffset(y);
+        VERIFY_IS_TRUE(copy.HasLocalAttributes());
+        VERIFY_ARE_EQUAL(rowAttr(1), copy.GetAttrByColumn(0));
+        VERIFY_ARE_EQUAL(rowAttr(2), copy.GetAttrByColumn(7));
+        VERIFY_ARE_EQUAL(attr, copy.GetAttrByColumn(15));
+    }
+
+    Log::Comment(L"Once there's space in the table again, resetting a row interns its attributes again");
+    for (const auto i : ids)
+    {
+        full._attributes->Release(i);
+    }
+    full.GetMutableRowByOffset(1).Reset(rowAttr(3));
+    VERIFY_IS_FALSE(full.GetRowByOffset(1).HasLocalAttributes());
+    VERIFY_ARE_EQUAL(rowAttr(3), full.GetRowByOffset(1).GetAttrByColumn(0));
+}
+
+void TextBufferTests::ColdScrollbackPinsRows()
+{
+    const til::size bufferSize{ 16, 600 };
+    const TextAttribute attr{ 0x7f };
+    TextBuffer buffer{ bufferSize, attr, 12, false, _renderer };
+    buffer.SetColdScrollbackDistance(5);
+
+    const auto label = [](til::CoordType y) {
+        auto text = std::to_wstring(y);
+        text.insert(0, 8 - text.size(), L'0');
+        return text;
+    };
+    const auto rowLabel = [&](til::CoordType y) {
+        return std::wstring{ buffer.GetRowByOffset(y).GetText().substr(0, 8) };
+    };
+
+    for (til::CoordType y = 0; y < bufferSize.height; ++y)
+    {
+        const auto text = label(y);
+        RowWriteState state{ .text = text };
+        buffer.GetMutableRowByOffset(y).ReplaceText(state);
+    }
+    buffer.GetCursor().SetPosition({ 0, bufferSize.height - 1 });
+    buffer.CompactScrollback();
+
+    Log::Comment(L"A pinned cold row survives reading more rows than the thaw pool holds");
+    const auto& first = buffer.GetRowByOffset(0);
+    const auto& second = buffer.GetRowByOffset(1);
+    {
+        const TextBuffer::RowPin firstPin{ buffer, 0 };
+        const TextBuffer::RowPin secondPin{ buffer, 1 };
+        for (til::CoordType y = 2; y < 500; ++y)
+        {
+            VERIFY_ARE_EQUAL(label(y), rowLabel(y));
+        }
+        VERIFY_ARE_EQUAL(label(0), std::wstring{ first.GetText().substr(0, 8) });
+        VERIFY_ARE_EQUAL(label(1), std::wstring{ second.GetText().substr(0, 8) });
+    }
+
+    Log::Comment(L"Once unpinned, the rows are ordinary thaw pool entries again");
+    for (til::CoordType y = 0; y < 500; ++y)
+    {
+        VERIFY_ARE_EQUAL(label(y), rowLabel(y));
+    }
+
+    Log::Comment(L"Pins of a flushed thaw pool are harmless");
+    {
+        const TextBuffer::RowPin pin{ buffer, 0 };
+        buffer.ScrollRows(1, 1, -1);
+    }
+    VERIFY_ARE_EQUAL(label(1), rowLabel(0));
+    VERIFY_ARE_EQUAL(label(0), rowLabel(1));
+}
+
 // This tests that rows removed from the buffer while resizing traditionally will also drop the high unicode
 // characters from the Unicode Storage buffer
 void TextBufferTests::ResizeTraditionalHighUnicodeRowRemoval()
@@ -2084,6 +2418,51 @@ void TextBufferTests::TestRowReplaceText()
 #undef complex
 }
 
+// ROW::ReplaceText writes runs of characters that are known to be narrow in bulk, without asking
+// CodepointWidthDetector. This test ensures that its idea of "known narrow" agrees with IsGlyphFullWidth()
+// for every code unit in the BMP, including at the boundaries of the vectorized loops.
+void TextBufferTests::TestRowReplaceTextKnownNarrow()
+{
+    static constexpr til::size bufferSize{ 128, 3 };
+    static constexpr UINT cursorSize = 12;
+    static constexpr size_t chunkSize = 61;
+    const TextAttribute attr{ 0x7f };
+    TextBuffer buffer{ bufferSize, attr, cursorSize, false, _renderer };
+    auto& row = buffer.GetMutableRowByOffset(0);
+
+    std::wstring text;
+    text.reserve(chunkSize);
+
+    for (size_t beg = 0x80; beg < 0x10000; beg += chunkSize)
+    {
+        text.clear();
+        for (auto wch = beg; wch < std::min<size_t>(beg + chunkSize, 0x10000); ++wch)
+        {
+            // Lone surrogates are replaced with U+FFFD, which would make the comparison below tedious.
+            text.push_back(til::is_surrogate(static_cast<wchar_t>(wch)) ? L'a' : static_cast<wchar_t>(wch));
+        }
+
+        row.Reset(attr);
+        RowWriteState state{
+            .text = text,
+            .columnBegin = 0,
+            .columnLimit = til::CoordTypeMax,
+        };
+        row.ReplaceText(state);
+        VERIFY_ARE_EQUAL(L"", state.text);
+
+        til::CoordType column = 0;
+        for (const auto& wch : text)
+        {
+            const auto wide = IsGlyphFullWidth(wch);
+            VERIFY_ARE_EQUAL(std::wstring_view{ &wch, 1 }, row.GlyphAt(column));
+            VERIFY_ARE_EQUAL(wide ? DbcsAttribute::Leading : DbcsAttribute::Single, row.DbcsAttrAt(column), NoThrowString().Format(L"U+%04X", wch));
+            column += wide ? 2 : 1;
+        }
+        VERIFY_ARE_EQUAL(column, state.columnEnd);
+    }
+}
+
 void TextBufferTests::TestAppendRTFText()
 {
     {
@@ -2775,3 +3154,132 @@ void TextBufferTests::NoHyperlinkTrim()
     VERIFY_ARE_EQUAL(_buffer->GetHyperlinkUriFromId(id), url);
     VERIFY_ARE_EQUAL(_buffer->_hyperlinkCustomIdMap[finalCustomId], id);
 }
+
+void TextBufferTests::FindChangedRows()
+{
+    // The height spans multiple blocks of _rowGenerationBlocks and isn't a multiple of their size.
+    static constexpr til::CoordType height = 200;
+    TextBuffer buffer{ { 10, height }, TextAttribute{ 0x7 }, 12, false, _renderer };
+
+    // Make the circular buffer wrap around in the middle of a block.
+    buffer._SetFirstRowIndex(150);
+
+    const auto generation = buffer.GetLastMutationId();
+    for (const auto y : { 3, 4, 70, 199 })
+    {
+        buffer.GetMutableRowByOffset(y).ReplaceCharacters(0, 1, L"X");
+    }
+
+    VERIFY_ARE_EQUAL(3, buffer.FindChangedRow(generation, 0, height));
+    VERIFY_ARE_EQUAL(5, buffer.FindUnchangedRow(generation, 3, height));
+    VERIFY_ARE_EQUAL(70, buffer.FindChangedRow(generation, 5, height));
+    VERIFY_ARE_EQUAL(71, buffer.FindUnchangedRow(generation, 70, height));
+    VERIFY_ARE_EQUAL(199, buffer.FindChangedRow(generation, 71, height));
+    VERIFY_ARE_EQUAL(199, buffer.FindChangedRow(generation, 71, 199));
+    VERIFY_ARE_EQUAL(height, buffer.FindUnchangedRow(generation, 199, height));
+    VERIFY_ARE_EQUAL(3, buffer.FindChangedRow(generation, -10, height));
+    VERIFY_ARE_EQUAL(height, buffer.FindChangedRow(generation, 0, height + 10));
+
+    // Verify against the plain per-row generations for every range.
+    for (til::CoordType beg = 0; beg < height; beg += 7)
+    {
+        til::CoordType expected = beg;
+        while (expected < height && buffer.GetRowGeneration(expected) <= generation)
+        {
+            ++expected;
+        }
+        VERIFY_ARE_EQUAL(expected, buffer.FindChangedRow(generation, beg, height));
+    }
+
+    VERIFY_ARE_EQUAL(height, buffer.FindChangedRow(buffer.GetLastMutationId(), 0, height));
+}
+
+void TextBufferTests::CommitReadAheadAndDecommit()
+{
+    static constexpr til::CoordType height = 3000;
+    const TextAttribute attr{ 0x7 };
+    TextBuffer buffer{ { 80, height }, attr, 12, false, _renderer };
+
+    // Writing the rows in order should double the read-ahead every time, which results in
+    // commits of 128, 256, 512, 1024 and 2048 rows, instead of 24 commits of 128 rows.
+    for (til::CoordType y = 0; y < height; ++y)
+    {
+        buffer.GetMutableRowByOffset(y).ReplaceCharacters(0, 4, fmt::format(L"{:04}", y));
+    }
+    VERIFY_IS_LESS_THAN_OR_EQUAL(buffer.GetCommitStatistics().commits, size_t{ 6 });
+
+    // Move the last 10 rows to the top, so that they're stored at the end of the arena,
+    // and erase everything else, similar to what ED 3 (Erase Scrollback) does.
+    buffer.ScrollRows(height - 10, 10, -(height - 10));
+    for (til::CoordType y = 10; y < height; ++y)
+    {
+        buffer.GetMutableRowByOffset(y).Reset(attr);
+    }
+
+    VERIFY_IS_GREATER_THAN(buffer.DecommitBlankRows(), size_t{ 0 });
+    VERIFY_IS_GREATER_THAN(buffer.GetCommitStatistics().decommittedBytes, size_t{ 0 });
+    // There's nothing left to decommit.
+    VERIFY_ARE_EQUAL(size_t{ 0 }, buffer.DecommitBlankRows());
+
+    for (til::CoordType y = 0; y < 10; ++y)
+    {
+        const auto expected = fmt::format(L"{:04}", height - 10 + y);
+        VERIFY_ARE_EQUAL(std::wstring_view{ expected }, buffer.GetRowByOffset(y).GetText().substr(0, 4));
+    }
+    for (til::CoordType y = 10; y < height; y += 97)
+    {
+        VERIFY_IS_FALSE(buffer.GetRowByOffset(y).ContainsText());
+    }
+
+    // The decommitted rows can be used again.
+    buffer.GetMutableRowByOffset(height - 1).ReplaceCharacters(0, 1, L"X");
+    VERIFY_ARE_EQUAL(L"X", buffer.GetRowByOffset(height - 1).GetText().substr(0, 1));
+    VERIFY_ARE_EQUAL(L"2990", buffer.GetRowByOffset(0).GetText().substr(0, 4));
+}
+
+void TextBufferTests::DecommitBlankColdRows()
+{
+    static constexpr til::CoordType height = 3000;
+    const TextAttribute attr{ 0x7 };
+    TextBuffer buffer{ { 80, height }, attr, 12, false, _renderer };
+    buffer.SetColdScrollbackDistance(100);
+
+    // The rows [1000, 2000) are left blank, but get packed regardless.
+    for (til::CoordType y = 0; y < height; ++y)
+    {
+        auto& row = buffer.GetMutableRowByOffset(y);
+        if (y < 1000 || y >= 2000)
+        {
+            row.ReplaceCharacters(0, 4, fmt::format(L"{:04}", y));
+        }
+    }
+    buffer.GetCursor().SetYPosition(height - 1);
+    buffer.CompactScrollback();
+
+    // Erasing the rows [2000, height) moves them back into the arena.
+    for (til::CoordType y = 2000; y < height; ++y)
+    {
+        buffer.GetMutableRowByOffset(y).Reset(attr);
+    }
+
+    VERIFY_IS_GREATER_THAN(buffer.DecommitBlankRows(), size_t{ 0 });
+    // There's nothing left to decommit.
+    VERIFY_ARE_EQUAL(size_t{ 0 }, buffer.DecommitBlankRows());
+
+    for (til::CoordType y = 0; y < 1000; ++y)
+    {
+        const auto expected = fmt::format(L"{:04}", y);
+        VERIFY_ARE_EQUAL(std::wstring_view{ expected }, buffer.GetRowByOffset(y).GetText().substr(0, 4));
+    }
+    for (til::CoordType y = 1000; y < height; y += 97)
+    {
+        VERIFY_IS_FALSE(buffer.GetRowByOffset(y).ContainsText());
+    }
+
+    // The decommitted rows can be used again.
+    buffer.GetMutableRowByOffset(height - 1).ReplaceCharacters(0, 1, L"X");
+    buffer.GetMutableRowByOffset(1500).ReplaceCharacters(0, 1, L"Y");
+    VERIFY_ARE_EQUAL(L"X", buffer.GetRowByOffset(height - 1).GetText().substr(0, 1));
+    VERIFY_ARE_EQUAL(L"Y", buffer.GetRowByOffset(1500).GetText().substr(0, 1));
+    VERIFY_ARE_EQUAL(L"0999", buffer.GetRowByOffset(999).GetText().substr(0, 4));
+}
@@ -388,7 +388,7 @@ public:
         return {};
     }
 
-    const std::vector<size_t> GetPatternId(const til::point /*location*/) const
+    std::span<const Microsoft::Console::Render::PatternSpan> GetPatternSpans(const til::CoordType /*viewportRow*/) const noexcept
     {
         return {};
     }
@@ -73,6 +73,8 @@ class Microsoft::Console::Render::VtRendererTest
     TEST_METHOD(Xterm256TestExtendedAttributes);
     TEST_METHOD(Xterm256TestAttributesAcrossReset);
     TEST_METHOD(Xterm256TestDoublyUnderlinedResetBeforeSettingStyle);
+    TEST_METHOD(Xterm256TestCombinedGraphicsRenditions);
+    TEST_METHOD(Xterm256TestCombinedGraphicsRenditionsEquivalence);
 
     TEST_METHOD(XtermTestInvalidate);
     TEST_METHOD(XtermTestColors);
@@ -83,6 +85,8 @@ class Microsoft::Console::Render::VtRendererTest
 
     TEST_METHOD(TestWrapping);
 
+    TEST_METHOD(TestShadowFrame);
+
     TEST_METHOD(TestResize);
 
     TEST_METHOD(TestCursorVisibility);
@@ -1051,6 +1055,299 @@ void VtRendererTest::Xterm256TestDoublyUnderlinedResetBeforeSettingStyle()
     VerifyExpectedInputsDrained();
 }
 
+// Applies the SGR sequences in the given output to the given attributes, the
+// way a terminal would, for the parameters that the Xterm256Engine emits.
+static void ApplyGraphicsRenditions(const std::string_view output, TextAttribute& attributes)
+{
+    const auto split = [](const std::string_view str, const char delimiter) {
+        std::vector<std::string_view> parts;
+        size_t begin = 0;
+        for (auto end = str.find(delimiter); end != std::string_view::npos; end = str.find(delimiter, begin))
+        {
+            parts.emplace_back(str.substr(begin, end - begin));
+            begin = end + 1;
+        }
+        parts.emplace_back(str.substr(begin));
+        return parts;
+    };
+
+    for (auto pos = output.find("\x1b["); pos != std::string_view::npos; pos = output.find("\x1b[", pos))
+    {
+        const auto end = output.find('m', pos);
+        VERIFY_ARE_NOT_EQUAL(std::string_view::npos, end);
+
+        std::vector<std::vector<int>> params;
+        for (const auto param : split(output.substr(pos + 2, end - pos - 2), ';'))
+        {
+            auto& subParams = params.emplace_back();
+            for (const auto subParam : split(param, ':'))
+            {
+                subParams.push_back(subParam.empty() ? 0 : std::stoi(std::string{ subParam }));
+            }
+        }
+        pos = end + 1;
+
+        const auto color = [&](size_t& i) {
+            const auto type = til::at(params, i + 1).front();
+            if (type == 5)
+            {
+                const auto index = til::at(params, i + 2).front();
+                i += 2;
+                return TextColor{ gsl::narrow_cast<BYTE>(index), true };
+            }
+            const auto rgb = RGB(til::at(params, i + 2).front(), til::at(params, i + 3).front(), til::at(params, i + 4).front());
+            i += 4;
+            return TextColor{ rgb };
+        };
+
+        for (size_t i = 0; i < params.size(); ++i)
+        {
+            const auto& subParams = til::at(params, i);
+            const auto value = subParams.front();
+            switch (value)
+            {
+            case 0:
+                attributes.SetDefaultForeground();
+                attributes.SetDefaultBackground();
+                attributes.SetDefaultUnderlineColor();
+                attributes.SetDefaultRenditionAttributes();
+                break;
+            case 1:
+                attributes.SetIntense(true);
+                break;
+            case 2:
+                attributes.SetFaint(true);
+                break;
+            case 3:
+                attributes.SetItalic(true);
+                break;
+            case 4:
+                attributes.SetUnderlineStyle(subParams.size() > 1 ? static_cast<UnderlineStyle>(subParams.at(1)) : UnderlineStyle::SinglyUnderlined);
+                break;
+            case 5:
+                attributes.SetBlinking(true);
+                break;
+            case 7:
+                attributes.SetReverseVideo(true);
+                break;
+            case 8:
+                attributes.SetInvisible(true);
+                break;
+            case 9:
+                attributes.SetCrossedOut(true);
+                break;
+            case 21:
+                attributes.SetUnderlineStyle(UnderlineStyle::DoublyUnderlined);
+                break;
+            case 22:
+                attributes.SetIntense(false);
+                attributes.SetFaint(false);
+                break;
+            case 23:
+                attributes.SetItalic(false);
+                break;
+            case 24:
+                attributes.SetUnderlineStyle(UnderlineStyle::NoUnderline);
+                break;
+            case 25:
+                attributes.SetBlinking(false);
+                break;
+            case 27:
+                attributes.SetReverseVideo(false);
+                break;
+            case 28:
+                attributes.SetInvisible(false);
+                break;
+            case 29:
+                attributes.SetCrossedOut(false);
+                break;
+            case 38:
+                attributes.SetForeground(color(i));
+                break;
+            case 39:
+                attributes.SetDefaultForeground();
+                break;
+            case 48:
+                attributes.SetBackground(color(i));
+                break;
+            case 49:
+                attributes.SetDefaultBackground();
+                break;
+            case 53:
+                attributes.SetOverlined(true);
+                break;
+            case 55:
+                attributes.SetOverlined(false);
+                break;
+            case 58:
+                attributes.SetUnderlineColor(subParams.at(1) == 5 ?
+                                                 TextColor{ gsl::narrow_cast<BYTE>(subParams.at(2)), true } :
+                                                 TextColor{ RGB(subParams.at(3), subParams.at(4), subParams.at(5)) });
+                break;
+            case 59:
+                attributes.SetDefaultUnderlineColor();
+                break;
+            default:
+                if (value >= 30 && value <= 37)
+                {
+                    attributes.SetIndexedForeground(gsl::narrow_cast<BYTE>(value - 30));
+                }
+                else if (value >= 40 && value <= 47)
+                {
+                    attributes.SetIndexedBackground(gsl::narrow_cast<BYTE>(value - 40));
+                }
+                else if (value >= 90 && value <= 97)
+                {
+                    attributes.SetIndexedForeground(gsl::narrow_cast<BYTE>(value - 90 + 8));
+                }
+                else if (value >= 100 && value <= 107)
+                {
+                    attributes.SetIndexedBackground(gsl::narrow_cast<BYTE>(value - 100 + 8));
+                }
+                else
+                {
+                    VERIFY_FAIL(NoThrowString().Format(L"Unexpected SGR parameter %d", value));
+                }
+                break;
+            }
+        }
+    }
+}
+
+void VtRendererTest::Xterm256TestCombinedGraphicsRenditions()
+{
+    auto hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+    auto engine = std::make_unique<Xterm256Engine>(std::move(hFile), SetUpViewport());
+    auto pfn = std::bind(&VtRendererTest::WriteCallback, this, std::placeholders::_1, std::placeholders::_2);
+    engine->SetTestCallback(pfn);
+    engine->SetCombineGraphicsRenditions(true);
+    RenderSettings renderSettings;
+    RenderData renderData;
+
+    Log::Comment(L"----Start With All Attributes Reset----");
+    TextAttribute textAttributes = {};
+    qExpectedInput.push_back("\x1b[m");
+    VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(textAttributes, renderSettings, &renderData, false, false));
+
+    Log::Comment(L"----Set Red, Intense and Italic in one sequence----");
+    textAttributes.SetIndexedForeground(TextColor::DARK_RED);
+    textAttributes.SetIntense(true);
+    textAttributes.SetItalic(true);
+    qExpectedInput.push_back("\x1b[31;1;3m");
+    VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(textAttributes, renderSettings, &renderData, false, false));
+
+    Log::Comment(L"----Set an RGB Background and remove Intense incrementally----");
+    textAttributes.SetBackground(RGB(1, 2, 3));
+    textAttributes.SetIntense(false);
+    qExpectedInput.push_back("\x1b[48;2;1;2;3;22m");
+    VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(textAttributes, renderSettings, &renderData, false, false));
+
+    Log::Comment(L"----Reset the Colors and set Curly Underline, which is shorter with a reset----");
+    textAttributes.SetDefaultForeground();
+    textAttributes.SetDefaultBackground();
+    textAttributes.SetUnderlineStyle(UnderlineStyle::CurlyUnderlined);
+    qExpectedInput.push_back("\x1b[0;3;4:3m");
+    VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(textAttributes, renderSettings, &renderData, false, false));
+
+    Log::Comment(L"----Nothing changed, so nothing should be emitted----");
+    VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(textAttributes, renderSettings, &renderData, false, false));
+
+    VerifyExpectedInputsDrained();
+}
+
+void VtRendererTest::Xterm256TestCombinedGraphicsRenditionsEquivalence()
+{
+    TextAttribute red;
+    red.SetIndexedForeground(TextColor::DARK_RED);
+
+    TextAttribute indexed;
+    indexed.SetIndexedForeground(TextColor::BRIGHT_BLUE);
+    indexed.SetIndexedBackground256(200);
+
+    TextAttribute rgb;
+    rgb.SetForeground(RGB(255, 128, 0));
+    rgb.SetBackground(RGB(0, 0, 64));
+    rgb.SetIntense(true);
+    rgb.SetUnderlineStyle(UnderlineStyle::CurlyUnderlined);
+    rgb.SetUnderlineColor(TextColor{ RGB(12, 34, 56) });
+
+    TextAttribute faint;
+    faint.SetIndexedBackground(TextColor::DARK_GREEN);
+    faint.SetFaint(true);
+    faint.SetItalic(true);
+    faint.SetUnderlineStyle(UnderlineStyle::DoublyUnderlined);
+    faint.SetUnderlineColor(TextColor{ 100, true });
+
+    TextAttribute everything;
+    everything.SetIntense(true);
+    everything.SetFaint(true);
+    everything.SetBlinking(true);
+    everything.SetInvisible(true);
+    everything.SetCrossedOut(true);
+    everything.SetReverseVideo(true);
+    everything.SetOverlined(true);
+
+    TextAttribute underlined;
+    underlined.SetIntense(true);
+    underlined.SetUnderlineStyle(UnderlineStyle::SinglyUnderlined);
+
+    TextAttribute reversed;
+    reversed.SetBackground(RGB(1, 2, 3));
+    reversed.SetReverseVideo(true);
+    reversed.SetUnderlineStyle(UnderlineStyle::DottedUnderlined);
+
+    const std::array samples{ TextAttribute{}, red, indexed, rgb, faint, everything, underlined, reversed };
+
+    RenderSettings renderSettings;
+    RenderData renderData;
+    std::string output;
+
+    // Paints `from` and then `to` with a new engine and returns the attributes the
+    // terminal ends up with, as well as the length of the output for `to` alone.
+    const auto paint = [&](const bool combine, const TextAttribute& from, const TextAttribute& to) {
+        auto hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+        auto engine = std::make_unique<Xterm256Engine>(std::move(hFile), SetUpViewport());
+        engine->SetTestCallback([&](const char* const pch, const size_t cch) {
+            output.append(pch, cch);
+            return true;
+        });
+        engine->SetCombineGraphicsRenditions(combine);
+
+        TextAttribute terminal;
+        output.clear();
+        VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(from, renderSettings, &renderData, false, false));
+        ApplyGraphicsRenditions(output, terminal);
+        VERIFY_ARE_EQUAL(from, terminal);
+
+        output.clear();
+        VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(to, renderSettings, &renderData, false, false));
+        ApplyGraphicsRenditions(output, terminal);
+        return std::pair{ terminal, output.size() };
+    };
+
+    size_t separateLength = 0;
+    size_t combinedLength = 0;
+
+    for (const auto& from : samples)
+    {
+        for (const auto& to : samples)
+        {
+            const auto [separateAttributes, separate] = paint(false, from, to);
+            const auto [combinedAttributes, combined] = paint(true, from, to);
+
+            VERIFY_ARE_EQUAL(to, separateAttributes);
+            VERIFY_ARE_EQUAL(to, combinedAttributes);
+            VERIFY_IS_LESS_THAN_OR_EQUAL(combined, separate);
+
+            separateLength += separate;
+            combinedLength += combined;
+        }
+    }
+
+    Log::Comment(NoThrowString().Format(L"Separate sequences: %zu bytes, combined sequences: %zu bytes", separateLength, combinedLength));
+    VERIFY_IS_LESS_THAN(combinedLength, separateLength);
+}
+
 void VtRendererTest::XtermTestInvalidate()
 {
     auto hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
@@ -1588,6 +1885,86 @@ void VtRendererTest::TestWrapping()
     });
 }
 
+void VtRendererTest::TestShadowFrame()
+{
+    auto hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+    auto engine = std::make_unique<Xterm256Engine>(std::move(hFile), SetUpViewport());
+    auto pfn = std::bind(&VtRendererTest::WriteCallback, this, std::placeholders::_1, std::placeholders::_2);
+    engine->SetTestCallback(pfn);
+    engine->SetShadowFrame(true);
+
+    VerifyFirstPaint(*engine);
+
+    std::vector<Cluster> clusters;
+    const auto paintLine = [&](const std::wstring_view line, const til::point coord) {
+        clusters.clear();
+        for (size_t i = 0; i < line.size(); i++)
+        {
+            clusters.emplace_back(line.substr(i, 1), 1);
+        }
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ clusters.data(), clusters.size() }, coord, false, false));
+    };
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(L"The first paint of a line has to emit all of it.");
+        qExpectedInput.push_back("\x1b[2;1H");
+        qExpectedInput.push_back("Hello, World!");
+        paintLine(L"Hello, World!", { 0, 1 });
+    });
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(L"Only the changed character should be emitted, after moving back with a CHA.");
+        qExpectedInput.push_back("\x1b[9G");
+        qExpectedInput.push_back("i");
+        paintLine(L"Hello, Wirld!", { 0, 1 });
+    });
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(L"Changes far apart should be emitted separately, skipping the unchanged text.");
+        qExpectedInput.push_back("\r");
+        qExpectedInput.push_back("J");
+        qExpectedInput.push_back("\x1b[11C");
+        qExpectedInput.push_back("s");
+        paintLine(L"Jello, Wirlds", { 0, 1 });
+    });
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(L"Changes close together should be emitted together, since that's shorter than moving the cursor.");
+        qExpectedInput.push_back("\x1b[2G");
+        qExpectedInput.push_back("xlx");
+        paintLine(L"Jxlxo, Wirlds", { 0, 1 });
+    });
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(L"Painting the same line again shouldn't emit anything.");
+        paintLine(L"Jxlxo, Wirlds", { 0, 1 });
+    });
+
+    Log::Comment(L"Scroll the contents up a line. The shadow frame should follow them.");
+    til::point scrollDelta{ 0, -1 };
+    VERIFY_SUCCEEDED(engine->InvalidateScroll(&scrollDelta));
+
+    TestPaint(*engine, [&]() {
+        qExpectedInput.push_back("\x1b[32;1H");
+        qExpectedInput.push_back("\n");
+        VERIFY_SUCCEEDED(engine->ScrollFrame());
+
+        paintLine(L"Jxlxo, Wirlds", { 0, 0 });
+    });
+
+    Log::Comment(L"Passing through a sequence we don't understand should invalidate the frame.");
+    qExpectedInput.push_back("\x1b[?1049h");
+    VERIFY_SUCCEEDED(engine->WriteTerminalUtf8("\x1b[?1049h"));
+
+    TestPaint(*engine, [&]() {
+        qExpectedInput.push_back("\x1b[H");
+        qExpectedInput.push_back("Jxlxo, Wirlds");
+        paintLine(L"Jxlxo, Wirlds", { 0, 0 });
+    });
+
+    VerifyExpectedInputsDrained();
+}
+
 void VtRendererTest::TestResize()
 {
     auto view = SetUpViewport();
@@ -0,0 +1,324 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <bit>
+
+#pragma warning(push)
+// Functions like front()/back()/operator[]() are explicitly unchecked, just like the std::deque equivalents.
+#pragma warning(disable : 26446) // Prefer to use gsl::at() instead of unchecked subscript operator (bounds.4).
+// The two segments of the ring are copied around using raw pointers into the backing allocation.
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+
+namespace til
+{
+    // A FIFO queue of trivially copyable items, backed by a single power-of-two sized allocation that
+    // grows as needed. Unlike std::deque it doesn't allocate in small blocks and its contents can be
+    // accessed as (at most) two contiguous segments, which makes bulk pushes and pops cheap.
+    // Inserting or erasing items is supported, but is only efficient close to the front.
+    template<typename T>
+    class ring_buffer
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+    public:
+        using value_type = T;
+        using size_type = size_t;
+        using reference = T&;
+        using const_reference = const T&;
+
+        static constexpr size_t initial_capacity = 16;
+
+        ring_buffer() = default;
+
+        ring_buffer(const ring_buffer&) = delete;
+        ring_buffer& operator=(const ring_buffer&) = delete;
+
+        ring_buffer(ring_buffer&& other) noexcept :
+            _data{ std::move(other._data) },
+            _capacity{ std::exchange(other._capacity, 0) },
+            _head{ std::exchange(other._head, 0) },
+            _size{ std::exchange(other._size, 0) }
+        {
+        }
+
+        ring_buffer& operator=(ring_buffer&& other) noexcept
+        {
+            ring_buffer tmp{ std::move(other) };
+            swap(tmp);
+            return *this;
+        }
+
+        void swap(ring_buffer& other) noexcept
+        {
+            std::swap(_data, other._data);
+            std::swap(_capacity, other._capacity);
+            std::swap(_head, other._head);
+            std::swap(_size, other._size);
+        }
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return _size == 0;
+        }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return _size;
+        }
+
+        [[nodiscard]] size_t capacity() const noexcept
+        {
+            return _capacity;
+        }
+
+        [[nodiscard]] static constexpr size_t max_size() noexcept
+        {
+            // The largest power of two a size_t can hold, so that the capacity can always be rounded up to one.
+            return (SIZE_MAX / 2 + 1) / sizeof(T);
+        }
+
+        T& operator[](size_t off) noexcept
+        {
+            return _data[(_head + off) & (_capacity - 1)];
+        }
+
+        const T& operator[](size_t off) const noexcept
+        {
+            return _data[(_head + off) & (_capacity - 1)];
+        }
+
+        T& front() noexcept
+        {
+            return operator[](0);
+        }
+
+        const T& front() const noexcept
+        {
+            return operator[](0);
+        }
+
+        T& back() noexcept
+        {
+            return operator[](_size - 1);
+        }
+
+        const T& back() const noexcept
+        {
+            return operator[](_size - 1);
+        }
+
+        // Returns the contents of the ring buffer as two contiguous segments, in order.
+        // The second segment is empty unless the contents wrap around the end of the allocation.
+        std::array<std::span<T>, 2> segments() noexcept
+        {
+            const auto first = std::min(_size, _capacity - _head);
+            return { { { _data.get() + _head, first }, { _data.get(), _size - first } } };
+        }
+
+        std::array<std::span<const T>, 2> segments() const noexcept
+        {
+            const auto first = std::min(_size, _capacity - _head);
+            return { { { _data.get() + _head, first }, { _data.get(), _size - first } } };
+        }
+
+        void reserve(size_t capacity)
+        {
+            if (capacity > _capacity)
+            {
+                _reallocate(capacity);
+            }
+        }
+
+        // Reduces the capacity to the smallest one that fits the contents.
+        // The allocation is released entirely if the ring buffer is empty.
+        void shrink_to_fit()
+        {
+            if (_size == 0)
+            {
+                _data.reset();
+                _capacity = 0;
+                _head = 0;
+                return;
+            }
+
+            if (std::bit_ceil(std::max(_size, initial_capacity)) < _capacity)
+            {
+                _reallocate(_size);
+            }
+        }
+
+        void clear() noexcept
+        {
+            _head = 0;
+            _size = 0;
+        }
+
+        void push_back(const T& item)
+        {
+            // `item` might refer to our own contents, which _reallocate() would invalidate.
+            const auto copy = item;
+            _reserve_additional(1);
+            operator[](_size) = copy;
+            _size++;
+        }
+
+        // NOTE: `items` must not refer to the contents of the ring buffer itself.
+        void append(std::span<const T> items)
+        {
+            if (items.empty())
+            {
+                return;
+            }
+
+            _reserve_additional(items.size());
+            _write(_size, items);
+            _size += items.size();
+        }
+
+        // Inserts `items` in front of the item at `pos`. The items in front
+        // of `pos` are shifted, so this is cheap only if `pos` is small.
+        // NOTE: `items` must not refer to the contents of the ring buffer itself.
+        void insert(size_t pos, std::span<const T> items)
+        {
+            assert(pos <= _size);
+
+            const auto count = items.size();
+            if (count == 0)
+            {
+                return;
+            }
+
+            _reserve_additional(count);
+            _head = (_head - count) & (_capacity - 1);
+            _size += count;
+
+            for (size_t i = 0; i < pos; ++i)
+            {
+                operator[](i) = operator[](i + count);
+            }
+
+            _write(pos, items);
+        }
+
+        // Removes the item at `pos`. The items in front of `pos`
+        // are shifted, so this is cheap only if `pos` is small.
+        void erase(size_t pos) noexcept
+        {
+            assert(pos < _size);
+
+            for (auto i = pos; i > 0; --i)
+            {
+                operator[](i) = operator[](i - 1);
+            }
+
+            pop_front();
+        }
+
+        // Removes all items for which `pred` returns true, while preserving the order of the others.
+        // Returns the number of removed items.
+        template<typename Predicate>
+        size_t erase_if(Predicate&& pred)
+        {
+            size_t kept = 0;
+
+            for (size_t i = 0; i < _size; ++i)
+            {
+                const auto& item = operator[](i);
+                if (!pred(item))
+                {
+                    if (kept != i)
+                    {
+                        operator[](kept) = item;
+                    }
+                    kept++;
+                }
+            }
+
+            const auto removed = _size - kept;
+            _size = kept;
+            return removed;
+        }
+
+        void pop_front(size_t count = 1) noexcept
+        {
+            count = std::min(count, _size);
+            _size -= count;
+            // Resetting the head when we run empty keeps subsequent bulk operations in a single segment.
+            _head = _size == 0 ? 0 : (_head + count) & (_capacity - 1);
+        }
+
+        // Moves up to `target.size()` items from the front of the ring buffer into `target`.
+        // Returns the number of items that were moved.
+        size_t pop_front(std::span<T> target) noexcept
+        {
+            const auto count = copy_front(target);
+            pop_front(count);
+            return count;
+        }
+
+        // Same as pop_front(), but without removing the items.
+        size_t copy_front(std::span<T> target) const noexcept
+        {
+            const auto count = std::min(target.size(), _size);
+            const auto [a, b] = segments();
+            const auto first = std::min(count, a.size());
+            std::copy_n(a.data(), first, target.data());
+            std::copy_n(b.data(), count - first, target.data() + first);
+            return count;
+        }
+
+    private:
+        void _reserve_additional(size_t count)
+        {
+            if (count > _capacity - _size)
+            {
+                if (count > max_size() - _size)
+                {
+                    _throw_too_long();
+                }
+                _reallocate(_size + count);
+            }
+        }
+
+        // Moves the contents into a new allocation with a capacity of at least `capacity`,
+        // which must not be less than the current size.
+        void _reallocate(size_t capacity)
+        {
+            capacity = std::bit_ceil(std::max(capacity, initial_capacity));
+            if (capacity > max_size())
+            {
+                _throw_too_long();
+            }
+
+            auto data = std::make_unique_for_overwrite<T[]>(capacity);
+            copy_front({ data.get(), _size });
+
+            _data = std::move(data);
+            _capacity = capacity;
+            _head = 0;
+        }
+
+        // Copies `items` to the (already reserved) slots starting at `pos`, wrapping around if necessary.
+        void _write(size_t pos, std::span<const T> items) noexcept
+        {
+            const auto beg = (_head + pos) & (_capacity - 1);
+            const auto first = std::min(items.size(), _capacity - beg);
+            std::copy_n(items.data(), first, _data.get() + beg);
+            std::copy_n(items.data() + first, items.size() - first, _data.get());
+        }
+
+        [[noreturn]] static void _throw_too_long()
+        {
+            throw std::length_error("ring_buffer too long");
+        }
+
+        std::unique_ptr<T[]> _data;
+        size_t _capacity = 0;
+        size_t _head = 0;
+        size_t _size = 0;
+    };
+}
+
+#pragma warning(pop)
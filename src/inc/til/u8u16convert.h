@@ -12,8 +12,11 @@ Abstract:
 Tests have been made in order to investigate whether or not own algorithms
 could overcome disadvantages of syscalls. Test results can be read up
 in PR #4093 and the test algorithms are available in src\tools\U8U16Test.
-Based on the results the decision was made to keep using the platform
-functions MultiByteToWideChar and WideCharToMultiByte.
+The platform functions MultiByteToWideChar and WideCharToMultiByte were used
+originally. They have since been replaced by the portable transcoders in
+til::details, which convert runs of ASCII 16 characters at a time and fall back
+to a scalar state machine otherwise. Their U+FFFD replacement behavior matches
+the platform functions, which U8U16Test validates using its corpora.
 
 Author(s):
 - Steffen Illhardt (german-one), Leonard Hecker (lhecker) 2020-2021
@@ -21,8 +24,216 @@ Author(s):
 
 #pragma once
 
+#if defined(TIL_SSE_INTRINSICS)
+#include <emmintrin.h>
+#elif defined(TIL_ARM_NEON_INTRINSICS)
+#include <arm_neon.h>
+#endif
+
 namespace til // Terminal Implementation Library. Also: "Today I Learned"
 {
+    namespace details
+    {
+#pragma warning(push)
+#pragma warning(disable : 26429 26481 26490) // use not_null, pointer arithmetic, reinterpret_cast
+        // Widens the leading run of ASCII characters in [src, end) into dst and returns a pointer past it.
+        inline const char* u8u16_ascii(const char* src, const char* end, wchar_t*& dst) noexcept
+        {
+            if constexpr (sizeof(wchar_t) == 2)
+            {
+#if defined(TIL_SSE_INTRINSICS)
+                const auto z = _mm_setzero_si128();
+                for (; end - src >= 16; src += 16, dst += 16)
+                {
+                    const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                    if (_mm_movemask_epi8(v))
+                    {
+                        break;
+                    }
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi8(v, z));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8), _mm_unpackhi_epi8(v, z));
+                }
+#elif defined(TIL_ARM_NEON_INTRINSICS)
+                for (; end - src >= 16; src += 16, dst += 16)
+                {
+                    const auto v = vld1q_u8(reinterpret_cast<const uint8_t*>(src));
+                    const auto w = vreinterpretq_u64_u8(v);
+                    if ((vgetq_lane_u64(w, 0) | vgetq_lane_u64(w, 1)) & 0x8080808080808080)
+                    {
+                        break;
+                    }
+                    vst1q_u16(reinterpret_cast<uint16_t*>(dst), vmovl_u8(vget_low_u8(v)));
+                    vst1q_u16(reinterpret_cast<uint16_t*>(dst + 8), vmovl_u8(vget_high_u8(v)));
+                }
+#endif
+            }
+
+            for (; src != end && static_cast<uint8_t>(*src) < 0x80; ++src, ++dst)
+            {
+                *dst = static_cast<wchar_t>(*src);
+            }
+            return src;
+        }
+
+        // Narrows the leading run of ASCII characters in [src, end) into dst and returns a pointer past it.
+        inline const wchar_t* u16u8_ascii(const wchar_t* src, const wchar_t* end, char*& dst) noexcept
+        {
+            if constexpr (sizeof(wchar_t) == 2)
+            {
+#if defined(TIL_SSE_INTRINSICS)
+                const auto z = _mm_setzero_si128();
+                const auto m = _mm_set1_epi16(static_cast<short>(0xff80));
+                for (; end - src >= 8; src += 8, dst += 8)
+                {
+                    const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, m), z)) != 0xffff)
+                    {
+                        break;
+                    }
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(v, v));
+                }
+#elif defined(TIL_ARM_NEON_INTRINSICS)
+                for (; end - src >= 8; src += 8, dst += 8)
+                {
+                    const auto v = vld1q_u16(reinterpret_cast<const uint16_t*>(src));
+                    const auto w = vreinterpretq_u64_u16(vandq_u16(v, vdupq_n_u16(0xff80)));
+                    if (vgetq_lane_u64(w, 0) | vgetq_lane_u64(w, 1))
+                    {
+                        break;
+                    }
+                    vst1_u8(reinterpret_cast<uint8_t*>(dst), vmovn_u16(v));
+                }
+#endif
+            }
+
+            for (; src != end && static_cast<char16_t>(*src) < 0x80; ++src, ++dst)
+            {
+                *dst = static_cast<char>(*src);
+            }
+            return src;
+        }
+
+        // Converts [src, end) to UTF-16 and returns a pointer past the last written code unit.
+        // dst must have room for at least (end - src) code units.
+        // Ill-formed sequences are replaced with U+FFFD, one per "maximal subpart" as recommended by
+        // the Unicode Standard (chapter 3.9). This matches the behavior of MultiByteToWideChar.
+        inline wchar_t* u8u16_decode(const char* src, const char* end, wchar_t* dst) noexcept
+        {
+            for (;;)
+            {
+                src = u8u16_ascii(src, end, dst);
+                if (src == end)
+                {
+                    return dst;
+                }
+
+                const auto lead = static_cast<uint8_t>(*src++);
+                // The valid range of the first continuation byte depends on the lead byte,
+                // which is how overlong encodings, surrogates and values >U+10FFFF are rejected.
+                uint8_t lo = 0x80;
+                uint8_t hi = 0xbf;
+                int trail;
+                char32_t cp;
+
+                if (lead >= 0xc2 && lead <= 0xdf)
+                {
+                    trail = 1;
+                    cp = lead & 0x1f;
+                }
+                else if (lead >= 0xe0 && lead <= 0xef)
+                {
+                    trail = 2;
+                    cp = lead & 0x0f;
+                    lo = lead == 0xe0 ? 0xa0 : lo;
+                    hi = lead == 0xed ? 0x9f : hi;
+                }
+                else if (lead >= 0xf0 && lead <= 0xf4)
+                {
+                    trail = 3;
+                    cp = lead & 0x07;
+                    lo = lead == 0xf0 ? 0x90 : lo;
+                    hi = lead == 0xf4 ? 0x8f : hi;
+                }
+                else
+                {
+                    *dst++ = L'\uFFFD';
+                    continue;
+                }
+
+                for (; trail && src != end; --trail, ++src)
+                {
+                    const auto b = static_cast<uint8_t>(*src);
+                    if (b < lo || b > hi)
+                    {
+                        break;
+                    }
+                    cp = (cp << 6) | (b & 0x3f);
+                    lo = 0x80;
+                    hi = 0xbf;
+                }
+
+                if (trail)
+                {
+                    *dst++ = L'\uFFFD';
+                }
+                else if (cp < 0x10000)
+                {
+                    *dst++ = static_cast<wchar_t>(cp);
+                }
+                else
+                {
+                    cp -= 0x10000;
+                    *dst++ = static_cast<wchar_t>(0xd800 | (cp >> 10));
+                    *dst++ = static_cast<wchar_t>(0xdc00 | (cp & 0x3ff));
+                }
+            }
+        }
+
+        // Converts [src, end) to UTF-8 and returns a pointer past the last written code unit.
+        // dst must have room for at least 3 * (end - src) code units.
+        // Unpaired surrogates are replaced with U+FFFD, just like WideCharToMultiByte does.
+        inline char* u16u8_encode(const wchar_t* src, const wchar_t* end, char* dst) noexcept
+        {
+            for (;;)
+            {
+                src = u16u8_ascii(src, end, dst);
+                if (src == end)
+                {
+                    return dst;
+                }
+
+                char32_t cp = static_cast<char16_t>(*src++);
+                if (cp < 0x800)
+                {
+                    *dst++ = static_cast<char>(0xc0 | (cp >> 6));
+                    *dst++ = static_cast<char>(0x80 | (cp & 0x3f));
+                    continue;
+                }
+
+                if (cp >= 0xd800 && cp <= 0xdfff)
+                {
+                    const char32_t next = src != end ? static_cast<char16_t>(*src) : 0;
+                    if (cp <= 0xdbff && next >= 0xdc00 && next <= 0xdfff)
+                    {
+                        ++src;
+                        cp = (((cp & 0x3ff) << 10) | (next & 0x3ff)) + 0x10000;
+                        *dst++ = static_cast<char>(0xf0 | (cp >> 18));
+                        *dst++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+                        *dst++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+                        *dst++ = static_cast<char>(0x80 | (cp & 0x3f));
+                        continue;
+                    }
+                    cp = 0xfffd;
+                }
+
+                *dst++ = static_cast<char>(0xe0 | (cp >> 12));
+                *dst++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+                *dst++ = static_cast<char>(0x80 | (cp & 0x3f));
+            }
+        }
+#pragma warning(pop)
+    }
+
     // state structure for maintenance of UTF-8 partials
     struct u8state
     {
@@ -56,7 +267,6 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
     // - S_OK          - the conversion succeeded
     // - E_OUTOFMEMORY - the function failed to allocate memory for the resulting string
     // - E_ABORT       - the resulting string length would exceed the upper boundary of an int and thus, the conversion was aborted before the conversion has been completed
-    // - E_UNEXPECTED  - the underlying conversion function failed
     // - HRESULT value converted from a caught exception
     template<class outT>
     [[nodiscard]] HRESULT u8u16(const std::string_view& in, outT& out) noexcept
@@ -69,11 +279,12 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             int lengthRequired{};
             // The worst ratio of UTF-8 code units to UTF-16 code units is 1 to 1 if UTF-8 consists of ASCII only.
             RETURN_HR_IF(E_ABORT, !base::MakeCheckedNum(in.length()).AssignIfValid(&lengthRequired));
-            out.resize(in.length()); // avoid to call MultiByteToWideChar twice only to get the required size
-            const int lengthOut = MultiByteToWideChar(CP_UTF8, 0ul, in.data(), lengthRequired, out.data(), lengthRequired);
-            out.resize(gsl::narrow_cast<size_t>(lengthOut));
+            out.resize(in.length()); // avoid to scan the string twice only to get the required size
+            const auto beg = out.data();
+            const auto end = details::u8u16_decode(in.data(), in.data() + in.length(), beg);
+            out.resize(gsl::narrow_cast<size_t>(end - beg));
 
-            return lengthOut == 0 ? E_UNEXPECTED : S_OK;
+            return S_OK;
         }
         CATCH_RETURN();
     }
@@ -90,7 +301,6 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
     // - S_OK          - the conversion succeeded
     // - E_OUTOFMEMORY - the function failed to allocate memory for the resulting string
     // - E_ABORT       - the resulting string length would exceed the upper boundary of an int and thus, the conversion was aborted before the conversion has been completed
-    // - E_UNEXPECTED  - the underlying conversion function failed
     // - HRESULT value converted from a caught exception
     template<class outT>
     [[nodiscard]] HRESULT u8u16(const std::string_view& in, outT& out, u8state& state) noexcept
@@ -120,10 +330,8 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
                     return S_OK;
                 }
 
-                len16 = MultiByteToWideChar(CP_UTF8, 0UL, &state.partials[0], gsl::narrow_cast<int>(state.have), out.data(), capa16);
-                RETURN_HR_IF(E_UNEXPECTED, !len16);
+                len16 = gsl::narrow_cast<int>(details::u8u16_decode(&state.partials[0], &state.partials[0] + state.have, out.data()) - out.data());
 
-                capa16 -= len16;
                 len8 -= copyable;
                 cursor8 += copyable;
                 // state.want is already zero at this point
@@ -158,10 +366,8 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 
             if (len8)
             {
-                const auto convLen{ MultiByteToWideChar(CP_UTF8, 0UL, cursor8, len8, out.data() + len16, capa16) };
-                RETURN_HR_IF(E_UNEXPECTED, !convLen);
-
-                len16 += convLen;
+                const auto beg = out.data() + len16;
+                len16 += gsl::narrow_cast<int>(details::u8u16_decode(cursor8, cursor8 + len8, beg) - beg);
             }
 
             out.resize(gsl::narrow_cast<size_t>(len16));
@@ -180,7 +386,6 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
     // - S_OK          - the conversion succeeded
     // - E_OUTOFMEMORY - the function failed to allocate memory for the resulting string
     // - E_ABORT       - the resulting string length would exceed the upper boundary of an int and thus, the conversion was aborted before the conversion has been completed
-    // - E_UNEXPECTED  - the underlying conversion function failed
     // - HRESULT value converted from a caught exception
     template<class outT>
     [[nodiscard]] HRESULT u16u8(const std::wstring_view& in, outT& out) noexcept
@@ -196,11 +401,12 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             // Code Points >U+FFFF: 2 UTF-16 code units --> 4 UTF-8 code units.
             // Thus, the worst ratio of UTF-16 code units to UTF-8 code units is 1 to 3.
             RETURN_HR_IF(E_ABORT, !base::MakeCheckedNum(in.length()).AssignIfValid(&lengthIn) || !base::CheckMul(lengthIn, 3).AssignIfValid(&lengthRequired));
-            out.resize(gsl::narrow_cast<size_t>(lengthRequired)); // avoid to call WideCharToMultiByte twice only to get the required size
-            const int lengthOut = WideCharToMultiByte(CP_UTF8, 0ul, in.data(), lengthIn, out.data(), lengthRequired, nullptr, nullptr);
-            out.resize(gsl::narrow_cast<size_t>(lengthOut));
+            out.resize(gsl::narrow_cast<size_t>(lengthRequired)); // avoid to scan the string twice only to get the required size
+            const auto beg = out.data();
+            const auto end = details::u16u8_encode(in.data(), in.data() + in.length(), beg);
+            out.resize(gsl::narrow_cast<size_t>(end - beg));
 
-            return lengthOut == 0 ? E_UNEXPECTED : S_OK;
+            return S_OK;
         }
         CATCH_RETURN();
     }
@@ -217,7 +423,6 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
     // - S_OK          - the conversion succeeded without any change of the represented code points
     // - E_OUTOFMEMORY - the function failed to allocate memory for the resulting string
     // - E_ABORT       - the resulting string length would exceed the upper boundary of an int and thus, the conversion was aborted before the conversion has been completed
-    // - E_UNEXPECTED  - the underlying conversion function failed
     // - HRESULT value converted from a caught exception
     template<class outT>
     [[nodiscard]] HRESULT u16u8(const std::wstring_view& in, outT& out, u16state& state) noexcept
@@ -238,11 +443,9 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             if (state.partials[0])
             {
                 state.partials[1] = *cursor16;
-                len8 = WideCharToMultiByte(CP_UTF8, 0UL, &state.partials[0], 2, out.data(), capa8, nullptr, nullptr);
-                RETURN_HR_IF(E_UNEXPECTED, !len8);
+                len8 = gsl::narrow_cast<int>(details::u16u8_encode(&state.partials[0], &state.partials[0] + 2, out.data()) - out.data());
 
                 state.reset();
-                capa8 -= len8;
                 --len16;
                 ++cursor16;
             }
@@ -259,10 +462,8 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 
             if (len16)
             {
-                const auto convLen{ WideCharToMultiByte(CP_UTF8, 0UL, cursor16, len16, out.data() + len8, capa8, nullptr, nullptr) };
-                RETURN_HR_IF(E_UNEXPECTED, !convLen);
-
-                len8 += convLen;
+                const auto beg = out.data() + len8;
+                len8 += gsl::narrow_cast<int>(details::u16u8_encode(cursor16, cursor16 + len16, beg) - beg);
             }
 
             out.resize(gsl::narrow_cast<size_t>(len8));
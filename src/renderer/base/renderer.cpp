@@ -736,21 +736,21 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
             // of the backing buffer to fill in line 1 of the screen.
             const auto screenPosition = bufferLine.Origin() - til::point{ 0, view.Top() };
 
-            // Retrieve the cell information iterator limited to just this line we want to redraw.
-            auto it = buffer.GetCellDataAt(bufferLine.Origin(), bufferLine);
+            // Retrieve the row we want to redraw. The helper reads its text and attributes directly.
+            const auto& bufferRow = buffer.GetRowByOffset(bufferLine.Origin().y);
 
             // Calculate if two things are true:
             // 1. this row wrapped
             // 2. We're painting the last col of the row.
             // In that case, set lineWrapped=true for the _PaintBufferOutputHelper call.
-            const auto lineWrapped = (buffer.GetRowByOffset(bufferLine.Origin().y).WasWrapForced()) &&
+            const auto lineWrapped = bufferRow.WasWrapForced() &&
                                      (bufferLine.RightExclusive() == buffer.GetSize().Width());
 
             // Prepare the appropriate line transform for the current row and viewport offset.
             LOG_IF_FAILED(pEngine->PrepareLineTransform(lineRendition, screenPosition.y, view.Left()));
 
             // Ask the helper to paint through this specific line.
-            _PaintBufferOutputHelper(pEngine, it, screenPosition, lineWrapped);
+            _PaintBufferOutputHelper(pEngine, bufferRow, bufferLine.Left(), bufferLine.RightExclusive(), screenPosition, lineWrapped);
         }
     }
 }
@@ -761,154 +761,166 @@ static bool _IsAllSpaces(const std::wstring_view v)
     return v.find_first_not_of(L' ') == decltype(v)::npos;
 }
 
+// Routine Description:
+// - Paints the columns [columnBegin, columnEnd) of the given row, one run of identical attributes at a time.
+// - The text, glyph widths and attributes are read directly from the row via RowRenderView.
+//   The clusters passed to PaintBufferLine() refer to the row's text and aren't copied.
+// Arguments:
+// - row - The row to paint.
+// - columnBegin, columnEnd - The range of columns in the row to paint.
+// - target - The position on the screen where columnBegin is painted.
+// - lineWrapped - Whether the row wrapped and the last column of the row is painted.
+// Return Value:
+// - <none>
 void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
-                                        TextBufferCellIterator it,
+                                        const ROW& row,
+                                        const til::CoordType columnBegin,
+                                        const til::CoordType columnEnd,
                                         const til::point target,
                                         const bool lineWrapped)
 {
     auto globalInvert{ _renderSettings.GetRenderMode(RenderSettings::Mode::ScreenReversed) };
 
+    auto view = row.CreateRenderView();
+    const auto colEnd = std::min(columnEnd, view.ColumnCount());
+    auto col = std::max(columnBegin, 0);
+
     // If we have valid data, let's figure out how to draw it.
-    if (it)
+    if (col >= colEnd)
     {
-        // TODO: MSFT: 20961091 -  This is a perf issue. Instead of rebuilding this and allocing memory to hold the reinterpretation,
-        // we should have an iterator/view adapter for the rendering.
-        // That would probably also eliminate the RenderData needing to give us the entire TextBuffer as well...
-        // Retrieve the iterator for one line of information.
-        til::CoordType cols = 0;
-
-        // Retrieve the first color.
-        auto color = it->TextAttr();
-        // Retrieve the first pattern id
-        auto patternIds = _pData->GetPatternId(target);
-        // Determine whether we're using a soft font.
-        auto usingSoftFont = s_IsSoftFontChar(it->Chars(), _firstSoftFontChar, _lastSoftFontChar);
-
-        // And hold the point where we should start drawing.
-        auto screenPoint = target;
-
-        // This outer loop will continue until we reach the end of the text we are trying to draw.
-        while (it)
+        return;
+    }
+
+    til::CoordType cols = 0;
+
+    // Retrieve the first glyph and color.
+    til::CoordType glyphEnd = 0;
+    auto glyph = view.GlyphAt(col, glyphEnd);
+    auto color = view.AttrAt(col);
+    // Retrieve the first pattern ids. The cursor walks the row's spans in lockstep with the columns.
+    PatternSpanCursor patterns{ _pData->GetPatternSpans(target.y) };
+    auto patternIds = patterns.At(target.x);
+    // Determine whether we're using a soft font.
+    auto usingSoftFont = s_IsSoftFontChar(glyph, _firstSoftFontChar, _lastSoftFontChar);
+
+    // And hold the point where we should start drawing.
+    auto screenPoint = target;
+
+    // This outer loop will continue until we reach the end of the text we are trying to draw.
+    while (col < colEnd)
+    {
+        // Hold onto the current run color right here for the length of the outer loop.
+        // We'll be changing the persistent one as we run through the inner loops to detect
+        // when a run changes, but we will still need to know this color at the bottom
+        // when we go to draw gridlines for the length of the run.
+        const auto currentRunColor = color;
+
+        // Update the drawing brushes with our color and font usage.
+        THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, currentRunColor, usingSoftFont, false));
+
+        // Advance the point by however many columns we've just outputted and reset the accumulator.
+        screenPoint.x += cols;
+        cols = 0;
+
+        // Hold onto the start of this run and the target location where we started
+        // in case we need to do some special work to paint the line drawing characters.
+        const auto currentRunColumnStart = col;
+        const auto currentRunTargetStart = screenPoint;
+
+        // Ensure that our cluster vector is clear.
+        _clusterBuffer.clear();
+
+        // Reset our flag to know when we're in the special circumstance
+        // of attempting to draw only the right-half of a two-column character
+        // as the first item in our run.
+        auto trimLeft = false;
+
+        // Run contains wide character (>1 columns)
+        auto containsWideCharacter = false;
+
+        // This inner loop will accumulate clusters until the color changes.
+        // When the color changes, it will save the new color off and break.
+        // We also accumulate clusters according to regex patterns
+        do
         {
-            // Hold onto the current run color right here for the length of the outer loop.
-            // We'll be changing the persistent one as we run through the inner loops to detect
-            // when a run changes, but we will still need to know this color at the bottom
-            // when we go to draw gridlines for the length of the run.
-            const auto currentRunColor = color;
-
-            // Hold onto the current pattern id as well
-            const auto currentPatternId = patternIds;
-
-            // Update the drawing brushes with our color and font usage.
-            THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, currentRunColor, usingSoftFont, false));
-
-            // Advance the point by however many columns we've just outputted and reset the accumulator.
-            screenPoint.x += cols;
-            cols = 0;
-
-            // Hold onto the start of this run iterator and the target location where we started
-            // in case we need to do some special work to paint the line drawing characters.
-            const auto currentRunItStart = it;
-            const auto currentRunTargetStart = screenPoint;
-
-            // Ensure that our cluster vector is clear.
-            _clusterBuffer.clear();
-
-            // Reset our flag to know when we're in the special circumstance
-            // of attempting to draw only the right-half of a two-column character
-            // as the first item in our run.
-            auto trimLeft = false;
-
-            // Run contains wide character (>1 columns)
-            auto containsWideCharacter = false;
-
-            // This inner loop will accumulate clusters until the color changes.
-            // When the color changes, it will save the new color off and break.
-            // We also accumulate clusters according to regex patterns
-            do
+            const auto thisPointPatterns = patterns.At(screenPoint.x + cols);
+            const auto thisUsingSoftFont = s_IsSoftFontChar(glyph, _firstSoftFontChar, _lastSoftFontChar);
+            const auto changedPatternOrFont = patternIds != thisPointPatterns || usingSoftFont != thisUsingSoftFont;
+            const auto& attr = view.AttrAt(col);
+            if (color != attr || changedPatternOrFont)
             {
-                til::point thisPoint{ screenPoint.x + cols, screenPoint.y };
-                const auto thisPointPatterns = _pData->GetPatternId(thisPoint);
-                const auto thisUsingSoftFont = s_IsSoftFontChar(it->Chars(), _firstSoftFontChar, _lastSoftFontChar);
-                const auto changedPatternOrFont = patternIds != thisPointPatterns || usingSoftFont != thisUsingSoftFont;
-                if (color != it->TextAttr() || changedPatternOrFont)
+                // foreground doesn't matter for runs of spaces (!)
+                // if we trick it . . . we call Paint far fewer times for cmatrix
+                if (!_IsAllSpaces(glyph) || !attr.HasIdenticalVisualRepresentationForBlankSpace(color, globalInvert) || changedPatternOrFont)
                 {
-                    auto newAttr{ it->TextAttr() };
-                    // foreground doesn't matter for runs of spaces (!)
-                    // if we trick it . . . we call Paint far fewer times for cmatrix
-                    if (!_IsAllSpaces(it->Chars()) || !newAttr.HasIdenticalVisualRepresentationForBlankSpace(color, globalInvert) || changedPatternOrFont)
-                    {
-                        color = newAttr;
-                        patternIds = thisPointPatterns;
-                        usingSoftFont = thisUsingSoftFont;
-                        break; // vend this run
-                    }
+                    color = attr;
+                    patternIds = thisPointPatterns;
+                    usingSoftFont = thisUsingSoftFont;
+                    break; // vend this run
                 }
+            }
 
-                // Walk through the text data and turn it into rendering clusters.
-                // Keep the columnCount as we go to improve performance over digging it out of the vector at the end.
-                auto columnCount = it->Columns();
+            // The glyph spans [col, glyphEnd). If col is the trailing half of a wide glyph, this is 1 column.
+            auto columnCount = glyphEnd - col;
 
-                // If we're on the first cluster to be added and it's marked as "trailing"
-                // (a.k.a. the right half of a two column character), then we need some special handling.
-                if (_clusterBuffer.empty() && it->DbcsAttr() == DbcsAttribute::Trailing)
-                {
-                    // Move left to the one so the whole character can be struck correctly.
-                    --screenPoint.x;
-                    // And tell the next function to trim off the left half of it.
-                    trimLeft = true;
-                    // And add one to the number of columns we expect it to take as we insert it.
-                    ++columnCount;
-                }
+            // If we're on the first cluster to be added and it's marked as "trailing"
+            // (a.k.a. the right half of a two column character), then we need some special handling.
+            if (_clusterBuffer.empty() && view.IsTrailer(col))
+            {
+                // Move left to the one so the whole character can be struck correctly.
+                --screenPoint.x;
+                // And tell the next function to trim off the left half of it.
+                trimLeft = true;
+                // And add one to the number of columns we expect it to take as we insert it.
+                ++columnCount;
+            }
 
-                if (columnCount > 1)
-                {
-                    containsWideCharacter = true;
-                }
+            if (columnCount > 1)
+            {
+                containsWideCharacter = true;
+            }
 
-                // Advance the cluster and column counts.
-                _clusterBuffer.emplace_back(it->Chars(), columnCount);
-                it += std::max(it->Columns(), 1); // prevent infinite loop for no visible columns
-                cols += columnCount;
+            // Advance the cluster and column counts.
+            _clusterBuffer.emplace_back(glyph, columnCount);
+            cols += columnCount;
+            col = glyphEnd;
 
-            } while (it);
+            if (col < colEnd)
+            {
+                glyph = view.GlyphAt(col, glyphEnd);
+            }
+        } while (col < colEnd);
 
-            // Do the painting.
-            THROW_IF_FAILED(pEngine->PaintBufferLine({ _clusterBuffer.data(), _clusterBuffer.size() }, screenPoint, trimLeft, lineWrapped));
+        // Do the painting.
+        THROW_IF_FAILED(pEngine->PaintBufferLine({ _clusterBuffer.data(), _clusterBuffer.size() }, screenPoint, trimLeft, lineWrapped));
 
-            // If we're allowed to do grid drawing, draw that now too (since it will be coupled with the color data)
-            // We're only allowed to draw the grid lines under certain circumstances.
-            if (_pData->IsGridLineDrawingAllowed())
+        // If we're allowed to do grid drawing, draw that now too (since it will be coupled with the color data)
+        // We're only allowed to draw the grid lines under certain circumstances.
+        if (_pData->IsGridLineDrawingAllowed())
+        {
+            // See GH: 803
+            // If we found a wide character while we looped above, it's possible we skipped over the right half
+            // attribute that could have contained different line information than the left half.
+            if (containsWideCharacter)
             {
-                // See GH: 803
-                // If we found a wide character while we looped above, it's possible we skipped over the right half
-                // attribute that could have contained different line information than the left half.
-                if (containsWideCharacter)
+                // We need to go through the columns again to ensure we get the lines associated with each
+                // exact column. The code above will condense two-column characters into one, but it is possible
+                // (like with the IME) that the line drawing characters will vary from the left to right half
+                // of a wider character. A separate view is used, so that `view` can keep moving forward.
+                auto lineView = row.CreateRenderView();
+                auto lineTarget = currentRunTargetStart;
+                const auto lineEnd = std::min(currentRunColumnStart + cols, view.ColumnCount());
+
+                for (auto lineColumn = currentRunColumnStart; lineColumn < lineEnd; ++lineColumn, ++lineTarget.x)
                 {
-                    // Start from the original position in this run.
-                    auto lineIt = currentRunItStart;
-                    // Start from the original target in this run.
-                    auto lineTarget = currentRunTargetStart;
-
-                    // We need to go through the iterators again to ensure we get the lines associated with each
-                    // exact column. The code above will condense two-column characters into one, but it is possible
-                    // (like with the IME) that the line drawing characters will vary from the left to right half
-                    // of a wider character.
-                    // We could theoretically pre-pass for this in the loop above to be more efficient about walking
-                    // the iterator, but I fear it would make the code even more confusing than it already is.
-                    // Do that in the future if some WPR trace points you to this spot as super bad.
-                    for (til::CoordType colsPainted = 0; colsPainted < cols; ++colsPainted, ++lineIt, ++lineTarget.x)
-                    {
-                        auto lines = lineIt->TextAttr();
-                        _PaintBufferOutputGridLineHelper(pEngine, lines, 1, lineTarget);
-                    }
-                }
-                else
-                {
-                    // If nothing exciting is going on, draw the lines in bulk.
-                    _PaintBufferOutputGridLineHelper(pEngine, currentRunColor, cols, screenPoint);
+                    _PaintBufferOutputGridLineHelper(pEngine, lineView.AttrAt(lineColumn), 1, lineTarget);
                 }
             }
+            else
+            {
+                // If nothing exciting is going on, draw the lines in bulk.
+                _PaintBufferOutputGridLineHelper(pEngine, currentRunColor, cols, screenPoint);
+            }
         }
     }
 }
@@ -1018,7 +1030,7 @@ bool Renderer::_isInHoveredInterval(const til::point coordTarget) const noexcept
 {
     return _hoveredInterval &&
            _hoveredInterval->start <= coordTarget && coordTarget <= _hoveredInterval->stop &&
-           _pData->GetPatternId(coordTarget).size() > 0;
+           PatternSpanCursor{ _pData->GetPatternSpans(coordTarget.y) }.At(coordTarget.x) != 0;
 }
 
 // Routine Description:
@@ -1150,9 +1162,11 @@ void Renderer::_PaintOverlay(IRenderEngine& engine,
                     const til::point target{ viewDirty.left, iRow };
                     const auto source = target - overlay.origin;
 
-                    auto it = overlay.buffer.GetCellLineDataAt(source);
-
-                    _PaintBufferOutputHelper(&engine, it, target, false);
+                    if (overlay.buffer.GetSize().IsInBounds(source))
+                    {
+                        const auto& row = overlay.buffer.GetRowByOffset(source.y);
+                        _PaintBufferOutputHelper(&engine, row, source.x, overlay.buffer.GetSize().Width(), target, false);
+                    }
                 }
             }
         }
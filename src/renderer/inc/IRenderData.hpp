@@ -36,6 +36,55 @@ namespace Microsoft::Console::Render
         const Microsoft::Console::Types::Viewport region;
     };
 
+    // A run of columns [begin, end) within a viewport row that's covered by the same set of regex
+    // patterns. Bit N of ids is set if pattern N covers the run. The spans of a row are sorted
+    // and don't overlap. Columns that aren't covered by any span have no patterns.
+    struct PatternSpan
+    {
+        til::CoordType begin = 0;
+        til::CoordType end = 0;
+        uint64_t ids = 0;
+    };
+
+    // Walks the PatternSpans of a row. The renderer queries the columns of a row left to right,
+    // which makes each lookup amortized O(1) without allocating anything.
+    class PatternSpanCursor
+    {
+    public:
+        constexpr PatternSpanCursor() noexcept = default;
+        constexpr explicit PatternSpanCursor(std::span<const PatternSpan> spans) noexcept :
+            _spans{ spans }
+        {
+        }
+
+        // Returns the pattern ids covering the given column, or 0 if there are none.
+        constexpr uint64_t At(const til::CoordType column) noexcept
+        {
+            // Stepping backwards is rare (e.g. the leading half of a wide glyph), but allowed.
+            while (_index != 0 && column < til::at(_spans, _index - 1).end)
+            {
+                --_index;
+            }
+            while (_index < _spans.size() && til::at(_spans, _index).end <= column)
+            {
+                ++_index;
+            }
+            if (_index < _spans.size())
+            {
+                const auto& span = til::at(_spans, _index);
+                if (span.begin <= column)
+                {
+                    return span.ids;
+                }
+            }
+            return 0;
+        }
+
+    private:
+        std::span<const PatternSpan> _spans;
+        size_t _index = 0;
+    };
+
     class IRenderData
     {
     public:
@@ -63,7 +112,7 @@ namespace Microsoft::Console::Render
         virtual const std::wstring_view GetConsoleTitle() const noexcept = 0;
         virtual const std::wstring GetHyperlinkUri(uint16_t id) const = 0;
         virtual const std::wstring GetHyperlinkCustomId(uint16_t id) const = 0;
-        virtual const std::vector<size_t> GetPatternId(const til::point location) const = 0;
+        virtual std::span<const PatternSpan> GetPatternSpans(const til::CoordType viewportRow) const noexcept = 0;
 
         // This block used to be IUiaData.
         virtual std::pair<COLORREF, COLORREF> GetAttributeColors(const TextAttribute& attr) const noexcept = 0;
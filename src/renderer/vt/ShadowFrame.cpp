@@ -0,0 +1,174 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "ShadowFrame.hpp"
+
+#pragma hdrstop
+using namespace Microsoft::Console::Render;
+
+// Routine Description:
+// - Resizes the frame to the given viewport size. Since we can't know how the
+//      terminal rearranged its contents, all cells are invalid afterwards.
+// Arguments:
+// - size: the new size of the viewport
+// Return Value:
+// - <none>
+void ShadowFrame::Reset(const til::size size)
+{
+    _cells.clear();
+    _cells.resize(size.area<size_t>());
+    _size = size;
+}
+
+// Routine Description:
+// - Forgets the contents of the entire frame. Used whenever something was
+//      written to the terminal that we can't track, like a passthrough sequence.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void ShadowFrame::InvalidateAll() noexcept
+{
+    std::fill(_cells.begin(), _cells.end(), Cell{});
+}
+
+// Routine Description:
+// - Forgets the contents of the given cells, because we know they changed
+//      in the terminal, but not what they changed into.
+// Arguments:
+// - target: the first cell to invalidate
+// - columns: the number of cells to invalidate, clamped to the end of the row
+// Return Value:
+// - <none>
+void ShadowFrame::Invalidate(const til::point target, const til::CoordType columns) noexcept
+{
+    if (!Contains(target))
+    {
+        return;
+    }
+
+    const auto count = std::min(columns, _size.width - target.x);
+    const auto begin = _cells.begin() + (target.y * _size.width + target.x);
+    std::fill(begin, begin + std::max(count, 0), Cell{});
+}
+
+// Routine Description:
+// - Shifts the rows of the frame the same way the terminal shifted them.
+//      The rows that get revealed are invalid.
+// Arguments:
+// - delta: the number of rows the contents moved down by. Negative values
+//      move the contents up, as with newlines emitted at the bottom.
+// Return Value:
+// - <none>
+void ShadowFrame::Scroll(const til::CoordType delta) noexcept
+{
+    const auto rows = std::min<til::CoordType>(std::abs(delta), _size.height);
+    const auto offset = gsl::narrow_cast<ptrdiff_t>(rows) * _size.width;
+    if (offset == 0)
+    {
+        return;
+    }
+
+    if (delta < 0)
+    {
+        std::move(_cells.begin() + offset, _cells.end(), _cells.begin());
+        std::fill(_cells.end() - offset, _cells.end(), Cell{});
+    }
+    else
+    {
+        std::move_backward(_cells.begin(), _cells.end() - offset, _cells.end());
+        std::fill(_cells.begin(), _cells.begin() + offset, Cell{});
+    }
+}
+
+bool ShadowFrame::Contains(const til::point target) const noexcept
+{
+    return target.x >= 0 && target.x < _size.width && target.y >= 0 && target.y < _size.height;
+}
+
+// Routine Description:
+// - Returns true if the terminal is known to already display the given
+//      cluster with the given attributes at the given position.
+// Arguments:
+// - target: the position of the cluster's leftmost column
+// - cluster: the text and width of the cluster
+// - attributes: the attributes the cluster would be emitted with
+// Return Value:
+// - true if emitting the cluster would be redundant.
+bool ShadowFrame::Matches(const til::point target, const Cluster& cluster, const TextAttribute& attributes) const noexcept
+{
+    const auto cell = _cellAt(target);
+    if (!cell || cell->columns == InvalidColumns || cell->columns == TrailingColumns)
+    {
+        return false;
+    }
+
+    const auto columns = cluster.GetColumns();
+    if (cell->columns != columns || cell->attributes != attributes || std::wstring_view{ &cell->text[0], cell->length } != cluster.GetText())
+    {
+        return false;
+    }
+
+    // The trailing columns might have been overwritten by a narrower cluster since.
+    for (til::CoordType i = 1; i < columns; ++i)
+    {
+        const auto trailer = _cellAt({ target.x + i, target.y });
+        if (!trailer || trailer->columns != TrailingColumns)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Routine Description:
+// - Stores that the given cluster was emitted at the given position.
+//      A wide cluster that is partially overwritten by it doesn't need any
+//      special handling, because Matches() verifies the trailing columns.
+// Arguments:
+// - target: the position of the cluster's leftmost column
+// - cluster: the text and width of the cluster
+// - attributes: the attributes the cluster was emitted with
+// Return Value:
+// - <none>
+void ShadowFrame::Record(const til::point target, const Cluster& cluster, const TextAttribute& attributes) noexcept
+{
+    const auto text = cluster.GetText();
+    const auto columns = cluster.GetColumns();
+
+    if (columns < 1 || columns > MaxClusterColumns || text.size() > MaxClusterLength || target.x + columns > _size.width)
+    {
+        Invalidate(target, columns);
+        return;
+    }
+
+    const auto cell = _cellAt(target);
+    if (!cell)
+    {
+        return;
+    }
+
+    std::copy(text.begin(), text.end(), &cell->text[0]);
+    cell->length = gsl::narrow_cast<uint8_t>(text.size());
+    cell->columns = gsl::narrow_cast<uint8_t>(columns);
+    cell->attributes = attributes;
+
+    for (til::CoordType i = 1; i < columns; ++i)
+    {
+        auto& trailer = *_cellAt({ target.x + i, target.y });
+        trailer = Cell{};
+        trailer.columns = TrailingColumns;
+    }
+}
+
+ShadowFrame::Cell* ShadowFrame::_cellAt(const til::point target) noexcept
+{
+    return Contains(target) ? &til::at(_cells, target.y * _size.width + target.x) : nullptr;
+}
+
+const ShadowFrame::Cell* ShadowFrame::_cellAt(const til::point target) const noexcept
+{
+    return Contains(target) ? &til::at(_cells, target.y * _size.width + target.x) : nullptr;
+}
@@ -0,0 +1,56 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ShadowFrame.hpp
+
+Abstract:
+- A copy of the viewport contents as they were last emitted to the connected
+  terminal. The VtEngine compares the rows it's asked to paint against this
+  frame, so that it can skip over cells the terminal already displays.
+--*/
+
+#pragma once
+
+#include "../inc/Cluster.hpp"
+#include "../../buffer/out/TextAttribute.hpp"
+
+namespace Microsoft::Console::Render
+{
+    class ShadowFrame final
+    {
+    public:
+        void Reset(const til::size size);
+        void InvalidateAll() noexcept;
+        void Invalidate(const til::point target, const til::CoordType columns) noexcept;
+        void Scroll(const til::CoordType delta) noexcept;
+
+        bool Contains(const til::point target) const noexcept;
+        bool Matches(const til::point target, const Cluster& cluster, const TextAttribute& attributes) const noexcept;
+        void Record(const til::point target, const Cluster& cluster, const TextAttribute& attributes) noexcept;
+
+    private:
+        // Each cluster is stored in the cell of its leftmost column.
+        // The remaining columns of a wide cluster are marked as TrailingColumns.
+        static constexpr uint8_t InvalidColumns = 0;
+        static constexpr uint8_t TrailingColumns = UINT8_MAX;
+        // Longer clusters are rare enough that we don't bother tracking them.
+        static constexpr size_t MaxClusterLength = 2;
+        static constexpr til::CoordType MaxClusterColumns = 2;
+
+        struct Cell
+        {
+            wchar_t text[MaxClusterLength];
+            uint8_t length;
+            uint8_t columns;
+            TextAttribute attributes;
+        };
+
+        Cell* _cellAt(const til::point target) noexcept;
+        const Cell* _cellAt(const til::point target) const noexcept;
+
+        std::vector<Cell> _cells;
+        til::size _size;
+    };
+}
@@ -97,6 +97,18 @@ using namespace Microsoft::Console::Render;
     return _WriteFormatted(FMT_COMPILE("\x1b[{}C"), chars);
 }
 
+// Method Description:
+// - Moves the cursor to the given column of the current row.
+// Arguments:
+// - column: the zero-based column to move the cursor to.
+// Return Value:
+// - S_OK if we succeeded, else an appropriate HRESULT for failing to allocate or write.
+[[nodiscard]] HRESULT VtEngine::_CursorHorizontalAbsolute(const til::CoordType column) noexcept
+{
+    // VT is 1-indexed, so increment the column by one.
+    return _WriteFormatted(FMT_COMPILE("\x1b[{}G"), column + 1);
+}
+
 // Method Description:
 // - Formats and writes a sequence to erase the remainder of the line starting
 //      from the cursor position.
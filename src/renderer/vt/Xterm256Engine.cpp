@@ -8,6 +8,252 @@ using namespace Microsoft::Console;
 using namespace Microsoft::Console::Render;
 using namespace Microsoft::Console::Types;
 
+namespace
+{
+    // Accumulates the parameters of a single SGR sequence in a fixed size
+    // buffer, so that building one doesn't need to allocate.
+    class GraphicsRenditionBuilder
+    {
+    public:
+        bool Empty() const noexcept
+        {
+            return _size == PrefixLength;
+        }
+
+        // Returns the length of the complete sequence, or 0 if there's nothing to emit.
+        size_t Length() const noexcept
+        {
+            if (_reset && _size == PrefixLength + 1)
+            {
+                return ResetSequence.size();
+            }
+            return Empty() ? 0 : _size + 1;
+        }
+
+        std::string_view Sequence() noexcept
+        {
+            // A lone reset parameter can be omitted, since it's the default.
+            if (_reset && _size == PrefixLength + 1)
+            {
+                return ResetSequence;
+            }
+            til::at(_data, _size) = 'm';
+            return { _data.data(), _size + 1 };
+        }
+
+        void AppendReset() noexcept
+        {
+            Append(0);
+            _reset = true;
+        }
+
+        void Append(const unsigned int parameter) noexcept
+        {
+            if (!Empty())
+            {
+                _Put(';');
+            }
+            _PutNumber(parameter);
+        }
+
+        // Appends a 16 color, 256 color or RGB color parameter.
+        // The base is 30 for the foreground and 40 for the background.
+        void AppendColor(const TextColor color, const unsigned int base) noexcept
+        {
+            if (color.IsDefault())
+            {
+                Append(base + 9);
+            }
+            else if (color.IsIndex16())
+            {
+                // The bright colors are in [90,97] for the foreground and [100,107] for the background.
+                const auto index = color.GetIndex();
+                Append((WI_IsFlagSet(index, FOREGROUND_INTENSITY) ? base + 60 : base) + (index & 7));
+            }
+            else if (color.IsIndex256())
+            {
+                Append(base + 8);
+                Append(5);
+                Append(color.GetIndex());
+            }
+            else if (color.IsRgb())
+            {
+                const auto rgb = color.GetRGB();
+                Append(base + 8);
+                Append(2);
+                Append(GetRValue(rgb));
+                Append(GetGValue(rgb));
+                Append(GetBValue(rgb));
+            }
+        }
+
+        // The underline color uses sub parameters, and can't be a 16 color.
+        void AppendUnderlineColor(const TextColor color) noexcept
+        {
+            if (color.IsDefault())
+            {
+                Append(59);
+            }
+            else if (color.IsIndex256())
+            {
+                Append(58);
+                _PutSubParameter(5);
+                _PutSubParameter(color.GetIndex());
+            }
+            else if (color.IsRgb())
+            {
+                const auto rgb = color.GetRGB();
+                Append(58);
+                _PutSubParameter(2);
+                // The color space ID is left empty.
+                _Put(':');
+                _PutSubParameter(GetRValue(rgb));
+                _PutSubParameter(GetGValue(rgb));
+                _PutSubParameter(GetBValue(rgb));
+            }
+        }
+
+        void AppendUnderlineStyle(const UnderlineStyle style) noexcept
+        {
+            switch (style)
+            {
+            case UnderlineStyle::NoUnderline:
+                Append(24);
+                break;
+            case UnderlineStyle::DoublyUnderlined:
+                Append(21);
+                break;
+            case UnderlineStyle::CurlyUnderlined:
+                Append(4);
+                _PutSubParameter(3);
+                break;
+            case UnderlineStyle::DottedUnderlined:
+                Append(4);
+                _PutSubParameter(4);
+                break;
+            case UnderlineStyle::DashedUnderlined:
+                Append(4);
+                _PutSubParameter(5);
+                break;
+            default:
+                Append(4); // treat unknown style as singly underlined
+                break;
+            }
+        }
+
+        // Appends the parameters that turn the `from` attributes into the `to` attributes.
+        // This mirrors what _RgbUpdateDrawingBrushes and _UpdateExtendedAttrs emit.
+        void AppendDelta(const TextAttribute& from, const TextAttribute& to) noexcept
+        {
+            if (to.GetForeground() != from.GetForeground())
+            {
+                AppendColor(to.GetForeground(), 30);
+            }
+            if (to.GetBackground() != from.GetBackground())
+            {
+                AppendColor(to.GetBackground(), 40);
+            }
+            if (to.GetUnderlineColor() != from.GetUnderlineColor())
+            {
+                AppendUnderlineColor(to.GetUnderlineColor());
+            }
+
+            // Turning off Intense and Faint must be handled at the same time,
+            // since there is only one parameter that resets both of them.
+            auto intense = from.IsIntense();
+            auto faint = from.IsFaint();
+            if ((intense && !to.IsIntense()) || (faint && !to.IsFaint()))
+            {
+                Append(22);
+                intense = false;
+                faint = false;
+            }
+            if (to.IsIntense() && !intense)
+            {
+                Append(1);
+            }
+            if (to.IsFaint() && !faint)
+            {
+                Append(2);
+            }
+
+            const auto ulStyle = to.GetUnderlineStyle();
+            const auto lastUlStyle = from.GetUnderlineStyle();
+            if (ulStyle != lastUlStyle)
+            {
+                // See _UpdateExtendedAttrs for why doubly underlined is reset first.
+                if (lastUlStyle == UnderlineStyle::DoublyUnderlined && ulStyle != UnderlineStyle::NoUnderline)
+                {
+                    Append(24);
+                }
+                AppendUnderlineStyle(ulStyle);
+            }
+
+            if (to.IsOverlined() != from.IsOverlined())
+            {
+                Append(to.IsOverlined() ? 53 : 55);
+            }
+            if (to.IsItalic() != from.IsItalic())
+            {
+                Append(to.IsItalic() ? 3 : 23);
+            }
+            if (to.IsBlinking() != from.IsBlinking())
+            {
+                Append(to.IsBlinking() ? 5 : 25);
+            }
+            if (to.IsInvisible() != from.IsInvisible())
+            {
+                Append(to.IsInvisible() ? 8 : 28);
+            }
+            if (to.IsCrossedOut() != from.IsCrossedOut())
+            {
+                Append(to.IsCrossedOut() ? 9 : 29);
+            }
+            if (to.IsReverseVideo() != from.IsReverseVideo())
+            {
+                Append(to.IsReverseVideo() ? 7 : 27);
+            }
+        }
+
+    private:
+        static constexpr std::string_view ResetSequence{ "\x1b[m" };
+        static constexpr size_t PrefixLength = 2;
+
+        void _Put(const char ch) noexcept
+        {
+            // The longest possible sequence is less than 100 characters. Always leave room for the final 'm'.
+            if (_size < _data.size() - 1)
+            {
+                til::at(_data, _size++) = ch;
+            }
+        }
+
+        void _PutNumber(const unsigned int value) noexcept
+        {
+            // None of our parameters exceed 3 digits.
+            if (value >= 100)
+            {
+                _Put(static_cast<char>('0' + value / 100 % 10));
+            }
+            if (value >= 10)
+            {
+                _Put(static_cast<char>('0' + value / 10 % 10));
+            }
+            _Put(static_cast<char>('0' + value % 10));
+        }
+
+        void _PutSubParameter(const unsigned int value) noexcept
+        {
+            _Put(':');
+            _PutNumber(value);
+        }
+
+        std::array<char, 128> _data{ '\x1b', '[' };
+        size_t _size = PrefixLength;
+        bool _reset = false;
+    };
+}
+
 Xterm256Engine::Xterm256Engine(_In_ wil::unique_hfile hPipe,
                                const Viewport initialViewport) :
     XtermEngine(std::move(hPipe), initialViewport, false)
@@ -34,7 +280,14 @@ Xterm256Engine::Xterm256Engine(_In_ wil::unique_hfile hPipe,
 {
     RETURN_HR_IF(S_FALSE, _passthrough && isSettingDefaultBrushes);
 
-    RETURN_IF_FAILED(VtEngine::_RgbUpdateDrawingBrushes(textAttributes));
+    if (_combineGraphicsRenditions)
+    {
+        RETURN_IF_FAILED(_UpdateGraphicsRendition(textAttributes));
+    }
+    else
+    {
+        RETURN_IF_FAILED(VtEngine::_RgbUpdateDrawingBrushes(textAttributes));
+    }
 
     RETURN_IF_FAILED(_UpdateHyperlinkAttr(textAttributes, pData));
 
@@ -50,7 +303,66 @@ Xterm256Engine::Xterm256Engine(_In_ wil::unique_hfile hPipe,
     }
 
     // Only do extended attributes in xterm-256color, as to not break telnet.exe.
-    return _UpdateExtendedAttrs(textAttributes);
+    // The combined sequence already included them.
+    return _combineGraphicsRenditions ? S_OK : _UpdateExtendedAttrs(textAttributes);
+}
+
+// Routine Description:
+// - Configures the engine to emit all the changes to the colors and character
+//      rendition attributes in a single SGR sequence, instead of one sequence
+//      per attribute. See _UpdateGraphicsRendition.
+// Arguments:
+// - combine - True to combine the changes. False otherwise.
+// Return Value:
+// - <none>
+void Xterm256Engine::SetCombineGraphicsRenditions(const bool combine) noexcept
+{
+    _combineGraphicsRenditions = combine;
+}
+
+// Routine Description:
+// - Write a single SGR sequence that changes the colors and character
+//      rendition attributes from the last ones we emitted to the given ones.
+//      We either change just the attributes that differ, or reset everything
+//      and set the attributes that differ from the defaults, whichever is shorter.
+// Arguments:
+// - textAttributes - Text attributes to use for the colors and character rendition
+// Return Value:
+// - S_OK if we succeeded, else an appropriate HRESULT for failing to allocate or write.
+[[nodiscard]] HRESULT Xterm256Engine::_UpdateGraphicsRendition(const TextAttribute& textAttributes) noexcept
+{
+    // The attributes that an SGR reset leaves us with.
+    static const TextAttribute resetAttributes{};
+
+    GraphicsRenditionBuilder incremental;
+    incremental.AppendDelta(_lastTextAttributes, textAttributes);
+
+    if (!incremental.Empty())
+    {
+        GraphicsRenditionBuilder reset;
+        reset.AppendReset();
+        reset.AppendDelta(resetAttributes, textAttributes);
+
+        auto& shortest = reset.Length() < incremental.Length() ? reset : incremental;
+        RETURN_IF_FAILED(_Write(shortest.Sequence()));
+    }
+
+    // We can't copy the attributes as a whole, because we want to retain
+    // the last hyperlink ID, which is handled by _UpdateHyperlinkAttr.
+    _lastTextAttributes.SetForeground(textAttributes.GetForeground());
+    _lastTextAttributes.SetBackground(textAttributes.GetBackground());
+    _lastTextAttributes.SetUnderlineColor(textAttributes.GetUnderlineColor());
+    _lastTextAttributes.SetIntense(textAttributes.IsIntense());
+    _lastTextAttributes.SetFaint(textAttributes.IsFaint());
+    _lastTextAttributes.SetUnderlineStyle(textAttributes.GetUnderlineStyle());
+    _lastTextAttributes.SetOverlined(textAttributes.IsOverlined());
+    _lastTextAttributes.SetItalic(textAttributes.IsItalic());
+    _lastTextAttributes.SetBlinking(textAttributes.IsBlinking());
+    _lastTextAttributes.SetInvisible(textAttributes.IsInvisible());
+    _lastTextAttributes.SetCrossedOut(textAttributes.IsCrossedOut());
+    _lastTextAttributes.SetReverseVideo(textAttributes.IsReverseVideo());
+
+    return S_OK;
 }
 
 // Routine Description:
@@ -38,9 +38,14 @@ namespace Microsoft::Console::Render
 
         [[nodiscard]] HRESULT ManuallyClearScrollback() noexcept override;
 
+        void SetCombineGraphicsRenditions(const bool combine) noexcept;
+
         friend class ::VtApiRoutines;
 
     private:
+        bool _combineGraphicsRenditions{ false };
+
+        [[nodiscard]] HRESULT _UpdateGraphicsRendition(const TextAttribute& textAttributes) noexcept;
         [[nodiscard]] HRESULT _UpdateExtendedAttrs(const TextAttribute& textAttributes) noexcept;
         [[nodiscard]] HRESULT _UpdateHyperlinkAttr(const TextAttribute& textAttributes,
                                                    const gsl::not_null<IRenderData*> pData) noexcept;
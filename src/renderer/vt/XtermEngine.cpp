@@ -64,6 +64,7 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
         //      the screen on the first paint, just to make sure that the
         //      terminal's state is consistent with what we'll be rendering.
         RETURN_IF_FAILED(_ClearScreen());
+        _InvalidateShadowFrame();
         _clearedAllThisFrame = true;
         _firstPaint = false;
     }
@@ -231,6 +232,8 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
 //  If the new cursor is only down one line from the current, only write a newline
 //  If the new cursor is only down one line and at the start of the line, write
 //      a carriage return.
+//  If the shadow frame is enabled and the cursor stays on the same line, write
+//      a CHA if that's shorter than the alternative.
 //  Otherwise just write the whole sequence for moving it.
 // Arguments:
 // - coord: location to move the cursor to.
@@ -309,6 +312,16 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
             std::string seq = "\b";
             hr = _Write(seq);
         }
+        else if (_shadowFrameEnabled && coord.y == _lastText.y &&
+                 (coord.x < _lastText.x || _ParameterLength(coord.x + 1) < _ParameterLength(coord.x - _lastText.x)))
+        {
+            // Same line, and a CHA is shorter than a CUP (backwards) or a CUF (forwards).
+            if (coord.x < _lastText.x)
+            {
+                _needToDisableCursor = true;
+            }
+            hr = _CursorHorizontalAbsolute(coord.x);
+        }
         else if (coord.y == _lastText.y && coord.x > _lastText.x)
         {
             // Same line, forward some distance
@@ -398,6 +411,12 @@ try
         RETURN_IF_FAILED(_InsertLine(absDy));
     }
 
+    // The terminal moved its contents along, so move our copy of them too.
+    if (_shadowFrameEnabled)
+    {
+        _shadowFrame.Scroll(dy);
+    }
+
     // Restore our wrap state.
     _wrappedRow = oldWrappedRow;
     _delayedEolWrap = oldDelayedEolWrap;
@@ -511,7 +530,7 @@ CATCH_RETURN();
 {
     return _fUseAsciiOnly ?
                VtEngine::_PaintAsciiBufferLine(clusters, coord) :
-               VtEngine::_PaintUtf8BufferLine(clusters, coord, lineWrapped);
+               VtEngine::_PaintChangedUtf8BufferLine(clusters, coord, lineWrapped);
 }
 
 // Method Description:
@@ -523,6 +542,8 @@ CATCH_RETURN();
 // - S_OK or suitable HRESULT error from either conversion or writing pipe.
 [[nodiscard]] HRESULT XtermEngine::WriteTerminalW(const std::wstring_view wstr) noexcept
 {
+    // We don't know what the sequence does to the terminal's contents.
+    _InvalidateShadowFrame();
     RETURN_IF_FAILED(_fUseAsciiOnly ?
                          VtEngine::_WriteTerminalAscii(wstr) :
                          VtEngine::_WriteTerminalUtf8(wstr));
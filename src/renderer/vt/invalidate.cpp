@@ -112,6 +112,13 @@ CATCH_RETURN();
     //      end paint to specifically handle this.
     _circled = circled;
 
+    // The terminal will scroll its contents in ways that we don't track
+    // precisely while the buffer circles. Repaint everything afterwards.
+    if (circled)
+    {
+        _InvalidateShadowFrame();
+    }
+
     _trace.TraceTriggerCircling(*pForcePaint);
     return S_OK;
 }
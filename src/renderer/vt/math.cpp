@@ -5,6 +5,8 @@
 
 #include "vtrenderer.hpp"
 
+#include <til/unicode.h>
+
 #pragma hdrstop
 
 using namespace Microsoft::Console::Render;
@@ -87,3 +89,74 @@ bool VtEngine::_WillWriteSingleChar() const
 
     return invalidIsNext || invalidIsLast;
 }
+
+// Routine Description:
+// - Returns the number of characters it takes to print the given number as
+//      a VT sequence parameter.
+// Arguments:
+// - parameter - the parameter to measure
+// Return Value:
+// - the number of decimal digits in the parameter.
+size_t VtEngine::_ParameterLength(const til::CoordType parameter) noexcept
+{
+    size_t length = 1;
+    for (auto remainder = parameter; remainder >= 10; remainder /= 10)
+    {
+        length++;
+    }
+    return length;
+}
+
+// Routine Description:
+// - Returns the number of bytes the given string takes up when it's encoded
+//      in UTF-8, without actually encoding it.
+// Arguments:
+// - str - the UTF-16 string to measure
+// Return Value:
+// - the length of the UTF-8 encoding of the string.
+size_t VtEngine::_Utf8Length(const std::wstring_view str) noexcept
+{
+    size_t length = 0;
+    for (const auto wch : str)
+    {
+        // A surrogate pair is 4 bytes in UTF-8, so each half accounts for 2.
+        length += wch < 0x80 ? 1 : (wch < 0x800 || til::is_surrogate(wch) ? 2 : 3);
+    }
+    return length;
+}
+
+// Routine Description:
+// - Returns the length of the shortest sequence that moves the cursor from
+//      one column to another on the same row: either a CUF for moving forward,
+//      or a CHA, which can move in either direction.
+// Arguments:
+// - from - the column the cursor is currently in
+// - to - the column to move the cursor to
+// Return Value:
+// - the number of bytes it takes to move the cursor.
+size_t VtEngine::_HorizontalMoveLength(const til::CoordType from, const til::CoordType to) noexcept
+{
+    // ESC [ %d G
+    const auto cha = 3 + _ParameterLength(to + 1);
+    if (to <= from)
+    {
+        return cha;
+    }
+    // ESC [ %d C
+    const auto cuf = 3 + _ParameterLength(to - from);
+    return std::min(cha, cuf);
+}
+
+// Routine Description:
+// - Returns the length of the sequences that are needed to erase the given
+//      number of characters instead of printing spaces: an ECH for erasing them
+//      and a CUF for moving the cursor past them.
+// Arguments:
+// - chars - the number of characters to erase
+// Return Value:
+// - the number of bytes it takes to erase the characters.
+size_t VtEngine::_EraseCharacterLength(const til::CoordType chars) noexcept
+{
+    // ESC [ %d X ESC [ %d C
+    return 2 * (3 + _ParameterLength(chars));
+}
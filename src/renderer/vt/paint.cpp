@@ -503,7 +503,11 @@ using namespace Microsoft::Console::Types;
     // GH#13229: ECH and EL don't fill the space with visual attributes like
     // underline, reverse video, hyperlinks, etc. If these spaces had those
     // attrs, then don't try and optimize them out.
-    const auto optimalToUseECH = numSpaces > ERASE_CHARACTER_STRING_LENGTH;
+    // With the shadow frame we're trying to minimize the output, so we compare
+    // against the actual length of the sequences instead.
+    const auto optimalToUseECH = _shadowFrameEnabled ?
+                                     gsl::narrow_cast<size_t>(numSpaces) > _EraseCharacterLength(numSpaces) :
+                                     numSpaces > ERASE_CHARACTER_STRING_LENGTH;
     const auto useEraseChar = (optimalToUseECH) &&
                               (!_newBottomLine) &&
                               (!_clearedAllThisFrame) &&
@@ -614,6 +618,9 @@ using namespace Microsoft::Console::Types;
         _delayedEolWrap = true;
     }
 
+    // Whether the cells of the spaces we didn't print got cleared anyway.
+    auto spacesWritten = !removeSpaces;
+
     if (useEraseChar)
     {
         // ECH doesn't actually move the cursor itself. However, we think that
@@ -627,6 +634,7 @@ using namespace Microsoft::Console::Types;
         if (_deferredCursorPos.x <= _lastViewport.RightInclusive())
         {
             RETURN_IF_FAILED(_EraseCharacter(numSpaces));
+            spacesWritten = true;
         }
         // If we're past the end of the row (i.e. in the "delayed EOL wrap"
         // state), then there is no need to erase the rest of line. In fact
@@ -635,6 +643,7 @@ using namespace Microsoft::Console::Types;
         else if (_lastText.x <= _lastViewport.RightInclusive())
         {
             RETURN_IF_FAILED(_EraseLine());
+            spacesWritten = true;
         }
     }
     else if (_newBottomLine && printingBottomLine)
@@ -650,6 +659,7 @@ using namespace Microsoft::Console::Types;
             // TODO GH#5430 - Determine why and when we would do this.
             auto spaces = std::wstring(numSpaces, L' ');
             RETURN_IF_FAILED(VtEngine::_WriteTerminalUtf8(spaces));
+            spacesWritten = true;
 
             _lastText.x += numSpaces;
         }
@@ -663,9 +673,125 @@ using namespace Microsoft::Console::Types;
         _newBottomLineBG = std::nullopt;
     }
 
+    if (_shadowFrameEnabled)
+    {
+        _RecordShadowFrame(clusters, coord, cchActual, spacesWritten);
+    }
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Draws one line of the buffer to the screen like _PaintUtf8BufferLine, but
+//      skips the clusters the terminal already displays according to the
+//      shadow frame. Each run of changed clusters is painted separately, unless
+//      the unchanged clusters between two runs take fewer bytes to print
+//      again than the cursor movement that would skip over them.
+// Arguments:
+// - clusters - text and column widths to be written
+// - coord - character coordinate target to render within viewport
+// - lineWrapped - true if the line wrapped after the last cluster
+// Return Value:
+// - S_OK or suitable HRESULT error from writing pipe.
+[[nodiscard]] HRESULT VtEngine::_PaintChangedUtf8BufferLine(const std::span<const Cluster> clusters,
+                                                            const til::point coord,
+                                                            const bool lineWrapped) noexcept
+{
+    // After a clear, the shadow frame is all invalid anyway. Don't bother.
+    if (!_UsingShadowFrame() || _clearedAllThisFrame || coord.y < _virtualTop || clusters.empty() || !_shadowFrame.Contains(coord))
+    {
+        return _PaintUtf8BufferLine(clusters, coord, lineWrapped);
+    }
+
+    // GH#4415 - If the previous row wrapped, we have to print the first
+    // cluster of this row without moving the cursor in between, or the
+    // terminal won't wrap the row. Likewise, we have to print the last cluster
+    // of a row that wraps, so that the terminal enters the delayed EOL wrap state.
+    const auto continuesWrappedRow = coord.x == 0 && _wrappedRow.has_value() && coord.y == _wrappedRow.value() + 1;
+    const auto last = clusters.size() - 1;
+
+    // The pending run of changed clusters is [begin, end).
+    size_t begin = 0;
+    size_t end = 0;
+    auto beginX = coord.x;
+    auto endX = coord.x;
+    size_t gapLength = 0;
+
+    auto x = coord.x;
+    for (size_t i = 0; i <= last; ++i)
+    {
+        const auto& cluster = til::at(clusters, i);
+        const auto columns = cluster.GetColumns();
+        const auto changed = (i == 0 && continuesWrappedRow) ||
+                             (i == last && lineWrapped) ||
+                             !_shadowFrame.Matches({ x, coord.y }, cluster, _lastTextAttributes);
+
+        if (changed)
+        {
+            if (begin == end || gapLength > _HorizontalMoveLength(endX, x))
+            {
+                if (begin != end)
+                {
+                    RETURN_IF_FAILED(_PaintUtf8BufferLine(clusters.subspan(begin, end - begin), { beginX, coord.y }, false));
+                }
+                begin = i;
+                beginX = x;
+            }
+            end = i + 1;
+            endX = x + columns;
+            gapLength = 0;
+        }
+        else if (begin != end)
+        {
+            gapLength += _Utf8Length(cluster.GetText());
+        }
+
+        x += columns;
+    }
+
+    if (begin != end)
+    {
+        RETURN_IF_FAILED(_PaintUtf8BufferLine(clusters.subspan(begin, end - begin), { beginX, coord.y }, lineWrapped && end == clusters.size()));
+    }
+
     return S_OK;
 }
 
+// Routine Description:
+// - Stores the clusters that _PaintUtf8BufferLine just emitted in the shadow
+//      frame. Trailing spaces that were neither printed nor erased are
+//      invalidated instead, since we don't know what the terminal shows there.
+// Arguments:
+// - clusters - text and column widths that were painted
+// - coord - character coordinate the clusters were painted at
+// - cchWritten - the number of characters of the clusters that were printed
+// - spacesWritten - true if the cells beyond cchWritten were cleared anyway
+// Return Value:
+// - <none>
+void VtEngine::_RecordShadowFrame(const std::span<const Cluster> clusters,
+                                  const til::point coord,
+                                  const size_t cchWritten,
+                                  const bool spacesWritten) noexcept
+{
+    const auto trackable = _UsingShadowFrame();
+    auto target = coord;
+    size_t cch = 0;
+
+    for (const auto& cluster : clusters)
+    {
+        cch += cluster.GetText().size();
+        if (trackable && (cch <= cchWritten || spacesWritten))
+        {
+            _shadowFrame.Record(target, cluster, _lastTextAttributes);
+        }
+        else
+        {
+            _shadowFrame.Invalidate(target, cluster.GetColumns());
+        }
+        target.x += cluster.GetColumns();
+    }
+}
+
 // Method Description:
 // - Updates the window's title string. Emits the VT sequence to SetWindowTitle.
 //      Because wintelnet does not understand these sequences by default, we
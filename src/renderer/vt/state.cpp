@@ -173,6 +173,8 @@ void VtEngine::Cork(bool corked) noexcept
 // - Wrapper for _Write.
 [[nodiscard]] HRESULT VtEngine::WriteTerminalUtf8(const std::string_view str) noexcept
 {
+    // We don't know what the string does to the terminal's contents.
+    _InvalidateShadowFrame();
     return _Write(str);
 }
 
@@ -311,6 +313,19 @@ void VtEngine::Cork(bool corked) noexcept
         }
 
         _resized = true;
+
+        if (_shadowFrameEnabled)
+        {
+            try
+            {
+                _shadowFrame.Reset(newSize);
+            }
+            catch (...)
+            {
+                LOG_CAUGHT_EXCEPTION();
+                _shadowFrameEnabled = false;
+            }
+        }
     }
 
     // See MSFT:19408543
@@ -487,6 +502,54 @@ void VtEngine::SetPassthroughMode(const bool passthrough) noexcept
     _passthrough = passthrough;
 }
 
+// Method Description:
+// - Configure the renderer to keep a copy of the frame that was last emitted to
+//   the terminal. Rows are then compared against it while painting, so that
+//   only the cells that actually changed are emitted, and cursor movements are
+//   picked by their length. This requires that nothing else modifies the
+//   terminal's contents behind our back, which is why it's not used in
+//   passthrough mode.
+// Arguments:
+// - enabled - True to turn on the shadow frame. False otherwise.
+// Return Value:
+// - <none>
+void VtEngine::SetShadowFrame(const bool enabled)
+{
+    if (enabled)
+    {
+        _shadowFrame.Reset(_lastViewport.Dimensions());
+    }
+    _shadowFrameEnabled = enabled;
+}
+
+// Method Description:
+// - Returns true if the rows we paint should be compared against the shadow
+//   frame. Text drawn with line renditions or a soft font doesn't map onto
+//   the cells of the shadow frame, so we stop tracking it while those are used.
+// Arguments:
+// - <none>
+// Return Value:
+// - true iff PaintBufferLine should only emit the changed parts of a row.
+bool VtEngine::_UsingShadowFrame() const noexcept
+{
+    return _shadowFrameEnabled && !_passthrough && !_usingLineRenditions && !_usingSoftFont;
+}
+
+// Method Description:
+// - Forgets the contents of the shadow frame, so that the next paint of any
+//   cell is emitted regardless of what we last sent to the terminal.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtEngine::_InvalidateShadowFrame() noexcept
+{
+    if (_shadowFrameEnabled)
+    {
+        _shadowFrame.InvalidateAll();
+    }
+}
+
 void VtEngine::SetLookingForDSRCallback(std::function<void(bool)> pfnLooking) noexcept
 {
     _pfnSetLookingForDSR = pfnLooking;
@@ -536,6 +599,7 @@ HRESULT VtEngine::RequestWin32Input() noexcept
 
 HRESULT VtEngine::SwitchScreenBuffer(const bool useAltBuffer) noexcept
 {
+    _InvalidateShadowFrame();
     RETURN_IF_FAILED(_SwitchScreenBuffer(useAltBuffer));
     _Flush();
     return S_OK;
@@ -18,6 +18,7 @@ Author(s):
 #include "../inc/RenderEngineBase.hpp"
 #include "../../types/inc/Viewport.hpp"
 #include "tracing.hpp"
+#include "ShadowFrame.hpp"
 #include <string>
 #include <functional>
 
@@ -84,6 +85,7 @@ namespace Microsoft::Console::Render
         void EndResizeRequest();
         void SetResizeQuirk(const bool resizeQuirk);
         void SetPassthroughMode(const bool passthrough) noexcept;
+        void SetShadowFrame(const bool enabled);
         void SetLookingForDSRCallback(std::function<void(bool)> pfnLooking) noexcept;
         void SetTerminalCursorTextPosition(const til::point coordCursor) noexcept;
         [[nodiscard]] virtual HRESULT ManuallyClearScrollback() noexcept;
@@ -142,6 +144,9 @@ namespace Microsoft::Console::Render
         bool _corked{ false };
         std::optional<TextColor> _newBottomLineBG{ std::nullopt };
 
+        ShadowFrame _shadowFrame;
+        bool _shadowFrameEnabled{ false };
+
         [[nodiscard]] HRESULT _WriteFill(const size_t n, const char c) noexcept;
         [[nodiscard]] HRESULT _Write(std::string_view const str) noexcept;
         void _Flush() noexcept;
@@ -169,6 +174,7 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT _DeleteLine(const til::CoordType sLines) noexcept;
         [[nodiscard]] HRESULT _InsertLine(const til::CoordType sLines) noexcept;
         [[nodiscard]] HRESULT _CursorForward(const til::CoordType chars) noexcept;
+        [[nodiscard]] HRESULT _CursorHorizontalAbsolute(const til::CoordType column) noexcept;
         [[nodiscard]] HRESULT _EraseCharacter(const til::CoordType chars) noexcept;
         [[nodiscard]] HRESULT _CursorPosition(const til::point coord) noexcept;
         [[nodiscard]] HRESULT _CursorHome() noexcept;
@@ -219,6 +225,18 @@ namespace Microsoft::Console::Render
 
         bool _WillWriteSingleChar() const;
 
+        static size_t _ParameterLength(const til::CoordType parameter) noexcept;
+        static size_t _Utf8Length(const std::wstring_view str) noexcept;
+        static size_t _HorizontalMoveLength(const til::CoordType from, const til::CoordType to) noexcept;
+        static size_t _EraseCharacterLength(const til::CoordType chars) noexcept;
+
+        bool _UsingShadowFrame() const noexcept;
+        void _InvalidateShadowFrame() noexcept;
+        void _RecordShadowFrame(const std::span<const Cluster> clusters,
+                                const til::point coord,
+                                const size_t cchWritten,
+                                const bool spacesWritten) noexcept;
+
         // buffer space for these two functions to build their lines
         // so they don't have to alloc/free in a tight loop
         std::wstring _bufferLine;
@@ -226,6 +244,10 @@ namespace Microsoft::Console::Render
                                                    const til::point coord,
                                                    const bool lineWrapped) noexcept;
 
+        [[nodiscard]] HRESULT _PaintChangedUtf8BufferLine(const std::span<const Cluster> clusters,
+                                                          const til::point coord,
+                                                          const bool lineWrapped) noexcept;
+
         [[nodiscard]] HRESULT _PaintAsciiBufferLine(const std::span<const Cluster> clusters,
                                                     const til::point coord) noexcept;
 
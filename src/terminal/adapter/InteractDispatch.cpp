@@ -15,7 +15,6 @@
 #include "InteractDispatch.hpp"
 #include "../../host/conddkrefs.h"
 #include "../../interactivity/inc/ServiceLocator.hpp"
-#include "../../interactivity/inc/EventSynthesis.hpp"
 #include "../../types/inc/Viewport.hpp"
 
 using namespace Microsoft::Console::Interactivity;
@@ -67,15 +66,9 @@ bool InteractDispatch::WriteString(const std::wstring_view string)
 {
     if (!string.empty())
     {
-        const auto codepage = _api.GetConsoleOutputCP();
-        InputEventQueue keyEvents;
-
-        for (const auto& wch : string)
-        {
-            CharToKeyEvents(wch, codepage, keyEvents);
-        }
-
-        WriteInput(keyEvents);
+        // The input buffer only turns the string into key events if a client reads INPUT_RECORDs.
+        const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        gci.GetActiveInputBuffer()->WriteString(string, _api.GetConsoleOutputCP());
     }
     return true;
 }
@@ -3170,6 +3170,8 @@ bool AdaptDispatch::_EraseScrollback()
     _FillRect(textBuffer, { 0, height, bufferSize.width, bufferSize.height }, whitespace, {});
     // Also reset the line rendition for all of the cleared rows.
     textBuffer.ResetLineRenditionRange(height, bufferSize.height);
+    // The cleared rows don't need to stay committed.
+    textBuffer.DecommitBlankRows();
     // Move the viewport
     _api.SetViewportPosition({ viewport.left, 0 });
     // Move the cursor to the same relative location.
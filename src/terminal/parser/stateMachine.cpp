@@ -2114,6 +2114,17 @@ void StateMachine::ProcessString(const std::wstring_view string)
             break;
         }
 
+        // Most escape sequences in typical output are simple, complete CSI sequences like SGR
+        // and cursor movement. Those can be parsed in a single pass without the state machine.
+        if (_state == VTStates::Ground && til::at(string, i) == AsciiChars::ESC)
+        {
+            if (const auto length = _TryProcessCsiFast(string, i))
+            {
+                i += length;
+                continue;
+            }
+        }
+
         do
         {
             _runSize++;
@@ -2209,6 +2220,43 @@ void StateMachine::ProcessString(const std::wstring_view string)
     }
 }
 
+// Routine Description:
+// - Same as ProcessString, but for UTF-8 input, like what ConPTY and VT input
+//   receive from their pipes. Instead of converting all of the input to UTF-16
+//   upfront, which doubles the memory traffic for large writes, the input is
+//   converted in chunks into a buffer that's reused across calls. Each chunk
+//   is processed by ProcessString before the next one is converted.
+// - Partial UTF-8 sequences at the end of the input are stored in `state`
+//   and completed by the next call.
+// - Input engines rely on each write being processed as a whole (see the end
+//   of ProcessString), which is why their input is never split up.
+// Arguments:
+// - string - UTF-8 characters to operate upon
+// - state - holds partial UTF-8 sequences across calls
+// Return Value:
+// - S_OK, or the failure of the conversion to UTF-16, in which case the rest
+//   of the input is discarded. Invalid UTF-8 is replaced with U+FFFD and
+//   isn't a failure. Exceptions thrown while processing are propagated.
+[[nodiscard]] HRESULT StateMachine::ProcessUtf8(const std::string_view string, til::u8state& state)
+{
+    // 16KiB of UTF-8 turn into at most 32KiB of UTF-16.
+    static constexpr size_t chunkSize = 16 * 1024;
+
+    const auto step = _isEngineForInput ? string.size() : chunkSize;
+
+    for (size_t i = 0; i < string.size(); i += step)
+    {
+        RETURN_IF_FAILED(til::u8u16(string.substr(i, step), _utf8Buffer, state));
+        // The chunk may have consisted of nothing but a partial UTF-8 sequence.
+        if (!_utf8Buffer.empty())
+        {
+            ProcessString(_utf8Buffer);
+        }
+    }
+
+    return S_OK;
+}
+
 // Routine Description:
 // - Determines whether the character being processed is the last in the
 //   current output fragment, or there are more still to come. Other parts
@@ -2270,6 +2318,115 @@ void StateMachine::_AccumulateTo(const wchar_t wch, VTInt& value) noexcept
     }
 }
 
+// Routine Description:
+// - Parses and dispatches a complete CSI sequence in the form of
+//     ESC [ [<=>?] [0-9;]* final
+//   directly from the given string, without feeding it through the state machine
+//   one character at a time. This covers the vast majority of sequences found in
+//   typical output, like SGR, CUP, EL, etc.
+// - Sequences with intermediates, sub parameters, embedded control characters,
+//   or sequences that are split across multiple strings aren't handled here.
+//   The caller is expected to process those with ProcessCharacter instead.
+// - The resulting dispatch is identical to what the state machine would produce.
+// Arguments:
+// - string - The string that is currently being processed.
+// - offset - The offset of the ESC character within the string.
+// Return Value:
+// - The length of the processed sequence, or 0 if it wasn't processed.
+size_t StateMachine::_TryProcessCsiFast(const std::wstring_view string, const size_t offset)
+{
+    if (_isEngineForInput || !_parserMode.test(Mode::Ansi))
+    {
+        return 0;
+    }
+
+    // ESC, [, and at least the final character.
+    const auto size = string.size();
+    if (size - offset < 3 || til::at(string, offset) != AsciiChars::ESC || til::at(string, offset + 1) != L'[')
+    {
+        return 0;
+    }
+
+    // First we ensure that the whole sequence is well-formed before modifying any state,
+    // so that we can bail out at any point and leave it to the state machine.
+    const auto paramsBeg = offset + 2 + (_isCsiPrivateMarker(til::at(string, offset + 2)) ? 1 : 0);
+    auto paramsEnd = paramsBeg;
+    for (; paramsEnd < size; ++paramsEnd)
+    {
+        const auto wch = til::at(string, paramsEnd);
+        if (!_isNumericParamValue(wch) && !_isParameterDelimiter(wch))
+        {
+            break;
+        }
+    }
+
+    // The final character must be in the range 0x40 - 0x7E.
+    // Everything else (C0 controls, intermediates, sub parameters, etc.) requires the state machine.
+    if (paramsEnd >= size)
+    {
+        return 0;
+    }
+    const auto finalChar = til::at(string, paramsEnd);
+    if (finalChar < L'@' || finalChar > L'~')
+    {
+        return 0;
+    }
+
+    const auto length = paramsEnd + 1 - offset;
+    _runOffset = offset;
+    _runSize = length;
+    _processingLastCharacter = offset + length >= size;
+
+    _trace.ClearSequenceTrace();
+    _trace.AddSequenceTrace(string.substr(offset, length));
+    _ActionClear();
+
+    if (paramsBeg != offset + 2)
+    {
+        _ActionCollect(til::at(string, offset + 2));
+    }
+
+    // This replicates _ActionParam, including its handling of the parameter count
+    // and value limits. An empty parameter string results in no parameters at all.
+    if (paramsBeg != paramsEnd)
+    {
+        VTInt value = 0;
+        auto hasValue = false;
+
+        for (auto i = paramsBeg;; ++i)
+        {
+            const auto wch = i < paramsEnd ? til::at(string, i) : L';';
+            if (_isParameterDelimiter(wch))
+            {
+                _parameters.push_back(hasValue ? VTParameter{ value } : VTParameter{});
+                _subParameterRanges.push_back({ 0, 0 });
+                value = 0;
+                hasValue = false;
+
+                if (i >= paramsEnd)
+                {
+                    break;
+                }
+                if (_parameters.size() >= MAX_PARAMETER_COUNT)
+                {
+                    _parameterLimitOverflowed = true;
+                    break;
+                }
+            }
+            else
+            {
+                value = std::min(value * 10 + (wch - L'0'), MAX_PARAMETER_VALUE);
+                hasValue = true;
+            }
+        }
+    }
+
+    _ActionCsiDispatch(finalChar);
+    _EnterGround();
+    _ExecuteCsiCompleteCallback();
+    return length;
+}
+
 template<typename TLambda>
 bool StateMachine::_SafeExecute(TLambda&& lambda)
 try
@@ -64,6 +64,7 @@ namespace Microsoft::Console::VirtualTerminal
 
         void ProcessCharacter(const wchar_t wch);
         void ProcessString(const std::wstring_view string);
+        [[nodiscard]] HRESULT ProcessUtf8(const std::string_view string, til::u8state& state);
         bool IsProcessingLastCharacter() const noexcept;
 
         void OnCsiComplete(const std::function<void()> callback);
@@ -147,6 +148,8 @@ namespace Microsoft::Console::VirtualTerminal
 
         void _AccumulateTo(const wchar_t wch, VTInt& value) noexcept;
 
+        size_t _TryProcessCsiFast(const std::wstring_view string, const size_t offset);
+
         template<typename TLambda>
         bool _SafeExecute(TLambda&& lambda);
 
@@ -213,6 +216,10 @@ namespace Microsoft::Console::VirtualTerminal
 
         std::optional<std::wstring> _cachedSequence;
 
+        // Scratch space for ProcessUtf8(), which transcodes its input in
+        // chunks that are small enough to stay in the CPU caches.
+        std::wstring _utf8Buffer;
+
         // This is tracked per state machine instance so that separate calls to Process*
         //   can start and finish a sequence.
         bool _processingLastCharacter;
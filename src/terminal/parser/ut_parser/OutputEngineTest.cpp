@@ -45,10 +45,179 @@ public:
     }
 };
 
+// Records every action as a line of text, so that the output of two state machines can be compared.
+// Consecutive print actions are merged, since it depends on how the input was split whether
+// a run of text gets printed in one or more pieces.
+class RecordingEngine final : public IStateMachineEngine
+{
+public:
+    bool ActionExecute(const wchar_t wch) override
+    {
+        _record(L"Execute", std::to_wstring(wch));
+        return true;
+    }
+
+    bool ActionExecuteFromEscape(const wchar_t wch) override
+    {
+        _record(L"ExecuteFromEscape", std::to_wstring(wch));
+        return true;
+    }
+
+    bool ActionPrint(const wchar_t wch) override
+    {
+        return ActionPrintString({ &wch, 1 });
+    }
+
+    bool ActionPrintString(const std::wstring_view string) override
+    {
+        if (!_lastWasPrint)
+        {
+            log.append(L"\nPrint ");
+            _lastWasPrint = true;
+        }
+        log.append(string);
+        return true;
+    }
+
+    bool ActionPassThroughString(const std::wstring_view string) override
+    {
+        _record(L"PassThrough", std::wstring{ string });
+        return true;
+    }
+
+    bool ActionEscDispatch(const VTID id) override
+    {
+        _record(L"EscDispatch", std::to_wstring(static_cast<uint64_t>(id)));
+        return true;
+    }
+
+    bool ActionVt52EscDispatch(const VTID id, const VTParameters parameters) override
+    {
+        _record(L"Vt52EscDispatch", _format(id, parameters));
+        return true;
+    }
+
+    bool ActionCsiDispatch(const VTID id, const VTParameters parameters) override
+    {
+        _record(L"CsiDispatch", _format(id, parameters));
+        return true;
+    }
+
+    StringHandler ActionDcsDispatch(const VTID id, const VTParameters parameters) override
+    {
+        _record(L"DcsDispatch", _format(id, parameters));
+        return nullptr;
+    }
+
+    bool ActionClear() override
+    {
+        return true;
+    }
+
+    bool ActionIgnore() override
+    {
+        return true;
+    }
+
+    bool ActionOscDispatch(const wchar_t /*wch*/, const size_t parameter, const std::wstring_view string) override
+    {
+        _record(L"OscDispatch", std::to_wstring(parameter) + L";" + std::wstring{ string });
+        return true;
+    }
+
+    bool ActionSs3Dispatch(const wchar_t wch, const VTParameters parameters) override
+    {
+        _record(L"Ss3Dispatch", _format(wch, parameters));
+        return true;
+    }
+
+    std::wstring log;
+
+private:
+    void _record(const std::wstring_view action, const std::wstring_view details)
+    {
+        log.append(L"\n");
+        log.append(action);
+        log.append(L" ");
+        log.append(details);
+        _lastWasPrint = false;
+    }
+
+    static std::wstring _format(const VTID id, const VTParameters parameters)
+    {
+        auto str = std::to_wstring(static_cast<uint64_t>(id));
+        if (parameters.empty())
+        {
+            return str;
+        }
+
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            str.append(i ? L";" : L" ");
+            str.append(std::to_wstring(parameters.at(i).value()));
+
+            const auto subParams = parameters.subParamsFor(i);
+            for (size_t j = 0; j < subParams.size(); ++j)
+            {
+                str.append(L":");
+                str.append(std::to_wstring(subParams.at(j).value()));
+            }
+        }
+        return str;
+    }
+
+    bool _lastWasPrint = false;
+};
+
 class Microsoft::Console::VirtualTerminal::OutputEngineTest final
 {
     TEST_CLASS(OutputEngineTest);
 
+    // Processes the input in chunks of the given size with ProcessString() and returns what the engine recorded.
+    static std::wstring _process(const std::wstring_view input, const size_t chunkSize)
+    {
+        auto engine = std::make_unique<RecordingEngine>();
+        const auto& log = engine->log;
+        StateMachine mach(std::move(engine));
+
+        for (size_t i = 0; i < input.size(); i += chunkSize)
+        {
+            mach.ProcessString(input.substr(i, chunkSize));
+        }
+
+        return log;
+    }
+
+    // Same as above, but splits the input into two pieces at the given offset.
+    static std::wstring _processSplit(const std::wstring_view input, const size_t split)
+    {
+        auto engine = std::make_unique<RecordingEngine>();
+        const auto& log = engine->log;
+        StateMachine mach(std::move(engine));
+
+        mach.ProcessString(input.substr(0, split));
+        mach.ProcessString(input.substr(split));
+
+        return log;
+    }
+
+    static std::wstring _escape(const std::wstring_view input)
+    {
+        std::wstring str;
+        for (const auto ch : input)
+        {
+            if (ch < 0x20 || ch >= 0x7f)
+            {
+                fmt::format_to(std::back_inserter(str), FMT_COMPILE(L"\\x{:02x}"), static_cast<unsigned int>(ch));
+            }
+            else
+            {
+                str.push_back(ch);
+            }
+        }
+        return str;
+    }
+
     TEST_METHOD(TestEscapePath)
     {
         BEGIN_TEST_METHOD_PROPERTIES()
@@ -564,6 +733,82 @@ class Microsoft::Console::VirtualTerminal::OutputEngineTest final
         VERIFY_ARE_EQUAL(mach._state, StateMachine::VTStates::Ground);
     }
 
+    TEST_METHOD(TestCsiFastPathCoverage)
+    {
+        auto engine = std::make_unique<RecordingEngine>();
+        StateMachine mach(std::move(engine));
+
+        Log::Comment(L"Complete sequences without intermediates and sub parameters are parsed in one go");
+        VERIFY_ARE_EQUAL(3u, mach._TryProcessCsiFast(L"\x1b[m", 0));
+        VERIFY_ARE_EQUAL(6u, mach._TryProcessCsiFast(L"\x1b[;;5m", 0));
+        VERIFY_ARE_EQUAL(6u, mach._TryProcessCsiFast(L"\x1b[?25lfoo", 0));
+        VERIFY_ARE_EQUAL(5u, mach._TryProcessCsiFast(L"foo\x1b[12H", 3));
+        VERIFY_ARE_EQUAL(StateMachine::VTStates::Ground, mach._state);
+
+        Log::Comment(L"Everything else is left to the state machine");
+        VERIFY_ARE_EQUAL(0u, mach._TryProcessCsiFast(L"\x1b[", 0));
+        VERIFY_ARE_EQUAL(0u, mach._TryProcessCsiFast(L"\x1b[12", 0));
+        VERIFY_ARE_EQUAL(0u, mach._TryProcessCsiFast(L"\x1bM", 0));
+        VERIFY_ARE_EQUAL(0u, mach._TryProcessCsiFast(L"\x1b[38:5:1m", 0));
+        VERIFY_ARE_EQUAL(0u, mach._TryProcessCsiFast(L"\x1b[1$p", 0));
+        VERIFY_ARE_EQUAL(0u, mach._TryProcessCsiFast(L"\x1b[1?h", 0));
+        VERIFY_ARE_EQUAL(0u, mach._TryProcessCsiFast(L"\x1b[1\nH", 0));
+        VERIFY_ARE_EQUAL(0u, mach._TryProcessCsiFast(L"\x1b[1\x7fH", 0));
+        VERIFY_ARE_EQUAL(0u, mach._TryProcessCsiFast(L"\x1b[1\u00e9", 0));
+
+        Log::Comment(L"...including VT52 mode, where ESC [ is not a CSI");
+        mach.SetParserMode(StateMachine::Mode::Ansi, false);
+        VERIFY_ARE_EQUAL(0u, mach._TryProcessCsiFast(L"\x1b[m", 0));
+    }
+
+    TEST_METHOD(TestCsiFastPathEquivalence)
+    {
+        std::wstring manyParams = L"\x1b[";
+        for (auto i = 0; i < 100; ++i)
+        {
+            manyParams.append(std::to_wstring(i));
+            manyParams.push_back(L';');
+        }
+        manyParams.push_back(L'm');
+
+        const std::wstring inputs[]{
+            L"\x1b[m",
+            L"\x1b[0m",
+            L"\x1b[1;31mred\x1b[0m plain",
+            L"\x1b[;m\x1b[;;5;m\x1b[;",
+            L"\x1b[?25l\x1b[?1049h\x1b[>c\x1b[=5u",
+            L"\x1b[38;5;123m\x1b[48;2;1;2;3m",
+            L"\x1b[12;34H\x1b[2J\x1b[H\x1b[K",
+            L"\x1b[0000000000000000000000000001m\x1b[99999999999m",
+            L"\x1b[38:2::1:2:3m\x1b[4:3m",
+            L"\x1b[1$p\x1b[0 q\x1b[!p",
+            L"\x1b[1\n2H\x1b[\r;3H",
+            L"\x1b[1?m\x1b[?1;?2h",
+            L"\x1b[\x7f" L"1m\x1b[1\x18m\x1b[1\x1b[2m",
+            L"\x1b[1\u00e9\x1b[2\x9bm",
+            L"\x1b]0;title\x07\x1b[m\x1bP1$r\x1b\\\x1b[m",
+            L"\x1b" L"7\x1b[1;2r\x1b" L"8\x1b(0",
+            manyParams,
+        };
+
+        for (const auto& input : inputs)
+        {
+            Log::Comment(NoThrowString().Format(L"Input: \"%s\"", _escape(input).c_str()));
+
+            // The fast path needs at least 3 characters to work with, so feeding
+            // the input one character at a time serves as the reference.
+            const auto expected = _process(input, 1);
+
+            VERIFY_ARE_EQUAL(expected, _process(input, input.size()));
+
+            // The fast path must bail out for sequences that are split across strings.
+            for (size_t split = 1; split < input.size(); ++split)
+            {
+                VERIFY_ARE_EQUAL(expected, _processSplit(input, split));
+            }
+        }
+    }
+
     TEST_METHOD(TestC1Osc)
     {
         auto dispatch = std::make_unique<DummyDispatch>();
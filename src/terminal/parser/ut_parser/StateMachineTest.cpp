@@ -155,6 +155,7 @@ class Microsoft::Console::VirtualTerminal::StateMachineTest
     TEST_METHOD(RunStorageBeforeEscape);
     TEST_METHOD(BulkTextPrint);
     TEST_METHOD(PassThroughUnhandledSplitAcrossWrites);
+    TEST_METHOD(ProcessUtf8AcrossChunks);
 
     TEST_METHOD(DcsDataStringsReceivedByHandler);
 
@@ -277,6 +278,40 @@ void StateMachineTest::PassThroughUnhandledSplitAcrossWrites()
     VERIFY_ARE_EQUAL(L"", engine.printed);
 }
 
+void StateMachineTest::ProcessUtf8AcrossChunks()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // ProcessUtf8 converts its input in chunks of 16KiB. Make sure that
+    // neither escape sequences nor UTF-8 sequences get torn apart by that.
+    const size_t prefixLength = 16 * 1024 - 3;
+    std::string u8{};
+    u8.append(prefixLength, 'a');
+    u8.append("\x1b[12;34m"); // straddles the first chunk boundary
+    for (auto i = 0; i < 10000; ++i)
+    {
+        u8.append("\xe2\x82\xac"); // EURO SIGN; one of these straddles the second chunk boundary
+    }
+    u8.append("z");
+
+    std::wstring expected{};
+    expected.append(prefixLength, L'a');
+    expected.append(10000, L'\u20ac');
+    expected.append(L"z");
+
+    // Split the last EURO SIGN across two calls.
+    til::u8state state{};
+    const std::string_view view{ u8 };
+    VERIFY_SUCCEEDED(machine.ProcessUtf8(view.substr(0, u8.size() - 2), state));
+    VERIFY_SUCCEEDED(machine.ProcessUtf8(view.substr(u8.size() - 2), state));
+
+    VERIFY_ARE_EQUAL(expected, engine.printed);
+    VERIFY_ARE_EQUAL((std::vector<size_t>{ 12u, 34u }), engine.csiParams);
+}
+
 void StateMachineTest::DcsDataStringsReceivedByHandler()
 {
     BEGIN_TEST_METHOD_PROPERTIES()
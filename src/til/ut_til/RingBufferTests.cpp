@@ -0,0 +1,174 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include <til/ring_buffer.h>
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class RingBufferTests
+{
+    TEST_CLASS(RingBufferTests);
+
+    static void VerifyContents(const til::ring_buffer<int>& ring, const std::vector<int>& expected)
+    {
+        VERIFY_ARE_EQUAL(expected.size(), ring.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(expected[i], ring[i]);
+        }
+
+        std::vector<int> actual;
+        for (const auto& segment : ring.segments())
+        {
+            actual.insert(actual.end(), segment.begin(), segment.end());
+        }
+        VERIFY_IS_TRUE(expected == actual);
+    }
+
+    // Fills the ring such that its contents wrap around the end of its allocation.
+    static void FillWrapped(til::ring_buffer<int>& ring, std::vector<int>& expected)
+    {
+        for (auto i = 0; i < 12; ++i)
+        {
+            ring.push_back(i);
+        }
+        ring.pop_front(10);
+        for (auto i = 12; i < 24; ++i)
+        {
+            ring.push_back(i);
+        }
+
+        expected = { 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23 };
+        VERIFY_ARE_EQUAL(til::ring_buffer<int>::initial_capacity, ring.capacity());
+        VERIFY_IS_FALSE(ring.segments()[1].empty());
+    }
+
+    TEST_METHOD(PushAndPop)
+    {
+        til::ring_buffer<int> ring;
+        VERIFY_IS_TRUE(ring.empty());
+        VERIFY_ARE_EQUAL(0u, ring.capacity());
+
+        std::vector<int> expected;
+        FillWrapped(ring, expected);
+        VerifyContents(ring, expected);
+        VERIFY_ARE_EQUAL(10, ring.front());
+        VERIFY_ARE_EQUAL(23, ring.back());
+
+        std::array<int, 4> target{};
+        VERIFY_ARE_EQUAL(4u, ring.copy_front(target));
+        VERIFY_IS_TRUE((target == std::array{ 10, 11, 12, 13 }));
+        VERIFY_ARE_EQUAL(expected.size(), ring.size());
+
+        VERIFY_ARE_EQUAL(4u, ring.pop_front(target));
+        expected.erase(expected.begin(), expected.begin() + 4);
+        VerifyContents(ring, expected);
+
+        std::vector<int> rest(100);
+        VERIFY_ARE_EQUAL(expected.size(), ring.pop_front(rest));
+        VERIFY_IS_TRUE(ring.empty());
+    }
+
+    TEST_METHOD(GrowUnwrapsContents)
+    {
+        til::ring_buffer<int> ring;
+        std::vector<int> expected;
+        FillWrapped(ring, expected);
+
+        const std::vector<int> items{ 100, 101, 102, 103, 104 };
+        ring.append(items);
+        expected.insert(expected.end(), items.begin(), items.end());
+
+        VERIFY_ARE_EQUAL(32u, ring.capacity());
+        VERIFY_IS_TRUE(ring.segments()[1].empty());
+        VerifyContents(ring, expected);
+    }
+
+    TEST_METHOD(InsertAndErase)
+    {
+        til::ring_buffer<int> ring;
+        std::vector<int> expected;
+        FillWrapped(ring, expected);
+
+        const std::vector<int> items{ 100, 101 };
+        ring.insert(3, items);
+        expected.insert(expected.begin() + 3, items.begin(), items.end());
+        VerifyContents(ring, expected);
+
+        ring.erase(4);
+        expected.erase(expected.begin() + 4);
+        VerifyContents(ring, expected);
+
+        ring.insert(ring.size(), items);
+        expected.insert(expected.end(), items.begin(), items.end());
+        VerifyContents(ring, expected);
+    }
+
+    TEST_METHOD(EraseIf)
+    {
+        til::ring_buffer<int> ring;
+        std::vector<int> expected;
+        FillWrapped(ring, expected);
+
+        const auto isOdd = [](int i) { return i % 2 != 0; };
+        VERIFY_ARE_EQUAL(7u, ring.erase_if(isOdd));
+        std::erase_if(expected, isOdd);
+        VerifyContents(ring, expected);
+    }
+
+    TEST_METHOD(Swap)
+    {
+        til::ring_buffer<int> a;
+        til::ring_buffer<int> b;
+        std::vector<int> expected;
+        FillWrapped(a, expected);
+
+        a.swap(b);
+        VERIFY_IS_TRUE(a.empty());
+        VerifyContents(b, expected);
+
+        a = std::move(b);
+        VERIFY_IS_TRUE(b.empty());
+        VerifyContents(a, expected);
+    }
+
+    TEST_METHOD(ShrinkToFit)
+    {
+        til::ring_buffer<int> ring;
+        std::vector<int> expected;
+        for (auto i = 0; i < 100; ++i)
+        {
+            ring.push_back(i);
+            expected.emplace_back(i);
+        }
+        VERIFY_ARE_EQUAL(128u, ring.capacity());
+
+        // Nothing to shrink yet.
+        ring.shrink_to_fit();
+        VERIFY_ARE_EQUAL(128u, ring.capacity());
+
+        ring.pop_front(90);
+        expected.erase(expected.begin(), expected.begin() + 90);
+        ring.shrink_to_fit();
+        VERIFY_ARE_EQUAL(til::ring_buffer<int>::initial_capacity, ring.capacity());
+        VerifyContents(ring, expected);
+
+        // Wrapped contents end up in a single segment.
+        ring.clear();
+        FillWrapped(ring, expected);
+        ring.reserve(64);
+        ring.shrink_to_fit();
+        VERIFY_ARE_EQUAL(til::ring_buffer<int>::initial_capacity, ring.capacity());
+        VerifyContents(ring, expected);
+
+        ring.clear();
+        ring.shrink_to_fit();
+        VERIFY_ARE_EQUAL(0u, ring.capacity());
+        ring.push_back(42);
+        VerifyContents(ring, { 42 });
+    }
+};
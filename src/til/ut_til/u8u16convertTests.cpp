@@ -17,6 +17,9 @@ class Utf8Utf16ConvertTests
     TEST_METHOD(TestU8ToU16Partials);
     TEST_METHOD(TestU16ToU8Partials);
     TEST_METHOD(TestU8ToU16OneByOne);
+    TEST_METHOD(TestU8ToU16Invalid);
+    TEST_METHOD(TestU16ToU8Invalid);
+    TEST_METHOD(TestLongMixedStrings);
 };
 
 void Utf8Utf16ConvertTests::TestU8ToU16()
@@ -191,3 +194,66 @@ void Utf8Utf16ConvertTests::TestU8ToU16OneByOne()
     VERIFY_SUCCEEDED(til::u8u16(u8String1_4, u16Out1, state));
     VERIFY_ARE_EQUAL(u16StringComp1, u16Out1);
 }
+
+void Utf8Utf16ConvertTests::TestU8ToU16Invalid()
+{
+    // Every maximal subpart of an ill-formed sequence is replaced with a single U+FFFD.
+    // The examples are taken from table 3-8 in chapter 3.9 of the Unicode Standard.
+    const std::string u8String{ "a\x80\xc0\xaf\xe0\x80\xaf\xed\xa0\x80\xf4\x90\x80\x80\xe1\x80\xe2\xf0\x91\x92\xf1\xbf\x41" };
+    const std::wstring u16StringComp{ L"a\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\u0041" };
+
+    std::wstring u16Out{};
+    VERIFY_SUCCEEDED(til::u8u16(u8String, u16Out));
+    VERIFY_ARE_EQUAL(u16StringComp, u16Out);
+
+    // Incomplete sequences followed by valid characters only swallow the well-formed prefix.
+    VERIFY_SUCCEEDED(til::u8u16("\xe2\x82" "a\xf0\x9f\x98" "b\xc3", u16Out));
+    VERIFY_ARE_EQUAL(std::wstring_view{ L"\uFFFD" L"a\uFFFD" L"b\uFFFD" }, u16Out);
+}
+
+void Utf8Utf16ConvertTests::TestU16ToU8Invalid()
+{
+    // Unpaired surrogates are replaced with U+FFFD (EF BF BD).
+    const std::wstring u16String{
+        gsl::narrow_cast<wchar_t>(0xdc00U), // lone low surrogate
+        L'a',
+        gsl::narrow_cast<wchar_t>(0xd800U), // high surrogate followed by a non-surrogate
+        L'b',
+        gsl::narrow_cast<wchar_t>(0xd83dU), // valid surrogate pair (U+1F4F7 CAMERA)
+        gsl::narrow_cast<wchar_t>(0xdcf7U),
+        gsl::narrow_cast<wchar_t>(0xdbffU), // trailing high surrogate
+    };
+
+    std::string u8Out{};
+    VERIFY_SUCCEEDED(til::u16u8(u16String, u8Out));
+    VERIFY_ARE_EQUAL(std::string_view{ "\xef\xbf\xbd" "a\xef\xbf\xbd" "b\xf0\x9f\x93\xb7\xef\xbf\xbd" }, u8Out);
+}
+
+void Utf8Utf16ConvertTests::TestLongMixedStrings()
+{
+    // The ASCII fast path processes 16 bytes (or 8 UTF-16 code units) at a time.
+    // Place non-ASCII characters at every offset around those block boundaries
+    // and compare the results with the platform functions.
+    static constexpr std::string_view needles[]{ "\xc3\xb6", "\xe2\x82\xac", "\xf0\x9f\x93\xb7" };
+
+    for (const auto needle : needles)
+    {
+        for (size_t offset = 0; offset < 40; ++offset)
+        {
+            std::string u8String(offset, 'x');
+            u8String.append(needle);
+            u8String.append(37 - offset % 16, 'y');
+
+            std::wstring u16Comp(u8String.size(), L'\0');
+            u16Comp.resize(MultiByteToWideChar(CP_UTF8, 0, u8String.data(), gsl::narrow_cast<int>(u8String.size()), u16Comp.data(), gsl::narrow_cast<int>(u16Comp.size())));
+
+            std::wstring u16Out{};
+            VERIFY_SUCCEEDED(til::u8u16(u8String, u16Out));
+            VERIFY_ARE_EQUAL(u16Comp, u16Out);
+
+            std::string u8Out{};
+            VERIFY_SUCCEEDED(til::u16u8(u16Out, u8Out));
+            VERIFY_ARE_EQUAL(u8String, u8Out);
+        }
+    }
+}
@@ -3,6 +3,8 @@
 // NOTE The functions u8u16 and u16u8 contain own algorithms. Tests have shown that they perform
 // worse than the platform API functions.
 // Thus, these functions are *unrelated* to the til::u8u16 and til::u16u8 implementation.
+// The til functions are only measured and validated against the platform functions in the
+// natural language tests.
 
 #include <iostream>
 #include <memory>
@@ -13,6 +15,12 @@
 
 #include "U8U16Test.hpp"
 
+#include <wil/result.h>
+#include <gsl/gsl_util>
+#include <gsl/pointers>
+#include <base/numerics/safe_math.h>
+#include <til.h>
+
 typedef NTSTATUS(WINAPI* t_RtlUTF8ToUnicodeN)(PWSTR, ULONG, PULONG, PCCH, ULONG);
 typedef NTSTATUS(WINAPI* t_RtlUnicodeToUTF8N)(PCHAR, ULONG, PULONG, PCWSTR, ULONG);
 NTSTATUS(WINAPI* p_RtlUTF8ToUnicodeN)
@@ -366,6 +374,69 @@ void CompNaturalLang_WholeString(const std::string& fileName)
     hRes = u16u8_ptr(u16Str, u8StrOut);
     duration = GetDuration();
     std::cout << " u16u8_ptr           length " << u8StrOut.length() << " elapsed " << duration << std::endl;
+
+    GetDuration();
+    std::wstring u16StrTil{};
+    hRes = til::u8u16(u8Str, u16StrTil);
+    duration = GetDuration();
+    std::cout << " til::u8u16          length " << u16StrTil.length() << " elapsed " << duration << std::endl;
+
+    GetDuration();
+    std::string u8StrTil{};
+    hRes = til::u16u8(u16StrTil, u8StrTil);
+    duration = GetDuration();
+    std::cout << " til::u16u8          length " << u8StrTil.length() << " elapsed " << duration << std::endl;
+}
+
+// compares the til conversions with the platform functions, both for the whole string and chunk-wise using the partials handling
+bool ValidateNaturalLang(const std::string& fileName)
+{
+    std::string head{ __func__ };
+    head += " - " + fileName;
+    PrintHeader(head.c_str());
+    std::ostringstream buf{};
+    buf << std::ifstream{ fileName }.rdbuf();
+    const std::string u8Str = buf.str();
+
+    const auto platformU8U16 = [](const std::string& u8) {
+        std::wstring u16(u8.length(), L'\0');
+        u16.resize(MultiByteToWideChar(CP_UTF8, 0, u8.data(), static_cast<int>(u8.length()), u16.data(), static_cast<int>(u16.length())));
+        return u16;
+    };
+    const auto platformU16U8 = [](const std::wstring& u16) {
+        std::string u8(u16.length() * 3, '\0');
+        u8.resize(WideCharToMultiByte(CP_UTF8, 0, u16.data(), static_cast<int>(u16.length()), u8.data(), static_cast<int>(u8.length()), nullptr, nullptr));
+        return u8;
+    };
+
+    // append ill-formed sequences (Unicode Standard, table 3-8) to compare the U+FFFD replacement as well
+    const auto u8Invalid = u8Str + "\x80\xc0\xaf\xe0\x80\xaf\xed\xa0\x80\xf4\x90\x80\x80\xe1\x80\xe2\xf0\x91\x92\xf1\xbf" "A";
+    const auto u16Invalid = platformU8U16(u8Invalid);
+    auto valid = til::u8u16(u8Invalid) == u16Invalid && til::u16u8(u16Invalid) == platformU16U8(u16Invalid);
+
+    // chunk boundaries can split ill-formed sequences differently, so only the well-formed text is compared chunk-wise
+    const auto u16Comp = platformU8U16(u8Str);
+    const auto u8Comp = platformU16U8(u16Comp);
+
+    for (size_t chunkSize = 1u; chunkSize <= 17u; ++chunkSize)
+    {
+        til::u8state u8State{};
+        til::u16state u16State{};
+        std::wstring u16Out{};
+        std::string u8Out{};
+        for (size_t idx = 0u; idx < u8Str.length(); idx += chunkSize)
+        {
+            u16Out += til::u8u16(std::string_view{ u8Str }.substr(idx, chunkSize), u8State);
+        }
+        for (size_t idx = 0u; idx < u16Comp.length(); idx += chunkSize)
+        {
+            u8Out += til::u16u8(std::wstring_view{ u16Comp }.substr(idx, chunkSize), u16State);
+        }
+        valid = valid && u16Out == u16Comp && u8Out == u8Comp;
+    }
+
+    std::cout << (valid ? " OK" : " MISMATCH") << std::endl;
+    return valid;
 }
 
 void CompNaturalLang_Chunks(const std::string& fileName)
@@ -509,6 +580,11 @@ int main()
 
     std::cout << "\n\n### Natural Languages ###" << std::endl;
 
+    auto valid = ValidateNaturalLang("en.txt");
+    valid &= ValidateNaturalLang("fr.txt");
+    valid &= ValidateNaturalLang("ru.txt");
+    valid &= ValidateNaturalLang("zh.txt");
+
     CompNaturalLang_WholeString("en.txt");
     CompNaturalLang_WholeString("fr.txt");
     CompNaturalLang_WholeString("ru.txt");
@@ -520,7 +596,7 @@ int main()
     CompNaturalLang_Chunks("zh.txt");
 
     FreeLibrary(ntdll);
-    return 0;
+    return valid ? 0 : 1;
 }
 
 // returns the time elapsed between two calls (the return value of the first call is undefined)
@@ -0,0 +1,295 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "corpora.hpp"
+
+#include <pcg_random.hpp>
+
+using namespace Microsoft::Console::VtBench;
+
+namespace
+{
+    // A small wrapper around the PCG engine for the few kinds of random values we need.
+    struct Random
+    {
+        pcg_engines::oneseq_dxsm_64_32 rng{ 0x5eed5eed5eed5eedULL };
+
+        // Returns a random number in the half-open range [lo, hi).
+        til::CoordType Next(til::CoordType lo, til::CoordType hi) noexcept
+        {
+            return lo + gsl::narrow_cast<til::CoordType>(rng() % gsl::narrow_cast<uint32_t>(hi - lo));
+        }
+
+        bool Chance(til::CoordType percent) noexcept
+        {
+            return Next(0, 100) < percent;
+        }
+
+        template<typename T, size_t N>
+        const T& Pick(const T (&items)[N]) noexcept
+        {
+            return items[Next(0, gsl::narrow_cast<til::CoordType>(N))];
+        }
+    };
+
+    // Regular ASCII text, like the output of a build log or `cat` on a source file.
+    std::wstring generateAscii(Random& r, til::CoordType columns)
+    {
+        std::wstring text;
+        text.reserve(CorpusTargetSize + columns + 2);
+
+        while (text.size() < CorpusTargetSize)
+        {
+            const auto length = r.Next(0, columns);
+            for (til::CoordType i = 0; i < length; ++i)
+            {
+                text.push_back(static_cast<wchar_t>(r.Next(0x20, 0x7f)));
+            }
+            text.append(L"\r\n");
+        }
+
+        return text;
+    }
+
+    // CJK Unified Ideographs. Each of them is a wide glyph and as such
+    // exercises the non-ASCII path of ROW::ReplaceText and IsGlyphFullWidth.
+    std::wstring generateCjk(Random& r, til::CoordType columns)
+    {
+        std::wstring text;
+        text.reserve(CorpusTargetSize + columns + 2);
+
+        while (text.size() < CorpusTargetSize)
+        {
+            const auto length = r.Next(0, columns / 2);
+            for (til::CoordType i = 0; i < length; ++i)
+            {
+                text.push_back(r.Chance(10) ? L' ' : static_cast<wchar_t>(r.Next(0x4E00, 0xA000)));
+            }
+            text.append(L"\r\n");
+        }
+
+        return text;
+    }
+
+    // Non-ASCII text that is nonetheless narrow: box drawing characters, block elements
+    // and Hebrew, like a TUI with borders, progress bars and localized labels would emit.
+    // It exercises the bulk path for known-narrow characters in ROW::ReplaceText.
+    std::wstring generateBox(Random& r, til::CoordType columns)
+    {
+        static constexpr std::pair<til::CoordType, til::CoordType> ranges[]{
+            { 0x2500, 0x2580 }, // Box Drawing
+            { 0x2580, 0x25a0 }, // Block Elements
+            { 0x05d0, 0x05eb }, // Hebrew letters
+        };
+
+        std::wstring text;
+        text.reserve(CorpusTargetSize + columns + 2);
+
+        while (text.size() < CorpusTargetSize)
+        {
+            const auto length = r.Next(0, columns);
+            for (til::CoordType i = 0; i < length; ++i)
+            {
+                const auto& [lo, hi] = r.Pick(ranges);
+                text.push_back(r.Chance(10) ? L' ' : static_cast<wchar_t>(r.Next(lo, hi)));
+            }
+            text.append(L"\r\n");
+        }
+
+        return text;
+    }
+
+    // Chat-like text with emojis, including surrogate pairs, skin tone modifiers,
+    // zero width joiner sequences, variation selectors and regional indicators.
+    std::wstring generateEmoji(Random& r, til::CoordType columns)
+    {
+        static constexpr std::wstring_view emojis[]{
+            L"\U0001F600", // grinning face
+            L"\U0001F44D\U0001F3FD", // thumbs up + skin tone modifier
+            L"\U0001F468\u200D\U0001F469\u200D\U0001F467\u200D\U0001F466", // family (ZWJ sequence)
+            L"\U0001F3F3\uFE0F\u200D\U0001F308", // rainbow flag (VS16 + ZWJ)
+            L"\U0001F1E9\U0001F1EA", // flag (regional indicators)
+            L"\u2764\uFE0F", // heavy black heart + VS16
+            L"\U0001F9D1\u200D\U0001F4BB", // technologist (ZWJ sequence)
+        };
+        static constexpr std::wstring_view words[]{
+            L"hello", L"world", L"the", L"build", L"passed", L"on", L"the", L"first", L"try", L"lgtm",
+        };
+
+        std::wstring text;
+        text.reserve(CorpusTargetSize + columns + 2);
+
+        while (text.size() < CorpusTargetSize)
+        {
+            const auto length = gsl::narrow_cast<size_t>(r.Next(0, columns));
+            const auto lineStart = text.size();
+            while (text.size() - lineStart < length)
+            {
+                text.append(r.Chance(30) ? r.Pick(emojis) : r.Pick(words));
+                text.push_back(L' ');
+            }
+            text.append(L"\r\n");
+        }
+
+        return text;
+    }
+
+    // Mimics `ls --color` with LS_COLORS, which is SGR heavy with very short runs of text in between.
+    std::wstring generateSgr(Random& r, til::CoordType columns)
+    {
+        static constexpr std::wstring_view colors[]{
+            L"01;34", // directory
+            L"01;32", // executable
+            L"01;36", // symlink
+            L"01;31", // archive
+            L"00", // regular file
+            L"38;5;208", // 256-color
+            L"38;2;255;135;0", // true color
+        };
+        static constexpr std::wstring_view names[]{
+            L"src", L"build", L"README.md", L"main.cpp", L"a.out", L"node_modules", L"release.tar.gz", L"lib",
+        };
+
+        std::wstring text;
+        text.reserve(CorpusTargetSize + columns * 4);
+
+        while (text.size() < CorpusTargetSize)
+        {
+            til::CoordType x = 0;
+            for (;;)
+            {
+                const auto& name = r.Pick(names);
+                const auto width = gsl::narrow_cast<til::CoordType>(name.size()) + 2;
+                if (x + width > columns)
+                {
+                    break;
+                }
+                fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[0m\x1b[{}m{}\x1b[0m  "), r.Pick(colors), name);
+                x += width;
+            }
+            text.append(L"\r\n");
+        }
+
+        return text;
+    }
+
+    // Mimics full screen TUIs like htop or vim, which repaint the screen
+    // with absolute cursor positioning, colors and erase-in-line.
+    std::wstring generateTui(Random& r, til::CoordType columns, til::CoordType rows)
+    {
+        std::wstring text;
+        text.reserve(CorpusTargetSize + columns * rows * 2);
+
+        while (text.size() < CorpusTargetSize)
+        {
+            text.append(L"\x1b[?25l\x1b[H");
+
+            for (til::CoordType y = 1; y <= rows; ++y)
+            {
+                fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[{};1H"), y);
+
+                til::CoordType x = 0;
+                while (x < columns)
+                {
+                    const auto length = std::min(r.Next(1, 16), columns - x);
+                    fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[38;5;{};48;5;{}m"), r.Next(0, 256), r.Next(232, 256));
+                    for (til::CoordType i = 0; i < length; ++i)
+                    {
+                        text.push_back(static_cast<wchar_t>(r.Next(0x20, 0x7f)));
+                    }
+                    x += length;
+                }
+
+                text.append(L"\x1b[m\x1b[K");
+            }
+
+            fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[{};{}H\x1b[?25h"), r.Next(1, rows + 1), r.Next(1, columns + 1));
+        }
+
+        return text;
+    }
+
+    // Mimics a colored compiler log interleaved with progress bars that redraw themselves in place,
+    // like cargo, ninja or pip produce. Most lines consist of a few short SGR and cursor movement
+    // sequences with only little text in between, which makes CSI parsing the dominant cost.
+    std::wstring generateLog(Random& r, til::CoordType columns)
+    {
+        static constexpr std::wstring_view verbs[]{ L"Compiling", L"Checking", L"Linking", L"Building" };
+        static constexpr std::wstring_view crates[]{ L"serde", L"tokio", L"libc", L"syn", L"quote", L"regex", L"memchr", L"unicode-width" };
+
+        const auto barWidth = std::max(columns / 2, 10);
+        std::wstring text;
+        text.reserve(CorpusTargetSize + columns * 8);
+
+        while (text.size() < CorpusTargetSize)
+        {
+            if (r.Chance(20))
+            {
+                fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[1m\x1b[33mwarning\x1b[0m\x1b[1m: unused variable `x{}`\x1b[0m\r\n"), r.Next(0, 1000));
+                fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"  \x1b[1m\x1b[38;5;12m-->\x1b[0m src/lib.rs:{}:{}\r\n"), r.Next(1, 1000), r.Next(1, 80));
+            }
+            else
+            {
+                fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"\x1b[1m\x1b[32m{:>12}\x1b[0m {} v0.{}.{}\r\n"), r.Pick(verbs), r.Pick(crates), r.Next(0, 20), r.Next(0, 10));
+            }
+
+            // The progress bar is redrawn a few times on the line below the log.
+            const auto filled = r.Next(0, barWidth);
+            for (auto i = 0; i < 3; ++i)
+            {
+                text.append(L"\x1b[2K\r\x1b[1m\x1b[36m    Building\x1b[0m [");
+                text.append(gsl::narrow_cast<size_t>(filled), L'=');
+                text.push_back(L'>');
+                text.append(gsl::narrow_cast<size_t>(barWidth - filled), L' ');
+                fmt::format_to(std::back_inserter(text), FMT_COMPILE(L"] {}/{}\x1b[1G"), filled, barWidth);
+            }
+            text.append(L"\x1b[2K\r");
+        }
+
+        return text;
+    }
+
+    // Lines much longer than the terminal is wide, which forces the text to be wrapped.
+    std::wstring generateWrap(Random& r, til::CoordType columns)
+    {
+        const auto lineLength = gsl::narrow_cast<size_t>(columns) * 40;
+
+        std::wstring text;
+        text.reserve(CorpusTargetSize + lineLength + 2);
+
+        while (text.size() < CorpusTargetSize)
+        {
+            for (size_t i = 0; i < lineLength; ++i)
+            {
+                text.push_back(static_cast<wchar_t>(r.Next(0x20, 0x7f)));
+            }
+            text.append(L"\r\n");
+        }
+
+        return text;
+    }
+}
+
+std::vector<Corpus> Microsoft::Console::VtBench::GenerateCorpora(til::CoordType columns, til::CoordType rows)
+{
+    Random r;
+    std::vector<Corpus> corpora;
+
+    corpora.emplace_back(Corpus{ .name = "ascii", .text = generateAscii(r, columns) });
+    corpora.emplace_back(Corpus{ .name = "cjk", .text = generateCjk(r, columns) });
+    corpora.emplace_back(Corpus{ .name = "box", .text = generateBox(r, columns) });
+    corpora.emplace_back(Corpus{ .name = "emoji", .text = generateEmoji(r, columns) });
+    corpora.emplace_back(Corpus{ .name = "sgr", .text = generateSgr(r, columns) });
+    corpora.emplace_back(Corpus{ .name = "tui", .text = generateTui(r, columns, rows) });
+    corpora.emplace_back(Corpus{ .name = "log", .text = generateLog(r, columns) });
+    corpora.emplace_back(Corpus{ .name = "wrap", .text = generateWrap(r, columns) });
+
+    for (auto& c : corpora)
+    {
+        c.utf8 = til::u16u8(c.text);
+        c.utf8Bytes = c.utf8.size();
+    }
+
+    return corpora;
+}
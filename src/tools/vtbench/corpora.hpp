@@ -0,0 +1,31 @@
+/*++
+Copyright (c) Microsoft Corporation.
+Licensed under the MIT license.
+
+Module Name:
+- corpora.hpp
+
+Abstract:
+- Generates the canned inputs used by the vtbench suites. All corpora are generated
+  from a fixed seed, so that results are comparable across runs and machines.
+--*/
+
+#pragma once
+
+namespace Microsoft::Console::VtBench
+{
+    struct Corpus
+    {
+        std::string_view name;
+        std::wstring text;
+        // `text` encoded as UTF-8. This is what a ConPTY client would actually write.
+        std::string utf8;
+        // The size of `utf8`, which is what MB/s refers to.
+        size_t utf8Bytes = 0;
+    };
+
+    // Roughly the amount of text each corpus contains (in UTF-16 code units).
+    inline constexpr size_t CorpusTargetSize = 4 * 1024 * 1024;
+
+    std::vector<Corpus> GenerateCorpora(til::CoordType columns, til::CoordType rows);
+}
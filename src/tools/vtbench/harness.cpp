@@ -0,0 +1,131 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "harness.hpp"
+
+using namespace Microsoft::Console::VtBench;
+
+double Measurement::MegabytesPerSecond() const noexcept
+{
+    const auto seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0 ? static_cast<double>(bytes) * static_cast<double>(iterations) / seconds / 1e6 : 0;
+}
+
+double Measurement::NanosecondsPerChar() const noexcept
+{
+    const auto total = static_cast<double>(chars) * static_cast<double>(iterations);
+    return total > 0 ? static_cast<double>(elapsed.count()) / total : 0;
+}
+
+Harness::Harness(Options options) :
+    _options{ std::move(options) }
+{
+}
+
+bool Harness::ShouldRun(std::string_view suite, std::string_view name) const
+{
+    if (_options.filter.empty())
+    {
+        return true;
+    }
+    const auto fullName = fmt::format(FMT_COMPILE("{}/{}"), suite, name);
+    return fullName.find(_options.filter) != std::string::npos;
+}
+
+void Harness::ReportMemory(std::string_view suite, std::string_view name, size_t bytes)
+{
+    if (!ShouldRun(suite, name))
+    {
+        return;
+    }
+
+    _report(Measurement{
+        .suite = std::string{ suite },
+        .name = std::string{ name },
+        .memoryBytes = bytes,
+    });
+}
+
+void Harness::ReportCounter(std::string_view suite, std::string_view name, double value, std::string_view unit)
+{
+    if (!ShouldRun(suite, name))
+    {
+        return;
+    }
+
+    _report(Measurement{
+        .suite = std::string{ suite },
+        .name = std::string{ name },
+        .counter = value,
+        .unit = std::string{ unit },
+    });
+}
+
+void Harness::_report(Measurement m)
+{
+    if (!_options.json && !m.unit.empty())
+    {
+        const auto line = fmt::format("{:<10} {:<24} {:>10.2f} {}\n", m.suite, m.name, m.counter, m.unit);
+        fwrite(line.data(), 1, line.size(), stdout);
+        fflush(stdout);
+    }
+    else if (!_options.json && m.memoryBytes)
+    {
+        const auto line = fmt::format("{:<10} {:<24} {:>10.2f} MB private\n", m.suite, m.name, static_cast<double>(m.memoryBytes) / 1e6);
+        fwrite(line.data(), 1, line.size(), stdout);
+        fflush(stdout);
+    }
+    else if (!_options.json)
+    {
+        const auto line = fmt::format("{:<10} {:<24} {:>10.2f} MB/s {:>10.3f} ns/char {:>6} iterations\n",
+                                      m.suite,
+                                      m.name,
+                                      m.MegabytesPerSecond(),
+                                      m.NanosecondsPerChar(),
+                                      m.iterations);
+        fwrite(line.data(), 1, line.size(), stdout);
+        fflush(stdout);
+    }
+
+    _measurements.emplace_back(std::move(m));
+}
+
+// The JSON output is intentionally flat, so that it can be consumed by CI trend tracking
+// tools without any knowledge about vtbench. The names never contain characters that
+// require escaping, which is why we don't bother implementing it.
+void Harness::Finish()
+{
+    if (!_options.json)
+    {
+        return;
+    }
+
+    std::string out;
+    out.append(R"({"benchmarks":[)");
+
+    for (auto it = _measurements.begin(); it != _measurements.end(); ++it)
+    {
+        if (it != _measurements.begin())
+        {
+            out.push_back(',');
+        }
+        fmt::format_to(std::back_inserter(out),
+                       R"({{"suite":"{}","name":"{}","bytes":{},"chars":{},"iterations":{},"elapsed_ns":{},"mb_per_s":{:.3f},"ns_per_char":{:.4f},"memory_bytes":{},"counter":{:.3f},"unit":"{}"}})",
+                       it->suite,
+                       it->name,
+                       it->bytes,
+                       it->chars,
+                       it->iterations,
+                       it->elapsed.count(),
+                       it->MegabytesPerSecond(),
+                       it->NanosecondsPerChar(),
+                       it->memoryBytes,
+                       it->counter,
+                       it->unit);
+    }
+
+    out.append("]}\n");
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+}
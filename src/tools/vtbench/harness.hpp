@@ -0,0 +1,111 @@
+/*++
+Copyright (c) Microsoft Corporation.
+Licensed under the MIT license.
+
+Module Name:
+- harness.hpp
+
+Abstract:
+- A minimal measurement harness for vtbench. Each suite calls Harness::Run() once per
+  benchmark with a callable that processes `chars` characters (`bytes` bytes when
+  encoded as UTF-8) per invocation. The harness repeats the callable until both
+  the minimum duration and iteration count are met and records the throughput.
+- Results can be printed as a human readable table or as JSON for CI trend tracking.
+--*/
+
+#pragma once
+
+namespace Microsoft::Console::VtBench
+{
+    struct Options
+    {
+        // Only benchmarks whose "suite/name" contains this string are run.
+        std::string filter;
+        // Each benchmark is repeated until it ran at least this long...
+        std::chrono::nanoseconds minDuration{ std::chrono::seconds{ 1 } };
+        // ...and at least this many times.
+        size_t minIterations = 3;
+        // Print results as JSON instead of a table.
+        bool json = false;
+    };
+
+    struct Measurement
+    {
+        std::string suite;
+        std::string name;
+        // Size of the input per iteration in bytes (UTF-8) and UTF-16 code units.
+        size_t bytes = 0;
+        size_t chars = 0;
+        size_t iterations = 0;
+        std::chrono::nanoseconds elapsed{};
+        // Set instead of the above by Harness::ReportMemory().
+        size_t memoryBytes = 0;
+        // Set instead of the above by Harness::ReportCounter().
+        double counter = 0;
+        std::string unit;
+
+        double MegabytesPerSecond() const noexcept;
+        double NanosecondsPerChar() const noexcept;
+    };
+
+    class Harness
+    {
+    public:
+        explicit Harness(Options options);
+
+        bool ShouldRun(std::string_view suite, std::string_view name) const;
+
+        // The optional `setup` callable is invoked before every iteration and isn't included in the timing.
+        // This allows benchmarks to reset their state (for instance to start with an empty TextBuffer).
+        template<typename Setup, typename Func>
+        void Run(std::string_view suite, std::string_view name, size_t bytes, size_t chars, Setup&& setup, Func&& func)
+        {
+            if (!ShouldRun(suite, name))
+            {
+                return;
+            }
+
+            // Warm up caches, the commit watermark of the TextBuffer, etc.
+            setup();
+            func();
+
+            Measurement m{
+                .suite = std::string{ suite },
+                .name = std::string{ name },
+                .bytes = bytes,
+                .chars = chars,
+            };
+
+            do
+            {
+                setup();
+                const auto beg = std::chrono::steady_clock::now();
+                func();
+                const auto end = std::chrono::steady_clock::now();
+                m.elapsed += end - beg;
+                m.iterations++;
+            } while (m.elapsed < _options.minDuration || m.iterations < _options.minIterations);
+
+            _report(m);
+        }
+
+        template<typename Func>
+        void Run(std::string_view suite, std::string_view name, size_t bytes, size_t chars, Func&& func)
+        {
+            Run(suite, name, bytes, chars, [] {}, std::forward<Func>(func));
+        }
+
+        // Records a memory measurement instead of a timing.
+        void ReportMemory(std::string_view suite, std::string_view name, size_t bytes);
+        // Records an arbitrary value, like the number of page faults per MB of output.
+        void ReportCounter(std::string_view suite, std::string_view name, double value, std::string_view unit);
+
+        void Finish();
+
+    private:
+        void _report(Measurement m);
+
+        Options _options;
+        std::vector<Measurement> _measurements;
+    };
+}
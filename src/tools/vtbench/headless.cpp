@@ -0,0 +1,196 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "headless.hpp"
+
+using namespace Microsoft::Console::VtBench;
+using namespace Microsoft::Console::VirtualTerminal;
+
+HeadlessTerminal::HeadlessTerminal(til::size viewportSize, til::CoordType scrollbackRows) :
+    _viewportSize{ viewportSize },
+    _scrollbackRows{ std::max(scrollbackRows, viewportSize.height) }
+{
+    Reset();
+}
+
+void HeadlessTerminal::Write(std::wstring_view text)
+{
+    _stateMachine->ProcessString(text);
+    // Same as Terminal::Write().
+    _textBuffer->CompactScrollback();
+}
+
+void HeadlessTerminal::WriteUtf8(std::string_view text)
+{
+    THROW_IF_FAILED(_stateMachine->ProcessUtf8(text, _u8State));
+    _textBuffer->CompactScrollback();
+}
+
+// Throws away the current buffer contents and returns to the initial state,
+// as if the terminal was just started. Benchmarks call this between iterations.
+void HeadlessTerminal::Reset()
+{
+    // The buffer is deliberately not marked as active: There are no render engines
+    // attached to the DummyRenderer and so there's nothing to invalidate.
+    _textBuffer = std::make_unique<TextBuffer>(til::size{ _viewportSize.width, _scrollbackRows }, TextAttribute{}, 0, false, _renderer);
+    _textBuffer->SetColdScrollbackDistance(_coldScrollbackDistance);
+    _textBuffer->SetPrefault(_prefault);
+    _viewportTop = 0;
+    _systemMode = { Mode::AutoWrap };
+    _u8State.reset();
+
+    // AdaptDispatch holds on to modes, margins, charsets, etc. Recreating
+    // the entire chain is the most robust way to get rid of all that state.
+    auto dispatch = std::make_unique<AdaptDispatch>(*this, _renderer, _renderer._renderSettings, _terminalInput);
+    auto engine = std::make_unique<OutputStateMachineEngine>(std::move(dispatch));
+    _stateMachine = std::make_unique<StateMachine>(std::move(engine));
+}
+
+// Applies to the current and all future buffers created by Reset(). See TextBuffer::SetColdScrollbackDistance().
+void HeadlessTerminal::SetColdScrollbackDistance(til::CoordType distance)
+{
+    _coldScrollbackDistance = distance;
+    _textBuffer->SetColdScrollbackDistance(distance);
+}
+
+// Applies to the current and all future buffers created by Reset(). See TextBuffer::SetPrefault().
+void HeadlessTerminal::SetPrefault(bool enabled)
+{
+    _prefault = enabled;
+    _textBuffer->SetPrefault(enabled);
+}
+
+StateMachine& HeadlessTerminal::GetStateMachine()
+{
+    return *_stateMachine;
+}
+
+TextBuffer& HeadlessTerminal::GetTextBuffer()
+{
+    return *_textBuffer;
+}
+
+til::rect HeadlessTerminal::GetViewport() const
+{
+    return { 0, _viewportTop, _viewportSize.width, _viewportTop + _viewportSize.height };
+}
+
+void HeadlessTerminal::SetViewportPosition(const til::point position)
+{
+    _viewportTop = std::clamp(position.y, 0, _scrollbackRows - _viewportSize.height);
+}
+
+void HeadlessTerminal::ReturnResponse(const std::wstring_view /*response*/)
+{
+}
+
+bool HeadlessTerminal::IsVtInputEnabled() const
+{
+    return false;
+}
+
+void HeadlessTerminal::SetTextAttributes(const TextAttribute& attrs)
+{
+    _textBuffer->SetCurrentAttributes(attrs);
+}
+
+void HeadlessTerminal::SetSystemMode(const Mode mode, const bool enabled)
+{
+    _systemMode.set(mode, enabled);
+}
+
+bool HeadlessTerminal::GetSystemMode(const Mode mode) const
+{
+    return _systemMode.test(mode);
+}
+
+void HeadlessTerminal::WarningBell()
+{
+}
+
+void HeadlessTerminal::SetWindowTitle(const std::wstring_view /*title*/)
+{
+}
+
+// The alternate screen buffer isn't supported, because its cost is dominated by
+// allocating a new TextBuffer and that's not what this tool is meant to measure.
+void HeadlessTerminal::UseAlternateScreenBuffer(const TextAttribute& /*attrs*/)
+{
+}
+
+void HeadlessTerminal::UseMainScreenBuffer()
+{
+}
+
+CursorType HeadlessTerminal::GetUserDefaultCursorStyle() const
+{
+    return CursorType::Legacy;
+}
+
+void HeadlessTerminal::ShowWindow(bool /*showOrHide*/)
+{
+}
+
+void HeadlessTerminal::SetConsoleOutputCP(const unsigned int /*codepage*/)
+{
+}
+
+unsigned int HeadlessTerminal::GetConsoleOutputCP() const
+{
+    return CP_UTF8;
+}
+
+void HeadlessTerminal::CopyToClipboard(const std::wstring_view /*content*/)
+{
+}
+
+void HeadlessTerminal::SetTaskbarProgress(const DispatchTypes::TaskbarState /*state*/, const size_t /*progress*/)
+{
+}
+
+void HeadlessTerminal::SetWorkingDirectory(const std::wstring_view /*uri*/)
+{
+}
+
+void HeadlessTerminal::PlayMidiNote(const int /*noteNumber*/, const int /*velocity*/, const std::chrono::microseconds /*duration*/)
+{
+}
+
+bool HeadlessTerminal::ResizeWindow(const til::CoordType /*width*/, const til::CoordType /*height*/)
+{
+    return false;
+}
+
+bool HeadlessTerminal::IsConsolePty() const
+{
+    return false;
+}
+
+void HeadlessTerminal::NotifyAccessibilityChange(const til::rect& /*changedRect*/)
+{
+}
+
+void HeadlessTerminal::NotifyBufferRotation(const int /*delta*/)
+{
+}
+
+void HeadlessTerminal::MarkPrompt(const ScrollMark& /*mark*/)
+{
+}
+
+void HeadlessTerminal::MarkCommandStart()
+{
+}
+
+void HeadlessTerminal::MarkOutputStart()
+{
+}
+
+void HeadlessTerminal::MarkCommandFinish(std::optional<unsigned int> /*error*/)
+{
+}
+
+void HeadlessTerminal::InvokeCompletions(std::wstring_view /*menuJson*/, unsigned int /*replaceLength*/)
+{
+}
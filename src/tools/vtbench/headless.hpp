@@ -0,0 +1,79 @@
+/*++
+Copyright (c) Microsoft Corporation.
+Licensed under the MIT license.
+
+Module Name:
+- headless.hpp
+
+Abstract:
+- A terminal without a window, a renderer or a connection. It wires up the regular
+  StateMachine, OutputStateMachineEngine and AdaptDispatch with a real TextBuffer,
+  so that benchmarks measure the exact same code paths that conhost and Windows Terminal
+  use when processing output, minus the painting.
+--*/
+
+#pragma once
+
+#include "../../terminal/adapter/adaptDispatch.hpp"
+#include "../../terminal/parser/OutputStateMachineEngine.hpp"
+#include "../../renderer/inc/DummyRenderer.hpp"
+
+namespace Microsoft::Console::VtBench
+{
+    class HeadlessTerminal final : public VirtualTerminal::ITerminalApi
+    {
+    public:
+        HeadlessTerminal(til::size viewportSize, til::CoordType scrollbackRows);
+
+        void Write(std::wstring_view text);
+        void WriteUtf8(std::string_view text);
+        void Reset();
+        void SetColdScrollbackDistance(til::CoordType distance);
+        void SetPrefault(bool enabled);
+
+        VirtualTerminal::StateMachine& GetStateMachine() override;
+        TextBuffer& GetTextBuffer() override;
+        til::rect GetViewport() const override;
+        void SetViewportPosition(const til::point position) override;
+
+        void ReturnResponse(const std::wstring_view response) override;
+        bool IsVtInputEnabled() const override;
+        void SetTextAttributes(const TextAttribute& attrs) override;
+        void SetSystemMode(const Mode mode, const bool enabled) override;
+        bool GetSystemMode(const Mode mode) const override;
+        void WarningBell() override;
+        void SetWindowTitle(const std::wstring_view title) override;
+        void UseAlternateScreenBuffer(const TextAttribute& attrs) override;
+        void UseMainScreenBuffer() override;
+        CursorType GetUserDefaultCursorStyle() const override;
+        void ShowWindow(bool showOrHide) override;
+        void SetConsoleOutputCP(const unsigned int codepage) override;
+        unsigned int GetConsoleOutputCP() const override;
+        void CopyToClipboard(const std::wstring_view content) override;
+        void SetTaskbarProgress(const VirtualTerminal::DispatchTypes::TaskbarState state, const size_t progress) override;
+        void SetWorkingDirectory(const std::wstring_view uri) override;
+        void PlayMidiNote(const int noteNumber, const int velocity, const std::chrono::microseconds duration) override;
+        bool ResizeWindow(const til::CoordType width, const til::CoordType height) override;
+        bool IsConsolePty() const override;
+        void NotifyAccessibilityChange(const til::rect& changedRect) override;
+        void NotifyBufferRotation(const int delta) override;
+        void MarkPrompt(const ScrollMark& mark) override;
+        void MarkCommandStart() override;
+        void MarkOutputStart() override;
+        void MarkCommandFinish(std::optional<unsigned int> error) override;
+        void InvokeCompletions(std::wstring_view menuJson, unsigned int replaceLength) override;
+
+    private:
+        DummyRenderer _renderer;
+        VirtualTerminal::TerminalInput _terminalInput;
+        std::unique_ptr<TextBuffer> _textBuffer;
+        std::unique_ptr<VirtualTerminal::StateMachine> _stateMachine;
+        til::u8state _u8State;
+        til::size _viewportSize;
+        til::CoordType _scrollbackRows = 0;
+        til::CoordType _viewportTop = 0;
+        til::CoordType _coldScrollbackDistance = 0;
+        bool _prefault = false;
+        til::enumset<Mode> _systemMode{ Mode::AutoWrap };
+    };
+}
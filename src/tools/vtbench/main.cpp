@@ -0,0 +1,66 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// vtbench measures the throughput of our VT output pipeline without a window, renderer or ConPTY,
+// so that regressions in the parser or text buffer can be tracked independently of the platform
+// specific parts of conhost and Windows Terminal. benchcat on the other hand measures end-to-end.
+
+#include "precomp.h"
+#include "suites.hpp"
+
+using namespace Microsoft::Console::VtBench;
+
+static void printUsage()
+{
+    fwprintf(stderr,
+             L"Usage: vtbench.exe [-json] [-filter <substring>] [-time <milliseconds>] [-iterations <count>]\r\n"
+             L"  -json        Print results as JSON for CI trend tracking.\r\n"
+             L"  -filter      Only run benchmarks whose \"suite/name\" contains the given string.\r\n"
+             L"  -time        Minimum duration of each benchmark in milliseconds. Defaults to 1000.\r\n"
+             L"  -iterations  Minimum number of iterations of each benchmark. Defaults to 3.\r\n");
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+try
+{
+    Options options;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::wstring_view arg{ argv[i] };
+        const auto hasValue = i + 1 < argc;
+
+        if (arg == L"-json")
+        {
+            options.json = true;
+        }
+        else if (arg == L"-filter" && hasValue)
+        {
+            options.filter = til::u16u8(argv[++i]);
+        }
+        else if (arg == L"-time" && hasValue)
+        {
+            options.minDuration = std::chrono::milliseconds{ _wtoi(argv[++i]) };
+        }
+        else if (arg == L"-iterations" && hasValue)
+        {
+            options.minIterations = gsl::narrow_cast<size_t>(std::max(1, _wtoi(argv[++i])));
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    Harness harness{ std::move(options) };
+    RunParserSuite(harness);
+    RunScrollbackSuite(harness);
+    harness.Finish();
+    return 0;
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return 1;
+}
@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "suites.hpp"
+
+#include "corpora.hpp"
+#include "headless.hpp"
+
+using namespace Microsoft::Console::VtBench;
+using namespace Microsoft::Console::VirtualTerminal;
+
+namespace
+{
+    // Accepts all sequences without doing anything with them, which isolates the cost of parsing.
+    class NullDispatch final : public TermDispatch
+    {
+    public:
+        void Print(const wchar_t /*wchPrintable*/) override
+        {
+        }
+
+        void PrintString(const std::wstring_view /*string*/) override
+        {
+        }
+    };
+}
+
+void Microsoft::Console::VtBench::RunParserSuite(Harness& harness)
+{
+    const auto corpora = GenerateCorpora(DefaultViewportSize.width, DefaultViewportSize.height);
+    HeadlessTerminal terminal{ DefaultViewportSize, DefaultScrollbackRows };
+
+    for (const auto& corpus : corpora)
+    {
+        harness.Run(
+            "parser",
+            corpus.name,
+            corpus.utf8Bytes,
+            corpus.text.size(),
+            [&] { terminal.Reset(); },
+            [&] { terminal.Write(corpus.text); });
+    }
+
+    for (const auto& corpus : corpora)
+    {
+        harness.Run(
+            "parser-utf8",
+            corpus.name,
+            corpus.utf8Bytes,
+            corpus.text.size(),
+            [&] { terminal.Reset(); },
+            [&] { terminal.WriteUtf8(corpus.utf8); });
+    }
+
+    StateMachine stateMachine{ std::make_unique<OutputStateMachineEngine>(std::make_unique<NullDispatch>()) };
+
+    for (const auto& corpus : corpora)
+    {
+        harness.Run(
+            "vt",
+            corpus.name,
+            corpus.utf8Bytes,
+            corpus.text.size(),
+            [&] { stateMachine.ResetState(); },
+            [&] { stateMachine.ProcessString(corpus.text); });
+    }
+
+    // The next two compare the two ways of getting UTF-8 into the parser:
+    // Converting all of it to UTF-16 first, like the TerminalOutput event requires, and ProcessUtf8.
+    for (const auto& corpus : corpora)
+    {
+        harness.Run(
+            "vt-u8u16",
+            corpus.name,
+            corpus.utf8Bytes,
+            corpus.text.size(),
+            [&] { stateMachine.ResetState(); },
+            [&] { stateMachine.ProcessString(til::u8u16(corpus.utf8)); });
+    }
+
+    til::u8state state;
+
+    for (const auto& corpus : corpora)
+    {
+        harness.Run(
+            "vt-utf8",
+            corpus.name,
+            corpus.utf8Bytes,
+            corpus.text.size(),
+            [&] {
+                stateMachine.ResetState();
+                state.reset();
+            },
+            [&] { THROW_IF_FAILED(stateMachine.ProcessUtf8(corpus.utf8, state)); });
+    }
+}
@@ -0,0 +1,111 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "suites.hpp"
+
+#include <psapi.h>
+#include <random>
+
+#include "corpora.hpp"
+#include "headless.hpp"
+
+using namespace Microsoft::Console::VtBench;
+
+static PROCESS_MEMORY_COUNTERS_EX getMemoryCounters()
+{
+    PROCESS_MEMORY_COUNTERS_EX counters{};
+    THROW_IF_WIN32_BOOL_FALSE(GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters)));
+    return counters;
+}
+
+void Microsoft::Console::VtBench::RunScrollbackSuite(Harness& harness)
+{
+    // TextBuffer uses 16-bit row indices, which makes this the largest scrollback it supports.
+    static constexpr til::CoordType scrollbackRows = UINT16_MAX;
+    // The same distance that Terminal uses.
+    static constexpr til::CoordType coldScrollbackDistance = 1000;
+    static constexpr size_t randomReads = 64 * 1024;
+
+    const auto corpora = GenerateCorpora(DefaultViewportSize.width, DefaultViewportSize.height);
+    const auto& corpus = corpora.front();
+
+    // Random rows from the entire buffer. Unlike rows near the cursor, these are mostly cold.
+    std::vector<til::CoordType> rows(randomReads);
+    {
+        std::minstd_rand rng{ 42 };
+        std::uniform_int_distribution<til::CoordType> dist{ 0, scrollbackRows - 1 };
+        std::generate(rows.begin(), rows.end(), [&] { return dist(rng); });
+    }
+
+    struct Variant
+    {
+        std::string_view name;
+        til::CoordType distance;
+        bool prefault;
+    };
+    static constexpr Variant variants[]{
+        { "hot", 0, false },
+        { "cold", coldScrollbackDistance, false },
+        { "prefault", 0, true },
+    };
+
+    for (const auto& [variant, distance, prefault] : variants)
+    {
+        const auto memoryName = fmt::format(FMT_COMPILE("memory-{}"), variant);
+        const auto commitsName = fmt::format(FMT_COMPILE("commits-{}"), variant);
+        const auto faultsName = fmt::format(FMT_COMPILE("faults-{}"), variant);
+        const auto writeName = fmt::format(FMT_COMPILE("write-{}"), variant);
+        const auto readName = fmt::format(FMT_COMPILE("read-{}"), variant);
+
+        if (!harness.ShouldRun("scrollback", memoryName) && !harness.ShouldRun("scrollback", commitsName) && !harness.ShouldRun("scrollback", faultsName) &&
+            !harness.ShouldRun("scrollback", writeName) && !harness.ShouldRun("scrollback", readName))
+        {
+            continue;
+        }
+
+        const auto countersBefore = getMemoryCounters();
+
+        HeadlessTerminal terminal{ DefaultViewportSize, scrollbackRows };
+        terminal.SetColdScrollbackDistance(distance);
+        terminal.SetPrefault(prefault);
+
+        // Fill the entire scrollback, so that we measure the steady state of a long running session.
+        size_t written = 0;
+        while (terminal.GetViewport().bottom < scrollbackRows)
+        {
+            terminal.Write(corpus.text);
+            written += corpus.utf8Bytes;
+        }
+
+        const auto countersAfter = getMemoryCounters();
+        const auto usageBefore = countersBefore.PrivateUsage;
+        const auto usageAfter = countersAfter.PrivateUsage;
+        harness.ReportMemory("scrollback", memoryName, usageAfter > usageBefore ? usageAfter - usageBefore : 0);
+
+        // The page faults are counted for the entire process, which includes those on the threadpool for prefault.
+        const auto megabytes = static_cast<double>(written) / 1e6;
+        const auto& statistics = terminal.GetTextBuffer().GetCommitStatistics();
+        harness.ReportCounter("scrollback", commitsName, static_cast<double>(statistics.commits) / megabytes, "commits/MB");
+        harness.ReportCounter("scrollback", faultsName, static_cast<double>(countersAfter.PageFaultCount - countersBefore.PageFaultCount) / megabytes, "faults/MB");
+
+        harness.Run("scrollback", writeName, corpus.utf8Bytes, corpus.text.size(), [&] { terminal.Write(corpus.text); });
+
+        const auto& buffer = terminal.GetTextBuffer();
+        size_t readChars = 0;
+        for (const auto y : rows)
+        {
+            readChars += buffer.GetRowByOffset(y).GetText().size();
+        }
+
+        volatile size_t sink = 0;
+        harness.Run("scrollback", readName, readChars * sizeof(wchar_t), readChars, [&] {
+            size_t total = 0;
+            for (const auto y : rows)
+            {
+                total += buffer.GetRowByOffset(y).GetText().size();
+            }
+            sink = total;
+        });
+    }
+}
@@ -0,0 +1,29 @@
+/*++
+Copyright (c) Microsoft Corporation.
+Licensed under the MIT license.
+
+Module Name:
+- suites.hpp
+
+Abstract:
+- Entrypoints for all benchmark suites of vtbench.
+--*/
+
+#pragma once
+
+#include "harness.hpp"
+
+namespace Microsoft::Console::VtBench
+{
+    // The size of the terminal all suites use, unless they specifically need something else.
+    inline constexpr til::size DefaultViewportSize{ 120, 30 };
+    inline constexpr til::CoordType DefaultScrollbackRows = 9001;
+
+    // StateMachine::ProcessString -> OutputStateMachineEngine -> AdaptDispatch -> TextBuffer.
+    // Also measures StateMachine::ProcessString -> OutputStateMachineEngine on its own, with a dispatch that does nothing.
+    // The *-utf8 variants do the same via StateMachine::ProcessUtf8 and vt-u8u16 is the til::u8u16 + ProcessString baseline for vt-utf8.
+    void RunParserSuite(Harness& harness);
+    // Memory usage and row access latency of a full scrollback, with and without TextBuffer's cold storage.
+    // Also counts the commits and page faults per MB of output, with and without TextBuffer's prefault option.
+    void RunScrollbackSuite(Harness& harness);
+}
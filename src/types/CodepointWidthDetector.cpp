@@ -19,6 +19,9 @@ namespace
         return range.upperBound < searchTerm;
     }
 
+    // NOTE: isKnownNarrow() in Row.cpp hardcodes some of the gaps in this table.
+    //       If you regenerate it, ensure that TestRowReplaceTextKnownNarrow still passes.
+    //
     // Generated by Generate-CodepointWidthsFromUCD.ps1 -Pack:True -Full: -NoOverrides:False
     // on 2022-11-15 19:54:23Z from Unicode 15.0.0.
     // 321149 (0x4E67D) codepoints covered.
@@ -323,6 +326,117 @@ namespace
         UnicodeRange{ 0xf0000, 0xffffd, 1 },
         UnicodeRange{ 0x100000, 0x10fffd, 1 },
     };
+
+    // s_wideAndAmbiguousTable is turned into a two-stage lookup table at compile time, which allows us to look up
+    // the width of any codepoint with 2 dependent loads and without branches. The first stage maps the upper bits
+    // of a codepoint (codepoint >> s_blockShift) to a block in the second stage. Each block stores the width class
+    // of its s_blockSize codepoints packed into 2 bits each. The vast majority of blocks are uniformly narrow, wide
+    // or ambiguous and share the first 3 blocks, whose indices coincide with their width class for this reason.
+    // This results in about 7.5KB of data, compared to the ~2.4KB of the table above.
+    enum WidthClass : uint8_t
+    {
+        WidthClassNarrow = 0,
+        WidthClassWide = 1,
+        WidthClassAmbiguous = 2,
+    };
+
+    static constexpr char32_t s_codepointCount = 0x110000;
+    static constexpr size_t s_blockShift = 8;
+    static constexpr size_t s_blockSize = size_t{ 1 } << s_blockShift;
+    static constexpr size_t s_blockCount = s_codepointCount >> s_blockShift;
+    static constexpr size_t s_uniformBlockCount = 3;
+
+    using WidthBlock = std::array<uint64_t, s_blockSize / 32>;
+
+    // Returns the WidthClass of all codepoints in the given block if they're all the same and -1 otherwise.
+    // `range` must point to the first entry in s_wideAndAmbiguousTable whose upperBound is >= the block's first codepoint.
+    static constexpr int uniformWidthClass(const size_t block, const UnicodeRange* range) noexcept
+    {
+        const auto first = gsl::narrow_cast<char32_t>(block << s_blockShift);
+        const auto last = gsl::narrow_cast<char32_t>(first + s_blockSize - 1);
+
+        if (range == s_wideAndAmbiguousTable.data() + s_wideAndAmbiguousTable.size() || range->lowerBound > last)
+        {
+            return WidthClassNarrow;
+        }
+        if (range->lowerBound <= first && range->upperBound >= last)
+        {
+            return range->isAmbiguous ? WidthClassAmbiguous : WidthClassWide;
+        }
+        return -1;
+    }
+
+    static constexpr size_t countMixedWidthBlocks() noexcept
+    {
+        size_t count = 0;
+        auto range = s_wideAndAmbiguousTable.data();
+        const auto rangeEnd = range + s_wideAndAmbiguousTable.size();
+
+        for (size_t block = 0; block < s_blockCount; ++block)
+        {
+            for (; range != rangeEnd && range->upperBound < (block << s_blockShift); ++range)
+            {
+            }
+            count += uniformWidthClass(block, range) < 0;
+        }
+
+        return count;
+    }
+
+    struct WidthTable
+    {
+        std::array<uint8_t, s_blockCount> stage1{};
+        std::array<WidthBlock, s_uniformBlockCount + countMixedWidthBlocks()> stage2{};
+    };
+
+    static constexpr WidthTable buildWidthTable() noexcept
+    {
+        WidthTable table;
+        table.stage2[WidthClassWide].fill(0x5555555555555555);
+        table.stage2[WidthClassAmbiguous].fill(0xaaaaaaaaaaaaaaaa);
+
+        auto range = s_wideAndAmbiguousTable.data();
+        const auto rangeEnd = range + s_wideAndAmbiguousTable.size();
+        auto nextBlock = s_uniformBlockCount;
+
+        for (size_t block = 0; block < s_blockCount; ++block)
+        {
+            const auto first = gsl::narrow_cast<char32_t>(block << s_blockShift);
+            const auto last = gsl::narrow_cast<char32_t>(first + s_blockSize - 1);
+
+            for (; range != rangeEnd && range->upperBound < first; ++range)
+            {
+            }
+
+            if (const auto c = uniformWidthClass(block, range); c >= 0)
+            {
+                table.stage1[block] = gsl::narrow_cast<uint8_t>(c);
+                continue;
+            }
+
+            auto& data = table.stage2[nextBlock];
+            table.stage1[block] = gsl::narrow_cast<uint8_t>(nextBlock);
+            ++nextBlock;
+
+            // Unlike the loop above, this one doesn't advance `range`, because
+            // the last range we visit here may extend into the next block.
+            for (auto r = range; r != rangeEnd && r->lowerBound <= last; ++r)
+            {
+                const uint64_t c = r->isAmbiguous ? WidthClassAmbiguous : WidthClassWide;
+                const auto beg = std::max<char32_t>(r->lowerBound, first) - first;
+                const auto end = std::min<char32_t>(r->upperBound, last) - first;
+                for (auto i = beg; i <= end; ++i)
+                {
+                    data[i / 32] |= c << (i % 32 * 2);
+                }
+            }
+        }
+
+        return table;
+    }
+
+    static constexpr auto s_widthTable = buildWidthTable();
+    static_assert(s_widthTable.stage2.size() <= 256, "stage1 uses uint8_t indices");
 }
 
 // Routine Description:
@@ -376,21 +490,39 @@ bool CodepointWidthDetector::IsWide(const std::wstring_view& glyph) noexcept
 
 // GetWidth's slow-path for non-ASCII characters. Returns the number of columns the codepoint takes up in the terminal.
 uint8_t CodepointWidthDetector::_lookupGlyphWidth(const char32_t codepoint, const std::wstring_view& glyph) noexcept
+{
+    const auto widthClass = _lookupWidthClass(codepoint);
+    if (widthClass == WidthClassAmbiguous) [[unlikely]]
+    {
+        return _checkFallbackViaCache(codepoint, glyph);
+    }
+    // WidthClassNarrow and WidthClassWide are 1 less than the number of columns they take up.
+    return gsl::narrow_cast<uint8_t>(widthClass + 1);
+}
+
+// Returns the WidthClass of the codepoint via the two-stage s_widthTable.
+// The codepoint must be less than 0x110000, which is always the case for ones decoded from UTF-16.
+uint8_t CodepointWidthDetector::_lookupWidthClass(const char32_t codepoint) noexcept
+{
+    const auto block = til::at(s_widthTable.stage1, codepoint >> s_blockShift);
+    const auto bits = til::at(til::at(s_widthTable.stage2, block), (codepoint >> 5) & (s_blockSize / 32 - 1));
+    return gsl::narrow_cast<uint8_t>((bits >> (codepoint % 32 * 2)) & 3);
+}
+
+// Returns the WidthClass of the codepoint via a binary search over s_wideAndAmbiguousTable.
+// This is how _lookupWidthClass used to be implemented. It's kept around for unit tests,
+// which ensure that both agree with each other and compare their performance.
+uint8_t CodepointWidthDetector::_searchWidthClass(const char32_t codepoint) noexcept
 {
 #pragma warning(suppress : 26447) // The function is declared 'noexcept' but calls function 'lower_bound<...>()' which may throw exceptions (f.6).
     const auto it = std::lower_bound(s_wideAndAmbiguousTable.begin(), s_wideAndAmbiguousTable.end(), codepoint);
-    uint8_t width = 1;
 
     if (it != s_wideAndAmbiguousTable.end() && codepoint >= it->lowerBound && codepoint <= it->upperBound)
     {
-        width = 2;
-        if (it->isAmbiguous)
-        {
-            width = _checkFallbackViaCache(codepoint, glyph);
-        }
+        return it->isAmbiguous ? WidthClassAmbiguous : WidthClassWide;
     }
 
-    return width;
+    return WidthClassNarrow;
 }
 
 // Call the function specified via SetFallbackMethod() to turn CodepointWidth::Ambiguous into Narrow/Wide.
@@ -404,13 +536,17 @@ try
         return 1;
     }
 
-    if (const auto it = _fallbackCache.find(codepoint); it != _fallbackCache.end())
+    // The cache is direct-mapped: Each codepoint can only ever be stored in a single slot and evicts
+    // whatever was stored there before. Ambiguous codepoints mostly come in contiguous ranges (Latin-1,
+    // Greek, Cyrillic, the Private Use Area, ...), which the low bits of the codepoint map to distinct slots.
+    auto& entry = til::at(_fallbackCache, codepoint % _fallbackCache.size());
+    if (entry.codepoint == codepoint)
     {
-        return it->second;
+        return entry.width;
     }
 
     const uint8_t width = _pfnFallbackMethod(glyph) ? 2 : 1;
-    _fallbackCache.insert_or_assign(codepoint, width);
+    entry = { codepoint, width };
     return width;
 }
 catch (...)
@@ -444,6 +580,5 @@ void CodepointWidthDetector::SetFallbackMethod(std::function<bool(const std::wst
 // - <none>
 void CodepointWidthDetector::NotifyFontChanged() noexcept
 {
-#pragma warning(suppress : 26447) // The function is declared 'noexcept' but calls function 'clear()' which may throw exceptions (f.6).
-    _fallbackCache.clear();
+    _fallbackCache.fill({});
 }
@@ -0,0 +1,302 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "inc/PipeWriter.hpp"
+
+#include <til/unicode.h>
+
+using namespace Microsoft::Console::Utils;
+
+// Routine Description:
+// - Starts the writer thread for the given pipe. The pipe handle isn't owned by this class
+//   and needs to stay valid until Stop() returned.
+// Arguments:
+// - pipe - The pipe to write to.
+// - capacity - The number of UTF-16 code units Write() may queue up before it blocks.
+PipeWriter::PipeWriter(HANDLE pipe, size_t capacity) :
+    _pipe{ pipe },
+    _capacity{ capacity }
+{
+    _thread.reset(CreateThread(nullptr, 0, s_ThreadProc, this, 0, nullptr));
+    THROW_LAST_ERROR_IF(!_thread);
+    LOG_IF_FAILED(SetThreadDescription(_thread.get(), L"PipeWriter Thread"));
+}
+
+PipeWriter::~PipeWriter()
+{
+    Stop();
+}
+
+// Routine Description:
+// - Queues the given text to be written to the pipe and returns immediately.
+// - If more than the capacity is already queued up, this blocks until enough of it was written.
+//   A payload is always accepted if the queue is empty, no matter how large it is, which means
+//   that a single paste never blocks the caller.
+// Arguments:
+// - text - The text to write.
+// - cancelSuffixLength - If Cancel() is called after some of the text was written, the remainder is
+//   discarded except for this many code units at the end of it. This allows a bracketed paste to be
+//   cancelled without leaving the reader stuck in the middle of it.
+void PipeWriter::Write(std::wstring_view text, size_t cancelSuffixLength)
+{
+    if (text.empty())
+    {
+        return;
+    }
+
+    // Copy the text before acquiring the lock, so that the writer thread isn't held up by it.
+    Payload payload{ std::wstring{ text }, std::min(cancelSuffixLength, text.size()) };
+
+    std::unique_lock lock{ _mutex };
+    _queueDrained.wait(lock, [&]() noexcept {
+        return _stop || _failed || _queuedSize == 0 || _queuedSize + payload.text.size() <= _capacity;
+    });
+    if (_stop || _failed)
+    {
+        return;
+    }
+
+    _queuedSize += payload.text.size();
+    _queue.emplace_back(std::move(payload));
+    lock.unlock();
+    _queueNotEmpty.notify_one();
+}
+
+// Routine Description:
+// - Discards all queued text, including the remainder of the payload that's currently being written.
+//   Whatever chunk the thread is currently writing may still reach the pipe if the cancellation
+//   doesn't arrive in time, but nothing after it will, except for the cancelSuffixLength given to Write().
+void PipeWriter::Cancel() noexcept
+{
+    {
+        const std::scoped_lock lock{ _mutex };
+        _generation++;
+        for (const auto& payload : _queue)
+        {
+            _queuedSize -= payload.text.size();
+        }
+        _queue.clear();
+    }
+    _queueDrained.notify_all();
+
+    // Abort a WriteFile() that's blocked on a reader that doesn't read. The thread notices that
+    // the _generation changed and drops the rest of the payload. If the thread isn't blocked
+    // in WriteFile() right now this does nothing, which is fine for the same reason.
+    CancelSynchronousIo(_thread.get());
+}
+
+// Routine Description:
+// - Waits until all queued text was written to the pipe (or discarded due to an error).
+void PipeWriter::Flush() noexcept
+{
+    std::unique_lock lock{ _mutex };
+    _queueDrained.wait(lock, [&]() noexcept { return _stop || _failed || (_queuedSize == 0 && !_busy); });
+}
+
+// Routine Description:
+// - Discards all queued text and waits for the writer thread to exit.
+//   Afterwards the pipe isn't used anymore and Write() doesn't do anything.
+void PipeWriter::Stop() noexcept
+{
+    if (!_thread)
+    {
+        return;
+    }
+
+    {
+        const std::scoped_lock lock{ _mutex };
+        _stop = true;
+        _generation++;
+        for (const auto& payload : _queue)
+        {
+            _queuedSize -= payload.text.size();
+        }
+        _queue.clear();
+    }
+    _queueNotEmpty.notify_all();
+    _queueDrained.notify_all();
+
+    // Just like ConptyConnection::Close() we loop around CancelSynchronousIo()
+    // in case we called it while the thread wasn't stuck in WriteFile() yet.
+    for (;;)
+    {
+        CancelSynchronousIo(_thread.get());
+        if (WaitForSingleObject(_thread.get(), 100) != WAIT_TIMEOUT)
+        {
+            break;
+        }
+    }
+
+    _thread.reset();
+}
+
+// Routine Description:
+// - Returns the number of UTF-16 code units that are still waiting to be written.
+size_t PipeWriter::GetQueuedSize() noexcept
+{
+    const std::scoped_lock lock{ _mutex };
+    return _queuedSize;
+}
+
+// Routine Description:
+// - Returns true if writing to the pipe failed, for instance because the reader closed it.
+//   All text written since then was discarded.
+bool PipeWriter::HasFailed() noexcept
+{
+    const std::scoped_lock lock{ _mutex };
+    return _failed;
+}
+
+DWORD WINAPI PipeWriter::s_ThreadProc(LPVOID parameter) noexcept
+{
+    return static_cast<PipeWriter*>(parameter)->_ThreadProc();
+}
+
+DWORD PipeWriter::_ThreadProc() noexcept
+try
+{
+    for (;;)
+    {
+        Payload payload;
+        uint64_t generation;
+
+        {
+            std::unique_lock lock{ _mutex };
+            _queueNotEmpty.wait(lock, [&]() noexcept { return _stop || !_queue.empty(); });
+            if (_stop)
+            {
+                return 0;
+            }
+            payload = std::move(_queue.front());
+            _queue.pop_front();
+            generation = _generation;
+            _busy = true;
+        }
+
+        std::wstring_view remaining{ payload.text };
+        size_t dropped = 0;
+        DWORD lastError = ERROR_SUCCESS;
+
+        while (!remaining.empty())
+        {
+            // Don't split surrogate pairs between chunks. u16u8() would handle it via _u16State,
+            // but this way a cancelled payload never leaves a partial character in the pipe.
+            auto count = std::min(remaining.size(), ChunkSize);
+            if (count < remaining.size() && til::is_leading_surrogate(til::at(remaining, count - 1)))
+            {
+                count--;
+            }
+
+            lastError = _WriteChunk(remaining.substr(0, count), generation);
+            remaining = remaining.substr(count);
+
+            {
+                const std::scoped_lock lock{ _mutex };
+                if (lastError != ERROR_SUCCESS || _generation != generation)
+                {
+                    dropped = remaining.size();
+                    _queuedSize -= count + remaining.size();
+                    remaining = {};
+                    generation = _generation;
+                }
+                else
+                {
+                    _queuedSize -= count;
+                }
+            }
+            _queueDrained.notify_all();
+        }
+
+        // A write aborted by CancelSynchronousIo() isn't an error. _WriteChunk() only
+        // returns ERROR_OPERATION_ABORTED if Cancel() or Stop() were called.
+        if (lastError == ERROR_OPERATION_ABORTED)
+        {
+            lastError = ERROR_SUCCESS;
+        }
+
+        if (dropped && lastError == ERROR_SUCCESS)
+        {
+            _u16State.reset();
+
+            // Finish the payload with its suffix, if it has one, unless it's already been written anyway.
+            const auto suffix = std::min(dropped, payload.cancelSuffixLength);
+            if (suffix)
+            {
+                lastError = _WriteChunk(std::wstring_view{ payload.text }.substr(payload.text.size() - suffix), generation);
+                if (lastError == ERROR_OPERATION_ABORTED)
+                {
+                    lastError = ERROR_SUCCESS;
+                }
+            }
+        }
+
+        {
+            const std::scoped_lock lock{ _mutex };
+            _busy = false;
+        }
+        _queueDrained.notify_all();
+
+        if (lastError != ERROR_SUCCESS)
+        {
+            const std::scoped_lock lock{ _mutex };
+
+            LOG_WIN32(lastError);
+            _failed = true;
+            for (const auto& p : _queue)
+            {
+                _queuedSize -= p.text.size();
+            }
+            _queue.clear();
+            _queueDrained.notify_all();
+            return lastError;
+        }
+    }
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    {
+        const std::scoped_lock lock{ _mutex };
+        _failed = true;
+        _queue.clear();
+        _queuedSize = 0;
+    }
+    _queueDrained.notify_all();
+    return 1;
+}
+
+// Converts the chunk to UTF-8 and writes all of it to the pipe. Returns the error code if WriteFile() failed.
+DWORD PipeWriter::_WriteChunk(std::wstring_view chunk, uint64_t generation)
+{
+    THROW_IF_FAILED(til::u16u8(chunk, _u8Buffer, _u16State));
+
+    auto data = _u8Buffer.data();
+    auto size = _u8Buffer.size();
+
+    while (size)
+    {
+        DWORD written = 0;
+        const auto ok = WriteFile(_pipe, data, gsl::narrow_cast<DWORD>(size), &written, nullptr);
+        const auto lastError = ok ? ERROR_SUCCESS : GetLastError();
+        data += written;
+        size -= written;
+
+        if (lastError == ERROR_OPERATION_ABORTED)
+        {
+            // CancelSynchronousIo() may arrive late and hit the write of a payload that was queued after the
+            // Cancel() call it belongs to. In that case we just continue writing where WriteFile() stopped.
+            const std::scoped_lock lock{ _mutex };
+            if (!_stop && _generation == generation)
+            {
+                continue;
+            }
+        }
+        if (lastError != ERROR_SUCCESS)
+        {
+            return lastError;
+        }
+    }
+
+    return ERROR_SUCCESS;
+}
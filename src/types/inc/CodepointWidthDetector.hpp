@@ -29,9 +29,19 @@ public:
 #endif
 
 private:
+    struct FallbackCacheEntry
+    {
+        char32_t codepoint = 0;
+        uint8_t width = 0;
+    };
+
     uint8_t _lookupGlyphWidth(char32_t codepoint, const std::wstring_view& glyph) noexcept;
+    static uint8_t _lookupWidthClass(char32_t codepoint) noexcept;
+    static uint8_t _searchWidthClass(char32_t codepoint) noexcept;
     uint8_t _checkFallbackViaCache(char32_t codepoint, const std::wstring_view& glyph) noexcept;
 
-    std::unordered_map<char32_t, uint8_t> _fallbackCache;
+    // A direct-mapped cache for the results of _pfnFallbackMethod, indexed by the lower bits of the codepoint.
+    // Slots with a codepoint of 0 are empty, since U+0000 is narrow and never asks the fallback.
+    std::array<FallbackCacheEntry, 1024> _fallbackCache{};
     std::function<bool(const std::wstring_view&)> _pfnFallbackMethod;
 };
@@ -0,0 +1,83 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- PipeWriter.hpp
+
+Abstract:
+- Writes UTF-16 text to a pipe as UTF-8 on a dedicated thread, so that callers (like the UI thread)
+  don't block while the reader on the other end is busy. Large payloads are converted and written
+  in chunks and the remaining queue can be cancelled at any time.
+
+--*/
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace Microsoft::Console::Utils
+{
+    class PipeWriter
+    {
+    public:
+        // The number of UTF-16 code units Write() queues up before it starts blocking.
+        static constexpr size_t DefaultCapacity = 8 * 1024 * 1024;
+        // The number of UTF-16 code units that are converted and written per WriteFile() call.
+        static constexpr size_t ChunkSize = 16 * 1024;
+
+        PipeWriter(HANDLE pipe, size_t capacity = DefaultCapacity);
+        ~PipeWriter();
+
+        PipeWriter(const PipeWriter&) = delete;
+        PipeWriter& operator=(const PipeWriter&) = delete;
+        PipeWriter(PipeWriter&&) = delete;
+        PipeWriter& operator=(PipeWriter&&) = delete;
+
+        void Write(std::wstring_view text, size_t cancelSuffixLength = 0);
+        void Cancel() noexcept;
+        void Flush() noexcept;
+        void Stop() noexcept;
+
+        size_t GetQueuedSize() noexcept;
+        bool HasFailed() noexcept;
+
+    private:
+        struct Payload
+        {
+            std::wstring text;
+            size_t cancelSuffixLength = 0;
+        };
+
+        static DWORD WINAPI s_ThreadProc(LPVOID parameter) noexcept;
+        DWORD _ThreadProc() noexcept;
+        DWORD _WriteChunk(std::wstring_view chunk, uint64_t generation);
+
+        HANDLE _pipe = INVALID_HANDLE_VALUE;
+        size_t _capacity = DefaultCapacity;
+        wil::unique_handle _thread;
+
+        // All of the following members are protected by _mutex.
+        std::mutex _mutex;
+        // Signaled when there's something in _queue or when _stop is set.
+        std::condition_variable _queueNotEmpty;
+        // Signaled whenever _queuedSize decreased.
+        std::condition_variable _queueDrained;
+        std::deque<Payload> _queue;
+        // The number of code units in _queue plus the unwritten remainder of the payload that's being written.
+        size_t _queuedSize = 0;
+        // Incremented by Cancel(). The thread stops writing a payload as soon as this differs
+        // from the value it had when the thread took the payload from the queue.
+        uint64_t _generation = 0;
+        // True while the thread is writing a payload it took from _queue.
+        bool _busy = false;
+        bool _stop = false;
+        bool _failed = false;
+
+        // Only used by the writer thread.
+        til::u16state _u16State;
+        std::string _u8Buffer;
+    };
+}
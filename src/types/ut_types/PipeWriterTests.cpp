@@ -0,0 +1,138 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../inc/PipeWriter.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+using namespace Microsoft::Console::Utils;
+
+class PipeWriterTests
+{
+    TEST_CLASS(PipeWriterTests);
+
+    TEST_METHOD(WriteDoesNotBlockOnSlowReader);
+    TEST_METHOD(CancelDiscardsRemainingInput);
+    TEST_METHOD(BrokenPipeFails);
+
+    // A small pipe buffer ensures that WriteFile() blocks until the reader caught up.
+    static constexpr DWORD _pipeBufferSize = 4096;
+
+    // Reads the pipe in small pieces with a delay in between, until `until` returns true or the pipe is closed.
+    template<typename Predicate>
+    static std::thread _slowReader(HANDLE pipe, std::string& output, Predicate until)
+    {
+        return std::thread{ [=, &output]() {
+            char buffer[1024];
+            DWORD read = 0;
+            while (!until(output) && ReadFile(pipe, &buffer[0], sizeof(buffer), &read, nullptr) && read)
+            {
+                output.append(&buffer[0], read);
+                Sleep(1);
+            }
+        } };
+    }
+
+    static std::wstring _createPayload(size_t length)
+    {
+        // Mix in non-ASCII and surrogate pairs, so that chunks get split in the middle of them.
+        static constexpr std::wstring_view pattern{ L"abc ä猫\U0001F600\r" };
+        std::wstring payload;
+        payload.reserve(length + pattern.size());
+        while (payload.size() < length)
+        {
+            payload.append(pattern);
+        }
+        return payload;
+    }
+};
+
+void PipeWriterTests::WriteDoesNotBlockOnSlowReader()
+{
+    wil::unique_hfile readPipe;
+    wil::unique_hfile writePipe;
+    VERIFY_WIN32_BOOL_SUCCEEDED(CreatePipe(readPipe.addressof(), writePipe.addressof(), nullptr, _pipeBufferSize));
+
+    const auto payload = _createPayload(1024 * 1024);
+    std::string output;
+
+    PipeWriter writer{ writePipe.get() };
+
+    Log::Comment(L"Writes return before the reader even started");
+    writer.Write(payload);
+    writer.Write(L"end");
+    VERIFY_IS_GREATER_THAN(writer.GetQueuedSize(), size_t{ 0 });
+
+    auto reader = _slowReader(readPipe.get(), output, [](const std::string&) { return false; });
+    writer.Flush();
+    VERIFY_ARE_EQUAL(size_t{ 0 }, writer.GetQueuedSize());
+    writer.Stop();
+    writePipe.reset();
+    reader.join();
+
+    VERIFY_IS_FALSE(writer.HasFailed());
+    VERIFY_IS_TRUE(output == til::u16u8(payload) + "end");
+}
+
+void PipeWriterTests::CancelDiscardsRemainingInput()
+{
+    wil::unique_hfile readPipe;
+    wil::unique_hfile writePipe;
+    VERIFY_WIN32_BOOL_SUCCEEDED(CreatePipe(readPipe.addressof(), writePipe.addressof(), nullptr, _pipeBufferSize));
+
+    static constexpr std::wstring_view pasteBegin{ L"\x1b[200~" };
+    static constexpr std::wstring_view pasteEnd{ L"\x1b[201~" };
+    const auto payload = std::wstring{ pasteBegin } + _createPayload(1024 * 1024) + std::wstring{ pasteEnd };
+    std::string output;
+
+    PipeWriter writer{ writePipe.get() };
+    writer.Write(payload, pasteEnd.size());
+    writer.Write(L"queued");
+
+    // Wait until the writer started writing the paste. Its first chunk is larger than
+    // the pipe buffer, so it's going to be stuck in WriteFile() until we cancel it.
+    for (DWORD available = 0; available == 0;)
+    {
+        Sleep(1);
+        VERIFY_WIN32_BOOL_SUCCEEDED(PeekNamedPipe(readPipe.get(), nullptr, 0, nullptr, &available, nullptr));
+    }
+
+    Log::Comment(L"Cancelling while the writer is stuck on the full pipe drops the rest of the paste");
+    writer.Cancel();
+    writer.Write(L"\x03");
+
+    auto reader = _slowReader(readPipe.get(), output, [](const std::string& s) { return s.ends_with('\x03'); });
+    writer.Flush();
+    reader.join();
+
+    VERIFY_IS_FALSE(writer.HasFailed());
+    VERIFY_IS_LESS_THAN(output.size(), til::u16u8(payload).size());
+    VERIFY_IS_TRUE(output.starts_with(til::u16u8(pasteBegin)));
+    VERIFY_IS_TRUE(output.ends_with(til::u16u8(pasteEnd) + "\x03"));
+    VERIFY_IS_TRUE(output.find("queued") == std::string::npos);
+}
+
+void PipeWriterTests::BrokenPipeFails()
+{
+    wil::unique_hfile readPipe;
+    wil::unique_hfile writePipe;
+    VERIFY_WIN32_BOOL_SUCCEEDED(CreatePipe(readPipe.addressof(), writePipe.addressof(), nullptr, _pipeBufferSize));
+
+    PipeWriter writer{ writePipe.get() };
+    readPipe.reset();
+
+    writer.Write(L"abc");
+    writer.Flush();
+    VERIFY_IS_TRUE(writer.HasFailed());
+    VERIFY_ARE_EQUAL(size_t{ 0 }, writer.GetQueuedSize());
+
+    Log::Comment(L"Writes after a failure are discarded");
+    writer.Write(L"def");
+    VERIFY_ARE_EQUAL(size_t{ 0 }, writer.GetQueuedSize());
+}